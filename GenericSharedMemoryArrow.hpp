@@ -0,0 +1,304 @@
+/**
+ * 	@file		GenericSharedMemoryArrow.hpp
+ *	@brief		Definition of the GenericSharedMemoryArrow class.
+ *	@details	This header file defines an exporter of segment records through the Apache Arrow C Data
+				Interface, so Arrow based tools (pyarrow, Polars, DuckDB...) can import them without
+				converting rows. Records are described by field descriptors (usually reflected), and
+				are exported as a struct array with a child array per field. Arrow columns must be
+				contiguous, so records stored as an array of structs are exported from a columnar
+				snapshot taken in one pass, while columns that are already contiguous (such as those of
+				a structure of arrays segment) are exported in place. Arrow itself is not required, as
+				the C Data Interface is a stable ABI defined by the structs below.
+ *	@author		James Horner
+ */
+
+#ifndef GENERIC_SHARED_MEMORY_ARROW_H
+#define GENERIC_SHARED_MEMORY_ARROW_H
+
+// C++ Standard Library Headers
+#include <algorithm>
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <memory>
+#include <mutex>
+#include <new>
+#include <string>
+#include <vector>
+
+// Library Headers
+#include "GenericSharedMemoryContainers.hpp"
+#include "GenericSharedMemoryModel.hpp"
+#include "GenericSharedMemoryReflection.hpp"
+
+#ifndef ARROW_C_DATA_INTERFACE
+#define ARROW_C_DATA_INTERFACE
+
+#define ARROW_FLAG_DICTIONARY_ORDERED 1
+#define ARROW_FLAG_NULLABLE 2
+#define ARROW_FLAG_MAP_KEYS_SORTED 4
+
+/// Struct ArrowSchema describes the type of an exported array, as defined by the Arrow C Data Interface.
+struct ArrowSchema {
+    const char *format;
+    const char *name;
+    const char *metadata;
+    int64_t flags;
+    int64_t n_children;
+    struct ArrowSchema **children;
+    struct ArrowSchema *dictionary;
+    void (*release)(struct ArrowSchema *);
+    void *private_data;
+};
+
+/// Struct ArrowArray holds the buffers of an exported array, as defined by the Arrow C Data Interface.
+struct ArrowArray {
+    int64_t length;
+    int64_t null_count;
+    int64_t offset;
+    int64_t n_buffers;
+    int64_t n_children;
+    const void **buffers;
+    struct ArrowArray **children;
+    struct ArrowArray *dictionary;
+    void (*release)(struct ArrowArray *);
+    void *private_data;
+};
+
+#endif /* ARROW_C_DATA_INTERFACE */
+
+/// Alignment, in bytes, of the column buffers of an export, as recommended by Arrow.
+#define GENERIC_SHARED_MEMORY_ARROW_ALIGNMENT 64
+
+/**
+ * @brief 	Class GenericSharedMemoryArrow exports records through the Arrow C Data Interface.
+ * @details Exports produce an ArrowSchema and ArrowArray for a struct array of the records, which the consumer owns and
+ * 			must release through their release callbacks. Children can be moved out and released independently, as
+ * 			every array holds a reference to the buffers it uses. Fields of kind Bool are exported bit packed, as Arrow
+ * 			requires, and fields of kind Other as fixed size binary. No field is nullable.
+ */
+class GenericSharedMemoryArrow {
+public:
+    /**
+     * @brief Function export_records() is used to export records stored as an array of structs, from a columnar snapshot.
+     * @param records first record, which must not be written during the call.
+     * @param count number of records.
+     * @param stride distance between records in bytes.
+     * @param fields descriptors of the exported fields, of which the names, offsets, sizes and kinds are used.
+     * @param field_count number of fields.
+     * @param schema schema to fill in.
+     * @param array array to fill in.
+     * @returns Boolean true when the records were exported, false if a field is not exportable.
+     */
+    static bool export_records(const void *records, std::size_t count, std::size_t stride,
+                               const GenericSharedMemoryField *fields, std::size_t field_count,
+                               ArrowSchema *schema, ArrowArray *array) {
+        std::vector<const void *> columns(field_count, nullptr);
+        auto storage = std::make_shared<storage_t>();
+        for (std::size_t index = 0; index < field_count; index++) {
+            const GenericSharedMemoryField &field = fields[index];
+            if (field.kind == GenericSharedMemoryFieldKind::Bool) {
+                continue;
+            }
+
+            // Gather the field of every record into its own contiguous column.
+            unsigned char *column = storage->allocate(count * field.size);
+            const unsigned char *source = (const unsigned char *)records + field.offset;
+            for (std::size_t row = 0; row < count; row++) {
+                memcpy(column + row * field.size, source + row * stride, field.size);
+            }
+            columns[index] = column;
+        }
+        return export_columns(columns.data(), count, fields, field_count, storage, schema, array, records, stride);
+    }
+
+    /**
+     * @brief Function export_columns() is used to export records stored as contiguous columns, in place.
+     * @param columns first value of each field's column, which must stay unchanged until the array is released.
+     * @param count number of records.
+     * @param fields descriptors of the exported fields, of which the names, sizes and kinds are used.
+     * @param field_count number of fields.
+     * @param owner object kept alive until the array and all its children are released, such as the owner of the columns.
+     * @param schema schema to fill in.
+     * @param array array to fill in.
+     * @returns Boolean true when the records were exported, false if a field is not exportable.
+     */
+    static bool export_columns(const void *const *columns, std::size_t count,
+                               const GenericSharedMemoryField *fields, std::size_t field_count,
+                               std::shared_ptr<void> owner, ArrowSchema *schema, ArrowArray *array) {
+        auto storage = std::make_shared<storage_t>();
+        storage->owner = std::move(owner);
+        return export_columns(columns, count, fields, field_count, storage, schema, array, nullptr, 0);
+    }
+
+    /// Function export_records() exports the reflected fields of records, from a columnar snapshot.
+    template<typename Record>
+    static bool export_records(const Record *records, std::size_t count, ArrowSchema *schema, ArrowArray *array) {
+        return export_records(records, count, sizeof(Record), GenericSharedMemoryReflection<Record>::fields.data(),
+                              GenericSharedMemoryReflection<Record>::field_count, schema, array);
+    }
+
+    /**
+     * @brief Function export_model() is used to export the records of a model, holding its lock while taking the snapshot.
+     * @param model connected model of a std::array or GenericSharedMemoryVector of reflectable records.
+     * @param schema schema to fill in.
+     * @param array array to fill in.
+     * @returns Boolean true when the records were exported, false if the model is not connected or a field is not exportable.
+     */
+    template<typename Record, std::size_t N>
+    static bool export_model(GenericSharedMemoryModel<std::array<Record, N>> &model, ArrowSchema *schema, ArrowArray *array) {
+        std::scoped_lock<GenericSharedMemoryModel<std::array<Record, N>>> guard(model);
+        return model.data != nullptr && export_records(model.data->data(), N, schema, array);
+    }
+    template<typename Record, std::size_t N>
+    static bool export_model(GenericSharedMemoryModel<GenericSharedMemoryVector<Record, N>> &model, ArrowSchema *schema, ArrowArray *array) {
+        std::scoped_lock<GenericSharedMemoryModel<GenericSharedMemoryVector<Record, N>>> guard(model);
+        return model.data != nullptr && export_records(model.data->data(), std::min(model.data->size(), N), schema, array);
+    }
+
+    /// Function format() returns the Arrow format string of a field, or an empty string if it is not exportable.
+    static std::string format(const GenericSharedMemoryField &field) {
+        switch (field.kind) {
+            case GenericSharedMemoryFieldKind::Bool:
+                return field.size == 1 ? "b" : "";
+            case GenericSharedMemoryFieldKind::Signed:
+                return field.size == 1 ? "c" : field.size == 2 ? "s" : field.size == 4 ? "i" : field.size == 8 ? "l" : "";
+            case GenericSharedMemoryFieldKind::Unsigned:
+                return field.size == 1 ? "C" : field.size == 2 ? "S" : field.size == 4 ? "I" : field.size == 8 ? "L" : "";
+            case GenericSharedMemoryFieldKind::Float:
+                return field.size == 2 ? "e" : field.size == 4 ? "f" : field.size == 8 ? "g" : "";
+            case GenericSharedMemoryFieldKind::Other:
+                return field.size > 0 ? "w:" + std::to_string(field.size) : "";
+        }
+        return "";
+    }
+
+private:
+    /// Struct storage_t holds the buffers shared by the arrays of an export.
+    struct storage_t {
+        /// Function allocate() returns a new zeroed buffer aligned for Arrow, owned by the storage.
+        unsigned char *allocate(std::size_t bytes) {
+            const std::size_t rounded = (bytes + GENERIC_SHARED_MEMORY_ARROW_ALIGNMENT - 1) / GENERIC_SHARED_MEMORY_ARROW_ALIGNMENT * GENERIC_SHARED_MEMORY_ARROW_ALIGNMENT;
+            unsigned char *buffer = (unsigned char *)::operator new(rounded > 0 ? rounded : GENERIC_SHARED_MEMORY_ARROW_ALIGNMENT, std::align_val_t(GENERIC_SHARED_MEMORY_ARROW_ALIGNMENT));
+            memset(buffer, 0, rounded);
+            buffers.emplace_back(buffer);
+            return buffer;
+        }
+
+        /// Deleter of the aligned buffers.
+        struct deleter_t {
+            void operator()(unsigned char *buffer) const {
+                ::operator delete(buffer, std::align_val_t(GENERIC_SHARED_MEMORY_ARROW_ALIGNMENT));
+            }
+        };
+
+        /// Buffers allocated for the export.
+        std::vector<std::unique_ptr<unsigned char, deleter_t>> buffers;
+        /// Object kept alive for columns exported in place.
+        std::shared_ptr<void> owner;
+    };
+
+    /// Struct schema_private_t holds the strings and children of an exported schema.
+    struct schema_private_t {
+        std::string format;
+        std::string name;
+        std::vector<ArrowSchema> children;
+        std::vector<ArrowSchema *> child_pointers;
+    };
+
+    /// Struct array_private_t holds the buffer pointers and children of an exported array.
+    struct array_private_t {
+        std::shared_ptr<storage_t> storage;
+        std::array<const void *, 2> buffers = {nullptr, nullptr};
+        std::vector<ArrowArray> children;
+        std::vector<ArrowArray *> child_pointers;
+    };
+
+    /// Function release_schema() is the release callback of exported schemas, releasing any children not moved out.
+    static void release_schema(ArrowSchema *schema) {
+        schema_private_t *data = (schema_private_t *)schema->private_data;
+        for (ArrowSchema &child : data->children) {
+            if (child.release != nullptr) {
+                child.release(&child);
+            }
+        }
+        delete data;
+        schema->release = nullptr;
+    }
+
+    /// Function release_array() is the release callback of exported arrays, releasing any children not moved out.
+    static void release_array(ArrowArray *array) {
+        array_private_t *data = (array_private_t *)array->private_data;
+        for (ArrowArray &child : data->children) {
+            if (child.release != nullptr) {
+                child.release(&child);
+            }
+        }
+        delete data;
+        array->release = nullptr;
+    }
+
+    /// Function make_schema() fills in a schema with the given format and name.
+    static schema_private_t *make_schema(ArrowSchema *schema, std::string format, std::string name) {
+        schema_private_t *data = new schema_private_t{std::move(format), std::move(name), {}, {}};
+        *schema = ArrowSchema{data->format.c_str(), data->name.c_str(), nullptr, 0, 0, nullptr, nullptr, &release_schema, data};
+        return data;
+    }
+
+    /// Function make_array() fills in an array with the given length and number of buffers.
+    static array_private_t *make_array(ArrowArray *array, std::shared_ptr<storage_t> storage, std::size_t count, int64_t n_buffers) {
+        array_private_t *data = new array_private_t{std::move(storage), {nullptr, nullptr}, {}, {}};
+        *array = ArrowArray{(int64_t)count, 0, 0, n_buffers, 0, data->buffers.data(), nullptr, nullptr, &release_array, data};
+        return data;
+    }
+
+    /// Function export_columns() builds the struct array, bit packing Bool fields from the columns or the records.
+    static bool export_columns(const void *const *columns, std::size_t count,
+                               const GenericSharedMemoryField *fields, std::size_t field_count,
+                               std::shared_ptr<storage_t> storage, ArrowSchema *schema, ArrowArray *array,
+                               const void *records, std::size_t stride) {
+        for (std::size_t index = 0; index < field_count; index++) {
+            if (format(fields[index]).empty()) {
+                return false;
+            }
+        }
+
+        schema_private_t *schema_data = make_schema(schema, "+s", "");
+        array_private_t *array_data = make_array(array, storage, count, 1);
+        schema_data->children.resize(field_count);
+        array_data->children.resize(field_count);
+        for (std::size_t index = 0; index < field_count; index++) {
+            const GenericSharedMemoryField &field = fields[index];
+            std::string name = field.name.empty() ? "f" + std::to_string(index) : std::string(field.name);
+            make_schema(&schema_data->children[index], format(field), std::move(name));
+            array_private_t *child = make_array(&array_data->children[index], storage, count, 2);
+
+            if (field.kind == GenericSharedMemoryFieldKind::Bool) {
+                // Pack the bools into bits, taking them from the column or directly from the records.
+                unsigned char *bits = storage->allocate((count + 7) / 8);
+                for (std::size_t row = 0; row < count; row++) {
+                    const unsigned char *value = columns[index] != nullptr
+                        ? (const unsigned char *)columns[index] + row
+                        : (const unsigned char *)records + row * stride + field.offset;
+                    bits[row / 8] |= (unsigned char)((*value != 0) << (row % 8));
+                }
+                child->buffers[1] = bits;
+            }
+            else {
+                child->buffers[1] = columns[index];
+            }
+        }
+        for (std::size_t index = 0; index < field_count; index++) {
+            schema_data->child_pointers.push_back(&schema_data->children[index]);
+            array_data->child_pointers.push_back(&array_data->children[index]);
+        }
+        schema->n_children = (int64_t)field_count;
+        schema->children = schema_data->child_pointers.data();
+        array->n_children = (int64_t)field_count;
+        array->children = array_data->child_pointers.data();
+        return true;
+    }
+};
+
+#endif /* GENERIC_SHARED_MEMORY_ARROW_H */
@@ -0,0 +1,426 @@
+/**
+ * 	@file		GenericSharedMemoryChannel.hpp
+ *	@brief		Definition of the GenericSharedMemoryChannel class.
+ *	@details	This header file defines channels, which connect the stages of a pipeline through shared
+				memory. A channel is either a queue of messages from one writer to one reader, or a latest
+				value written by one writer and read by any number of readers. Unlike the models, the size
+				of a channel is chosen at runtime and recorded in a header in the segment, so a pipeline
+				runner can create channels from a description and stages can connect to them by name
+				alone. The header also counts the messages written and read and the writes that found a
+				queue full, so the runner can report throughput, depth and backpressure for every edge.
+ *	@author		James Horner
+ */
+
+#ifndef GENERIC_SHARED_MEMORY_CHANNEL_H
+#define GENERIC_SHARED_MEMORY_CHANNEL_H
+
+// C++ Standard Library Headers
+#include <atomic>
+#include <cerrno>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <string>
+
+// Platform Dependant System Libraries
+#include <fcntl.h>      // Needed for read/write definitions
+#include <unistd.h>     // Needed for close()
+#include <sys/mman.h>   // For POSIX shared memory via shm_open
+#include <sys/stat.h>
+
+// Library Headers
+#include "GenericSharedMemoryFutex.hpp"
+#include "GenericSharedMemoryLog.hpp"
+
+/// Value of the magic word of an initialised channel, "GSMC".
+#define GENERIC_SHARED_MEMORY_CHANNEL_MAGIC 0x434D5347u
+
+/// Kind of a channel.
+enum class GenericSharedMemoryChannelKind : uint32_t {
+    /// Queue of messages from one writer to one reader.
+    Queue = 1,
+    /// Latest value written by one writer, read by any number of readers.
+    Latest = 2
+};
+
+/// Struct GenericSharedMemoryChannelStats holds the counters of a channel.
+struct GenericSharedMemoryChannelStats {
+    /// Number of messages written.
+    uint64_t written;
+    /// Number of messages read.
+    uint64_t read;
+    /// Number of messages waiting in a queue.
+    uint64_t queued;
+    /// Maximum number of messages waiting in a queue, or 1 for a latest value.
+    uint64_t depth;
+    /// Number of writes that found a queue full, which waited or were refused.
+    uint64_t full;
+};
+
+/**
+ * @brief 	Struct GenericSharedMemoryChannelHeader is the start of a channel segment, followed by its message slots.
+ * @details The writer's and the reader's counters are on separate cache lines. For a latest value, head is a sequence
+ * 			that is odd while the value is being written and advances by two per message.
+ */
+struct GenericSharedMemoryChannelHeader {
+    /// GENERIC_SHARED_MEMORY_CHANNEL_MAGIC once the header is initialised.
+    std::atomic<uint32_t> magic;
+    /// Kind of the channel.
+    GenericSharedMemoryChannelKind kind;
+    /// Size of a message in bytes.
+    uint64_t message_bytes;
+    /// Number of message slots.
+    uint64_t depth;
+    /// Number of messages written, or the sequence of a latest value.
+    alignas(64) std::atomic<uint64_t> head;
+    /// Futex word incremented by writes while readers wait.
+    std::atomic<uint32_t> written;
+    /// Number of readers waiting for a message.
+    std::atomic<uint32_t> reader_waiters;
+    /// Number of messages read.
+    alignas(64) std::atomic<uint64_t> tail;
+    /// Futex word incremented by reads while the writer waits.
+    std::atomic<uint32_t> consumed;
+    /// Number of writers waiting for space.
+    std::atomic<uint32_t> writer_waiters;
+    /// Number of writes that found a queue full.
+    alignas(64) std::atomic<uint64_t> full;
+};
+
+/**
+ * @brief 	Class GenericSharedMemoryChannel is used for management of a connection to a channel segment.
+ * @details The segment is created and sized by create(), usually by a pipeline runner, and stages then connect() to it
+ * 			by name. Each connection is used by one thread at a time, and a queue has one writer and one reader.
+ */
+class GenericSharedMemoryChannel {
+public:
+    /// Constructor for the GenericSharedMemoryChannel class that initialises members, but does not connect shared memory.
+    GenericSharedMemoryChannel(const std::string name, const bool log_warnings = false) :
+        m_name(name),
+        m_log_warnings(log_warnings)
+    {
+    }
+
+    /// Destructor for the GenericSharedMemoryChannel class that disconnects the segment.
+    ~GenericSharedMemoryChannel() {
+        disconnect();
+    }
+
+    GenericSharedMemoryChannel(const GenericSharedMemoryChannel &) = delete;
+    GenericSharedMemoryChannel &operator=(const GenericSharedMemoryChannel &) = delete;
+
+    /// Function segment_bytes() returns the size of the segment of a channel.
+    static std::size_t segment_bytes(GenericSharedMemoryChannelKind kind, std::size_t message_bytes, std::size_t depth) {
+        return sizeof(GenericSharedMemoryChannelHeader) + slot_bytes(message_bytes) * (kind == GenericSharedMemoryChannelKind::Queue ? depth : 1);
+    }
+
+    /**
+     * @brief Function create() is used to create the segment of the channel, replacing any segment of the same name.
+     * @details The old segment is unlinked rather than truncated, so processes still connected to it keep a working mapping.
+     * @param kind kind of the channel.
+     * @param message_bytes size of a message in bytes.
+     * @param depth maximum number of messages waiting in a queue, ignored for a latest value.
+     * @returns Boolean true when the channel was created and connected, false otherwise.
+     */
+    bool create(GenericSharedMemoryChannelKind kind, std::size_t message_bytes, std::size_t depth = 1);
+
+    /**
+     * @brief Function connect() is used to connect to the segment of a channel created by create().
+     * @returns Boolean true when the channel was connected, false if it does not exist or is not initialised.
+     */
+    bool connect();
+
+    /**
+     * @brief Function disconnect() is used to disconnect from the segment of the channel.
+     * @returns Boolean true when the segment was disconnected, false if it was not connected.
+     */
+    bool disconnect() {
+        if (m_header == nullptr) {
+            return false;
+        }
+        munmap(m_header, m_bytes);
+        m_header = nullptr;
+        m_bytes = 0;
+        return true;
+    }
+
+    /// Function is_connected() returns true if the channel is connected.
+    bool is_connected() const {
+        return m_header != nullptr;
+    }
+
+    /// Function remove() removes the segment of a channel, which stays mapped by the processes connected to it.
+    static bool remove(const std::string &name) {
+        return shm_unlink(name.c_str()) == 0;
+    }
+
+    /// Function kind() returns the kind of the channel, which is only meaningful while connected.
+    GenericSharedMemoryChannelKind kind() const {
+        return m_header != nullptr ? m_header->kind : GenericSharedMemoryChannelKind::Queue;
+    }
+
+    /// Function message_bytes() returns the size of a message in bytes, or 0 if the channel is not connected.
+    std::size_t message_bytes() const {
+        return m_header != nullptr ? (std::size_t)m_header->message_bytes : 0;
+    }
+
+    /**
+     * @brief Function write() is used to write a message.
+     * @details A queue that is full is counted as backpressure once per write, which then waits for space. A latest
+     * 			value is always overwritten.
+     * @param message message of message_bytes() bytes.
+     * @param timeout_ms time to wait for space in a full queue in milliseconds, 0 not to wait, or -1 to wait indefinitely.
+     * @returns Boolean true when the message was written, false if the queue stayed full or the channel is not connected.
+     */
+    bool write(const void *message, int timeout_ms = 0);
+
+    /**
+     * @brief Function read() is used to read a message.
+     * @details A queue gives each message once, in order. A latest value gives the newest value not yet read by this
+     * 			connection, skipping older values.
+     * @param message buffer of message_bytes() bytes to read the message into.
+     * @param timeout_ms time to wait for a message in milliseconds, 0 not to wait, or -1 to wait indefinitely.
+     * @returns Boolean true when a message was read, false if none arrived or the channel is not connected.
+     */
+    bool read(void *message, int timeout_ms = 0);
+
+    /// Function stats() returns the counters of the channel, which are zero if it is not connected.
+    GenericSharedMemoryChannelStats stats() const {
+        GenericSharedMemoryChannelStats result{};
+        if (m_header == nullptr) {
+            return result;
+        }
+        const bool queue = m_header->kind == GenericSharedMemoryChannelKind::Queue;
+        const uint64_t head = m_header->head.load(std::memory_order_acquire);
+        result.written = queue ? head : head / 2;
+        result.read = m_header->tail.load(std::memory_order_acquire);
+        result.queued = queue && result.written > result.read ? result.written - result.read : 0;
+        result.depth = m_header->depth;
+        result.full = m_header->full.load(std::memory_order_relaxed);
+        return result;
+    }
+
+private:
+    /// Function slot_bytes() returns the size of a message slot, which keeps slots 8 byte aligned.
+    static std::size_t slot_bytes(std::size_t message_bytes) {
+        return (message_bytes + 7) / 8 * 8;
+    }
+
+    /// Function slot() returns a message slot.
+    unsigned char *slot(uint64_t position) {
+        return (unsigned char *)(m_header + 1) + (position % m_header->depth) * slot_bytes(m_header->message_bytes);
+    }
+
+    /// Function wait() waits on a futex word of the header until a condition holds, counting the caller as a waiter.
+    template<typename Condition>
+    static bool wait(std::atomic<uint32_t> &word, std::atomic<uint32_t> &waiters, int timeout_ms, Condition &&condition) {
+        const auto deadline = std::chrono::steady_clock::now() + std::chrono::milliseconds(timeout_ms);
+        for (;;) {
+            if (condition()) {
+                return true;
+            }
+            int remaining_ms = -1;
+            if (timeout_ms >= 0) {
+                remaining_ms = (int)std::chrono::duration_cast<std::chrono::milliseconds>(deadline - std::chrono::steady_clock::now()).count();
+                if (remaining_ms <= 0) {
+                    return false;
+                }
+            }
+            // Count the waiter before checking again, so a change that misses the count is seen by the check.
+            waiters.fetch_add(1, std::memory_order_seq_cst);
+            const uint32_t value = word.load(std::memory_order_seq_cst);
+            if (!condition()) {
+                generic_shared_memory_futex_wait(&word, value, remaining_ms);
+            }
+            waiters.fetch_sub(1, std::memory_order_seq_cst);
+        }
+    }
+
+    /// Function notify() wakes the threads waiting on a futex word of the header, if there are any.
+    static void notify(std::atomic<uint32_t> &word, std::atomic<uint32_t> &waiters) {
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        if (waiters.load(std::memory_order_relaxed) > 0) {
+            word.fetch_add(1, std::memory_order_seq_cst);
+            generic_shared_memory_futex_wake(&word);
+        }
+    }
+
+    /// Function map() maps an open segment, logging a failure.
+    bool map(int file_mapping_handle, std::size_t bytes) {
+        void *mapping = mmap(NULL, bytes, PROT_READ | PROT_WRITE, MAP_SHARED, file_mapping_handle, 0);
+        const int mapping_errno = errno;
+        close(file_mapping_handle);
+        if (mapping == MAP_FAILED) {
+            warn(GenericSharedMemoryLogEvent::MapFailed, mapping_errno);
+            return false;
+        }
+        m_header = (GenericSharedMemoryChannelHeader *)mapping;
+        m_bytes = bytes;
+        return true;
+    }
+
+    /// Function warn() records a failure in the log if warnings are enabled.
+    void warn(GenericSharedMemoryLogEvent event, int error_number) {
+        if (m_log_warnings) {
+            GenericSharedMemoryLog::record(GenericSharedMemoryLogSeverity::Warning, event, m_name, error_number);
+        }
+    }
+
+    /// Name of the shared memory segment.
+    std::string m_name;
+    /// Flag for if warnings should be logged through the GenericSharedMemoryLog.
+    bool m_log_warnings;
+    /// Header of the mapped segment, or nullptr when not connected.
+    GenericSharedMemoryChannelHeader *m_header = nullptr;
+    /// Size of the mapping.
+    std::size_t m_bytes = 0;
+    /// Sequence of the last latest value read by this connection.
+    uint64_t m_last_sequence = 0;
+};
+
+inline bool GenericSharedMemoryChannel::create(GenericSharedMemoryChannelKind kind, std::size_t message_bytes, std::size_t depth)
+{
+    if (message_bytes == 0 || depth == 0 || (kind != GenericSharedMemoryChannelKind::Queue && kind != GenericSharedMemoryChannelKind::Latest)) {
+        return false;
+    }
+    disconnect();
+    if (kind == GenericSharedMemoryChannelKind::Latest) {
+        depth = 1;
+    }
+    const std::size_t bytes = segment_bytes(kind, message_bytes, depth);
+
+    // Unlinking any old channel before creating the new one starts it zero filled, while stages still attached to the
+    // old segment keep their mapping rather than having it truncated under them.
+    shm_unlink(m_name.c_str());
+    int file_mapping_handle = shm_open(m_name.c_str(), O_CREAT | O_EXCL | O_RDWR, 0666);
+    if (file_mapping_handle < 0) {
+        warn(GenericSharedMemoryLogEvent::OpenFailed, errno);
+        return false;
+    }
+    if (ftruncate(file_mapping_handle, (off_t)bytes) != 0) {
+        warn(GenericSharedMemoryLogEvent::TruncateFailed, errno);
+        close(file_mapping_handle);
+        return false;
+    }
+    if (!map(file_mapping_handle, bytes)) {
+        return false;
+    }
+    m_header->kind = kind;
+    m_header->message_bytes = message_bytes;
+    m_header->depth = depth;
+    m_header->magic.store(GENERIC_SHARED_MEMORY_CHANNEL_MAGIC, std::memory_order_release);
+    m_last_sequence = 0;
+    return true;
+}
+
+inline bool GenericSharedMemoryChannel::connect()
+{
+    if (m_header != nullptr) {
+        return true;
+    }
+    int file_mapping_handle = shm_open(m_name.c_str(), O_RDWR, 0666);
+    if (file_mapping_handle < 0) {
+        warn(GenericSharedMemoryLogEvent::OpenFailed, errno);
+        return false;
+    }
+    struct stat mapping_stat;
+    if (fstat(file_mapping_handle, &mapping_stat) != 0 || (std::size_t)mapping_stat.st_size < sizeof(GenericSharedMemoryChannelHeader)) {
+        close(file_mapping_handle);
+        return false;
+    }
+    if (!map(file_mapping_handle, (std::size_t)mapping_stat.st_size)) {
+        return false;
+    }
+
+    // The header must be initialised and describe a channel of a known kind that fits the segment, as reads and writes
+    // index slots by the kind and depth.
+    const GenericSharedMemoryChannelKind kind = m_header->kind;
+    const std::size_t message_bytes = m_header->message_bytes;
+    const std::size_t depth = m_header->depth;
+    const bool valid = m_header->magic.load(std::memory_order_acquire) == GENERIC_SHARED_MEMORY_CHANNEL_MAGIC &&
+                       (kind == GenericSharedMemoryChannelKind::Queue || kind == GenericSharedMemoryChannelKind::Latest) &&
+                       message_bytes != 0 && message_bytes <= m_bytes && depth != 0 && depth <= m_bytes / slot_bytes(message_bytes) &&
+                       m_bytes >= segment_bytes(kind, message_bytes, depth);
+    if (!valid) {
+        disconnect();
+        return false;
+    }
+    m_last_sequence = 0;
+    return true;
+}
+
+inline bool GenericSharedMemoryChannel::write(const void *message, int timeout_ms)
+{
+    GenericSharedMemoryChannelHeader *header = m_header;
+    if (header == nullptr) {
+        return false;
+    }
+    const std::size_t bytes = header->message_bytes;
+    if (header->kind == GenericSharedMemoryChannelKind::Latest) {
+        // Write the value under the sequence, like the seqlock of a composite segment.
+        const uint64_t sequence = header->head.load(std::memory_order_relaxed);
+        header->head.store(sequence + 1, std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_release);
+        memcpy(slot(0), message, bytes);
+        header->head.store(sequence + 2, std::memory_order_release);
+        notify(header->written, header->reader_waiters);
+        return true;
+    }
+
+    const uint64_t head = header->head.load(std::memory_order_relaxed);
+    auto has_space = [&]() { return head - header->tail.load(std::memory_order_acquire) < header->depth; };
+    if (!has_space()) {
+        header->full.fetch_add(1, std::memory_order_relaxed);
+        if (timeout_ms == 0 || !wait(header->consumed, header->writer_waiters, timeout_ms, has_space)) {
+            return false;
+        }
+    }
+    memcpy(slot(head), message, bytes);
+    header->head.store(head + 1, std::memory_order_release);
+    notify(header->written, header->reader_waiters);
+    return true;
+}
+
+inline bool GenericSharedMemoryChannel::read(void *message, int timeout_ms)
+{
+    GenericSharedMemoryChannelHeader *header = m_header;
+    if (header == nullptr) {
+        return false;
+    }
+    const std::size_t bytes = header->message_bytes;
+    if (header->kind == GenericSharedMemoryChannelKind::Latest) {
+        auto has_value = [&]() {
+            const uint64_t sequence = header->head.load(std::memory_order_acquire);
+            return sequence > m_last_sequence + 1 || (sequence > m_last_sequence && sequence % 2 == 0);
+        };
+        for (;;) {
+            if (!has_value() && (timeout_ms == 0 || !wait(header->written, header->reader_waiters, timeout_ms, has_value))) {
+                return false;
+            }
+            const uint64_t sequence = header->head.load(std::memory_order_acquire);
+            if (sequence % 2 != 0) {
+                continue;
+            }
+            memcpy(message, slot(0), bytes);
+            std::atomic_thread_fence(std::memory_order_acquire);
+            if (header->head.load(std::memory_order_relaxed) == sequence) {
+                m_last_sequence = sequence;
+                header->tail.fetch_add(1, std::memory_order_relaxed);
+                return true;
+            }
+        }
+    }
+
+    const uint64_t tail = header->tail.load(std::memory_order_relaxed);
+    auto has_message = [&]() { return header->head.load(std::memory_order_acquire) != tail; };
+    if (!has_message() && (timeout_ms == 0 || !wait(header->written, header->reader_waiters, timeout_ms, has_message))) {
+        return false;
+    }
+    memcpy(message, slot(tail), bytes);
+    header->tail.store(tail + 1, std::memory_order_release);
+    notify(header->consumed, header->writer_waiters);
+    return true;
+}
+
+#endif /* GENERIC_SHARED_MEMORY_CHANNEL_H */
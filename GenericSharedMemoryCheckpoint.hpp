@@ -0,0 +1,392 @@
+/**
+ * 	@file		GenericSharedMemoryCheckpoint.hpp
+ *	@brief		Definition of the GenericSharedMemoryCheckpointer class.
+ *	@details	This header file defines an incremental checkpointer for shared memory segments. The
+				first checkpoint saves every page of the segment, and each later checkpoint saves only
+				the pages modified since the previous one, forming a chain of checkpoint files that is
+				replayed in order to restore the segment. Modified pages are found using the kernel's
+				soft-dirty page tracking where it is available and requested, or by comparing a hash
+				of every page with its hash at the previous checkpoint.
+ *	@author		James Horner
+ */
+
+#ifndef GENERIC_SHARED_MEMORY_CHECKPOINT_H
+#define GENERIC_SHARED_MEMORY_CHECKPOINT_H
+
+// C++ Standard Library Headers
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <mutex>
+#include <string>
+#include <vector>
+
+// Platform Dependant System Libraries
+#ifdef __linux__
+#include <fcntl.h>      // Needed for open()
+#include <unistd.h>     // Needed for pread() and write()
+#include <sys/mman.h>   // Needed for mmap()
+#endif
+
+// Library Headers
+#include "GenericSharedMemoryModel.hpp"
+
+/// Method used by the GenericSharedMemoryCheckpointer to find the pages modified since the previous checkpoint.
+enum class GenericSharedMemoryCheckpointTracking : uint8_t {
+    /// Compare a hash of each page with its hash at the previous checkpoint, which finds writes from any process.
+    PageHash,
+    /// Use the kernel's soft-dirty bits, which only see writes made by this process, falling back to PageHash if unsupported.
+    SoftDirty
+};
+
+/// Header at the start of every checkpoint file.
+struct GenericSharedMemoryCheckpointHeader {
+    /// Magic number identifying a checkpoint file.
+    char magic[8];
+    /// Identifier shared by the files of one chain, so files left over from an older chain are not replayed.
+    uint64_t chain_id;
+    /// Position of the file in the chain, starting from 0 for the full checkpoint.
+    uint64_t sequence;
+    /// Size of a page, and of each page record, in bytes.
+    uint64_t page_size;
+    /// Size of the segment in bytes.
+    uint64_t segment_bytes;
+    /// Number of page records following the header.
+    uint64_t page_count;
+};
+
+/**
+ * @brief 	Class GenericSharedMemoryCheckpointer is used to write incremental checkpoints of a shared memory segment.
+ * @details Checkpoints are written to a chain of files named with a prefix and their sequence number ("prefix.0", "prefix.1",
+ * 			...). Each file holds a header followed by records of a page index and the contents of the page, so the I/O of
+ * 			each checkpoint is proportional to the number of pages modified rather than to the size of the segment. Each
+ * 			file is written under a temporary name and renamed once complete, so a chain never ends in a partial file. The
+ * 			first checkpoint of a chain removes the later files of any older chain with the prefix, and a restore stops at
+ * 			the first file of another chain.
+ *
+ * 			Writers should be quiescent while checkpoint() runs (for example by writing through write_data() on a model
+ * 			whose lock is held), otherwise a page modified during the checkpoint may be saved in a mix of its old and new
+ * 			contents. With soft-dirty tracking, a page first modified between the scan and the clearing of the soft-dirty
+ * 			bits is only saved once it is modified again, and clearing the bits affects every mapping of the process, so
+ * 			only one soft-dirty checkpointer should be used per process.
+ */
+class GenericSharedMemoryCheckpointer {
+public:
+    /**
+     * @brief Constructor for the GenericSharedMemoryCheckpointer class that initialises members, but does not write a checkpoint.
+     * @param path_prefix prefix of the checkpoint file names.
+     * @param tracking method used to find the modified pages.
+     */
+    GenericSharedMemoryCheckpointer(const std::string path_prefix,
+                                    GenericSharedMemoryCheckpointTracking tracking = GenericSharedMemoryCheckpointTracking::PageHash) :
+        m_path_prefix(path_prefix),
+        m_page_size(generic_shared_memory_page_size()),
+        m_sequence(0),
+        m_last_page_count(0)
+    {
+        m_soft_dirty = tracking == GenericSharedMemoryCheckpointTracking::SoftDirty && soft_dirty_supported();
+    }
+
+    /**
+     * @brief Function checkpoint() is used to write the next checkpoint of a segment to the chain.
+     * @param address start of the segment, which must be page aligned when soft-dirty tracking is used.
+     * @param bytes size of the segment in bytes, which must be the same for every checkpoint.
+     * @returns Boolean true when the checkpoint was written, false otherwise.
+     */
+    bool checkpoint(const void *address, std::size_t bytes);
+
+    /**
+     * @brief Function checkpoint() is used to write the next checkpoint of a model's segment to the chain while holding 
+     * 			the model's lock.
+     * @param model connected model whose segment is saved.
+     * @returns Boolean true when the checkpoint was written, false if the model is not connected or it could not be written.
+     */
+    template<typename T>
+    bool checkpoint(GenericSharedMemoryModel<T> &model) {
+        std::scoped_lock<GenericSharedMemoryModel<T>> model_guard(model);
+        return model.data != nullptr && checkpoint(model.data, sizeof(T));
+    }
+
+    /**
+     * @brief Function restore() is used to restore a segment by replaying a chain of checkpoint files.
+     * @param path_prefix prefix of the checkpoint file names.
+     * @param address start of the segment to restore into.
+     * @param bytes size of the segment in bytes, which must match the size saved in the checkpoints.
+     * @returns Number of checkpoint files replayed, or 0 if the chain could not be restored, in which case the segment is unchanged.
+     */
+    static std::size_t restore(const std::string &path_prefix, void *address, std::size_t bytes);
+
+    /// Function sequence() returns the number of checkpoints written to the chain.
+    uint64_t sequence() const {
+        return m_sequence;
+    }
+
+    /// Function last_page_count() returns the number of pages saved by the most recent checkpoint.
+    std::size_t last_page_count() const {
+        return m_last_page_count;
+    }
+
+    /// Function is_soft_dirty() returns true if the checkpointer uses soft-dirty tracking.
+    bool is_soft_dirty() const {
+        return m_soft_dirty;
+    }
+
+    /// Function soft_dirty_supported() returns true if the kernel tracks soft-dirty bits, which is checked once.
+    static bool soft_dirty_supported();
+
+    /// Function hash_page() returns the hash used to find modified pages when soft-dirty tracking is not used.
+    static uint64_t hash_page(const unsigned char *page, std::size_t bytes) {
+        uint64_t hash = 0x9E3779B97F4A7C15ull ^ bytes;
+        std::size_t i = 0;
+        for (; i + sizeof(uint64_t) <= bytes; i += sizeof(uint64_t)) {
+            uint64_t word;
+            memcpy(&word, page + i, sizeof(word));
+            hash = (hash ^ word) * 0xFF51AFD7ED558CCDull;
+            hash ^= hash >> 32;
+        }
+        for (; i < bytes; i++) {
+            hash = (hash ^ page[i]) * 0x100000001B3ull;
+        }
+        return hash;
+    }
+
+private:
+    /// Function replay() reads a chain of checkpoint files, copying their pages into the segment unless it is null.
+    static std::size_t replay(const std::string &path_prefix, unsigned char *segment, std::size_t bytes);
+
+    /// Function clear_soft_dirty() clears the soft-dirty bits of every page of the process.
+    static bool clear_soft_dirty();
+
+    /// Function find_soft_dirty() finds the pages of a range with their soft-dirty bit set.
+    bool find_soft_dirty(const void *address, std::size_t page_count, std::vector<uint64_t> &pages);
+
+    /// Prefix of the checkpoint file names.
+    std::string m_path_prefix;
+    /// Size of a page in bytes.
+    std::size_t m_page_size;
+    /// Number of checkpoints written.
+    uint64_t m_sequence;
+    /// Number of pages saved by the most recent checkpoint.
+    std::size_t m_last_page_count;
+    /// Size of the segment in bytes, fixed by the first checkpoint.
+    std::size_t m_segment_bytes = 0;
+    /// Identifier of the chain, chosen by the first checkpoint.
+    uint64_t m_chain_id = 0;
+    /// Flag for if soft-dirty tracking is used.
+    bool m_soft_dirty;
+    /// Flag for if the next checkpoint saves every page, as a failed checkpoint cleared the soft-dirty bits.
+    bool m_full_next = false;
+    /// Hash of each page at the previous checkpoint, when soft-dirty tracking is not used.
+    std::vector<uint64_t> m_page_hashes;
+};
+
+inline bool GenericSharedMemoryCheckpointer::checkpoint(const void *address, std::size_t bytes)
+{
+    const unsigned char *segment = (const unsigned char *)address;
+    if (segment == nullptr || bytes == 0 || (m_sequence != 0 && bytes != m_segment_bytes)) {
+        return false;
+    }
+    const std::size_t page_count = (bytes + m_page_size - 1) / m_page_size;
+
+    // Find the pages to save: all of them for the first checkpoint, or after a failed checkpoint that cleared the
+    // soft-dirty bits, otherwise those modified since the previous one. New page hashes are only kept once the file
+    // is written, so a failed checkpoint leaves its pages to the next one.
+    std::vector<uint64_t> pages;
+    std::vector<uint64_t> hashes;
+    if (m_sequence == 0) {
+        m_chain_id = (uint64_t)std::chrono::system_clock::now().time_since_epoch().count() ^ (uint64_t)(uintptr_t)this;
+    }
+    if (m_sequence == 0 || m_full_next) {
+        for (uint64_t page = 0; page < page_count; page++) {
+            pages.push_back(page);
+        }
+        if (m_soft_dirty) {
+            m_soft_dirty = clear_soft_dirty();
+        }
+        for (std::size_t page = 0; !m_soft_dirty && page < page_count; page++) {
+            const std::size_t offset = page * m_page_size;
+            hashes.push_back(hash_page(segment + offset, std::min(m_page_size, bytes - offset)));
+        }
+    }
+    else if (m_soft_dirty) {
+        if (!find_soft_dirty(segment, page_count, pages)) {
+            return false;
+        }
+        if (!clear_soft_dirty()) {
+            m_full_next = true;
+            return false;
+        }
+    }
+    else {
+        for (std::size_t page = 0; page < page_count; page++) {
+            const std::size_t offset = page * m_page_size;
+            const uint64_t hash = hash_page(segment + offset, std::min(m_page_size, bytes - offset));
+            if (hash != m_page_hashes[page]) {
+                pages.push_back(page);
+                hashes.push_back(hash);
+            }
+        }
+    }
+
+    // Write the header and the page records to a temporary file.
+    const std::string path = m_path_prefix + "." + std::to_string(m_sequence);
+    const std::string temporary_path = path + ".tmp";
+    FILE *file = fopen(temporary_path.c_str(), "wb");
+    if (file == nullptr) {
+        return false;
+    }
+    GenericSharedMemoryCheckpointHeader header = {{'G', 'S', 'M', 'M', 'C', 'K', 'P', 'T'}, m_chain_id, m_sequence, m_page_size, bytes, pages.size()};
+    bool written = fwrite(&header, sizeof(header), 1, file) == 1;
+    std::vector<unsigned char> last_page(m_page_size, 0);
+    for (std::size_t i = 0; written && i < pages.size(); i++) {
+        const std::size_t offset = pages[i] * m_page_size;
+        const unsigned char *page = segment + offset;
+        // The last page of a segment that is not a whole number of pages is padded with zeros.
+        if (bytes - offset < m_page_size) {
+            memcpy(last_page.data(), page, bytes - offset);
+            page = last_page.data();
+        }
+        written = fwrite(&pages[i], sizeof(pages[i]), 1, file) == 1 && fwrite(page, m_page_size, 1, file) == 1;
+    }
+    written = fclose(file) == 0 && written;
+
+    // Replace any previous file with the sequence number once the new one is complete. The soft-dirty bits of the pages
+    // are already cleared, so after a failure only a full checkpoint is sure to save them.
+    if (!written || rename(temporary_path.c_str(), path.c_str()) != 0) {
+        remove(temporary_path.c_str());
+        m_full_next = m_soft_dirty;
+        return false;
+    }
+    m_page_hashes.resize(hashes.empty() ? m_page_hashes.size() : page_count);
+    for (std::size_t i = 0; i < hashes.size(); i++) {
+        m_page_hashes[pages[i]] = hashes[i];
+    }
+    m_full_next = false;
+    m_segment_bytes = bytes;
+    m_last_page_count = pages.size();
+    m_sequence++;
+
+    // A new chain replaces any older one with the prefix, so remove the files that followed its first.
+    for (uint64_t sequence = 1; m_sequence == 1 && remove((m_path_prefix + "." + std::to_string(sequence)).c_str()) == 0; sequence++) {
+    }
+    return true;
+}
+
+inline std::size_t GenericSharedMemoryCheckpointer::restore(const std::string &path_prefix, void *address, std::size_t bytes)
+{
+    // Check the whole chain before writing to the segment, so a damaged file never leaves it partially restored.
+    const std::size_t file_count = replay(path_prefix, nullptr, bytes);
+    if (file_count == 0 || address == nullptr || replay(path_prefix, (unsigned char *)address, bytes) != file_count) {
+        return 0;
+    }
+    return file_count;
+}
+
+inline std::size_t GenericSharedMemoryCheckpointer::replay(const std::string &path_prefix, unsigned char *segment, std::size_t bytes)
+{
+    std::size_t file_count = 0;
+
+    // Replay the files in order until the chain ends.
+    uint64_t chain_id = 0;
+    for (;; file_count++) {
+        FILE *file = fopen((path_prefix + "." + std::to_string(file_count)).c_str(), "rb");
+        if (file == nullptr) {
+            break;
+        }
+        GenericSharedMemoryCheckpointHeader header;
+        bool valid = fread(&header, sizeof(header), 1, file) == 1 && memcmp(header.magic, "GSMMCKPT", 8) == 0;
+        // A file left by a different chain ends the chain, whatever the size of its segment.
+        if (valid && file_count != 0 && header.chain_id != chain_id) {
+            fclose(file);
+            break;
+        }
+        valid = valid && header.sequence == file_count && header.segment_bytes == bytes && header.page_size != 0;
+        chain_id = header.chain_id;
+        std::vector<unsigned char> page(valid ? header.page_size : 0);
+        for (uint64_t i = 0; valid && i < header.page_count; i++) {
+            uint64_t page_index;
+            valid = fread(&page_index, sizeof(page_index), 1, file) == 1 && fread(page.data(), page.size(), 1, file) == 1 &&
+                    page_index * header.page_size < bytes;
+            if (valid && segment != nullptr) {
+                const std::size_t offset = page_index * header.page_size;
+                memcpy(segment + offset, page.data(), std::min<std::size_t>(header.page_size, bytes - offset));
+            }
+        }
+        fclose(file);
+        if (!valid) {
+            return 0;
+        }
+    }
+    return file_count;
+}
+
+inline bool GenericSharedMemoryCheckpointer::clear_soft_dirty()
+{
+#ifdef __linux__
+    // Writing 4 to clear_refs clears the soft-dirty bits of every page of the process.
+    int clear_refs = open("/proc/self/clear_refs", O_WRONLY);
+    if (clear_refs < 0) {
+        return false;
+    }
+    const bool cleared = write(clear_refs, "4", 1) == 1;
+    close(clear_refs);
+    return cleared;
+#else
+    return false;
+#endif
+}
+
+inline bool GenericSharedMemoryCheckpointer::find_soft_dirty(const void *address, std::size_t page_count, std::vector<uint64_t> &pages)
+{
+#ifdef __linux__
+    // Each page has a 64-bit entry in pagemap, with the soft-dirty flag in bit 55.
+    int pagemap = open("/proc/self/pagemap", O_RDONLY);
+    if (pagemap < 0) {
+        return false;
+    }
+    std::vector<uint64_t> entries(page_count);
+    const off_t offset = (off_t)(((uintptr_t)address / m_page_size) * sizeof(uint64_t));
+    const bool found = pread(pagemap, entries.data(), entries.size() * sizeof(uint64_t), offset) == (ssize_t)(entries.size() * sizeof(uint64_t));
+    close(pagemap);
+    for (std::size_t page = 0; found && page < page_count; page++) {
+        if ((entries[page] >> 55) & 1) {
+            pages.push_back(page);
+        }
+    }
+    return found;
+#else
+    (void)address;
+    (void)page_count;
+    (void)pages;
+    return false;
+#endif
+}
+
+inline bool GenericSharedMemoryCheckpointer::soft_dirty_supported()
+{
+    static std::once_flag checked;
+    static bool supported = false;
+    std::call_once(checked, []() {
+#ifdef __linux__
+        // Check that a page written after the bits are cleared is reported as soft-dirty.
+        const std::size_t page_size = generic_shared_memory_page_size();
+        volatile unsigned char *probe = (volatile unsigned char *)mmap(NULL, page_size, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+        if (probe == MAP_FAILED) {
+            return;
+        }
+        probe[0] = 1;
+        if (clear_soft_dirty()) {
+            probe[0] = 2;
+            GenericSharedMemoryCheckpointer checkpointer("");
+            std::vector<uint64_t> pages;
+            supported = checkpointer.find_soft_dirty((const void *)probe, 1, pages) && pages.size() == 1;
+        }
+        munmap((void *)probe, page_size);
+#endif
+    });
+    return supported;
+}
+
+#endif /* GENERIC_SHARED_MEMORY_CHECKPOINT_H */
@@ -0,0 +1,464 @@
+/**
+ * 	@file		GenericSharedMemoryChecksum.hpp
+ *	@brief		Definition of CRC32C checksums and checksummed segment layouts.
+ *	@details	This header file defines a CRC32C function which uses the SSE4.2 or ARMv8 CRC32
+				instructions when the processor has them, falling back to a table driven
+				implementation otherwise, and two wrappers that store a checksum alongside the payload
+				of a segment. The payload is published and sealed together under a sequence lock,
+				through GenericSharedMemoryChecksumModel, and readers and replicators verify it to
+				detect writes that bypassed the model. The chunked wrapper
+				keeps a checksum per chunk of a large payload, so a write only needs to reseal the
+				chunks it modified and corruption can be located.
+ *	@author		James Horner
+ */
+
+#ifndef GENERIC_SHARED_MEMORY_CHECKSUM_H
+#define GENERIC_SHARED_MEMORY_CHECKSUM_H
+
+// C++ Standard Library Headers
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <mutex>
+#include <string>
+#include <thread>
+
+// Platform Dependant System Libraries
+#if defined(__x86_64__) || defined(_M_X64)
+#define GENERIC_SHARED_MEMORY_CRC32C_SSE42
+#include <nmmintrin.h>
+#ifdef _MSC_VER
+#include <intrin.h>
+#endif
+#elif defined(__aarch64__) && (defined(__ARM_FEATURE_CRC32) || (defined(__linux__) && defined(__GNUC__)))
+#define GENERIC_SHARED_MEMORY_CRC32C_ARM
+#include <arm_acle.h>
+#ifndef __ARM_FEATURE_CRC32
+#include <sys/auxv.h>    // Needed for getauxval()
+#include <asm/hwcap.h>   // Needed for HWCAP_CRC32
+#endif
+#endif
+
+// Library Headers
+#include "GenericSharedMemoryModel.hpp"
+
+#if defined(__GNUC__) && defined(GENERIC_SHARED_MEMORY_CRC32C_SSE42)
+#define GENERIC_SHARED_MEMORY_CRC32C_TARGET __attribute__((target("sse4.2")))
+#elif defined(__GNUC__) && defined(GENERIC_SHARED_MEMORY_CRC32C_ARM) && !defined(__ARM_FEATURE_CRC32)
+#define GENERIC_SHARED_MEMORY_CRC32C_TARGET __attribute__((target("+crc")))
+#else
+#define GENERIC_SHARED_MEMORY_CRC32C_TARGET
+#endif
+
+/// Namespace generic_shared_memory_crc32c_detail holds the implementations selected between by generic_shared_memory_crc32c().
+namespace generic_shared_memory_crc32c_detail {
+    /// Struct tables holds the tables for the slicing-by-8 software implementation, generated at compile time.
+    struct tables {
+        uint32_t entries[8][256];
+
+        constexpr tables() : entries() {
+            // Reflected CRC32C (Castagnoli) polynomial.
+            for (uint32_t byte = 0; byte < 256; byte++) {
+                uint32_t crc = byte;
+                for (int bit = 0; bit < 8; bit++) {
+                    crc = (crc >> 1) ^ (0x82F63B78u & (0u - (crc & 1)));
+                }
+                entries[0][byte] = crc;
+            }
+            for (uint32_t byte = 0; byte < 256; byte++) {
+                for (int slice = 1; slice < 8; slice++) {
+                    entries[slice][byte] = (entries[slice - 1][byte] >> 8) ^ entries[0][entries[slice - 1][byte] & 0xFF];
+                }
+            }
+        }
+    };
+
+    inline constexpr tables s_tables;
+
+    /// Function software() computes the CRC32C of a buffer eight bytes at a time using lookup tables.
+    inline uint32_t software(const unsigned char *bytes, std::size_t size, uint32_t crc) {
+        const auto &table = s_tables.entries;
+        for (; size >= 8; size -= 8, bytes += 8) {
+            uint32_t low, high;
+            memcpy(&low, bytes, 4);
+            memcpy(&high, bytes + 4, 4);
+            low ^= crc;
+            crc = table[7][low & 0xFF] ^ table[6][(low >> 8) & 0xFF] ^ table[5][(low >> 16) & 0xFF] ^ table[4][low >> 24] ^
+                  table[3][high & 0xFF] ^ table[2][(high >> 8) & 0xFF] ^ table[1][(high >> 16) & 0xFF] ^ table[0][high >> 24];
+        }
+        for (; size > 0; size--, bytes++) {
+            crc = (crc >> 8) ^ table[0][(crc ^ *bytes) & 0xFF];
+        }
+        return crc;
+    }
+
+#if defined(GENERIC_SHARED_MEMORY_CRC32C_SSE42)
+    /// Function hardware() computes the CRC32C of a buffer eight bytes at a time using the SSE4.2 crc32 instruction.
+    GENERIC_SHARED_MEMORY_CRC32C_TARGET inline uint32_t hardware(const unsigned char *bytes, std::size_t size, uint32_t crc) {
+        uint64_t crc64 = crc;
+        for (; size >= 8; size -= 8, bytes += 8) {
+            uint64_t word;
+            memcpy(&word, bytes, 8);
+            crc64 = _mm_crc32_u64(crc64, word);
+        }
+        crc = (uint32_t)crc64;
+        for (; size > 0; size--, bytes++) {
+            crc = _mm_crc32_u8(crc, *bytes);
+        }
+        return crc;
+    }
+
+    /// Function hardware_supported() returns true if the processor has the SSE4.2 crc32 instruction.
+    inline bool hardware_supported() {
+#ifdef _MSC_VER
+        int registers[4];
+        __cpuid(registers, 1);
+        return (registers[2] & (1 << 20)) != 0;
+#else
+        return __builtin_cpu_supports("sse4.2");
+#endif
+    }
+#elif defined(GENERIC_SHARED_MEMORY_CRC32C_ARM)
+    /// Function hardware() computes the CRC32C of a buffer eight bytes at a time using the ARMv8 crc32c instructions.
+    GENERIC_SHARED_MEMORY_CRC32C_TARGET inline uint32_t hardware(const unsigned char *bytes, std::size_t size, uint32_t crc) {
+        for (; size >= 8; size -= 8, bytes += 8) {
+            uint64_t word;
+            memcpy(&word, bytes, 8);
+            crc = __crc32cd(crc, word);
+        }
+        for (; size > 0; size--, bytes++) {
+            crc = __crc32cb(crc, *bytes);
+        }
+        return crc;
+    }
+
+    /// Function hardware_supported() returns true if the processor has the ARMv8 crc32c instructions.
+    inline bool hardware_supported() {
+#ifdef __ARM_FEATURE_CRC32
+        return true;
+#else
+        return (getauxval(AT_HWCAP) & HWCAP_CRC32) != 0;
+#endif
+    }
+#endif
+}
+
+/**
+ * @brief Function generic_shared_memory_crc32c() is used to compute the CRC32C checksum of a buffer.
+ * @param data start of the buffer.
+ * @param size size of the buffer in bytes.
+ * @param crc checksum of the preceding data, to continue a checksum across several buffers.
+ * @returns CRC32C checksum of the data.
+ */
+inline uint32_t generic_shared_memory_crc32c(const void *data, std::size_t size, uint32_t crc = 0)
+{
+    const unsigned char *bytes = (const unsigned char *)data;
+    crc = ~crc;
+#if defined(GENERIC_SHARED_MEMORY_CRC32C_SSE42) || defined(GENERIC_SHARED_MEMORY_CRC32C_ARM)
+    static const bool hardware = generic_shared_memory_crc32c_detail::hardware_supported();
+    if (hardware) {
+        return ~generic_shared_memory_crc32c_detail::hardware(bytes, size, crc);
+    }
+#endif
+    return ~generic_shared_memory_crc32c_detail::software(bytes, size, crc);
+}
+
+/// Function generic_shared_memory_crc32c_hardware() returns true if generic_shared_memory_crc32c() uses CRC instructions.
+inline bool generic_shared_memory_crc32c_hardware()
+{
+#if defined(GENERIC_SHARED_MEMORY_CRC32C_SSE42) || defined(GENERIC_SHARED_MEMORY_CRC32C_ARM)
+    return generic_shared_memory_crc32c_detail::hardware_supported();
+#else
+    return false;
+#endif
+}
+
+/// Namespace generic_shared_memory_checksum_detail holds the sequence lock shared by the checksummed layouts.
+namespace generic_shared_memory_checksum_detail {
+    /// Function lock() takes a sequence lock by making it odd, which excludes other writers, returning the odd sequence.
+    inline uint32_t lock(std::atomic<uint32_t> &sequence) {
+        uint32_t current = sequence.load(std::memory_order_relaxed);
+        while ((current & 1) || !sequence.compare_exchange_weak(current, current + 1, std::memory_order_acquire)) {
+            if (current & 1) {
+                std::this_thread::yield();
+                current = sequence.load(std::memory_order_relaxed);
+            }
+        }
+        std::atomic_thread_fence(std::memory_order_release);
+        return current + 1;
+    }
+
+    /// Function unlock() releases a sequence lock taken by lock() with the next even sequence.
+    inline void unlock(std::atomic<uint32_t> &sequence, uint32_t locked) {
+        sequence.store(locked + 1, std::memory_order_release);
+    }
+
+    /// Function read() calls a reader until it runs without a write starting or finishing during it, returning its result.
+    template<typename Reader>
+    auto read(const std::atomic<uint32_t> &sequence, Reader reader) {
+        for (;;) {
+            const uint32_t before = sequence.load(std::memory_order_acquire);
+            if (before & 1) {
+                std::this_thread::yield();
+                continue;
+            }
+            auto result = reader();
+            std::atomic_thread_fence(std::memory_order_acquire);
+            if (sequence.load(std::memory_order_relaxed) == before) {
+                return result;
+            }
+        }
+    }
+}
+
+/**
+ * @brief 	Struct GenericSharedMemoryChecksummed is a segment layout holding a payload and its CRC32C checksum.
+ * @details Use it through a GenericSharedMemoryChecksumModel, whose write_data() publishes and seals the payload, and verify()
+ * 			it before trusting it. The checksum and payload are guarded by a sequence lock, so verify() retries instead of 
+ * 			reporting a payload that is being published as corrupt. Writers that modify the payload in place must seal() it 
+ * 			afterwards, and may be reported as corrupt by readers in between. The checksum is stored in a header before the 
+ * 			payload so it can be replicated along with it.
+ * @param 	T datatype of the payload.
+ */
+template<typename T>
+struct GenericSharedMemoryChecksummed {
+    /// Datatype of the payload.
+    using payload_t = T;
+
+    /// Sequence lock of the checksum and payload, odd while either is written.
+    std::atomic<uint32_t> sequence;
+    /// CRC32C checksum of the payload as of the last seal.
+    uint32_t checksum;
+    /// Payload of the segment.
+    T payload;
+
+    /// Function publish() writes a new payload and seals it, under the sequence lock.
+    void publish(const T &value) {
+        const uint32_t locked = generic_shared_memory_checksum_detail::lock(sequence);
+        memcpy((void *)&payload, &value, sizeof(T));
+        checksum = generic_shared_memory_crc32c(&payload, sizeof(T));
+        generic_shared_memory_checksum_detail::unlock(sequence, locked);
+    }
+
+    /// Function seal() updates the checksum to match the payload, under the sequence lock.
+    void seal() {
+        const uint32_t locked = generic_shared_memory_checksum_detail::lock(sequence);
+        checksum = generic_shared_memory_crc32c(&payload, sizeof(T));
+        generic_shared_memory_checksum_detail::unlock(sequence, locked);
+    }
+
+    /// Function load() returns a copy of the payload made without a publish overlapping it.
+    T load() const {
+        return generic_shared_memory_checksum_detail::read(sequence, [this]() {
+            T value;
+            memcpy((void *)&value, &payload, sizeof(T));
+            return value;
+        });
+    }
+
+    /// Function verify() returns true if the payload matches its checksum.
+    bool verify() const {
+        return generic_shared_memory_checksum_detail::read(sequence, [this]() {
+            return checksum == generic_shared_memory_crc32c(&payload, sizeof(T));
+        });
+    }
+};
+
+/**
+ * @brief 	Struct GenericSharedMemoryChunkChecksummed is a segment layout holding a large payload and a checksum per chunk.
+ * @details A writer that modifies part of the payload publishes it with publish_range(), which only reseals the chunks it 
+ * 			touched, and readers can verify the whole payload, a single chunk or find the first corrupt chunk. As with 
+ * 			GenericSharedMemoryChecksummed, the checksums and payload are guarded by a sequence lock.
+ * @param 	T datatype of the payload.
+ * @param 	ChunkBytes size of each chunk in bytes.
+ */
+template<typename T, std::size_t ChunkBytes = 65536>
+struct GenericSharedMemoryChunkChecksummed {
+    static_assert(ChunkBytes > 0, "ChunkBytes must not be zero.");
+
+    /// Datatype of the payload.
+    using payload_t = T;
+
+    /// Number of chunks the payload is divided into.
+    static constexpr std::size_t chunk_count = (sizeof(T) + ChunkBytes - 1) / ChunkBytes;
+
+    /// Sequence lock of the checksums and payload, odd while either is written.
+    std::atomic<uint32_t> sequence;
+    /// CRC32C checksums of each chunk of the payload as of the last seal.
+    uint32_t checksums[chunk_count];
+    /// Payload of the segment.
+    T payload;
+
+    /// Function publish() writes a new payload and seals every chunk, under the sequence lock.
+    void publish(const T &value) {
+        publish_range(0, &value, sizeof(T));
+    }
+
+    /**
+     * @brief Function publish_range() writes a range of the payload and reseals the chunks it overlaps, under the sequence lock.
+     * @param offset offset of the range from the start of the payload.
+     * @param source bytes to write to the range.
+     * @param size size of the range in bytes, which is clipped to the payload.
+     */
+    void publish_range(std::size_t offset, const void *source, std::size_t size) {
+        if (offset >= sizeof(T)) {
+            return;
+        }
+        size = size < sizeof(T) - offset ? size : sizeof(T) - offset;
+        const uint32_t locked = generic_shared_memory_checksum_detail::lock(sequence);
+        memcpy((unsigned char *)&payload + offset, source, size);
+        seal_range_locked(offset, size);
+        generic_shared_memory_checksum_detail::unlock(sequence, locked);
+    }
+
+    /// Function seal() updates the checksums of every chunk to match the payload.
+    void seal() {
+        seal_range(0, sizeof(T));
+    }
+
+    /**
+     * @brief Function seal_range() updates the checksums of the chunks overlapping a range of the payload, under the sequence lock.
+     * @param offset offset of the range from the start of the payload.
+     * @param size size of the range in bytes.
+     */
+    void seal_range(std::size_t offset, std::size_t size) {
+        const uint32_t locked = generic_shared_memory_checksum_detail::lock(sequence);
+        seal_range_locked(offset, size);
+        generic_shared_memory_checksum_detail::unlock(sequence, locked);
+    }
+
+    /// Function load() returns a copy of the payload made without a publish overlapping it.
+    T load() const {
+        return generic_shared_memory_checksum_detail::read(sequence, [this]() {
+            T value;
+            memcpy((void *)&value, &payload, sizeof(T));
+            return value;
+        });
+    }
+
+    /// Function verify_chunk() returns true if a chunk of the payload matches its checksum.
+    bool verify_chunk(std::size_t chunk) const {
+        return chunk < chunk_count && generic_shared_memory_checksum_detail::read(sequence, [this, chunk]() {
+            return checksums[chunk] == chunk_checksum(chunk);
+        });
+    }
+
+    /// Function verify() returns true if every chunk of the payload matches its checksum.
+    bool verify() const {
+        return find_corrupt_chunk() == chunk_count;
+    }
+
+    /// Function find_corrupt_chunk() returns the index of the first chunk not matching its checksum, or chunk_count if none.
+    std::size_t find_corrupt_chunk() const {
+        return generic_shared_memory_checksum_detail::read(sequence, [this]() {
+            std::size_t chunk = 0;
+            while (chunk < chunk_count && checksums[chunk] == chunk_checksum(chunk)) {
+                chunk++;
+            }
+            return chunk;
+        });
+    }
+
+private:
+    /// Function seal_range_locked() updates the checksums of the chunks overlapping a range, the sequence lock must be held.
+    void seal_range_locked(std::size_t offset, std::size_t size) {
+        if (size == 0 || offset >= sizeof(T)) {
+            return;
+        }
+        const std::size_t last_chunk = (offset + size - 1 < sizeof(T) ? offset + size - 1 : sizeof(T) - 1) / ChunkBytes;
+        for (std::size_t chunk = offset / ChunkBytes; chunk <= last_chunk; chunk++) {
+            checksums[chunk] = chunk_checksum(chunk);
+        }
+    }
+
+    /// Function chunk_checksum() computes the checksum of a chunk of the payload.
+    uint32_t chunk_checksum(std::size_t chunk) const {
+        const std::size_t offset = chunk * ChunkBytes;
+        const std::size_t size = sizeof(T) - offset < ChunkBytes ? sizeof(T) - offset : ChunkBytes;
+        return generic_shared_memory_crc32c((const unsigned char *)&payload + offset, size);
+    }
+};
+
+/**
+ * @brief 	Class GenericSharedMemoryChecksumModel is used for management of a connection to a checksummed segment.
+ * @details write_data() publishes the payload and seals it in one step under the layout's sequence lock, so writers using 
+ * 			the model can't leave a segment whose checksum doesn't match, and get_data() and verify() never see a 
+ * 			half published payload.
+ * @param 	Layout checksummed segment layout, GenericSharedMemoryChecksummed or GenericSharedMemoryChunkChecksummed.
+ */
+template<typename Layout>
+class GenericSharedMemoryChecksumModel {
+public:
+    /// Datatype of the payload.
+    using payload_t = typename Layout::payload_t;
+
+    /// Constructor for the GenericSharedMemoryChecksumModel class that initialises members, but does not connect shared memory.
+    GenericSharedMemoryChecksumModel(const std::string name, const bool log_warnings = false) :
+        m_model(name, log_warnings)
+    {
+    }
+
+    /// Function connect() is used to connect the model, returning true if it is connected.
+    bool connect() {
+        return m_model.connect();
+    }
+
+    /// Function disconnect() is used to disconnect the model.
+    bool disconnect() {
+        return m_model.disconnect();
+    }
+
+    /// Function is_connected() returns true if the model is connected.
+    bool is_connected() {
+        return m_model.is_connected();
+    }
+
+    /**
+     * @brief Function write_data() is used to publish a new payload and seal it.
+     * @param new_value payload to be written.
+     * @returns Boolean true when the payload was written, false if the model is not connected.
+     */
+    bool write_data(const payload_t &new_value) {
+        std::scoped_lock<GenericSharedMemoryModel<Layout>> model_guard(m_model);
+        if (m_model.data == nullptr) {
+            return false;
+        }
+        m_model.data->publish(new_value);
+        return true;
+    }
+
+    /**
+     * @brief Function write_range() is used to publish a range of the payload, resealing only the chunks it overlaps.
+     * @param offset offset of the range from the start of the payload.
+     * @param source bytes to write to the range.
+     * @param size size of the range in bytes.
+     * @returns Boolean true when the range was written, false if the model is not connected.
+     */
+    bool write_range(std::size_t offset, const void *source, std::size_t size) requires requires (Layout &layout) { layout.publish_range(0, nullptr, 0); } {
+        std::scoped_lock<GenericSharedMemoryModel<Layout>> model_guard(m_model);
+        if (m_model.data == nullptr) {
+            return false;
+        }
+        m_model.data->publish_range(offset, source, size);
+        return true;
+    }
+
+    /// Function get_data() returns a consistent copy of the payload, or a value initialised payload if the model is not connected.
+    payload_t get_data() {
+        std::scoped_lock<GenericSharedMemoryModel<Layout>> model_guard(m_model);
+        return m_model.data != nullptr ? m_model.data->load() : payload_t{};
+    }
+
+    /// Function verify() returns true if the payload matches its checksum, false if it is corrupt or the model is not connected.
+    bool verify() {
+        std::scoped_lock<GenericSharedMemoryModel<Layout>> model_guard(m_model);
+        return m_model.data != nullptr && m_model.data->verify();
+    }
+
+private:
+    /// Model for the shared memory segment holding the layout.
+    GenericSharedMemoryModel<Layout> m_model;
+};
+
+#endif /* GENERIC_SHARED_MEMORY_CHECKSUM_H */
@@ -0,0 +1,242 @@
+/**
+ * 	@file		GenericSharedMemoryColumns.hpp
+ *	@brief		Definition of the GenericSharedMemoryColumns class.
+ *	@details	This header file defines a structure of arrays segment, which stores each reflected field
+				of a record type in its own contiguous column aligned to a cache line. Scans over one
+				field then read memory sequentially and vectorise, rather than striding over whole
+				records. Rows can still be read and written as records, columns are available as spans
+				for bulk access, and the columns can be exported to Arrow in place.
+ *	@author		James Horner
+ */
+
+#ifndef GENERIC_SHARED_MEMORY_COLUMNS_H
+#define GENERIC_SHARED_MEMORY_COLUMNS_H
+
+// C++ Standard Library Headers
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <mutex>
+#include <span>
+#include <string>
+#include <type_traits>
+
+// Library Headers
+#include "GenericSharedMemoryArrow.hpp"
+#include "GenericSharedMemoryModel.hpp"
+#include "GenericSharedMemoryReflection.hpp"
+
+/// Alignment, in bytes, of each column of a structure of arrays segment.
+#define GENERIC_SHARED_MEMORY_COLUMN_ALIGNMENT 64
+
+/// Struct GenericSharedMemoryColumnLayout is the structure mapped to a structure of arrays segment.
+template<std::size_t Bytes>
+struct GenericSharedMemoryColumnLayout {
+    /// Number of rows in use.
+    uint64_t size;
+    /// Storage of the columns, each starting on a cache line.
+    alignas(GENERIC_SHARED_MEMORY_COLUMN_ALIGNMENT) unsigned char columns[Bytes];
+};
+
+/**
+ * @brief 	Class GenericSharedMemoryColumns is used for management of a connection to a structure of arrays segment.
+ * @details Row functions and size changes hold the model's mutex, like get_data() and write_data() of the model, so they
+ * 			are consistent within a process. Columns are spans over the mapping, for which callers coordinate access
+ * 			themselves, as with the data pointer of the model.
+ * @param 	Record reflectable record type, whose fields become the columns.
+ * @param 	Capacity maximum number of rows.
+ */
+template<typename Record, std::size_t Capacity>
+class GenericSharedMemoryColumns {
+    static_assert(std::is_trivially_copyable_v<Record>, "Records must be trivially copyable.");
+    static_assert(Capacity > 0, "A structure of arrays segment needs a capacity of at least one row.");
+
+    using reflection_t = GenericSharedMemoryReflection<Record>;
+
+public:
+    /// Number of columns, one per field of the record type.
+    static constexpr std::size_t column_count = reflection_t::field_count;
+
+    /// Type of the values of a column.
+    template<std::size_t Index>
+    using column_type = typename reflection_t::template field_type<Index>;
+
+private:
+    /// Function make_offsets() computes the offset of each column, and of the end of the last one, in the storage.
+    static constexpr std::array<std::size_t, column_count + 1> make_offsets() {
+        std::array<std::size_t, column_count + 1> offsets = {};
+        std::size_t end = 0;
+        for (std::size_t index = 0; index < column_count; index++) {
+            offsets[index] = (end + GENERIC_SHARED_MEMORY_COLUMN_ALIGNMENT - 1) / GENERIC_SHARED_MEMORY_COLUMN_ALIGNMENT * GENERIC_SHARED_MEMORY_COLUMN_ALIGNMENT;
+            end = offsets[index] + Capacity * reflection_t::fields[index].size;
+        }
+        offsets[column_count] = (end + GENERIC_SHARED_MEMORY_COLUMN_ALIGNMENT - 1) / GENERIC_SHARED_MEMORY_COLUMN_ALIGNMENT * GENERIC_SHARED_MEMORY_COLUMN_ALIGNMENT;
+        return offsets;
+    }
+
+public:
+    /// Offsets of the columns in the storage of the segment.
+    static constexpr std::array<std::size_t, column_count + 1> column_offsets = make_offsets();
+
+    /// Type of the structure mapped to the segment.
+    using layout_t = GenericSharedMemoryColumnLayout<column_offsets[column_count]>;
+
+    /// Constructor for the GenericSharedMemoryColumns class that initialises members, but does not connect shared memory.
+    GenericSharedMemoryColumns(const std::string name, const bool log_warnings = false) :
+        m_model(name, log_warnings)
+    {
+    }
+
+    /**
+     * @brief Function connect() is used to connect to the shared memory segment.
+     * @returns Boolean true when the shared memory segment was successfully connected, false otherwise.
+     */
+    bool connect() {
+        return m_model.connect();
+    }
+
+    /**
+     * @brief Function disconnect() is used to disconnect from the shared memory segment.
+     * @returns Boolean true when the shared memory segment was successfully disconnected, false otherwise.
+     */
+    bool disconnect() {
+        return m_model.disconnect();
+    }
+
+    /**
+     * @brief Function is_connected() is used to check if the segment is connected.
+     * @returns Boolean true when the shared memory is connected, false otherwise.
+     */
+    bool is_connected() {
+        return m_model.is_connected();
+    }
+
+    /// Function size() returns the number of rows in use, or 0 if the segment is not connected.
+    std::size_t size() {
+        std::scoped_lock<GenericSharedMemoryModel<layout_t>> guard(m_model);
+        return m_model.data != nullptr ? clamp(m_model.data->size) : 0;
+    }
+
+    /// Function capacity() returns the maximum number of rows.
+    static constexpr std::size_t capacity() {
+        return Capacity;
+    }
+
+    /**
+     * @brief Function resize() is used to change the number of rows in use, leaving the values of new rows as they were.
+     * @param size new number of rows.
+     * @returns Boolean true when the rows were resized, false if size is over the capacity or the segment is not connected.
+     */
+    bool resize(std::size_t size) {
+        std::scoped_lock<GenericSharedMemoryModel<layout_t>> guard(m_model);
+        if (m_model.data == nullptr || size > Capacity) {
+            return false;
+        }
+        m_model.data->size = size;
+        return true;
+    }
+
+    /// Function clear() removes every row.
+    void clear() {
+        resize(0);
+    }
+
+    /**
+     * @brief Function push_back() is used to append a row.
+     * @param record values of the row.
+     * @returns Boolean true when the row was appended, false if the segment is full or not connected.
+     */
+    bool push_back(const Record &record) {
+        std::scoped_lock<GenericSharedMemoryModel<layout_t>> guard(m_model);
+        if (m_model.data == nullptr || m_model.data->size >= Capacity) {
+            return false;
+        }
+        store(m_model.data, m_model.data->size, record);
+        m_model.data->size++;
+        return true;
+    }
+
+    /**
+     * @brief Function get_row() is used to gather a row into a record.
+     * @param row position of the row.
+     * @returns Values of the row, or a value initialised record if the row is not in use or the segment is not connected.
+     */
+    Record get_row(std::size_t row) {
+        Record record{};
+        std::scoped_lock<GenericSharedMemoryModel<layout_t>> guard(m_model);
+        layout_t *layout = m_model.data;
+        if (layout != nullptr && row < clamp(layout->size)) {
+            reflection_t::for_each(record, [&](const GenericSharedMemoryField &field, auto &value) {
+                memcpy(&value, layout->columns + column_offsets[field.index] + row * field.size, field.size);
+            });
+        }
+        return record;
+    }
+
+    /**
+     * @brief Function set_row() is used to scatter a record into a row.
+     * @param row position of the row, which must be in use.
+     * @param record values of the row.
+     * @returns Boolean true when the row was written, false if the row is not in use or the segment is not connected.
+     */
+    bool set_row(std::size_t row, const Record &record) {
+        std::scoped_lock<GenericSharedMemoryModel<layout_t>> guard(m_model);
+        if (m_model.data == nullptr || row >= clamp(m_model.data->size)) {
+            return false;
+        }
+        store(m_model.data, row, record);
+        return true;
+    }
+
+    /// Function column() returns a span over the rows in use of a column, which is empty if the segment is not connected.
+    template<std::size_t Index>
+    std::span<column_type<Index>> column() {
+        std::scoped_lock<GenericSharedMemoryModel<layout_t>> guard(m_model);
+        layout_t *layout = m_model.data;
+        if (layout == nullptr) {
+            return {};
+        }
+        return std::span<column_type<Index>>((column_type<Index> *)(layout->columns + column_offsets[Index]), clamp(layout->size));
+    }
+
+    /**
+     * @brief Function export_arrow() is used to export the rows in use through the Arrow C Data Interface, in place.
+     * @details The exported columns view the mapping, so the exported rows should not be written, and the segment must
+     * 			stay connected, until the array is released.
+     * @param schema schema to fill in.
+     * @param array array to fill in.
+     * @returns Boolean true when the rows were exported, false if the segment is not connected or a field is not exportable.
+     */
+    bool export_arrow(ArrowSchema *schema, ArrowArray *array) {
+        std::scoped_lock<GenericSharedMemoryModel<layout_t>> guard(m_model);
+        layout_t *layout = m_model.data;
+        if (layout == nullptr) {
+            return false;
+        }
+        std::array<const void *, column_count> columns;
+        for (std::size_t index = 0; index < column_count; index++) {
+            columns[index] = layout->columns + column_offsets[index];
+        }
+        return GenericSharedMemoryArrow::export_columns(columns.data(), clamp(layout->size), reflection_t::fields.data(),
+                                                        column_count, nullptr, schema, array);
+    }
+
+private:
+    /// Function clamp() bounds a size read from the segment by the capacity, in case the segment was corrupted.
+    static std::size_t clamp(uint64_t size) {
+        return size < Capacity ? (std::size_t)size : Capacity;
+    }
+
+    /// Function store() scatters a record into a row of the columns.
+    static void store(layout_t *layout, std::size_t row, const Record &record) {
+        reflection_t::for_each(record, [&](const GenericSharedMemoryField &field, const auto &value) {
+            memcpy(layout->columns + column_offsets[field.index] + row * field.size, &value, field.size);
+        });
+    }
+
+    /// Model for the shared memory segment.
+    GenericSharedMemoryModel<layout_t> m_model;
+};
+
+#endif /* GENERIC_SHARED_MEMORY_COLUMNS_H */
@@ -0,0 +1,254 @@
+/**
+ * 	@file		GenericSharedMemoryComposite.hpp
+ *	@brief		Definition of the GenericSharedMemoryComposite class.
+ *	@details	This header file defines a composite model connecting to one named shared memory
+				segment holding several independent members. Each member is laid out on its own
+				cache lines with its own sequence lock, so a write to one member never invalidates or
+				blocks readers of the others, and readers can wait for a member to be updated through
+				a futex on its sequence. Members are accessed by type with get<T>() and write<T>().
+ *	@author		James Horner
+ */
+
+#ifndef GENERIC_SHARED_MEMORY_COMPOSITE_H
+#define GENERIC_SHARED_MEMORY_COMPOSITE_H
+
+// C++ Standard Library Headers
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <cstring>
+#include <string>
+#include <thread>
+#include <type_traits>
+
+// Library Headers
+#include "GenericSharedMemoryFutex.hpp"
+#include "GenericSharedMemoryModel.hpp"
+
+/// Alignment, in bytes, of each member of a composite segment so that members never share a cache line.
+#define GENERIC_SHARED_MEMORY_COMPOSITE_ALIGNMENT 64
+
+/**
+ * @brief 	Struct GenericSharedMemoryCompositeSlot holds one member of a composite segment.
+ * @details The sequence is even while the member is stable and odd while it is being written, and is incremented twice
+ * 			by every write, so the version of the member is half the sequence. All of the fields are valid when zero.
+ * @param 	T datatype of the member.
+ */
+template<typename T>
+struct alignas(GENERIC_SHARED_MEMORY_COMPOSITE_ALIGNMENT) GenericSharedMemoryCompositeSlot {
+    /// Sequence lock of the member.
+    std::atomic<uint32_t> sequence;
+    /// Number of threads waiting for the member to be written, so writers only wake when someone is waiting.
+    std::atomic<uint32_t> waiters;
+    /// Value of the member.
+    T value;
+};
+
+/// Struct GenericSharedMemoryCompositeLayout is the structure mapped to a composite segment, holding a slot per member in order.
+template<typename... Ts>
+struct GenericSharedMemoryCompositeLayout {};
+
+template<typename T, typename... Rest>
+struct GenericSharedMemoryCompositeLayout<T, Rest...> {
+    /// Slot of the first member.
+    GenericSharedMemoryCompositeSlot<T> first;
+    /// Slots of the remaining members.
+    GenericSharedMemoryCompositeLayout<Rest...> rest;
+};
+
+/**
+ * @brief 	Class GenericSharedMemoryComposite is used for management of a connection to a segment holding several members.
+ * @details Each member is read and written as a whole with a sequence lock, which readers never block: get<T>() copies the
+ * 			member and retries if a write overlapped the copy. Writers of the same member exclude each other, in any process,
+ * 			through the sequence. A writer that dies mid-write leaves its member locked, so members should only be written
+ * 			by processes that are not killed while writing.
+ * @param 	Ts datatypes of the members, which must be distinct and trivially copyable.
+ */
+template<typename... Ts>
+class GenericSharedMemoryComposite {
+    static_assert(sizeof...(Ts) > 0, "A composite segment needs at least one member.");
+    static_assert((std::is_trivially_copyable_v<Ts> && ...), "Members must be trivially copyable.");
+
+public:
+    /// Type of the structure mapped to the composite segment.
+    using layout_t = GenericSharedMemoryCompositeLayout<Ts...>;
+
+    /// Constructor for the GenericSharedMemoryComposite class that initialises members, but does not connect shared memory.
+    GenericSharedMemoryComposite(const std::string name, const bool log_warnings = false) :
+        m_model(name, log_warnings)
+    {
+    }
+
+    /**
+     * @brief Function connect() is used to connect the composite to its shared memory segment.
+     * @returns Boolean true when the shared memory segment was successfully connected, false otherwise.
+     */
+    bool connect() {
+        return m_model.connect();
+    }
+
+    /**
+     * @brief Function disconnect() is used to disconnect the composite from its shared memory segment.
+     * @returns Boolean true when the shared memory segment was successfully disconnected, false otherwise.
+     */
+    bool disconnect() {
+        return m_model.disconnect();
+    }
+
+    /**
+     * @brief Function is_connected() is used to check if the composite is connected.
+     * @returns Boolean true when the shared memory is connected, false otherwise.
+     */
+    bool is_connected() {
+        return m_model.is_connected();
+    }
+
+    /**
+     * @brief Function get() is used to get a consistent snapshot of a member.
+     * @returns Value of the member at the time of the call, or a value initialised T if the composite is not connected.
+     */
+    template<typename T>
+    T get();
+
+    /**
+     * @brief Function write() is used to write a new value of a member, waking any threads waiting for it.
+     * @param new_value value to be written.
+     */
+    template<typename T>
+    void write(const T &new_value);
+
+    /// Function version() returns the number of writes made to a member, or 0 if the composite is not connected.
+    template<typename T>
+    uint32_t version() {
+        GenericSharedMemoryCompositeSlot<T> *member = slot<T>();
+        return member != nullptr ? member->sequence.load(std::memory_order_acquire) >> 1 : 0;
+    }
+
+    /**
+     * @brief Function wait() is used to wait, in any process, for a member to be written.
+     * @param version version of the member to wait to change, as returned by version().
+     * @param timeout_ms time to wait in milliseconds, or -1 to wait indefinitely.
+     * @returns Boolean true when the member's version differs from version, false if the timeout expired or the composite
+     * 			is not connected.
+     */
+    template<typename T>
+    bool wait(uint32_t version, int timeout_ms = -1);
+
+private:
+    /// Function index_of() returns the position of a member's type in Ts.
+    template<typename T>
+    static constexpr std::size_t index_of() {
+        static_assert((std::is_same_v<T, Ts> + ...) == 1, "T must be exactly one of the composite's member types.");
+        std::size_t index = 0;
+        bool found = false;
+        ((found = found || std::is_same_v<T, Ts>, index += found ? 0 : 1), ...);
+        return index;
+    }
+
+    /// Function slot_at() returns the slot at a position of a layout.
+    template<std::size_t Index, typename Layout>
+    static auto &slot_at(Layout &layout) {
+        if constexpr (Index == 0) {
+            return layout.first;
+        }
+        else {
+            return slot_at<Index - 1>(layout.rest);
+        }
+    }
+
+    /// Function slot() returns the slot of a member, or nullptr if the composite is not connected.
+    template<typename T>
+    GenericSharedMemoryCompositeSlot<T> *slot() {
+        layout_t *layout = m_model.data;
+        return layout != nullptr ? &slot_at<index_of<T>()>(*layout) : nullptr;
+    }
+
+    /// Model for the shared memory segment holding the members.
+    GenericSharedMemoryModel<layout_t> m_model;
+};
+
+template<typename... Ts>
+template<typename T>
+T GenericSharedMemoryComposite<Ts...>::get()
+{
+    GenericSharedMemoryCompositeSlot<T> *member = slot<T>();
+    T value{};
+    if (member == nullptr) {
+        return value;
+    }
+
+    // Copy the member until a copy is made without a write starting or finishing during it.
+    for (;;) {
+        const uint32_t sequence = member->sequence.load(std::memory_order_acquire);
+        if (sequence & 1) {
+            std::this_thread::yield();
+            continue;
+        }
+        memcpy(&value, &member->value, sizeof(T));
+        std::atomic_thread_fence(std::memory_order_acquire);
+        if (member->sequence.load(std::memory_order_relaxed) == sequence) {
+            return value;
+        }
+    }
+}
+
+template<typename... Ts>
+template<typename T>
+void GenericSharedMemoryComposite<Ts...>::write(const T &new_value)
+{
+    GenericSharedMemoryCompositeSlot<T> *member = slot<T>();
+    if (member == nullptr) {
+        return;
+    }
+
+    // Take the member by making its sequence odd, which also excludes other writers.
+    uint32_t sequence = member->sequence.load(std::memory_order_relaxed);
+    while ((sequence & 1) || !member->sequence.compare_exchange_weak(sequence, sequence + 1, std::memory_order_acquire)) {
+        if (sequence & 1) {
+            std::this_thread::yield();
+            sequence = member->sequence.load(std::memory_order_relaxed);
+        }
+    }
+    std::atomic_thread_fence(std::memory_order_release);
+    memcpy(&member->value, &new_value, sizeof(T));
+
+    // Release the member with the next even sequence, then wake any waiters.
+    member->sequence.store(sequence + 2, std::memory_order_seq_cst);
+    if (member->waiters.load(std::memory_order_seq_cst) != 0) {
+        generic_shared_memory_futex_wake(&member->sequence);
+    }
+}
+
+template<typename... Ts>
+template<typename T>
+bool GenericSharedMemoryComposite<Ts...>::wait(uint32_t version, int timeout_ms)
+{
+    GenericSharedMemoryCompositeSlot<T> *member = slot<T>();
+    if (member == nullptr) {
+        return false;
+    }
+
+    // Register as a waiter before checking the sequence, so a write after the check is certain to wake this thread.
+    const auto deadline = std::chrono::steady_clock::now() + std::chrono::milliseconds(timeout_ms);
+    member->waiters.fetch_add(1, std::memory_order_seq_cst);
+    bool changed = false;
+    for (;;) {
+        const uint32_t sequence = member->sequence.load(std::memory_order_seq_cst);
+        if ((sequence >> 1) != version) {
+            changed = true;
+            break;
+        }
+        int remaining_ms = -1;
+        if (timeout_ms >= 0) {
+            remaining_ms = (int)std::chrono::duration_cast<std::chrono::milliseconds>(deadline - std::chrono::steady_clock::now()).count();
+            if (remaining_ms <= 0) {
+                break;
+            }
+        }
+        generic_shared_memory_futex_wait(&member->sequence, sequence, remaining_ms);
+    }
+    member->waiters.fetch_sub(1, std::memory_order_relaxed);
+    return changed;
+}
+
+#endif /* GENERIC_SHARED_MEMORY_COMPOSITE_H */
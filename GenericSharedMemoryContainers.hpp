@@ -0,0 +1,219 @@
+/**
+ * 	@file		GenericSharedMemoryContainers.hpp
+ *	@brief		Definition of the GenericSharedMemoryVector and GenericSharedMemoryString containers.
+ *	@details	This header file defines fixed capacity containers that can be stored inline in shared
+				memory segments, as they hold no pointers and never allocate. The containers report
+				their live bytes (their size and used elements) through live_bytes(), so the models
+				copy only the used prefix of a container in get_data() and write_data() rather than
+				its whole capacity.
+ *	@author		James Horner
+ */
+
+#ifndef GENERIC_SHARED_MEMORY_CONTAINERS_H
+#define GENERIC_SHARED_MEMORY_CONTAINERS_H
+
+// C++ Standard Library Headers
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <new>
+#include <string_view>
+#include <type_traits>
+
+/**
+ * @brief 	Class GenericSharedMemoryVector is a vector with a fixed capacity stored inline, for use in shared memory.
+ * @details The elements are stored after the size, so the live bytes of the vector are its size and its first size()
+ * 			elements. Elements past the size are left uninitialised, so creating or copying the vector never touches them.
+ * 			A vector in a newly created (zero filled) segment is empty.
+ * @param 	T datatype of the elements, which must be trivially copyable.
+ * @param 	N capacity of the vector.
+ */
+template<typename T, std::size_t N>
+class GenericSharedMemoryVector {
+    static_assert(std::is_trivially_copyable_v<T>, "Elements must be trivially copyable.");
+    static_assert(N > 0 && N <= UINT32_MAX, "Capacity must be between 1 and UINT32_MAX.");
+
+public:
+    /// Constructor for the GenericSharedMemoryVector class that creates an empty vector, leaving the elements uninitialised.
+    GenericSharedMemoryVector() : m_size(0) {}
+
+    /// Function size() returns the number of elements in the vector.
+    std::size_t size() const {
+        return m_size;
+    }
+
+    /// Function capacity() returns the maximum number of elements in the vector.
+    static constexpr std::size_t capacity() {
+        return N;
+    }
+
+    /// Function empty() returns true if the vector has no elements.
+    bool empty() const {
+        return m_size == 0;
+    }
+
+    /// Function full() returns true if the vector is at its capacity.
+    bool full() const {
+        return m_size >= N;
+    }
+
+    /**
+     * @brief Function push_back() is used to append an element to the vector.
+     * @param value element to be appended.
+     * @returns Boolean true when the element was appended, false if the vector is full.
+     */
+    bool push_back(const T &value) {
+        if (m_size >= N) {
+            return false;
+        }
+        memcpy((void*)&data()[m_size], &value, sizeof(T));
+        m_size++;
+        return true;
+    }
+
+    /// Function pop_back() removes the last element of the vector, if there is one.
+    void pop_back() {
+        if (m_size > 0) {
+            m_size--;
+        }
+    }
+
+    /**
+     * @brief Function resize() is used to change the number of elements in the vector.
+     * @param size new number of elements, any new elements are value initialised.
+     * @returns Boolean true when the vector was resized, false if size is over the capacity.
+     */
+    bool resize(std::size_t size) {
+        if (size > N) {
+            return false;
+        }
+        for (std::size_t i = m_size; i < size; i++) {
+            new (&data()[i]) T();
+        }
+        m_size = (uint32_t)size;
+        return true;
+    }
+
+    /// Function clear() removes every element of the vector.
+    void clear() {
+        m_size = 0;
+    }
+
+    /// Function data() returns the elements of the vector.
+    T *data() {
+        return std::launder(reinterpret_cast<T*>(m_storage));
+    }
+    const T *data() const {
+        return std::launder(reinterpret_cast<const T*>(m_storage));
+    }
+
+    /// Operator [] returns an element of the vector, which must be below size().
+    T &operator[](std::size_t index) {
+        return data()[index];
+    }
+    const T &operator[](std::size_t index) const {
+        return data()[index];
+    }
+
+    /// Functions begin() and end() return iterators over the elements of the vector.
+    T *begin() {
+        return data();
+    }
+    T *end() {
+        return data() + size();
+    }
+    const T *begin() const {
+        return data();
+    }
+    const T *end() const {
+        return data() + size();
+    }
+
+    /// Function live_bytes() returns the number of leading bytes of the vector in use, which is all the models copy.
+    std::size_t live_bytes() const {
+        return (std::size_t)(m_storage - (const unsigned char *)this) + (std::size_t)(m_size < N ? m_size : N) * sizeof(T);
+    }
+
+private:
+    /// Number of elements in the vector.
+    uint32_t m_size;
+    /// Storage for the elements.
+    alignas(T) unsigned char m_storage[N * sizeof(T)];
+};
+
+/**
+ * @brief 	Class GenericSharedMemoryString is a null terminated string with a fixed capacity stored inline, for use in shared memory.
+ * @details The characters are stored after the length, so the live bytes of the string are its length and its characters
+ * 			including the terminator. A string in a newly created (zero filled) segment is empty.
+ * @param 	N maximum number of characters, not including the terminator.
+ */
+template<std::size_t N>
+class GenericSharedMemoryString {
+    static_assert(N > 0 && N < UINT32_MAX, "Capacity must be between 1 and UINT32_MAX - 1.");
+
+public:
+    /// Constructor for the GenericSharedMemoryString class that creates an empty string, leaving the other characters uninitialised.
+    GenericSharedMemoryString() : m_length(0) {
+        m_characters[0] = '\0';
+    }
+
+    /// Constructor for the GenericSharedMemoryString class that copies a string, truncated to the capacity.
+    GenericSharedMemoryString(std::string_view value) {
+        assign(value);
+    }
+
+    /**
+     * @brief Function assign() is used to replace the contents of the string.
+     * @param value string to be copied, which is truncated to the capacity.
+     * @returns Boolean true when the whole string was copied, false if it was truncated.
+     */
+    bool assign(std::string_view value) {
+        m_length = (uint32_t)(value.size() < N ? value.size() : N);
+        memcpy(m_characters, value.data(), m_length);
+        m_characters[m_length] = '\0';
+        return m_length == value.size();
+    }
+
+    /// Function size() returns the number of characters in the string.
+    std::size_t size() const {
+        return m_length;
+    }
+
+    /// Function capacity() returns the maximum number of characters in the string.
+    static constexpr std::size_t capacity() {
+        return N;
+    }
+
+    /// Function empty() returns true if the string has no characters.
+    bool empty() const {
+        return m_length == 0;
+    }
+
+    /// Function c_str() returns the null terminated characters of the string.
+    const char *c_str() const {
+        return m_characters;
+    }
+
+    /// Function view() returns a view of the characters of the string.
+    std::string_view view() const {
+        return std::string_view(m_characters, m_length < N ? m_length : N);
+    }
+
+    /// Operator == compares the characters of the string.
+    bool operator==(std::string_view other) const {
+        return view() == other;
+    }
+
+    /// Function live_bytes() returns the number of leading bytes of the string in use, which is all the models copy.
+    std::size_t live_bytes() const {
+        return (std::size_t)((const char *)m_characters - (const char *)this) + (std::size_t)(m_length < N ? m_length : N) + 1;
+    }
+
+private:
+    /// Number of characters in the string.
+    uint32_t m_length;
+    /// Characters of the string, followed by a terminator.
+    char m_characters[N + 1];
+};
+
+#endif /* GENERIC_SHARED_MEMORY_CONTAINERS_H */
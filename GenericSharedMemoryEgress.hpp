@@ -0,0 +1,308 @@
+/**
+ * 	@file		GenericSharedMemoryEgress.hpp
+ *	@brief		Definition of the GenericSharedMemoryEgress class.
+ *	@details	This header file defines a class for sending the contents of shared memory segments over
+				stream sockets without copying them into the kernel. Sends use MSG_ZEROCOPY where the
+				kernel supports it, so the kernel reads the data from the pages it was sent from after
+				the send returns, and completions are read from the socket's error queue so the memory
+				is not modified until the kernel is done with it. Segments are snapshotted into a ring
+				of slots which are only reused once their send has completed, so a frame costs one copy
+				rather than one for get_data() and another into the kernel. Only POSIX platforms are
+				supported; without MSG_ZEROCOPY the sends are plain copying sends.
+ *	@author		James Horner
+ */
+
+#ifndef GENERIC_SHARED_MEMORY_EGRESS_H
+#define GENERIC_SHARED_MEMORY_EGRESS_H
+
+// C++ Standard Library Headers
+#include <algorithm>
+#include <cerrno>
+#include <chrono>
+#include <cstdint>
+#include <cstring>
+#include <mutex>
+#include <utility>
+#include <vector>
+
+// Platform Dependant System Libraries
+#include <poll.h>           // Needed for poll()
+#include <sys/mman.h>       // Needed for mmap()
+#include <sys/socket.h>     // Needed for sendmsg() and recvmsg()
+#ifdef __linux__
+#include <linux/errqueue.h> // Needed for sock_extended_err
+#include <netinet/in.h>     // Needed for IPPROTO_IP and IPPROTO_IPV6
+#endif
+#if defined(MSG_ZEROCOPY) && defined(SO_ZEROCOPY) && defined(SO_EE_ORIGIN_ZEROCOPY)
+#define GENERIC_SHARED_MEMORY_EGRESS_ZEROCOPY
+#endif
+
+// Library Headers
+#include "GenericSharedMemoryModel.hpp"
+
+/**
+ * @brief 	Class GenericSharedMemoryEgress is used to send the contents of segments over a stream socket without copying them.
+ * @details Every send is given an identifier, and the memory it was sent from must not be modified until is_complete()
+ * 			returns true for it (or wait() returns true), as the kernel may still read from it. send_snapshot() manages this by
+ * 			copying the segment into the next slot of a ring, waiting for the slot's previous send to complete first, so
+ * 			the segment can be modified as soon as it returns. Sends smaller than the zero copy threshold are copied into
+ * 			the kernel as usual, as the completion tracking costs more than the copy for them.
+ *
+ * 			The class is not thread safe, it should be used by a single thread per socket.
+ */
+class GenericSharedMemoryEgress {
+public:
+    /**
+     * @brief Constructor for the GenericSharedMemoryEgress class that enables zero copy sends on a socket.
+     * @param socket connected stream socket to send on, which is not closed by the class.
+     * @param slot_count number of snapshot slots, so the number of send_snapshot() frames that can be in flight.
+     * @param zerocopy_threshold size in bytes from which sends are made without copying.
+     */
+    GenericSharedMemoryEgress(int socket, std::size_t slot_count = 4, std::size_t zerocopy_threshold = 16384) :
+        m_socket(socket),
+        m_zerocopy_threshold(zerocopy_threshold),
+        m_slots(std::max<std::size_t>(1, slot_count))
+    {
+#ifdef GENERIC_SHARED_MEMORY_EGRESS_ZEROCOPY
+        const int enabled = 1;
+        m_zerocopy = setsockopt(m_socket, SOL_SOCKET, SO_ZEROCOPY, &enabled, sizeof(enabled)) == 0;
+#endif
+    }
+
+    /// Destructor for the GenericSharedMemoryEgress class that waits for the sends from the slots to complete and frees them.
+    ~GenericSharedMemoryEgress() {
+        flush(1000);
+        for (slot_t &slot : m_slots) {
+            if (slot.buffer != nullptr) {
+                munmap(slot.buffer, slot.capacity);
+            }
+        }
+    }
+
+    GenericSharedMemoryEgress(const GenericSharedMemoryEgress &) = delete;
+    GenericSharedMemoryEgress &operator=(const GenericSharedMemoryEgress &) = delete;
+
+    /**
+     * @brief Function send() is used to send a buffer, without copying it where possible.
+     * @param data start of the buffer, which must not be modified until the send has completed.
+     * @param bytes size of the buffer in bytes.
+     * @param send_id set to the identifier of the send, to be passed to is_complete() or wait().
+     * @returns Boolean true when every byte was sent, false if the socket failed.
+     */
+    bool send(const void *data, std::size_t bytes, uint64_t &send_id);
+
+    /**
+     * @brief Function send_snapshot() is used to send a snapshot of a model's segment from the next slot.
+     * @details The segment is copied into the slot while holding the model's lock, and the slot is not reused until the
+     * 			kernel has finished sending from it, so the segment can be modified as soon as the function returns.
+     * @param model connected model to send the segment of.
+     * @returns Boolean true when the snapshot was sent, false if the model is not connected, the slot's previous send
+     * 			could not be waited for or the socket failed.
+     */
+    template<typename T>
+    bool send_snapshot(GenericSharedMemoryModel<T> &model);
+
+    /// Function is_complete() returns true if the kernel has finished with the memory of a send.
+    bool is_complete(uint64_t send_id) {
+        poll_completions();
+        return m_completed_sends >= send_id;
+    }
+
+    /**
+     * @brief Function wait() is used to wait for the kernel to finish with the memory of a send.
+     * @param send_id identifier of the send.
+     * @param timeout_ms time to wait in milliseconds, or -1 to wait indefinitely.
+     * @returns Boolean true when the send has completed, false if the timeout expired first.
+     */
+    bool wait(uint64_t send_id, int timeout_ms = -1);
+
+    /// Function flush() waits, for up to a timeout in milliseconds (or indefinitely for -1), for every send to complete.
+    bool flush(int timeout_ms = -1) {
+        return wait(m_zerocopy_sends, timeout_ms);
+    }
+
+    /// Function poll_completions() reads the completions queued on the socket without blocking, returning how many were read.
+    std::size_t poll_completions();
+
+    /// Function uses_zerocopy() returns true if the socket accepted MSG_ZEROCOPY.
+    bool uses_zerocopy() const {
+        return m_zerocopy;
+    }
+
+    /// Function copied_sends() returns the number of zero copy sends the kernel completed by copying (for example on loopback).
+    uint64_t copied_sends() const {
+        return m_copied_sends;
+    }
+
+private:
+    /// Snapshot slot holding a copy of a segment until its send completes.
+    struct slot_t {
+        /// Page aligned buffer of the slot, mapped on first use.
+        unsigned char *buffer = nullptr;
+        /// Size of the buffer in bytes.
+        std::size_t capacity = 0;
+        /// Identifier of the last send from the slot.
+        uint64_t send_id = 0;
+    };
+
+    /// Socket the data is sent on.
+    int m_socket;
+    /// Size in bytes from which sends are made without copying.
+    std::size_t m_zerocopy_threshold;
+    /// Flag for if the socket accepted MSG_ZEROCOPY.
+    bool m_zerocopy = false;
+    /// Number of sendmsg() calls made with MSG_ZEROCOPY, which the kernel numbers from 0 in its completions.
+    uint64_t m_zerocopy_sends = 0;
+    /// Number of zero copy calls completed in order.
+    uint64_t m_completed_sends = 0;
+    /// Ranges of zero copy calls completed out of order, as first and one past last.
+    std::vector<std::pair<uint64_t, uint64_t>> m_out_of_order;
+    /// Number of zero copy calls the kernel completed by copying.
+    uint64_t m_copied_sends = 0;
+    /// Snapshot slots and the next one to use.
+    std::vector<slot_t> m_slots;
+    std::size_t m_next_slot = 0;
+};
+
+inline bool GenericSharedMemoryEgress::send(const void *data, std::size_t bytes, uint64_t &send_id)
+{
+    const unsigned char *position = (const unsigned char *)data;
+    const bool zerocopy = m_zerocopy && bytes >= m_zerocopy_threshold;
+    while (bytes > 0) {
+        int flags = MSG_NOSIGNAL;
+#ifdef GENERIC_SHARED_MEMORY_EGRESS_ZEROCOPY
+        if (zerocopy) {
+            flags |= MSG_ZEROCOPY;
+        }
+#endif
+        struct iovec io_vector = {(void *)position, bytes};
+        struct msghdr message = {};
+        message.msg_iov = &io_vector;
+        message.msg_iovlen = 1;
+        const ssize_t sent = sendmsg(m_socket, &message, flags);
+        if (sent < 0) {
+            // If the socket is full, or the kernel is out of memory to pin pages with, wait for it to drain.
+            if (errno == EINTR) {
+                continue;
+            }
+            if (errno == EAGAIN || errno == EWOULDBLOCK || errno == ENOBUFS) {
+                struct pollfd poll_socket = {m_socket, POLLOUT, 0};
+                ::poll(&poll_socket, 1, 10);
+                poll_completions();
+                continue;
+            }
+            send_id = m_zerocopy_sends;
+            return false;
+        }
+        // Every successful zero copy call is given the next number by the kernel, even if it sent only part of the data.
+        if (zerocopy) {
+            m_zerocopy_sends++;
+        }
+        position += sent;
+        bytes -= (std::size_t)sent;
+    }
+
+    // A copying send is complete once it returns, which is marked by the calls already completed.
+    send_id = zerocopy ? m_zerocopy_sends : m_completed_sends;
+    return true;
+}
+
+template<typename T>
+bool GenericSharedMemoryEgress::send_snapshot(GenericSharedMemoryModel<T> &model)
+{
+    // Wait for the slot's previous send to complete before reusing it, leaving the slot untouched if the kernel may
+    // still be reading from it.
+    slot_t &slot = m_slots[m_next_slot];
+    if (!wait(slot.send_id)) {
+        return false;
+    }
+    m_next_slot = (m_next_slot + 1) % m_slots.size();
+    if (slot.capacity < sizeof(T)) {
+        if (slot.buffer != nullptr) {
+            munmap(slot.buffer, slot.capacity);
+        }
+        const std::size_t page_size = generic_shared_memory_page_size();
+        const std::size_t capacity = (sizeof(T) + page_size - 1) / page_size * page_size;
+        void *buffer = mmap(NULL, capacity, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+        slot.buffer = buffer != MAP_FAILED ? (unsigned char *)buffer : nullptr;
+        slot.capacity = buffer != MAP_FAILED ? capacity : 0;
+        if (slot.buffer == nullptr) {
+            return false;
+        }
+    }
+    {
+        // The model may be unmapped while idle, so it is checked under its lock, which does not map it again.
+        std::scoped_lock<GenericSharedMemoryModel<T>> model_guard(model);
+        if (model.data == nullptr) {
+            return false;
+        }
+        memcpy(slot.buffer, model.data, sizeof(T));
+    }
+    return send(slot.buffer, sizeof(T), slot.send_id);
+}
+
+inline bool GenericSharedMemoryEgress::wait(uint64_t send_id, int timeout_ms)
+{
+    const auto deadline = std::chrono::steady_clock::now() + std::chrono::milliseconds(timeout_ms);
+    while (!is_complete(send_id)) {
+        int remaining_ms = -1;
+        if (timeout_ms >= 0) {
+            remaining_ms = (int)std::chrono::duration_cast<std::chrono::milliseconds>(deadline - std::chrono::steady_clock::now()).count();
+            if (remaining_ms <= 0) {
+                return false;
+            }
+        }
+        // Completions on the error queue are signalled as POLLERR, which is always polled for.
+        struct pollfd poll_socket = {m_socket, 0, 0};
+        if (::poll(&poll_socket, 1, remaining_ms) < 0 && errno != EINTR) {
+            return false;
+        }
+    }
+    return true;
+}
+
+inline std::size_t GenericSharedMemoryEgress::poll_completions()
+{
+    std::size_t completion_count = 0;
+#ifdef GENERIC_SHARED_MEMORY_EGRESS_ZEROCOPY
+    while (m_completed_sends < m_zerocopy_sends) {
+        // The control buffer holds cmsghdr structures, so it must be aligned for them.
+        alignas(struct cmsghdr) char control[128];
+        struct msghdr message = {};
+        message.msg_control = control;
+        message.msg_controllen = sizeof(control);
+        if (recvmsg(m_socket, &message, MSG_ERRQUEUE | MSG_DONTWAIT) < 0) {
+            break;
+        }
+        for (struct cmsghdr *header = CMSG_FIRSTHDR(&message); header != nullptr; header = CMSG_NXTHDR(&message, header)) {
+            const bool ip_error = (header->cmsg_level == IPPROTO_IP && header->cmsg_type == IP_RECVERR) ||
+                                  (header->cmsg_level == IPPROTO_IPV6 && header->cmsg_type == IPV6_RECVERR);
+            struct sock_extended_err error;
+            memcpy(&error, CMSG_DATA(header), sizeof(error));
+            if (!ip_error || error.ee_errno != 0 || error.ee_origin != SO_EE_ORIGIN_ZEROCOPY) {
+                continue;
+            }
+
+            // The completion covers the calls numbered from ee_info to ee_data, which wrap at 32 bits.
+            const uint64_t first = m_completed_sends + (uint32_t)(error.ee_info - (uint32_t)m_completed_sends);
+            const uint64_t last = first + (uint32_t)(error.ee_data - error.ee_info) + 1;
+            if (error.ee_code & SO_EE_CODE_ZEROCOPY_COPIED) {
+                m_copied_sends += last - first;
+            }
+            m_out_of_order.emplace_back(first, last);
+            completion_count++;
+        }
+
+        // Advance the in order count through every range that now follows it.
+        std::sort(m_out_of_order.begin(), m_out_of_order.end());
+        std::size_t merged = 0;
+        for (; merged < m_out_of_order.size() && m_out_of_order[merged].first <= m_completed_sends; merged++) {
+            m_completed_sends = std::max(m_completed_sends, m_out_of_order[merged].second);
+        }
+        m_out_of_order.erase(m_out_of_order.begin(), m_out_of_order.begin() + merged);
+    }
+#endif
+    return completion_count;
+}
+
+#endif /* GENERIC_SHARED_MEMORY_EGRESS_H */
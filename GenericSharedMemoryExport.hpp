@@ -0,0 +1,392 @@
+/**
+ * 	@file		GenericSharedMemoryExport.hpp
+ *	@brief		Definition of the GenericSharedMemoryExport class.
+ *	@details	This header file defines functions for exporting a shared memory segment to a compressed
+				file and importing it into another segment, for transferring the state of a segment to
+				a new node. The segment is split into chunks that are compressed and decompressed by
+				several threads, and decompressed directly into the destination mapping. The built-in
+				codec encodes runs of zero words and literal words, which is fast and compresses the
+				mostly-zero segments typical of preallocated state well without external libraries.
+ *	@author		James Horner
+ */
+
+#ifndef GENERIC_SHARED_MEMORY_EXPORT_H
+#define GENERIC_SHARED_MEMORY_EXPORT_H
+
+// C++ Standard Library Headers
+#include <algorithm>
+#include <atomic>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+// Library Headers
+#include "GenericSharedMemoryChecksum.hpp"
+#include "GenericSharedMemoryModel.hpp"
+
+/// Header at the start of every export file.
+struct GenericSharedMemoryExportHeader {
+    /// Magic number identifying an export file.
+    char magic[8];
+    /// Size of the segment in bytes.
+    uint64_t segment_bytes;
+    /// Size of each chunk in bytes, the last chunk may be smaller.
+    uint64_t chunk_bytes;
+    /// Number of chunks following the header.
+    uint64_t chunk_count;
+};
+
+/// Header before each chunk of an export file.
+struct GenericSharedMemoryExportChunk {
+    /// Encoding of the chunk, 0 for raw bytes or 1 for zero and literal word runs.
+    uint32_t encoding;
+    /// CRC32C checksum of the encoded bytes of the chunk.
+    uint32_t checksum;
+    /// Number of encoded bytes following the chunk header.
+    uint64_t encoded_bytes;
+};
+
+/**
+ * @brief 	Class GenericSharedMemoryExport is used to export segments to compressed files and to import them again.
+ * @details An export file holds a header followed by the chunks of the segment in order, each with a header giving its
+ * 			encoding, size and checksum, so a file can be streamed over a link and is checked as it is imported. Chunks are
+ * 			encoded as runs of 8 byte words, where runs of zero words take a single byte and are skipped when importing into
+ * 			a freshly created (and so zero filled) segment without touching its pages.
+ *
+ * 			Writers should be quiescent while a segment is exported; to export a consistent copy while writers continue, export
+ * 			the data of a GenericSharedMemorySnapshot instead.
+ */
+class GenericSharedMemoryExport {
+public:
+    /// Default size of each chunk in bytes.
+    static constexpr std::size_t default_chunk_bytes = 1 << 20;
+
+    /**
+     * @brief Function export_segment() is used to export a segment to a compressed file.
+     * @param address start of the segment.
+     * @param bytes size of the segment in bytes.
+     * @param path path of the file to write, which is written under a temporary name and renamed once complete.
+     * @param thread_count number of threads to compress with, or 0 to use the number of hardware threads.
+     * @param chunk_bytes size of each chunk in bytes, which must be a non-zero multiple of 8.
+     * @returns Boolean true when the file was written, false otherwise.
+     */
+    static bool export_segment(const void *address, std::size_t bytes, const std::string &path, unsigned thread_count = 0,
+                               std::size_t chunk_bytes = default_chunk_bytes);
+
+    /**
+     * @brief Function export_model() is used to export a model's segment to a compressed file while holding the model's lock.
+     * @param model connected model whose segment is exported.
+     * @param path path of the file to write.
+     * @param thread_count number of threads to compress with, or 0 to use the number of hardware threads.
+     * @returns Boolean true when the file was written, false if the model is not connected or it could not be written.
+     */
+    template<typename T>
+    static bool export_model(GenericSharedMemoryModel<T> &model, const std::string &path, unsigned thread_count = 0) {
+        // The model may be unmapped while idle, so it is checked under its lock, which does not map it again.
+        std::scoped_lock<GenericSharedMemoryModel<T>> model_guard(model);
+        return model.data != nullptr && export_segment(model.data, sizeof(T), path, thread_count);
+    }
+
+    /**
+     * @brief Function import_segment() is used to import a segment from an export file.
+     * @param path path of the file to read.
+     * @param address start of the segment to import into.
+     * @param bytes size of the segment in bytes, which must match the size saved in the file.
+     * @param zero_filled true if the segment is known to be zero filled (as a newly created segment is), so zero runs
+     * 			need not be written.
+     * @param thread_count number of threads to decompress with, or 0 to use the number of hardware threads.
+     * @returns Boolean true when the segment was imported, false if the file could not be read or is corrupt, in which case
+     * 			the segment may be partially imported.
+     */
+    static bool import_segment(const std::string &path, void *address, std::size_t bytes, bool zero_filled = false,
+                               unsigned thread_count = 0);
+
+    /**
+     * @brief Function import_model() is used to import a model's segment from an export file while holding the model's lock.
+     * @param model connected model whose segment is imported into.
+     * @param path path of the file to read.
+     * @param thread_count number of threads to decompress with, or 0 to use the number of hardware threads.
+     * @returns Boolean true when the segment was imported, false otherwise.
+     */
+    template<typename T>
+    static bool import_model(GenericSharedMemoryModel<T> &model, const std::string &path, unsigned thread_count = 0) {
+        std::scoped_lock<GenericSharedMemoryModel<T>> model_guard(model);
+        return model.data != nullptr && import_segment(path, model.data, sizeof(T), false, thread_count);
+    }
+
+    /**
+     * @brief Function segment_bytes() is used to read the size of the segment saved in an export file.
+     * @param path path of the file to read.
+     * @returns Size of the segment in bytes, or 0 if the file could not be read.
+     */
+    static std::size_t segment_bytes(const std::string &path);
+
+    /**
+     * @brief Function encode() is used to encode a buffer as runs of zero and literal words.
+     * @param data start of the buffer.
+     * @param size size of the buffer in bytes.
+     * @param encoded vector the encoding is written to, replacing its contents.
+     */
+    static void encode(const unsigned char *data, std::size_t size, std::vector<unsigned char> &encoded);
+
+    /**
+     * @brief Function decode() is used to decode a buffer encoded by encode().
+     * @param encoded start of the encoding.
+     * @param encoded_size size of the encoding in bytes.
+     * @param data buffer to decode into.
+     * @param size size of the decoded buffer in bytes.
+     * @param zero_filled true if the buffer is known to be zero filled, so zero runs are skipped.
+     * @returns Boolean true when the encoding was decoded to exactly size bytes, false if it is corrupt.
+     */
+    static bool decode(const unsigned char *encoded, std::size_t encoded_size, unsigned char *data, std::size_t size, bool zero_filled);
+
+private:
+    /// Function parallel_for() calls function with every index below count, spread over a number of threads.
+    template<typename Function>
+    static void parallel_for(std::size_t count, unsigned thread_count, Function function);
+
+    /// Function append_varint() appends a LEB128 encoded value to a buffer.
+    static void append_varint(std::vector<unsigned char> &buffer, uint64_t value) {
+        for (; value >= 0x80; value >>= 7) {
+            buffer.push_back((unsigned char)(value | 0x80));
+        }
+        buffer.push_back((unsigned char)value);
+    }
+
+    /// Function read_varint() reads a LEB128 encoded value, returning false if the buffer ends first.
+    static bool read_varint(const unsigned char *&position, const unsigned char *end, uint64_t &value) {
+        value = 0;
+        for (unsigned shift = 0; position < end && shift < 64; shift += 7) {
+            const unsigned char byte = *position++;
+            value |= (uint64_t)(byte & 0x7F) << shift;
+            if ((byte & 0x80) == 0) {
+                return true;
+            }
+        }
+        return false;
+    }
+};
+
+template<typename Function>
+void GenericSharedMemoryExport::parallel_for(std::size_t count, unsigned thread_count, Function function)
+{
+    // Use one thread per hardware thread by default, but never more threads than indices.
+    if (thread_count == 0) {
+        thread_count = std::max(1u, std::thread::hardware_concurrency());
+    }
+    thread_count = (unsigned)std::min<std::size_t>(thread_count, count);
+
+    // Each thread takes the next index until all have been done.
+    std::atomic<std::size_t> next_index(0);
+    auto worker = [&]() {
+        for (std::size_t index = next_index.fetch_add(1); index < count; index = next_index.fetch_add(1)) {
+            function(index);
+        }
+    };
+    std::vector<std::thread> threads;
+    for (unsigned i = 1; i < thread_count; i++) {
+        threads.emplace_back(worker);
+    }
+    worker();
+    for (std::thread &thread : threads) {
+        thread.join();
+    }
+}
+
+inline void GenericSharedMemoryExport::encode(const unsigned char *data, std::size_t size, std::vector<unsigned char> &encoded)
+{
+    // Each run starts with a varint of its length in words, shifted left with the low bit set for literal runs.
+    encoded.clear();
+    const std::size_t word_count = size / 8;
+    std::size_t word = 0;
+    auto is_zero = [data](std::size_t index) {
+        uint64_t value;
+        memcpy(&value, data + index * 8, 8);
+        return value == 0;
+    };
+    while (word < word_count) {
+        const std::size_t run_start = word;
+        if (is_zero(word)) {
+            while (word < word_count && is_zero(word)) {
+                word++;
+            }
+            append_varint(encoded, (uint64_t)(word - run_start) << 1);
+        }
+        else {
+            while (word < word_count && !is_zero(word)) {
+                word++;
+            }
+            append_varint(encoded, ((uint64_t)(word - run_start) << 1) | 1);
+            encoded.insert(encoded.end(), data + run_start * 8, data + word * 8);
+        }
+    }
+
+    // Bytes after the last whole word are stored as they are.
+    encoded.insert(encoded.end(), data + word_count * 8, data + size);
+}
+
+inline bool GenericSharedMemoryExport::decode(const unsigned char *encoded, std::size_t encoded_size, unsigned char *data,
+                                              std::size_t size, bool zero_filled)
+{
+    const unsigned char *position = encoded;
+    const unsigned char *end = encoded + encoded_size;
+    const std::size_t word_count = size / 8;
+    std::size_t word = 0;
+    while (word < word_count) {
+        uint64_t run;
+        if (!read_varint(position, end, run) || (run >> 1) == 0 || (run >> 1) > word_count - word) {
+            return false;
+        }
+        const std::size_t run_bytes = (std::size_t)(run >> 1) * 8;
+        if (run & 1) {
+            if ((std::size_t)(end - position) < run_bytes) {
+                return false;
+            }
+            memcpy(data + word * 8, position, run_bytes);
+            position += run_bytes;
+        }
+        else if (!zero_filled) {
+            memset(data + word * 8, 0, run_bytes);
+        }
+        word += (std::size_t)(run >> 1);
+    }
+
+    // The remaining bytes must be exactly the bytes after the last whole word.
+    if ((std::size_t)(end - position) != size - word_count * 8) {
+        return false;
+    }
+    memcpy(data + word_count * 8, position, size - word_count * 8);
+    return true;
+}
+
+inline bool GenericSharedMemoryExport::export_segment(const void *address, std::size_t bytes, const std::string &path,
+                                                      unsigned thread_count, std::size_t chunk_bytes)
+{
+    if (address == nullptr || chunk_bytes == 0 || chunk_bytes % 8 != 0) {
+        return false;
+    }
+    const unsigned char *segment = (const unsigned char *)address;
+    // A chunk larger than the segment is recorded as the segment's size, so importers can bound the chunk size.
+    chunk_bytes = std::min(chunk_bytes, std::max<std::size_t>(8, (bytes + 7) / 8 * 8));
+    const std::size_t chunk_count = (bytes + chunk_bytes - 1) / chunk_bytes;
+
+    const std::string temporary_path = path + ".tmp";
+    FILE *file = fopen(temporary_path.c_str(), "wb");
+    if (file == nullptr) {
+        return false;
+    }
+    GenericSharedMemoryExportHeader header = {{'G', 'S', 'M', 'M', 'S', 'N', 'A', 'P'}, bytes, chunk_bytes, chunk_count};
+    bool written = fwrite(&header, sizeof(header), 1, file) == 1;
+
+    // Encode the chunks in batches of a few per thread, writing each batch in order once it is encoded.
+    const std::size_t batch_size = 4 * (std::size_t)std::max(1u, thread_count != 0 ? thread_count : std::thread::hardware_concurrency());
+    std::vector<std::vector<unsigned char>> encoded(std::min(batch_size, chunk_count));
+    std::vector<GenericSharedMemoryExportChunk> chunks(encoded.size());
+    for (std::size_t batch_start = 0; written && batch_start < chunk_count; batch_start += batch_size) {
+        const std::size_t batch_count = std::min(batch_size, chunk_count - batch_start);
+        parallel_for(batch_count, thread_count, [&](std::size_t i) {
+            const std::size_t offset = (batch_start + i) * chunk_bytes;
+            const std::size_t size = std::min(chunk_bytes, bytes - offset);
+            encode(segment + offset, size, encoded[i]);
+            // Chunks that do not compress are stored raw.
+            if (encoded[i].size() >= size) {
+                encoded[i].assign(segment + offset, segment + offset + size);
+                chunks[i].encoding = 0;
+            }
+            else {
+                chunks[i].encoding = 1;
+            }
+            chunks[i].encoded_bytes = encoded[i].size();
+            chunks[i].checksum = generic_shared_memory_crc32c(encoded[i].data(), encoded[i].size());
+        });
+        for (std::size_t i = 0; written && i < batch_count; i++) {
+            written = fwrite(&chunks[i], sizeof(chunks[i]), 1, file) == 1 &&
+                      (encoded[i].empty() || fwrite(encoded[i].data(), encoded[i].size(), 1, file) == 1);
+        }
+    }
+    written = fclose(file) == 0 && written;
+
+    // Replace any previous file with the path once the new one is complete.
+    if (!written || rename(temporary_path.c_str(), path.c_str()) != 0) {
+        remove(temporary_path.c_str());
+        return false;
+    }
+    return true;
+}
+
+inline bool GenericSharedMemoryExport::import_segment(const std::string &path, void *address, std::size_t bytes, bool zero_filled,
+                                                      unsigned thread_count)
+{
+    if (address == nullptr) {
+        return false;
+    }
+    unsigned char *segment = (unsigned char *)address;
+    FILE *file = fopen(path.c_str(), "rb");
+    if (file == nullptr) {
+        return false;
+    }
+    GenericSharedMemoryExportHeader header;
+    bool valid = fread(&header, sizeof(header), 1, file) == 1 && memcmp(header.magic, "GSMMSNAP", 8) == 0 &&
+                 header.segment_bytes == bytes && header.chunk_bytes != 0 && header.chunk_bytes % 8 == 0 &&
+                 header.chunk_bytes <= std::max<std::size_t>(8, (bytes + 7) / 8 * 8) &&
+                 header.chunk_count == (bytes + header.chunk_bytes - 1) / header.chunk_bytes;
+
+    // Read the chunks in batches of a few per thread, decoding each batch directly into the segment.
+    const std::size_t batch_size = 4 * (std::size_t)std::max(1u, thread_count != 0 ? thread_count : std::thread::hardware_concurrency());
+    std::vector<std::vector<unsigned char>> encoded(valid ? std::min<std::size_t>(batch_size, header.chunk_count) : 0);
+    std::vector<GenericSharedMemoryExportChunk> chunks(encoded.size());
+    for (std::size_t batch_start = 0; valid && batch_start < header.chunk_count; batch_start += batch_size) {
+        const std::size_t batch_count = std::min<std::size_t>(batch_size, header.chunk_count - batch_start);
+        for (std::size_t i = 0; valid && i < batch_count; i++) {
+            // Chunks that do not compress are stored raw, so a chunk never encodes to more bytes than it holds.
+            const std::size_t offset = (batch_start + i) * header.chunk_bytes;
+            valid = fread(&chunks[i], sizeof(chunks[i]), 1, file) == 1 &&
+                    chunks[i].encoded_bytes <= std::min<std::size_t>(header.chunk_bytes, bytes - offset);
+            if (valid) {
+                encoded[i].resize((std::size_t)chunks[i].encoded_bytes);
+                valid = encoded[i].empty() || fread(encoded[i].data(), encoded[i].size(), 1, file) == 1;
+            }
+        }
+        std::atomic<bool> decoded(true);
+        if (valid) {
+            parallel_for(batch_count, thread_count, [&](std::size_t i) {
+                const std::size_t offset = (batch_start + i) * header.chunk_bytes;
+                const std::size_t size = std::min<std::size_t>(header.chunk_bytes, bytes - offset);
+                bool chunk_valid = chunks[i].checksum == generic_shared_memory_crc32c(encoded[i].data(), encoded[i].size());
+                if (chunk_valid && chunks[i].encoding == 0) {
+                    chunk_valid = encoded[i].size() == size;
+                    if (chunk_valid) {
+                        memcpy(segment + offset, encoded[i].data(), size);
+                    }
+                }
+                else if (chunk_valid) {
+                    chunk_valid = chunks[i].encoding == 1 && decode(encoded[i].data(), encoded[i].size(), segment + offset, size, zero_filled);
+                }
+                if (!chunk_valid) {
+                    decoded.store(false);
+                }
+            });
+        }
+        valid = valid && decoded.load();
+    }
+    fclose(file);
+    return valid;
+}
+
+inline std::size_t GenericSharedMemoryExport::segment_bytes(const std::string &path)
+{
+    FILE *file = fopen(path.c_str(), "rb");
+    if (file == nullptr) {
+        return 0;
+    }
+    GenericSharedMemoryExportHeader header;
+    const bool valid = fread(&header, sizeof(header), 1, file) == 1 && memcmp(header.magic, "GSMMSNAP", 8) == 0;
+    fclose(file);
+    return valid ? (std::size_t)header.segment_bytes : 0;
+}
+
+#endif /* GENERIC_SHARED_MEMORY_EXPORT_H */
@@ -0,0 +1,471 @@
+/**
+ * 	@file		GenericSharedMemoryFieldModel.hpp
+ *	@brief		Definition of the GenericSharedMemoryFieldModel class.
+ *	@details	This header file defines a model that tracks changes to a segment field by field. The
+				segment holds a generation counter per field, which the writer increments for each
+				field a write changes, and a table of subscriptions naming the fields they watch, which
+				the writer wakes only when one of their fields changed. Consumers interested in a few
+				fields of a large structure can therefore wait for and read just those fields. Fields
+				are either the reflected fields of the type or regions declared by the user.
+ *	@author		James Horner
+ */
+
+#ifndef GENERIC_SHARED_MEMORY_FIELD_MODEL_H
+#define GENERIC_SHARED_MEMORY_FIELD_MODEL_H
+
+// C++ Standard Library Headers
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <cstring>
+#include <initializer_list>
+#include <string>
+#include <thread>
+#include <type_traits>
+#include <vector>
+
+// Library Headers
+#include "GenericSharedMemoryFutex.hpp"
+#include "GenericSharedMemoryModel.hpp"
+#include "GenericSharedMemoryProcess.hpp"
+#include "GenericSharedMemoryReflection.hpp"
+
+/// Entry of the subscription table of a field segment, on its own cache line.
+template<std::size_t MaskWords>
+struct alignas(64) GenericSharedMemoryFieldSubscriber {
+    /// Process token of the subscription's process while the entry is used, or 0 when it is free.
+    std::atomic<uint64_t> owner;
+    /// Futex word incremented by writers when a watched field changes.
+    std::atomic<uint32_t> notify;
+    /// Bit mask of the watched fields.
+    std::atomic<uint64_t> mask[MaskWords];
+};
+
+/**
+ * @brief 	Struct GenericSharedMemoryFieldLayout is the structure mapped to a field segment.
+ * @details All of the fields are valid when zero. The sequence is a sequence lock over the value, odd while it is written.
+ */
+template<typename T, std::size_t Fields, std::size_t Subscribers>
+struct GenericSharedMemoryFieldLayout {
+    /// Sequence lock of the value.
+    alignas(64) std::atomic<uint32_t> sequence;
+    /// Number of writes that changed each field.
+    std::atomic<uint32_t> generations[Fields];
+    /// Subscription table.
+    GenericSharedMemoryFieldSubscriber<(Fields + 63) / 64> subscribers[Subscribers];
+    /// Value of the segment.
+    alignas(64) T value;
+};
+
+/**
+ * @brief 	Class GenericSharedMemoryFieldModel is used for management of a connection to a segment with per field change tracking.
+ * @details write_data() compares each field of the new value with the segment and only copies and bumps the generation of
+ * 			the fields that changed, then wakes the subscriptions watching them. Readers use a sequence lock, so never block
+ * 			writers, and can read single fields with read_field() or get_field(). Every process connected to a segment must
+ * 			use the same fields. Bytes not covered by a field (such as padding) are copied by every write.
+ * @param 	T datatype of the segment, which must be trivially copyable.
+ * @param 	Fields number of fields, by default the number of reflected fields of T.
+ * @param 	Subscribers number of entries in the subscription table.
+ */
+template<typename T, std::size_t Fields = GenericSharedMemoryReflection<T>::field_count, std::size_t Subscribers = 16>
+class GenericSharedMemoryFieldModel {
+    static_assert(std::is_trivially_copyable_v<T>, "T must be trivially copyable.");
+    static_assert(Fields > 0, "A field segment needs at least one field.");
+
+public:
+    /// Type of the structure mapped to the field segment.
+    using layout_t = GenericSharedMemoryFieldLayout<T, Fields, Subscribers>;
+
+    /**
+     * @brief 	Class subscription_t watches a set of fields of a field segment for changes.
+     * @details A subscription holds an entry of the segment's subscription table until it is destroyed, and must not
+     * 			outlive the connection of its model. It is used by a single thread.
+     */
+    class subscription_t {
+    public:
+        /// Destructor for the subscription_t class that releases its entry of the subscription table.
+        ~subscription_t() {
+            if (m_subscriber != nullptr) {
+                for (std::atomic<uint64_t> &word : m_subscriber->mask) {
+                    word.store(0, std::memory_order_relaxed);
+                }
+                m_subscriber->owner.store(0, std::memory_order_release);
+            }
+        }
+
+        subscription_t(subscription_t &&other) noexcept :
+            m_layout(other.m_layout), m_subscriber(other.m_subscriber), m_fields(std::move(other.m_fields)), m_seen(std::move(other.m_seen))
+        {
+            other.m_subscriber = nullptr;
+        }
+        subscription_t(const subscription_t &) = delete;
+        subscription_t &operator=(const subscription_t &) = delete;
+        subscription_t &operator=(subscription_t &&) = delete;
+
+        /// Function is_valid() returns true if the subscription holds an entry of the subscription table.
+        bool is_valid() const {
+            return m_subscriber != nullptr;
+        }
+
+        /**
+         * @brief Function poll() is used to check, without blocking, if a watched field changed since the last poll() or wait().
+         * @returns Boolean true when a watched field changed, in which case the changes are marked as seen.
+         */
+        bool poll() {
+            bool changed = false;
+            for (std::size_t i = 0; m_layout != nullptr && i < m_fields.size(); i++) {
+                const uint32_t generation = m_layout->generations[m_fields[i]].load(std::memory_order_acquire);
+                changed = changed || generation != m_seen[i];
+                m_seen[i] = generation;
+            }
+            return changed;
+        }
+
+        /**
+         * @brief Function wait() is used to wait, in any process, for a watched field to change.
+         * @param timeout_ms time to wait in milliseconds, or -1 to wait indefinitely.
+         * @returns Boolean true when a watched field changed since the last poll() or wait(), false if the timeout expired
+         * 			or the subscription is not valid.
+         */
+        bool wait(int timeout_ms = -1) {
+            if (m_subscriber == nullptr) {
+                return false;
+            }
+            const auto deadline = std::chrono::steady_clock::now() + std::chrono::milliseconds(timeout_ms);
+            for (;;) {
+                // Read the futex word before the generations, so a change after the check is certain to wake this thread.
+                const uint32_t notify = m_subscriber->notify.load(std::memory_order_seq_cst);
+                if (poll()) {
+                    return true;
+                }
+                int remaining_ms = -1;
+                if (timeout_ms >= 0) {
+                    remaining_ms = (int)std::chrono::duration_cast<std::chrono::milliseconds>(deadline - std::chrono::steady_clock::now()).count();
+                    if (remaining_ms <= 0) {
+                        return false;
+                    }
+                }
+                generic_shared_memory_futex_wait(&m_subscriber->notify, notify, remaining_ms);
+            }
+        }
+
+    private:
+        friend class GenericSharedMemoryFieldModel;
+
+        /// Constructor for the subscription_t class, used by subscribe().
+        subscription_t(layout_t *layout, GenericSharedMemoryFieldSubscriber<(Fields + 63) / 64> *subscriber, std::vector<std::size_t> fields) :
+            m_layout(layout), m_subscriber(subscriber), m_fields(std::move(fields)), m_seen(m_fields.size())
+        {
+            poll();
+        }
+
+        /// Segment the subscription watches.
+        layout_t *m_layout;
+        /// Entry of the subscription table, or nullptr if none was available.
+        GenericSharedMemoryFieldSubscriber<(Fields + 63) / 64> *m_subscriber;
+        /// Watched fields and the generations of them last seen.
+        std::vector<std::size_t> m_fields;
+        std::vector<uint32_t> m_seen;
+    };
+
+    /// Constructor for the GenericSharedMemoryFieldModel class that tracks the reflected fields of T.
+    GenericSharedMemoryFieldModel(const std::string name, const bool log_warnings = false) :
+        GenericSharedMemoryFieldModel(name, GenericSharedMemoryReflection<T>::fields, log_warnings)
+    {
+    }
+
+    /**
+     * @brief Constructor for the GenericSharedMemoryFieldModel class that tracks declared regions of T as its fields.
+     * @param name name of the shared memory segment.
+     * @param fields regions of T tracked as fields, of which only the offsets and sizes are used.
+     * @param log_warnings true to log warnings through the GenericSharedMemoryLog.
+     */
+    GenericSharedMemoryFieldModel(const std::string name, const std::array<GenericSharedMemoryField, Fields> &fields, const bool log_warnings = false) :
+        m_model(name, log_warnings),
+        m_fields(fields)
+    {
+        // Find the bytes not covered by any field, which are copied by every write.
+        std::vector<std::pair<std::size_t, std::size_t>> covered;
+        for (GenericSharedMemoryField &field : m_fields) {
+            field.size = std::min(field.size, sizeof(T) - std::min(field.offset, sizeof(T)));
+            covered.emplace_back(field.offset, field.offset + field.size);
+        }
+        std::sort(covered.begin(), covered.end());
+        std::size_t end = 0;
+        for (auto &[first, last] : covered) {
+            if (first > end) {
+                m_gaps.emplace_back(end, first - end);
+            }
+            end = std::max(end, last);
+        }
+        if (end < sizeof(T)) {
+            m_gaps.emplace_back(end, sizeof(T) - end);
+        }
+    }
+
+    /**
+     * @brief Function connect() is used to connect the model to its shared memory segment.
+     * @returns Boolean true when the shared memory segment was successfully connected, false otherwise.
+     */
+    bool connect() {
+        return m_model.connect();
+    }
+
+    /**
+     * @brief Function disconnect() is used to disconnect the model from its shared memory segment.
+     * @returns Boolean true when the shared memory segment was successfully disconnected, false otherwise.
+     */
+    bool disconnect() {
+        return m_model.disconnect();
+    }
+
+    /**
+     * @brief Function is_connected() is used to check if the model is connected.
+     * @returns Boolean true when the shared memory is connected, false otherwise.
+     */
+    bool is_connected() {
+        return m_model.is_connected();
+    }
+
+    /**
+     * @brief Function write_data() is used to write a new value, changing only the fields that differ.
+     * @param new_value value to be written.
+     * @returns Number of fields that changed, or 0 if the model is not connected.
+     */
+    std::size_t write_data(const T &new_value);
+
+    /**
+     * @brief Function write_field() is used to write a new value of a single field.
+     * @param index position of the field.
+     * @param value new value of the field, of the field's size.
+     * @returns Boolean true when the field changed, false if it was unchanged or the model is not connected.
+     */
+    bool write_field(std::size_t index, const void *value);
+
+    /// Function write_field() is used to write a new value of a reflected field, returning true if it changed.
+    template<std::size_t Index>
+    bool write_field(const typename GenericSharedMemoryReflection<T>::template field_type<Index> &value) {
+        return write_field(Index, &value);
+    }
+
+    /**
+     * @brief Function get_data() is used to get a consistent snapshot of the segment.
+     * @returns Value of the segment at the time of the call, or a value initialised T if the model is not connected.
+     */
+    T get_data() {
+        T value{};
+        read(0, sizeof(T), &value);
+        return value;
+    }
+
+    /**
+     * @brief Function read_field() is used to read a consistent snapshot of a single field.
+     * @param index position of the field.
+     * @param value buffer of the field's size to copy the field into.
+     * @returns Generation of the field that was read, or 0 if the model is not connected.
+     */
+    uint32_t read_field(std::size_t index, void *value) {
+        return index < Fields ? read(m_fields[index].offset, m_fields[index].size, value, index) : 0;
+    }
+
+    /// Function get_field() is used to read a consistent snapshot of a reflected field.
+    template<std::size_t Index>
+    typename GenericSharedMemoryReflection<T>::template field_type<Index> get_field() {
+        typename GenericSharedMemoryReflection<T>::template field_type<Index> value{};
+        read_field(Index, &value);
+        return value;
+    }
+
+    /// Function generation() returns the number of writes that changed a field, or 0 if the model is not connected.
+    uint32_t generation(std::size_t index) {
+        layout_t *layout = m_model.data;
+        return layout != nullptr && index < Fields ? layout->generations[index].load(std::memory_order_acquire) : 0;
+    }
+
+    /**
+     * @brief Function subscribe() is used to watch a set of fields for changes.
+     * @param fields positions of the fields to watch.
+     * @details When the subscription table is full, entries left by processes that exited without destroying their
+     * 			subscriptions are reclaimed.
+     * @returns Subscription, which is not valid if the model is not connected, a position is out of range or the
+     * 			subscription table is full.
+     */
+    subscription_t subscribe(std::initializer_list<std::size_t> fields);
+
+private:
+    /// Function read() copies part of the value under the sequence lock, returning the generation of a field if one is given.
+    uint32_t read(std::size_t offset, std::size_t size, void *destination, std::size_t field = Fields);
+
+    /// Function lock() takes the sequence lock of the value for writing, returning the sequence to release it with.
+    static uint32_t lock(layout_t *layout) {
+        uint32_t sequence = layout->sequence.load(std::memory_order_relaxed);
+        while ((sequence & 1) || !layout->sequence.compare_exchange_weak(sequence, sequence + 1, std::memory_order_acquire)) {
+            if (sequence & 1) {
+                std::this_thread::yield();
+                sequence = layout->sequence.load(std::memory_order_relaxed);
+            }
+        }
+        std::atomic_thread_fence(std::memory_order_release);
+        return sequence + 2;
+    }
+
+    /// Function notify() wakes the subscriptions watching any of the changed fields, after the sequence lock is released.
+    static void notify(layout_t *layout, const std::array<uint64_t, (Fields + 63) / 64> &changed);
+
+    /// Model for the shared memory segment.
+    GenericSharedMemoryModel<layout_t> m_model;
+    /// Fields of the value.
+    std::array<GenericSharedMemoryField, Fields> m_fields;
+    /// Offsets and sizes of the bytes of the value not covered by a field.
+    std::vector<std::pair<std::size_t, std::size_t>> m_gaps;
+};
+
+template<typename T, std::size_t Fields, std::size_t Subscribers>
+std::size_t GenericSharedMemoryFieldModel<T, Fields, Subscribers>::write_data(const T &new_value)
+{
+    layout_t *layout = m_model.data;
+    if (layout == nullptr) {
+        return 0;
+    }
+    unsigned char *current = (unsigned char *)&layout->value;
+    const unsigned char *next = (const unsigned char *)&new_value;
+
+    // Copy only the fields that differ, bumping their generations, while holding the sequence lock.
+    const uint32_t release_sequence = lock(layout);
+    std::array<uint64_t, (Fields + 63) / 64> changed = {};
+    std::size_t changed_count = 0;
+    for (std::size_t index = 0; index < Fields; index++) {
+        const GenericSharedMemoryField &field = m_fields[index];
+        if (memcmp(current + field.offset, next + field.offset, field.size) != 0) {
+            memcpy(current + field.offset, next + field.offset, field.size);
+            layout->generations[index].fetch_add(1, std::memory_order_release);
+            changed[index / 64] |= (uint64_t)1 << (index % 64);
+            changed_count++;
+        }
+    }
+    for (auto &[offset, size] : m_gaps) {
+        memcpy(current + offset, next + offset, size);
+    }
+    layout->sequence.store(release_sequence, std::memory_order_seq_cst);
+
+    if (changed_count != 0) {
+        notify(layout, changed);
+    }
+    return changed_count;
+}
+
+template<typename T, std::size_t Fields, std::size_t Subscribers>
+bool GenericSharedMemoryFieldModel<T, Fields, Subscribers>::write_field(std::size_t index, const void *value)
+{
+    layout_t *layout = m_model.data;
+    if (layout == nullptr || index >= Fields) {
+        return false;
+    }
+    const GenericSharedMemoryField &field = m_fields[index];
+    unsigned char *current = (unsigned char *)&layout->value + field.offset;
+
+    const uint32_t release_sequence = lock(layout);
+    const bool changed = memcmp(current, value, field.size) != 0;
+    if (changed) {
+        memcpy(current, value, field.size);
+        layout->generations[index].fetch_add(1, std::memory_order_release);
+    }
+    layout->sequence.store(release_sequence, std::memory_order_seq_cst);
+
+    if (changed) {
+        std::array<uint64_t, (Fields + 63) / 64> changed_mask = {};
+        changed_mask[index / 64] = (uint64_t)1 << (index % 64);
+        notify(layout, changed_mask);
+    }
+    return changed;
+}
+
+template<typename T, std::size_t Fields, std::size_t Subscribers>
+uint32_t GenericSharedMemoryFieldModel<T, Fields, Subscribers>::read(std::size_t offset, std::size_t size, void *destination, std::size_t field)
+{
+    layout_t *layout = m_model.data;
+    if (layout == nullptr) {
+        return 0;
+    }
+
+    // Copy until a copy is made without a write starting or finishing during it.
+    for (;;) {
+        const uint32_t sequence = layout->sequence.load(std::memory_order_acquire);
+        if (sequence & 1) {
+            std::this_thread::yield();
+            continue;
+        }
+        memcpy(destination, (const unsigned char *)&layout->value + offset, size);
+        const uint32_t generation = field < Fields ? layout->generations[field].load(std::memory_order_relaxed) : 0;
+        std::atomic_thread_fence(std::memory_order_acquire);
+        if (layout->sequence.load(std::memory_order_relaxed) == sequence) {
+            return generation;
+        }
+    }
+}
+
+template<typename T, std::size_t Fields, std::size_t Subscribers>
+void GenericSharedMemoryFieldModel<T, Fields, Subscribers>::notify(layout_t *layout, const std::array<uint64_t, (Fields + 63) / 64> &changed)
+{
+    for (auto &subscriber : layout->subscribers) {
+        if (subscriber.owner.load(std::memory_order_acquire) == 0) {
+            continue;
+        }
+        bool watched = false;
+        for (std::size_t word = 0; word < changed.size(); word++) {
+            watched = watched || (subscriber.mask[word].load(std::memory_order_relaxed) & changed[word]) != 0;
+        }
+        if (watched) {
+            subscriber.notify.fetch_add(1, std::memory_order_seq_cst);
+            generic_shared_memory_futex_wake(&subscriber.notify);
+        }
+    }
+}
+
+template<typename T, std::size_t Fields, std::size_t Subscribers>
+typename GenericSharedMemoryFieldModel<T, Fields, Subscribers>::subscription_t
+GenericSharedMemoryFieldModel<T, Fields, Subscribers>::subscribe(std::initializer_list<std::size_t> fields)
+{
+    layout_t *layout = m_model.data;
+    std::vector<std::size_t> watched(fields);
+    const bool valid = layout != nullptr && std::all_of(watched.begin(), watched.end(), [](std::size_t index) { return index < Fields; });
+
+    if (!valid) {
+        return subscription_t(nullptr, nullptr, {});
+    }
+
+    // Claim a free entry of the subscription table, or failing that one whose owner has exited.
+    const uint64_t token = generic_shared_memory_process_token();
+    GenericSharedMemoryFieldSubscriber<(Fields + 63) / 64> *claimed = nullptr;
+    for (auto &subscriber : layout->subscribers) {
+        uint64_t free_entry = 0;
+        if (subscriber.owner.compare_exchange_strong(free_entry, token, std::memory_order_acquire)) {
+            claimed = &subscriber;
+            break;
+        }
+    }
+    for (std::size_t i = 0; claimed == nullptr && i < Subscribers; i++) {
+        uint64_t owner = layout->subscribers[i].owner.load(std::memory_order_acquire);
+        if (owner != 0 && owner != token && !generic_shared_memory_process_alive(owner) &&
+            layout->subscribers[i].owner.compare_exchange_strong(owner, token, std::memory_order_acquire)) {
+            claimed = &layout->subscribers[i];
+        }
+    }
+    if (claimed == nullptr) {
+        return subscription_t(nullptr, nullptr, {});
+    }
+
+    // Publish the watched fields, replacing any left by a dead owner.
+    for (std::size_t word = 0; word < (Fields + 63) / 64; word++) {
+        uint64_t mask = 0;
+        for (std::size_t index : watched) {
+            mask |= index / 64 == word ? (uint64_t)1 << (index % 64) : 0;
+        }
+        claimed->mask[word].store(mask, std::memory_order_seq_cst);
+    }
+    return subscription_t(layout, claimed, std::move(watched));
+}
+
+#endif /* GENERIC_SHARED_MEMORY_FIELD_MODEL_H */
@@ -0,0 +1,75 @@
+/**
+ * 	@file		GenericSharedMemoryFutex.hpp
+ *	@brief		Definition of the futex functions used to wait on words in shared memory.
+ *	@details	This header file defines functions for blocking until a 32 bit word in shared memory
+				changes and for waking the threads blocked on it, in any process mapping the word.
+				std::atomic::wait() cannot be used for this as it is only guaranteed to work within a
+				process (libstdc++ uses private futexes). On Linux the functions use shared futexes,
+				and elsewhere waiting falls back to polling the word with short sleeps.
+ *	@author		James Horner
+ */
+
+#ifndef GENERIC_SHARED_MEMORY_FUTEX_H
+#define GENERIC_SHARED_MEMORY_FUTEX_H
+
+// C++ Standard Library Headers
+#include <atomic>
+#include <chrono>
+#include <climits>
+#include <cstdint>
+#include <thread>
+
+// Platform Dependant System Libraries
+#ifdef __linux__
+#include <cerrno>
+#include <ctime>
+#include <unistd.h>         // Needed for syscall()
+#include <sys/syscall.h>    // Needed for SYS_futex
+#include <linux/futex.h>    // Needed for FUTEX_WAIT and FUTEX_WAKE
+#endif
+
+/**
+ * @brief Function generic_shared_memory_futex_wait() is used to block while a word in shared memory holds a value.
+ * @param word word to wait on, which may be in memory shared with other processes.
+ * @param expected value to wait while the word holds.
+ * @param timeout_ms time to wait in milliseconds, or -1 to wait indefinitely.
+ * @returns Boolean true when the word no longer holds the value (or the wait was woken), false if the timeout expired.
+ * @note Like any futex wait, it may return spuriously, so callers should check the word again.
+ */
+inline bool generic_shared_memory_futex_wait(std::atomic<uint32_t> *word, uint32_t expected, int timeout_ms = -1)
+{
+#ifdef __linux__
+    struct timespec timeout = {timeout_ms / 1000, (long)(timeout_ms % 1000) * 1000000};
+    // The futex is not private, so it is matched by the physical page and wakes reach every process.
+    if (syscall(SYS_futex, (uint32_t *)word, FUTEX_WAIT, expected, timeout_ms >= 0 ? &timeout : nullptr, nullptr, 0) == 0) {
+        return true;
+    }
+    return errno != ETIMEDOUT;
+#else
+    const auto deadline = std::chrono::steady_clock::now() + std::chrono::milliseconds(timeout_ms);
+    while (word->load(std::memory_order_acquire) == expected) {
+        if (timeout_ms >= 0 && std::chrono::steady_clock::now() >= deadline) {
+            return false;
+        }
+        std::this_thread::sleep_for(std::chrono::microseconds(100));
+    }
+    return true;
+#endif
+}
+
+/**
+ * @brief Function generic_shared_memory_futex_wake() is used to wake threads blocked on a word in shared memory.
+ * @param word word the threads are waiting on.
+ * @param count maximum number of threads to wake.
+ */
+inline void generic_shared_memory_futex_wake(std::atomic<uint32_t> *word, int count = INT_MAX)
+{
+#ifdef __linux__
+    syscall(SYS_futex, (uint32_t *)word, FUTEX_WAKE, count, nullptr, nullptr, 0);
+#else
+    (void)word;
+    (void)count;
+#endif
+}
+
+#endif /* GENERIC_SHARED_MEMORY_FUTEX_H */
@@ -0,0 +1,37 @@
+/**
+ * 	@file		GenericSharedMemoryHash.hpp
+ *	@brief		Definition of the FNV-1a hash used for names and schemas.
+ *	@details	This header file defines the 64-bit FNV-1a hash shared by the log, the slab directory and
+				the schemas of versioned segments. The hash is stored in segments and log records, so
+				every process must compute it the same way.
+ *	@author		James Horner
+ */
+
+#ifndef GENERIC_SHARED_MEMORY_HASH_H
+#define GENERIC_SHARED_MEMORY_HASH_H
+
+// C++ Standard Library Headers
+#include <cstddef>
+#include <cstdint>
+
+/// Initial value of a 64-bit FNV-1a hash.
+#define GENERIC_SHARED_MEMORY_FNV1A_BASIS 14695981039346656037ull
+
+/**
+ * @brief Function generic_shared_memory_fnv1a() is used to compute the 64-bit FNV-1a hash of a buffer.
+ * @param data start of the buffer.
+ * @param size size of the buffer in bytes.
+ * @param hash hash of the preceding data, to continue a hash across several buffers.
+ * @returns FNV-1a hash of the data.
+ */
+inline uint64_t generic_shared_memory_fnv1a(const void *data, std::size_t size, uint64_t hash = GENERIC_SHARED_MEMORY_FNV1A_BASIS)
+{
+    const unsigned char *bytes = (const unsigned char *)data;
+    for (std::size_t i = 0; i < size; i++) {
+        hash ^= bytes[i];
+        hash *= 1099511628211ull;
+    }
+    return hash;
+}
+
+#endif /* GENERIC_SHARED_MEMORY_HASH_H */
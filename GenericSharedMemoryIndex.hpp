@@ -0,0 +1,796 @@
+/**
+ * 	@file		GenericSharedMemoryIndex.hpp
+ *	@brief		Definition of the GenericSharedMemoryIndex class.
+ *	@details	This header file defines an ordered index living in a shared memory segment: a B+tree of
+				fixed capacity whose nodes are whole cache lines and refer to each other by index rather
+				than by pointer, so every process can map the segment anywhere. The tree uses optimistic
+				lock coupling: every node has a version, readers traverse without writing anything and
+				restart if a version they read changed, and writers lock only the nodes they modify, so
+				lookups and range scans run in any process concurrently with inserts and erases.
+ *	@author		James Horner
+ */
+
+#ifndef GENERIC_SHARED_MEMORY_INDEX_H
+#define GENERIC_SHARED_MEMORY_INDEX_H
+
+// C++ Standard Library Headers
+#include <algorithm>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <string>
+#include <thread>
+#include <type_traits>
+
+// Library Headers
+#include "GenericSharedMemoryModel.hpp"
+
+/**
+ * @brief 	Class GenericSharedMemoryIndex is used for management of a connection to a segment holding a B+tree.
+ * @details Inner nodes are split as soon as a writer passes a full one, so the parent of a splitting node always has room.
+ * 			A leaf emptied by erase() is unlinked from its parent and the chain of leaves and its node freed for reuse, and
+ * 			an inner node left with a single child is replaced by that child, so windows of keys sliding through the index
+ * 			reuse the same nodes. Leaves are not merged while they hold keys, so erasing most but not all of the keys of
+ * 			many leaves can still leave insert() out of nodes, when it returns false. A writer that dies while holding a
+ * 			node's lock leaves the node locked, so the index should only be written by processes that are not killed while
+ * 			writing.
+ * @param 	Key datatype of the keys, which must be trivially copyable and ordered by operator<.
+ * @param 	Value datatype of the values, which must be trivially copyable.
+ * @param 	Capacity number of keys the index is sized for.
+ * @param 	NodeBytes size of a node, a multiple of the cache line size.
+ */
+template<typename Key, typename Value, std::size_t Capacity, std::size_t NodeBytes = 256>
+class GenericSharedMemoryIndex {
+    static_assert(std::is_trivially_copyable_v<Key> && std::is_trivially_copyable_v<Value>, "Keys and values must be trivially copyable.");
+    static_assert(NodeBytes % 64 == 0, "Nodes must be a whole number of cache lines.");
+    static_assert(alignof(Key) <= 8 && alignof(Value) <= 8, "Keys and values must be aligned to at most 8 bytes.");
+
+    /// Size of the fields of a node before its keys.
+    static constexpr std::size_t header_bytes = 24;
+
+    /// Function payload_offset() returns the offset of the values or children after the keys of a node with a number of slots.
+    static constexpr std::size_t payload_offset(std::size_t slots) {
+        return (slots * sizeof(Key) + 7) / 8 * 8;
+    }
+
+    /// Function node_bytes() returns the size of a node with a number of slots.
+    static constexpr std::size_t node_bytes(std::size_t slots) {
+        const std::size_t values = slots * sizeof(Value);
+        const std::size_t children = (slots + 1) * sizeof(uint32_t);
+        return header_bytes + payload_offset(slots) + (values > children ? values : children);
+    }
+
+    /// Function make_slots() returns the largest number of keys that fits in a node.
+    static constexpr std::size_t make_slots() {
+        std::size_t slots = 0;
+        while (node_bytes(slots + 1) <= NodeBytes) {
+            slots++;
+        }
+        return slots;
+    }
+
+public:
+    /// Number of keys in a node.
+    static constexpr std::size_t slots = make_slots();
+    static_assert(slots >= 3, "Nodes must hold at least three keys, so use larger nodes.");
+
+private:
+    /// Function make_node_count() returns the number of nodes needed for Capacity keys, with nodes at least half full.
+    static constexpr std::size_t make_node_count() {
+        std::size_t level = (Capacity + slots / 2 - 1) / (slots / 2) + 1;
+        std::size_t total = level;
+        while (level > 1) {
+            level = (level + (slots + 1) / 2 - 1) / ((slots + 1) / 2);
+            total += level;
+        }
+        return total + 2;
+    }
+
+public:
+    /// Number of nodes in the segment.
+    static constexpr std::size_t node_count = make_node_count();
+
+    /**
+     * @brief 	Struct node_t is a node of the tree, used as a leaf or an inner node.
+     * @details The version is a lock and a counter: bit 1 is set while a writer holds the node, bit 0 is unused, and the
+     * 			version is incremented by each unlock. Versions only grow, including across a node being freed and reused,
+     * 			so a reader holding a freed node always fails to validate it. A zeroed node is an empty leaf, so node 0 of a
+     * 			new segment is an empty tree. Leaves hold count keys and their values, and inner nodes count keys and
+     * 			count + 1 children, where child i holds the keys up to and including key i.
+     */
+    struct alignas(64) node_t {
+        /// Version lock of the node.
+        std::atomic<uint64_t> version;
+        /// Number of keys in the node.
+        uint32_t count;
+        /// Non-zero for inner nodes.
+        uint32_t inner;
+        /// Index of the next leaf in key order, or 0 for the last leaf, or of the next free node while the node is free.
+        uint32_t next;
+        /// Keys of the node, followed by the values or children.
+        alignas(8) unsigned char storage[NodeBytes - header_bytes];
+    };
+    static_assert(sizeof(node_t) == NodeBytes && offsetof(node_t, storage) == header_bytes, "Nodes must fill their cache lines exactly.");
+
+    /// Struct header_t is the header of the segment.
+    struct alignas(64) header_t {
+        /// Index of the root node.
+        std::atomic<uint32_t> root;
+        /// Number of nodes allocated after node 0.
+        std::atomic<uint32_t> allocated;
+        /// Number of keys in the tree.
+        std::atomic<uint64_t> size;
+        /// List of freed nodes: the index of the first in the low 32 bits, or 0 if there is none, and a count of the
+        /// nodes taken from it in the high 32 bits, so a node freed and taken again between a read and a swap is noticed.
+        std::atomic<uint64_t> free_nodes;
+    };
+
+    /// Struct layout_t is the structure mapped to the segment.
+    struct layout_t {
+        header_t header;
+        node_t nodes[node_count];
+    };
+
+    /// Constructor for the GenericSharedMemoryIndex class that initialises members, but does not connect shared memory.
+    GenericSharedMemoryIndex(const std::string name, const bool log_warnings = false) :
+        m_model(name, log_warnings)
+    {
+    }
+
+    /**
+     * @brief Function connect() is used to connect the index to its shared memory segment.
+     * @returns Boolean true when the shared memory segment was successfully connected, false otherwise.
+     */
+    bool connect() {
+        return m_model.connect();
+    }
+
+    /**
+     * @brief Function disconnect() is used to disconnect the index from its shared memory segment.
+     * @returns Boolean true when the shared memory segment was successfully disconnected, false otherwise.
+     */
+    bool disconnect() {
+        return m_model.disconnect();
+    }
+
+    /**
+     * @brief Function is_connected() is used to check if the index is connected.
+     * @returns Boolean true when the shared memory is connected, false otherwise.
+     */
+    bool is_connected() {
+        return m_model.is_connected();
+    }
+
+    /// Function size() returns the number of keys in the index, or 0 if it is not connected.
+    std::size_t size() {
+        layout_t *layout = m_model.data;
+        return layout != nullptr ? (std::size_t)layout->header.size.load(std::memory_order_relaxed) : 0;
+    }
+
+    /// Function capacity() returns the number of keys the index is sized for.
+    static constexpr std::size_t capacity() {
+        return Capacity;
+    }
+
+    /**
+     * @brief Function insert() is used to insert a key, or replace the value of a key already in the index.
+     * @param key key to insert.
+     * @param value value of the key.
+     * @returns Boolean true when the key was stored, false if the index is out of nodes or not connected.
+     */
+    bool insert(const Key &key, const Value &value);
+
+    /**
+     * @brief Function erase() is used to remove a key.
+     * @param key key to remove.
+     * @returns Boolean true when the key was removed, false if it was not in the index or the index is not connected.
+     */
+    bool erase(const Key &key);
+
+    /**
+     * @brief Function find() is used to look up the value of a key.
+     * @param key key to look up.
+     * @param value set to the value of the key if it is found.
+     * @returns Boolean true when the key was found, false otherwise.
+     */
+    bool find(const Key &key, Value &value);
+
+    /**
+     * @brief Function scan() is used to visit the keys in a range in order.
+     * @details Each leaf is copied and validated before its entries are visited, so the function sees consistent entries
+     * 			and is never called twice for a key, though entries of different leaves may be from different times.
+     * @param low first key of the range.
+     * @param high key after the range, which is excluded.
+     * @param function function called as function(const Key &, const Value &) for each entry, returning false to stop.
+     * @returns Number of entries visited.
+     */
+    template<typename Function>
+    std::size_t scan(const Key &low, const Key &high, Function &&function);
+
+private:
+    /// Constant locked is the bit of a version set while a writer holds the node.
+    static constexpr uint64_t locked = 2;
+
+    /// Functions keys(), values() and children() return the arrays of a node.
+    static Key *keys(node_t *node) {
+        return (Key *)node->storage;
+    }
+    static Value *values(node_t *node) {
+        return (Value *)(node->storage + payload_offset(slots));
+    }
+    static uint32_t *children(node_t *node) {
+        return (uint32_t *)(node->storage + payload_offset(slots));
+    }
+
+    /// Function read_lock() returns the version of a node, or false if a writer holds it.
+    static bool read_lock(node_t *node, uint64_t &version) {
+        version = node->version.load(std::memory_order_acquire);
+        return (version & locked) == 0;
+    }
+
+    /// Function validate() returns true if a node's version is unchanged since it was read.
+    static bool validate(node_t *node, uint64_t version) {
+        std::atomic_thread_fence(std::memory_order_acquire);
+        return node->version.load(std::memory_order_relaxed) == version;
+    }
+
+    /// Function upgrade() takes the lock of a node if its version is unchanged since it was read.
+    static bool upgrade(node_t *node, uint64_t version) {
+        return node->version.compare_exchange_strong(version, version + locked, std::memory_order_acquire);
+    }
+
+    /// Function unlock() releases the lock of a node, moving it to a new version.
+    static void unlock(node_t *node) {
+        node->version.fetch_add(locked, std::memory_order_release);
+    }
+
+    /// Function lower_bound() returns the position of the first key of a node not less than a key.
+    static uint32_t lower_bound(node_t *node, uint32_t count, const Key &key) {
+        Key *node_keys = keys(node);
+        uint32_t low = 0;
+        uint32_t high = count;
+        while (low < high) {
+            const uint32_t middle = (low + high) / 2;
+            if (node_keys[middle] < key) {
+                low = middle + 1;
+            }
+            else {
+                high = middle;
+            }
+        }
+        return low;
+    }
+
+    /// Function node() returns a node by index, or nullptr for an index out of range read from a changing node.
+    static node_t *node(layout_t *layout, uint32_t index) {
+        return index < node_count ? &layout->nodes[index] : nullptr;
+    }
+
+    /**
+     * @brief Function allocate() takes a freed node, or a node never used, and locks it.
+     * @details A writer holding a stale version of a freed node may have locked it before failing to validate its parent,
+     * 			so the lock is waited for rather than assumed free.
+     * @param layout segment of the tree.
+     * @param index set to the index of the node.
+     * @returns Boolean true when a node was allocated, false if the segment is out of nodes.
+     */
+    static bool allocate(layout_t *layout, uint32_t &index) {
+        uint64_t head = layout->header.free_nodes.load(std::memory_order_acquire);
+        while ((uint32_t)head != 0) {
+            const uint32_t next = layout->nodes[(uint32_t)head].next;
+            if (layout->header.free_nodes.compare_exchange_weak(head, ((head >> 32) + 1) << 32 | next, std::memory_order_acquire)) {
+                break;
+            }
+        }
+        index = (uint32_t)head;
+        if (index == 0) {
+            index = layout->header.allocated.fetch_add(1, std::memory_order_relaxed) + 1;
+            if (index >= node_count) {
+                return false;
+            }
+        }
+        node_t *allocated = &layout->nodes[index];
+        for (uint64_t version = allocated->version.load(std::memory_order_relaxed);; std::this_thread::yield()) {
+            if ((version & locked) == 0 && upgrade(allocated, version)) {
+                return true;
+            }
+            version = allocated->version.load(std::memory_order_relaxed);
+        }
+    }
+
+    /// Function release() returns an unlinked and unlocked node to the free list. Node 0 is never freed, as an index of 0 ends lists of nodes.
+    static void release(layout_t *layout, uint32_t index) {
+        if (index == 0) {
+            return;
+        }
+        uint64_t head = layout->header.free_nodes.load(std::memory_order_relaxed);
+        do {
+            layout->nodes[index].next = (uint32_t)head;
+        } while (!layout->header.free_nodes.compare_exchange_weak(head, (head & ~(uint64_t)UINT32_MAX) | index, std::memory_order_release));
+    }
+
+    /**
+     * @brief Function split() splits a locked full node into itself and a new node, and inserts the new node in the parent.
+     * @param layout segment of the tree.
+     * @param index index of the node.
+     * @param parent locked parent of the node, or nullptr if the node is the root.
+     * @returns Boolean true when the node was split, false if the segment is out of nodes.
+     */
+    bool split(layout_t *layout, uint32_t index, node_t *parent);
+
+    /**
+     * @brief Function reclaim() removes the empty leaf of a key and the inner nodes left with a single child on its path.
+     * @param layout segment of the tree.
+     * @param key key whose leaf was emptied.
+     */
+    void reclaim(layout_t *layout, const Key &key);
+
+    /// Function descend() walks optimistically from the root to the leaf of a key, returning false to restart.
+    bool descend(layout_t *layout, const Key &key, node_t *&parent, uint64_t &parent_version, node_t *&leaf, uint64_t &leaf_version);
+
+    /// Model for the shared memory segment.
+    GenericSharedMemoryModel<layout_t> m_model;
+};
+
+template<typename Key, typename Value, std::size_t Capacity, std::size_t NodeBytes>
+bool GenericSharedMemoryIndex<Key, Value, Capacity, NodeBytes>::split(layout_t *layout, uint32_t index, node_t *parent)
+{
+    // The new nodes are locked until the split is complete, as a freed node may still be read by a stale reader.
+    node_t *left = &layout->nodes[index];
+    uint32_t first;
+    uint32_t root_index = 0;
+    if (!allocate(layout, first)) {
+        return false;
+    }
+    if (parent == nullptr && !allocate(layout, root_index)) {
+        unlock(&layout->nodes[first]);
+        release(layout, first);
+        return false;
+    }
+    node_t *right = &layout->nodes[first];
+    const uint32_t count = left->count;
+    Key separator;
+    right->inner = left->inner;
+    if (left->inner) {
+        // The middle key moves up, and the keys and children after it move to the new node.
+        const uint32_t middle = count / 2;
+        separator = keys(left)[middle];
+        right->count = count - middle - 1;
+        memcpy(keys(right), keys(left) + middle + 1, right->count * sizeof(Key));
+        memcpy(children(right), children(left) + middle + 1, (right->count + 1) * sizeof(uint32_t));
+        left->count = middle;
+        right->next = 0;
+    }
+    else {
+        // The upper half of the entries move to the new leaf, and the last key left behind separates them.
+        const uint32_t middle = (count + 1) / 2;
+        right->count = count - middle;
+        memcpy(keys(right), keys(left) + middle, right->count * sizeof(Key));
+        memcpy((void *)values(right), values(left) + middle, right->count * sizeof(Value));
+        left->count = middle;
+        separator = keys(left)[middle - 1];
+        right->next = left->next;
+        left->next = first;
+    }
+
+    if (parent != nullptr) {
+        // Splitting full inner nodes on the way down leaves the parent room for the separator.
+        const uint32_t position = lower_bound(parent, parent->count, separator);
+        memmove(keys(parent) + position + 1, keys(parent) + position, (parent->count - position) * sizeof(Key));
+        memmove(children(parent) + position + 2, children(parent) + position + 1, (parent->count - position) * sizeof(uint32_t));
+        keys(parent)[position] = separator;
+        children(parent)[position + 1] = first;
+        parent->count++;
+    }
+    else {
+        // Grow the tree by a level, publishing the new root before the old one is unlocked.
+        node_t *root = &layout->nodes[root_index];
+        root->inner = 1;
+        root->next = 0;
+        root->count = 1;
+        keys(root)[0] = separator;
+        children(root)[0] = index;
+        children(root)[1] = first;
+        layout->header.root.store(root_index, std::memory_order_release);
+        unlock(root);
+    }
+    unlock(right);
+    return true;
+}
+
+template<typename Key, typename Value, std::size_t Capacity, std::size_t NodeBytes>
+void GenericSharedMemoryIndex<Key, Value, Capacity, NodeBytes>::reclaim(layout_t *layout, const Key &key)
+{
+    for (;; std::this_thread::yield()) {
+        // Walk down to the leaf of the key, remembering the last separator passed on its left, which is the largest key
+        // of the leaf before it.
+        const uint32_t root = layout->header.root.load(std::memory_order_acquire);
+        node_t *parent = nullptr;
+        uint64_t parent_version = 0;
+        uint32_t position = 0;
+        uint32_t index = root;
+        node_t *current = node(layout, index);
+        uint64_t version;
+        Key bound;
+        bool bounded = false;
+        if (current == nullptr || !read_lock(current, version) || layout->header.root.load(std::memory_order_acquire) != root) {
+            continue;
+        }
+        bool restart = false;
+        while (current->inner) {
+            const uint32_t count = std::min<uint32_t>(current->count, slots);
+            if (count == 0) {
+                // Replace an inner node left with one child by the child, in its parent or as the root.
+                restart = true;
+                if (parent != nullptr && !upgrade(parent, parent_version)) {
+                    break;
+                }
+                if (!upgrade(current, version)) {
+                    if (parent != nullptr) {
+                        unlock(parent);
+                    }
+                    break;
+                }
+                bool spliced = true;
+                if (parent != nullptr) {
+                    children(parent)[position] = children(current)[0];
+                }
+                else if (layout->header.root.load(std::memory_order_acquire) == index) {
+                    layout->header.root.store(children(current)[0], std::memory_order_release);
+                }
+                else {
+                    spliced = false;
+                }
+                unlock(current);
+                if (parent != nullptr) {
+                    unlock(parent);
+                }
+                if (spliced) {
+                    release(layout, index);
+                }
+                break;
+            }
+            const uint32_t child_position = lower_bound(current, count, key);
+            const uint32_t child = children(current)[child_position];
+            Key separator;
+            if (child_position > 0) {
+                memcpy((void *)&separator, &keys(current)[child_position - 1], sizeof(Key));
+            }
+            if ((parent != nullptr && !validate(parent, parent_version)) || !validate(current, version) || node(layout, child) == nullptr) {
+                restart = true;
+                break;
+            }
+            if (child_position > 0) {
+                bound = separator;
+                bounded = true;
+            }
+            parent = current;
+            parent_version = version;
+            position = child_position;
+            index = child;
+            current = node(layout, index);
+            if (!read_lock(current, version)) {
+                restart = true;
+                break;
+            }
+        }
+        if (restart) {
+            continue;
+        }
+
+        // Only an empty leaf that is not the root is removed.
+        const uint32_t count = current->count;
+        if (!validate(current, version)) {
+            continue;
+        }
+        if (count != 0 || parent == nullptr) {
+            return;
+        }
+
+        // Lock the leaf before it, which links to it, unless it is the first leaf, then its parent and the leaf.
+        node_t *previous = nullptr;
+        if (bounded) {
+            node_t *previous_parent;
+            uint64_t previous_parent_version;
+            uint64_t previous_version;
+            if (!descend(layout, bound, previous_parent, previous_parent_version, previous, previous_version) || !upgrade(previous, previous_version)) {
+                continue;
+            }
+            if ((previous_parent != nullptr && !validate(previous_parent, previous_parent_version)) || previous->next != index) {
+                unlock(previous);
+                continue;
+            }
+        }
+        if (!upgrade(parent, parent_version)) {
+            if (previous != nullptr) {
+                unlock(previous);
+            }
+            continue;
+        }
+        if (!upgrade(current, version)) {
+            unlock(parent);
+            if (previous != nullptr) {
+                unlock(previous);
+            }
+            continue;
+        }
+
+        // Remove the leaf and a separator next to it from the parent, so its keys fall to a neighbour, and unlink it.
+        const uint32_t parent_count = parent->count;
+        const uint32_t separator = position < parent_count ? position : position - 1;
+        memmove(keys(parent) + separator, keys(parent) + separator + 1, (parent_count - separator - 1) * sizeof(Key));
+        memmove(children(parent) + position, children(parent) + position + 1, (parent_count - position) * sizeof(uint32_t));
+        parent->count = parent_count - 1;
+        if (previous != nullptr) {
+            previous->next = current->next;
+            unlock(previous);
+        }
+        unlock(current);
+        unlock(parent);
+        release(layout, index);
+
+        // Walk again, to replace the parent if it was left with one child.
+    }
+}
+
+template<typename Key, typename Value, std::size_t Capacity, std::size_t NodeBytes>
+bool GenericSharedMemoryIndex<Key, Value, Capacity, NodeBytes>::descend(layout_t *layout, const Key &key, node_t *&parent, uint64_t &parent_version,
+                                                                      node_t *&leaf, uint64_t &leaf_version)
+{
+    const uint32_t root = layout->header.root.load(std::memory_order_acquire);
+    parent = nullptr;
+    leaf = node(layout, root);
+    if (leaf == nullptr || !read_lock(leaf, leaf_version)) {
+        return false;
+    }
+    // The root may have split after it was read, leaving some keys in a sibling the old root no longer reaches.
+    if (layout->header.root.load(std::memory_order_acquire) != root) {
+        return false;
+    }
+    while (leaf->inner) {
+        const uint32_t count = std::min<uint32_t>(leaf->count, slots);
+        node_t *child = node(layout, children(leaf)[lower_bound(leaf, count, key)]);
+        if (parent != nullptr && !validate(parent, parent_version)) {
+            return false;
+        }
+        if (!validate(leaf, leaf_version) || child == nullptr) {
+            return false;
+        }
+        parent = leaf;
+        parent_version = leaf_version;
+        leaf = child;
+        if (!read_lock(leaf, leaf_version)) {
+            return false;
+        }
+    }
+    return true;
+}
+
+template<typename Key, typename Value, std::size_t Capacity, std::size_t NodeBytes>
+bool GenericSharedMemoryIndex<Key, Value, Capacity, NodeBytes>::insert(const Key &key, const Value &value)
+{
+    layout_t *layout = m_model.data;
+    if (layout == nullptr) {
+        return false;
+    }
+    for (;; std::this_thread::yield()) {
+        // Walk down optimistically, splitting the first full node found and restarting after each split.
+        const uint32_t root = layout->header.root.load(std::memory_order_acquire);
+        node_t *parent = nullptr;
+        uint64_t parent_version = 0;
+        uint32_t index = root;
+        node_t *current = node(layout, index);
+        uint64_t version;
+        if (current == nullptr || !read_lock(current, version) || layout->header.root.load(std::memory_order_acquire) != root) {
+            continue;
+        }
+        bool restart = false;
+        for (;;) {
+            const uint32_t count = current->count;
+            if (count >= slots) {
+                if (parent != nullptr && !upgrade(parent, parent_version)) {
+                    restart = true;
+                    break;
+                }
+                if (!upgrade(current, version)) {
+                    if (parent != nullptr) {
+                        unlock(parent);
+                    }
+                    restart = true;
+                    break;
+                }
+                if (parent == nullptr && layout->header.root.load(std::memory_order_acquire) != index) {
+                    unlock(current);
+                    restart = true;
+                    break;
+                }
+                const bool split_done = split(layout, index, parent);
+                unlock(current);
+                if (parent != nullptr) {
+                    unlock(parent);
+                }
+                if (!split_done) {
+                    return false;
+                }
+                restart = true;
+                break;
+            }
+            if (!current->inner) {
+                break;
+            }
+            const uint32_t child = children(current)[lower_bound(current, count, key)];
+            if ((parent != nullptr && !validate(parent, parent_version)) || !validate(current, version) || node(layout, child) == nullptr) {
+                restart = true;
+                break;
+            }
+            parent = current;
+            parent_version = version;
+            index = child;
+            current = node(layout, index);
+            if (!read_lock(current, version)) {
+                restart = true;
+                break;
+            }
+        }
+        if (restart) {
+            continue;
+        }
+
+        // The leaf has room, so lock it, check the path to it is unchanged, and insert the entry.
+        if (!upgrade(current, version)) {
+            continue;
+        }
+        if (parent != nullptr && !validate(parent, parent_version)) {
+            unlock(current);
+            continue;
+        }
+        const uint32_t count = current->count;
+        const uint32_t position = lower_bound(current, count, key);
+        if (position < count && !(key < keys(current)[position])) {
+            memcpy((void *)&values(current)[position], &value, sizeof(Value));
+        }
+        else {
+            memmove(keys(current) + position + 1, keys(current) + position, (count - position) * sizeof(Key));
+            memmove((void *)(values(current) + position + 1), values(current) + position, (count - position) * sizeof(Value));
+            memcpy((void *)&keys(current)[position], &key, sizeof(Key));
+            memcpy((void *)&values(current)[position], &value, sizeof(Value));
+            current->count = count + 1;
+            layout->header.size.fetch_add(1, std::memory_order_relaxed);
+        }
+        unlock(current);
+        return true;
+    }
+}
+
+template<typename Key, typename Value, std::size_t Capacity, std::size_t NodeBytes>
+bool GenericSharedMemoryIndex<Key, Value, Capacity, NodeBytes>::erase(const Key &key)
+{
+    layout_t *layout = m_model.data;
+    if (layout == nullptr) {
+        return false;
+    }
+    for (;; std::this_thread::yield()) {
+        node_t *parent;
+        uint64_t parent_version;
+        node_t *leaf;
+        uint64_t leaf_version;
+        if (!descend(layout, key, parent, parent_version, leaf, leaf_version) || !upgrade(leaf, leaf_version)) {
+            continue;
+        }
+        if (parent != nullptr && !validate(parent, parent_version)) {
+            unlock(leaf);
+            continue;
+        }
+        const uint32_t count = leaf->count;
+        const uint32_t position = lower_bound(leaf, count, key);
+        const bool found = position < count && !(key < keys(leaf)[position]);
+        if (found) {
+            memmove(keys(leaf) + position, keys(leaf) + position + 1, (count - position - 1) * sizeof(Key));
+            memmove((void *)(values(leaf) + position), values(leaf) + position + 1, (count - position - 1) * sizeof(Value));
+            leaf->count = count - 1;
+            layout->header.size.fetch_sub(1, std::memory_order_relaxed);
+        }
+        unlock(leaf);
+        if (found && count == 1) {
+            reclaim(layout, key);
+        }
+        return found;
+    }
+}
+
+template<typename Key, typename Value, std::size_t Capacity, std::size_t NodeBytes>
+bool GenericSharedMemoryIndex<Key, Value, Capacity, NodeBytes>::find(const Key &key, Value &value)
+{
+    layout_t *layout = m_model.data;
+    if (layout == nullptr) {
+        return false;
+    }
+    for (;; std::this_thread::yield()) {
+        node_t *parent;
+        uint64_t parent_version;
+        node_t *leaf;
+        uint64_t leaf_version;
+        if (!descend(layout, key, parent, parent_version, leaf, leaf_version)) {
+            continue;
+        }
+        const uint32_t count = std::min<uint32_t>(leaf->count, slots);
+        const uint32_t position = lower_bound(leaf, count, key);
+        const bool found = position < count && !(key < keys(leaf)[position]);
+        Value result;
+        if (found) {
+            memcpy((void *)&result, &values(leaf)[position], sizeof(Value));
+        }
+        if ((parent != nullptr && !validate(parent, parent_version)) || !validate(leaf, leaf_version)) {
+            continue;
+        }
+        if (found) {
+            value = result;
+        }
+        return found;
+    }
+}
+
+template<typename Key, typename Value, std::size_t Capacity, std::size_t NodeBytes>
+template<typename Function>
+std::size_t GenericSharedMemoryIndex<Key, Value, Capacity, NodeBytes>::scan(const Key &low, const Key &high, Function &&function)
+{
+    layout_t *layout = m_model.data;
+    if (layout == nullptr || !(low < high)) {
+        return 0;
+    }
+    std::size_t visited = 0;
+    Key from = low;
+    bool after_from = false;
+    Key leaf_keys[slots];
+    Value leaf_values[slots];
+    for (;; std::this_thread::yield()) {
+        // Find the leaf holding the first key not yet visited.
+        node_t *parent;
+        uint64_t parent_version;
+        node_t *leaf;
+        uint64_t leaf_version;
+        if (!descend(layout, from, parent, parent_version, leaf, leaf_version)) {
+            continue;
+        }
+        if (parent != nullptr && !validate(parent, parent_version)) {
+            continue;
+        }
+
+        // Copy and validate each leaf before visiting it, following the links between leaves, and restart from the
+        // last visited key if a leaf changed.
+        for (;;) {
+            const uint32_t count = std::min<uint32_t>(leaf->count, slots);
+            memcpy((void *)leaf_keys, keys(leaf), count * sizeof(Key));
+            memcpy((void *)leaf_values, values(leaf), count * sizeof(Value));
+            node_t *next = leaf->next != 0 ? node(layout, leaf->next) : nullptr;
+            if (!validate(leaf, leaf_version)) {
+                break;
+            }
+            for (uint32_t position = 0; position < count; position++) {
+                const Key &key = leaf_keys[position];
+                if (key < from || (after_from && !(from < key))) {
+                    continue;
+                }
+                if (!(key < high) || !function(key, leaf_values[position])) {
+                    return visited;
+                }
+                visited++;
+                from = key;
+                after_from = true;
+            }
+            // The leaf is validated again once the next leaf's version is read, as the next leaf may have been unlinked and
+            // freed in between.
+            const uint64_t previous_version = leaf_version;
+            if (next == nullptr || !read_lock(next, leaf_version) || !validate(leaf, previous_version)) {
+                if (next == nullptr) {
+                    return visited;
+                }
+                break;
+            }
+            leaf = next;
+        }
+    }
+}
+
+#endif /* GENERIC_SHARED_MEMORY_INDEX_H */
@@ -0,0 +1,559 @@
+/**
+ * 	@file		GenericSharedMemoryKernels.hpp
+ *	@brief		Definition of the GenericSharedMemoryKernels class.
+ *	@details	This header file defines scan, filter and aggregate kernels that run in place on the numeric
+				fields of segments, so queries such as "which entries are over a threshold" or "what is
+				the largest value" need no copy of the segment. The kernels run on columns (such as those
+				of a structure of arrays segment) or on a field of an array of records, and are
+				vectorised for AVX2 and AVX-512, selected at runtime, with a scalar fallback for other
+				processors and compilers.
+ *	@author		James Horner
+ */
+
+#ifndef GENERIC_SHARED_MEMORY_KERNELS_H
+#define GENERIC_SHARED_MEMORY_KERNELS_H
+
+// C++ Standard Library Headers
+#include <algorithm>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <span>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+// Library Headers
+#include "GenericSharedMemoryReflection.hpp"
+
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+#define GENERIC_SHARED_MEMORY_KERNELS_X86
+#define GENERIC_SHARED_MEMORY_KERNELS_AVX2 __attribute__((target("avx2")))
+#define GENERIC_SHARED_MEMORY_KERNELS_AVX512 __attribute__((target("avx512f,avx512bw,avx512dq,avx512vl")))
+#define GENERIC_SHARED_MEMORY_KERNELS_INLINE __attribute__((always_inline)) inline
+#else
+#define GENERIC_SHARED_MEMORY_KERNELS_INLINE inline
+#endif
+
+/// Comparison applied by the filter and count kernels, as value <op> operand.
+enum class GenericSharedMemoryCompare : uint8_t {
+    Less,
+    LessEqual,
+    Greater,
+    GreaterEqual,
+    Equal,
+    NotEqual
+};
+
+/// Instruction set used by the kernels.
+enum class GenericSharedMemoryKernelIsa : uint8_t {
+    Scalar,
+    Avx2,
+    Avx512
+};
+
+/**
+ * @brief 	Struct GenericSharedMemoryColumnView is a view of values spaced a fixed distance apart in memory.
+ * @details A view of a column has a stride of sizeof(T), and a view of a field of an array of records has a stride of the
+ * 			size of a record. Views of columns are what the kernels vectorise best.
+ * @param 	T datatype of the values.
+ */
+template<typename T>
+struct GenericSharedMemoryColumnView {
+    /// First value.
+    const unsigned char *data;
+    /// Number of values.
+    std::size_t size;
+    /// Distance between values in bytes.
+    std::size_t stride;
+
+    /// Constructor for the GenericSharedMemoryColumnView struct that views values a stride apart.
+    GenericSharedMemoryColumnView(const T *values, std::size_t count, std::size_t stride = sizeof(T)) :
+        data((const unsigned char *)values), size(count), stride(stride)
+    {
+    }
+
+    /// Constructor for the GenericSharedMemoryColumnView struct that views a column.
+    GenericSharedMemoryColumnView(std::span<const T> column) :
+        GenericSharedMemoryColumnView(column.data(), column.size())
+    {
+    }
+    GenericSharedMemoryColumnView(std::span<T> column) :
+        GenericSharedMemoryColumnView(column.data(), column.size())
+    {
+    }
+
+    /// Operator [] returns a value of the view.
+    T operator[](std::size_t index) const {
+        T value;
+        memcpy(&value, data + index * stride, sizeof(T));
+        return value;
+    }
+
+    /// Function contiguous() returns true if the values are adjacent.
+    bool contiguous() const {
+        return stride == sizeof(T);
+    }
+};
+
+/// Namespace generic_shared_memory_kernels_detail holds the kernels, written once for every instruction set.
+namespace generic_shared_memory_kernels_detail {
+#ifdef GENERIC_SHARED_MEMORY_KERNELS_X86
+    /// Struct vector holds the GCC vector type of Bytes bytes of T.
+    template<typename T, std::size_t Bytes>
+    struct vector {
+        typedef T type __attribute__((vector_size(Bytes)));
+    };
+#else
+    /// Struct vector is never instantiated without vector extensions, but lets the kernels parse.
+    template<typename T, std::size_t Bytes>
+    struct vector {
+        using type = T;
+    };
+#endif
+    template<typename T, std::size_t Bytes>
+    using vector_t = typename vector<T, Bytes>::type;
+
+    /// Type accumulating sums of T, wide enough to not overflow for practical sizes and of the same signedness as T.
+    template<typename T>
+    using sum_t = std::conditional_t<std::is_floating_point_v<T>, double, std::conditional_t<std::is_signed_v<T>, int64_t, uint64_t>>;
+
+    /// Type of the result of a comparison of A, a bool for scalars or lanes of all ones or zero for vectors.
+    template<typename A>
+    using mask_t = decltype(std::declval<A>() < std::declval<A>());
+
+    /// Constant simd is true for the types the vectorised kernels handle.
+    template<typename T>
+    constexpr bool simd = (std::is_integral_v<T> || std::is_floating_point_v<T>) && !std::is_same_v<T, bool> && (sizeof(T) == 4 || sizeof(T) == 8);
+
+    /**
+     * @brief Function compare() applies a comparison to scalars, or lane by lane to vectors giving lanes of all ones or zero.
+     * @details Vectors are passed by reference rather than returned, as a vector returned from a function compiled
+     * 			without AVX has a different ABI, which GCC warns about even when the function is inlined.
+     */
+    template<GenericSharedMemoryCompare Op, typename A>
+    GENERIC_SHARED_MEMORY_KERNELS_INLINE void compare(const A &a, const A &b, mask_t<A> &result) {
+        if constexpr (Op == GenericSharedMemoryCompare::Less) { result = a < b; }
+        else if constexpr (Op == GenericSharedMemoryCompare::LessEqual) { result = a <= b; }
+        else if constexpr (Op == GenericSharedMemoryCompare::Greater) { result = a > b; }
+        else if constexpr (Op == GenericSharedMemoryCompare::GreaterEqual) { result = a >= b; }
+        else if constexpr (Op == GenericSharedMemoryCompare::Equal) { result = a == b; }
+        else { result = a != b; }
+    }
+
+    /// Function load() loads the vector of values starting at an index of a view.
+    template<bool Contiguous, typename V, typename T>
+    GENERIC_SHARED_MEMORY_KERNELS_INLINE void load(const GenericSharedMemoryColumnView<T> &view, std::size_t index, V &values) {
+        if constexpr (Contiguous) {
+            memcpy(&values, view.data + index * sizeof(T), sizeof(V));
+        }
+        else {
+            for (std::size_t lane = 0; lane < sizeof(V) / sizeof(T); lane++) {
+                values[lane] = view[index + lane];
+            }
+        }
+    }
+
+    /// Function lanes_any() returns true if any lane of a comparison is set.
+    template<typename M>
+    GENERIC_SHARED_MEMORY_KERNELS_INLINE bool lanes_any(const M &mask) {
+        auto any = mask[0];
+        for (std::size_t lane = 1; lane < sizeof(M) / sizeof(mask[0]); lane++) {
+            any |= mask[lane];
+        }
+        return any != 0;
+    }
+
+    /// Struct count_kernel counts the values of a view satisfying a comparison.
+    template<GenericSharedMemoryCompare Op, typename T>
+    struct count_kernel {
+        template<std::size_t Bytes, bool Contiguous>
+        static GENERIC_SHARED_MEMORY_KERNELS_INLINE std::size_t run(const GenericSharedMemoryColumnView<T> &view, T operand) {
+            std::size_t index = 0;
+            std::size_t total = 0;
+            if constexpr (Bytes != 0) {
+                using V = vector_t<T, Bytes>;
+                constexpr std::size_t lanes = Bytes / sizeof(T);
+                const V operands = V{} + operand;
+                V values;
+                mask_t<V> mask;
+                mask_t<V> counts = {};
+                for (; index + lanes <= view.size; index += lanes) {
+                    load<Contiguous>(view, index, values);
+                    compare<Op>(values, operands, mask);
+                    counts -= mask;
+                }
+                for (std::size_t lane = 0; lane < lanes; lane++) {
+                    total += (std::size_t)counts[lane];
+                }
+            }
+            for (; index < view.size; index++) {
+                bool selected;
+                compare<Op>(view[index], operand, selected);
+                total += selected ? 1 : 0;
+            }
+            return total;
+        }
+    };
+
+    /// Struct filter_kernel writes the indices of the values of a view satisfying a comparison.
+    template<GenericSharedMemoryCompare Op, typename T>
+    struct filter_kernel {
+        template<std::size_t Bytes, bool Contiguous>
+        static GENERIC_SHARED_MEMORY_KERNELS_INLINE std::size_t run(const GenericSharedMemoryColumnView<T> &view, T operand, uint32_t *selection) {
+            std::size_t index = 0;
+            std::size_t selected = 0;
+            if constexpr (Bytes != 0) {
+                using V = vector_t<T, Bytes>;
+                constexpr std::size_t lanes = Bytes / sizeof(T);
+                const V operands = V{} + operand;
+                V values;
+                mask_t<V> mask;
+                for (; index + lanes <= view.size; index += lanes) {
+                    load<Contiguous>(view, index, values);
+                    compare<Op>(values, operands, mask);
+                    if (!lanes_any(mask)) {
+                        continue;
+                    }
+                    // Write every index and only advance past the selected ones, which avoids a branch per lane.
+                    for (std::size_t lane = 0; lane < lanes; lane++) {
+                        selection[selected] = (uint32_t)(index + lane);
+                        selected += (std::size_t)(mask[lane] & 1);
+                    }
+                }
+            }
+            for (; index < view.size; index++) {
+                bool matches;
+                compare<Op>(view[index], operand, matches);
+                selection[selected] = (uint32_t)index;
+                selected += matches ? 1 : 0;
+            }
+            return selected;
+        }
+    };
+
+    /// Struct sum_kernel sums the values of a view.
+    template<typename T>
+    struct sum_kernel {
+        template<std::size_t Bytes, bool Contiguous>
+        static GENERIC_SHARED_MEMORY_KERNELS_INLINE sum_t<T> run(const GenericSharedMemoryColumnView<T> &view) {
+            std::size_t index = 0;
+            sum_t<T> total = 0;
+            if constexpr (Bytes != 0) {
+                using V = vector_t<T, Bytes>;
+                constexpr std::size_t lanes = Bytes / sizeof(T);
+                using W = vector_t<sum_t<T>, lanes * sizeof(sum_t<T>)>;
+                V values;
+                W totals = {};
+                for (; index + lanes <= view.size; index += lanes) {
+                    load<Contiguous>(view, index, values);
+                    totals += __builtin_convertvector(values, W);
+                }
+                for (std::size_t lane = 0; lane < lanes; lane++) {
+                    total += totals[lane];
+                }
+            }
+            for (; index < view.size; index++) {
+                total += (sum_t<T>)view[index];
+            }
+            return total;
+        }
+    };
+
+    /// Struct extremes_kernel finds the smallest and largest values of a non-empty view.
+    template<typename T>
+    struct extremes_kernel {
+        template<std::size_t Bytes, bool Contiguous>
+        static GENERIC_SHARED_MEMORY_KERNELS_INLINE std::pair<T, T> run(const GenericSharedMemoryColumnView<T> &view) {
+            std::size_t index = 0;
+            T smallest = view[0];
+            T largest = view[0];
+            if constexpr (Bytes != 0) {
+                using V = vector_t<T, Bytes>;
+                constexpr std::size_t lanes = Bytes / sizeof(T);
+                if (view.size >= lanes) {
+                    V smallests;
+                    load<Contiguous>(view, 0, smallests);
+                    V largests = smallests;
+                    V values;
+                    for (index = lanes; index + lanes <= view.size; index += lanes) {
+                        load<Contiguous>(view, index, values);
+                        smallests = values < smallests ? values : smallests;
+                        largests = values > largests ? values : largests;
+                    }
+                    for (std::size_t lane = 0; lane < lanes; lane++) {
+                        smallest = smallests[lane] < smallest ? smallests[lane] : smallest;
+                        largest = largests[lane] > largest ? largests[lane] : largest;
+                    }
+                }
+            }
+            for (; index < view.size; index++) {
+                const T value = view[index];
+                smallest = value < smallest ? value : smallest;
+                largest = value > largest ? value : largest;
+            }
+            return {smallest, largest};
+        }
+    };
+
+    /// Struct top_kernel finds the indices of the k largest (or smallest) values of a view, best first.
+    template<typename T>
+    struct top_kernel {
+        template<std::size_t Bytes, bool Contiguous>
+        static GENERIC_SHARED_MEMORY_KERNELS_INLINE std::size_t run(const GenericSharedMemoryColumnView<T> &view, std::size_t k, bool largest, uint32_t *indices) {
+            // The heap keeps the worst of the best k at its front, which is the threshold a value must beat.
+            std::vector<std::pair<T, uint32_t>> heap;
+            heap.reserve(k);
+            auto better = [largest](const std::pair<T, uint32_t> &a, const std::pair<T, uint32_t> &b) {
+                return largest ? (a.first > b.first || (a.first == b.first && a.second < b.second))
+                               : (a.first < b.first || (a.first == b.first && a.second < b.second));
+            };
+            auto offer = [&](T value, std::size_t index) {
+                const std::pair<T, uint32_t> entry(value, (uint32_t)index);
+                if (heap.size() < k) {
+                    heap.push_back(entry);
+                    std::push_heap(heap.begin(), heap.end(), better);
+                }
+                else if (better(entry, heap.front())) {
+                    std::pop_heap(heap.begin(), heap.end(), better);
+                    heap.back() = entry;
+                    std::push_heap(heap.begin(), heap.end(), better);
+                }
+            };
+
+            std::size_t index = 0;
+            if constexpr (Bytes != 0) {
+                using V = vector_t<T, Bytes>;
+                constexpr std::size_t lanes = Bytes / sizeof(T);
+                V values;
+                for (; index + lanes <= view.size; index += lanes) {
+                    load<Contiguous>(view, index, values);
+                    // Skip blocks without a value that could enter the heap, which once it fills is nearly all of them. Ties
+                    // never enter, as values are offered in index order.
+                    if (heap.size() == k) {
+                        const V threshold = V{} + heap.front().first;
+                        if (!(largest ? lanes_any(values > threshold) : lanes_any(values < threshold))) {
+                            continue;
+                        }
+                    }
+                    for (std::size_t lane = 0; lane < lanes; lane++) {
+                        offer(values[lane], index + lane);
+                    }
+                }
+            }
+            for (; index < view.size; index++) {
+                offer(view[index], index);
+            }
+
+            std::sort_heap(heap.begin(), heap.end(), better);
+            for (std::size_t i = 0; i < heap.size(); i++) {
+                indices[i] = heap[i].second;
+            }
+            return heap.size();
+        }
+    };
+
+#ifdef GENERIC_SHARED_MEMORY_KERNELS_X86
+    /// Functions run_avx512() and run_avx2() compile a kernel for an instruction set.
+    template<typename Kernel, bool Contiguous, typename T, typename... Args>
+    GENERIC_SHARED_MEMORY_KERNELS_AVX512 auto run_avx512(const GenericSharedMemoryColumnView<T> &view, Args... args) {
+        return Kernel::template run<64, Contiguous>(view, args...);
+    }
+    template<typename Kernel, bool Contiguous, typename T, typename... Args>
+    GENERIC_SHARED_MEMORY_KERNELS_AVX2 auto run_avx2(const GenericSharedMemoryColumnView<T> &view, Args... args) {
+        return Kernel::template run<32, Contiguous>(view, args...);
+    }
+
+    /// Function supported_isa() returns the best instruction set the processor supports.
+    inline GenericSharedMemoryKernelIsa supported_isa() {
+        if (__builtin_cpu_supports("avx512f") && __builtin_cpu_supports("avx512bw") &&
+            __builtin_cpu_supports("avx512dq") && __builtin_cpu_supports("avx512vl")) {
+            return GenericSharedMemoryKernelIsa::Avx512;
+        }
+        return __builtin_cpu_supports("avx2") ? GenericSharedMemoryKernelIsa::Avx2 : GenericSharedMemoryKernelIsa::Scalar;
+    }
+#else
+    inline GenericSharedMemoryKernelIsa supported_isa() {
+        return GenericSharedMemoryKernelIsa::Scalar;
+    }
+#endif
+
+    /// Instruction set used by the kernels, initialised to the best supported.
+    inline std::atomic<GenericSharedMemoryKernelIsa> s_isa = supported_isa();
+
+    /// Function run() runs a kernel with the selected instruction set.
+    template<typename Kernel, typename T, typename... Args>
+    auto run(const GenericSharedMemoryColumnView<T> &view, Args... args) {
+#ifdef GENERIC_SHARED_MEMORY_KERNELS_X86
+        if constexpr (simd<T>) {
+            switch (s_isa.load(std::memory_order_relaxed)) {
+                case GenericSharedMemoryKernelIsa::Avx512:
+                    return view.contiguous() ? run_avx512<Kernel, true>(view, args...) : run_avx512<Kernel, false>(view, args...);
+                case GenericSharedMemoryKernelIsa::Avx2:
+                    return view.contiguous() ? run_avx2<Kernel, true>(view, args...) : run_avx2<Kernel, false>(view, args...);
+                case GenericSharedMemoryKernelIsa::Scalar:
+                    break;
+            }
+        }
+#endif
+        return Kernel::template run<0, false>(view, args...);
+    }
+
+    /// Function with_compare() calls a function with a comparison as a compile time constant.
+    template<typename Function>
+    auto with_compare(GenericSharedMemoryCompare op, Function &&function) {
+        switch (op) {
+            case GenericSharedMemoryCompare::Less: return function(std::integral_constant<GenericSharedMemoryCompare, GenericSharedMemoryCompare::Less>());
+            case GenericSharedMemoryCompare::LessEqual: return function(std::integral_constant<GenericSharedMemoryCompare, GenericSharedMemoryCompare::LessEqual>());
+            case GenericSharedMemoryCompare::Greater: return function(std::integral_constant<GenericSharedMemoryCompare, GenericSharedMemoryCompare::Greater>());
+            case GenericSharedMemoryCompare::GreaterEqual: return function(std::integral_constant<GenericSharedMemoryCompare, GenericSharedMemoryCompare::GreaterEqual>());
+            case GenericSharedMemoryCompare::Equal: return function(std::integral_constant<GenericSharedMemoryCompare, GenericSharedMemoryCompare::Equal>());
+            default: return function(std::integral_constant<GenericSharedMemoryCompare, GenericSharedMemoryCompare::NotEqual>());
+        }
+    }
+}
+
+/**
+ * @brief 	Class GenericSharedMemoryKernels runs scans, filters and aggregates in place on views of segment fields.
+ * @details The kernels read the mapping directly, so for consistent results they must run while the values are not
+ * 			written: under the model's lock (with std::scoped_lock) for writers in the same process, or on a snapshot.
+ * 			Values of 4 and 8 byte arithmetic types are vectorised, other types use the scalar kernels. Floating point
+ * 			NaNs compare as in C++, so they are never selected and may be skipped by min() and max().
+ */
+class GenericSharedMemoryKernels {
+public:
+    /// Function field() returns a view of a reflected field of an array of records.
+    template<std::size_t Index, typename Record>
+    static GenericSharedMemoryColumnView<typename GenericSharedMemoryReflection<Record>::template field_type<Index>> field(const Record *records, std::size_t count) {
+        using field_t = typename GenericSharedMemoryReflection<Record>::template field_type<Index>;
+        return GenericSharedMemoryColumnView<field_t>(
+            (const field_t *)((const unsigned char *)records + GenericSharedMemoryReflection<Record>::template offset_of<Index>()), count, sizeof(Record));
+    }
+
+    /**
+     * @brief Function count() is used to count the values satisfying a comparison.
+     * @param view values to scan.
+     * @param op comparison applied as value <op> operand.
+     * @param operand value compared against.
+     * @returns Number of values satisfying the comparison.
+     */
+    template<typename T>
+    static std::size_t count(GenericSharedMemoryColumnView<T> view, GenericSharedMemoryCompare op, T operand) {
+        return generic_shared_memory_kernels_detail::with_compare(op, [&](auto constant) {
+            return generic_shared_memory_kernels_detail::run<generic_shared_memory_kernels_detail::count_kernel<decltype(constant)::value, T>>(view, operand);
+        });
+    }
+
+    /**
+     * @brief Function filter() is used to find the values satisfying a comparison.
+     * @param view values to scan.
+     * @param op comparison applied as value <op> operand.
+     * @param operand value compared against.
+     * @param selection selection vector the indices of the values are written to in order, with room for view.size indices.
+     * @returns Number of indices written to the selection vector.
+     */
+    template<typename T>
+    static std::size_t filter(GenericSharedMemoryColumnView<T> view, GenericSharedMemoryCompare op, T operand, uint32_t *selection) {
+        return generic_shared_memory_kernels_detail::with_compare(op, [&](auto constant) {
+            return generic_shared_memory_kernels_detail::run<generic_shared_memory_kernels_detail::filter_kernel<decltype(constant)::value, T>>(view, operand, selection);
+        });
+    }
+
+    /// Function sum() returns the sum of the values, as a double for floating point values, a uint64_t for unsigned values and an int64_t otherwise.
+    template<typename T>
+    static generic_shared_memory_kernels_detail::sum_t<T> sum(GenericSharedMemoryColumnView<T> view) {
+        return generic_shared_memory_kernels_detail::run<generic_shared_memory_kernels_detail::sum_kernel<T>>(view);
+    }
+
+    /// Function sum() returns the sum of the values at the indices of a selection vector.
+    template<typename T>
+    static generic_shared_memory_kernels_detail::sum_t<T> sum(GenericSharedMemoryColumnView<T> view, const uint32_t *selection, std::size_t selected) {
+        generic_shared_memory_kernels_detail::sum_t<T> total = 0;
+        for (std::size_t i = 0; i < selected; i++) {
+            total += (generic_shared_memory_kernels_detail::sum_t<T>)view[selection[i]];
+        }
+        return total;
+    }
+
+    /// Function mean() returns the mean of the values, or 0 if there are none.
+    template<typename T>
+    static double mean(GenericSharedMemoryColumnView<T> view) {
+        return view.size > 0 ? (double)sum(view) / (double)view.size : 0.0;
+    }
+
+    /// Function mean() returns the mean of the values at the indices of a selection vector, or 0 if there are none.
+    template<typename T>
+    static double mean(GenericSharedMemoryColumnView<T> view, const uint32_t *selection, std::size_t selected) {
+        return selected > 0 ? (double)sum(view, selection, selected) / (double)selected : 0.0;
+    }
+
+    /**
+     * @brief Function min() is used to find the smallest value.
+     * @param view values to scan.
+     * @param result set to the smallest value.
+     * @returns Boolean true when there are values, false if the view is empty.
+     */
+    template<typename T>
+    static bool min(GenericSharedMemoryColumnView<T> view, T &result) {
+        if (view.size == 0) {
+            return false;
+        }
+        result = generic_shared_memory_kernels_detail::run<generic_shared_memory_kernels_detail::extremes_kernel<T>>(view).first;
+        return true;
+    }
+
+    /**
+     * @brief Function max() is used to find the largest value.
+     * @param view values to scan.
+     * @param result set to the largest value.
+     * @returns Boolean true when there are values, false if the view is empty.
+     */
+    template<typename T>
+    static bool max(GenericSharedMemoryColumnView<T> view, T &result) {
+        if (view.size == 0) {
+            return false;
+        }
+        result = generic_shared_memory_kernels_detail::run<generic_shared_memory_kernels_detail::extremes_kernel<T>>(view).second;
+        return true;
+    }
+
+    /**
+     * @brief Function top_k() is used to find the k largest or smallest values.
+     * @param view values to scan.
+     * @param k number of values to find.
+     * @param indices array the indices of the values are written to, best first, with ties in index order.
+     * @param largest true to find the largest values, false for the smallest.
+     * @returns Number of indices written, the smaller of k and view.size.
+     */
+    template<typename T>
+    static std::size_t top_k(GenericSharedMemoryColumnView<T> view, std::size_t k, uint32_t *indices, bool largest = true) {
+        // The heap is reserved for k entries, so k is clamped to the values there are rather than trusted.
+        k = std::min(k, view.size);
+        if (k == 0) {
+            return 0;
+        }
+        return generic_shared_memory_kernels_detail::run<generic_shared_memory_kernels_detail::top_kernel<T>>(view, k, largest, indices);
+    }
+
+    /// Function isa() returns the instruction set used by the kernels.
+    static GenericSharedMemoryKernelIsa isa() {
+        return generic_shared_memory_kernels_detail::s_isa.load(std::memory_order_relaxed);
+    }
+
+    /**
+     * @brief Function set_isa() is used to select the instruction set used by the kernels, such as for benchmarking.
+     * @param isa instruction set to use.
+     * @returns Boolean true when the instruction set was selected, false if the processor does not support it.
+     */
+    static bool set_isa(GenericSharedMemoryKernelIsa isa) {
+        const GenericSharedMemoryKernelIsa supported = generic_shared_memory_kernels_detail::supported_isa();
+        if ((uint8_t)isa > (uint8_t)supported) {
+            return false;
+        }
+        generic_shared_memory_kernels_detail::s_isa.store(isa, std::memory_order_relaxed);
+        return true;
+    }
+};
+
+#endif /* GENERIC_SHARED_MEMORY_KERNELS_H */
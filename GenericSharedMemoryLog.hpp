@@ -0,0 +1,393 @@
+/**
+ * 	@file		GenericSharedMemoryLog.hpp
+ *	@brief		Definition of the GenericSharedMemoryLog class.
+ *	@details	This header file defines a lock-free logging channel used by the shared memory models
+				to report connection failures and other events. Events are pushed as fixed size records
+				into a bounded ring that never blocks the caller, and are drained either by a background
+				thread owned by the log or by an external reader. The ring is a plain standard layout
+				structure, so it can live in process memory or inside a shared memory segment.
+ *	@author		James Horner
+ */
+
+#ifndef GENERIC_SHARED_MEMORY_LOG_H
+#define GENERIC_SHARED_MEMORY_LOG_H
+
+// C++ Standard Library Headers
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <functional>
+#include <mutex>
+#include <new>
+#include <string>
+#include <thread>
+
+// Platform Dependant System Libraries
+#ifdef _WIN32
+#define WIN32_LEAN_AND_MEAN
+#include <Windows.h>
+#else
+#include <unistd.h>     // Needed for getpid()
+#endif
+
+// Library Headers
+#include "GenericSharedMemoryHash.hpp"
+
+/// Severity of an event recorded in the log.
+enum class GenericSharedMemoryLogSeverity : uint8_t {
+    Debug,
+    Info,
+    Warning,
+    Error
+};
+
+/// Kind of event recorded in the log.
+enum class GenericSharedMemoryLogEvent : uint8_t {
+    OpenFailed,
+    TruncateFailed,
+    MapFailed,
+    FixedAddressUnavailable,
+    SchemaIncompatible
+};
+
+/**
+ * @brief 	Struct GenericSharedMemoryLogRecord is a single fixed size entry in the log ring.
+ * @details The record holds everything needed to diagnose a failure without formatting anything on the
+ * 			hot path: the severity, the event, a hash of the segment name (plus a truncated copy of it for
+ * 			humans), the errno / GetLastError() value, the process ID and a wall clock timestamp.
+ */
+struct GenericSharedMemoryLogRecord {
+    /// Wall clock time of the event in nanoseconds since the epoch.
+    uint64_t timestamp_ns;
+    /// FNV-1a hash of the full segment name.
+    uint64_t name_hash;
+    /// Value of errno (or GetLastError() on Windows) at the time of the event.
+    int32_t error_number;
+    /// ID of the process that recorded the event.
+    uint32_t process_id;
+    /// Severity of the event.
+    GenericSharedMemoryLogSeverity severity;
+    /// Kind of the event.
+    GenericSharedMemoryLogEvent event;
+    /// Null terminated, possibly truncated, copy of the segment name.
+    char name[38];
+};
+
+/**
+ * @brief 	Struct GenericSharedMemoryLogRing is a bounded, lock-free, multi-producer multi-consumer ring of log records.
+ * @details The ring follows the sequence-per-slot design, with the sequences stored relative to the slot index so
+ * 			that an all-zero ring (such as a freshly created shared memory segment) is valid and empty. Producers
+ * 			never wait: when the ring is full the record is dropped and counted instead.
+ * @param 	Capacity number of records in the ring, must be a power of two.
+ */
+template<std::size_t Capacity = 1024>
+struct GenericSharedMemoryLogRing {
+    static_assert(Capacity >= 2 && (Capacity & (Capacity - 1)) == 0, "Capacity must be a power of two.");
+
+    /**
+     * @brief Function push() is used to append a record to the ring without blocking.
+     * @param record record to be appended.
+     * @returns Boolean true when the record was stored, false if the ring was full and the record was dropped.
+     */
+    bool push(const GenericSharedMemoryLogRecord &record) {
+        uint64_t position = m_tail.load(std::memory_order_relaxed);
+        for (;;) {
+            slot_t &slot = m_slots[position & (Capacity - 1)];
+            const uint64_t sequence = slot.sequence.load(std::memory_order_acquire) + (position & (Capacity - 1));
+            const int64_t difference = (int64_t)(sequence - position);
+            if (difference == 0) {
+                if (m_tail.compare_exchange_weak(position, position + 1, std::memory_order_relaxed)) {
+                    slot.record = record;
+                    slot.sequence.store(position + 1 - (position & (Capacity - 1)), std::memory_order_release);
+                    return true;
+                }
+            }
+            else if (difference < 0) {
+                m_dropped.fetch_add(1, std::memory_order_relaxed);
+                return false;
+            }
+            else {
+                position = m_tail.load(std::memory_order_relaxed);
+            }
+        }
+    }
+
+    /**
+     * @brief Function pop() is used to remove the oldest record from the ring without blocking.
+     * @param record record that is filled in when one was available.
+     * @returns Boolean true when a record was removed, false if the ring was empty.
+     */
+    bool pop(GenericSharedMemoryLogRecord &record) {
+        uint64_t position = m_head.load(std::memory_order_relaxed);
+        for (;;) {
+            slot_t &slot = m_slots[position & (Capacity - 1)];
+            const uint64_t sequence = slot.sequence.load(std::memory_order_acquire) + (position & (Capacity - 1));
+            const int64_t difference = (int64_t)(sequence - (position + 1));
+            if (difference == 0) {
+                if (m_head.compare_exchange_weak(position, position + 1, std::memory_order_relaxed)) {
+                    record = slot.record;
+                    slot.sequence.store(position + Capacity - (position & (Capacity - 1)), std::memory_order_release);
+                    return true;
+                }
+            }
+            else if (difference < 0) {
+                return false;
+            }
+            else {
+                position = m_head.load(std::memory_order_relaxed);
+            }
+        }
+    }
+
+    /// Function dropped() returns the number of records dropped because the ring was full.
+    uint64_t dropped() const {
+        return m_dropped.load(std::memory_order_relaxed);
+    }
+
+private:
+    /// A slot of the ring, with its sequence stored relative to the slot index.
+    struct slot_t {
+        std::atomic<uint64_t> sequence;
+        GenericSharedMemoryLogRecord record;
+    };
+
+    /// Position of the next record to be written, on its own cache line.
+    alignas(64) std::atomic<uint64_t> m_tail;
+    /// Position of the next record to be read, on its own cache line.
+    alignas(64) std::atomic<uint64_t> m_head;
+    /// Number of records dropped because the ring was full.
+    alignas(64) std::atomic<uint64_t> m_dropped;
+    /// Slots of the ring.
+    alignas(64) slot_t m_slots[Capacity];
+};
+
+/**
+ * @brief 	Class GenericSharedMemoryLog is the process wide logging channel used by the shared memory models.
+ * @details Records are pushed into a process local ring by default, or into any ring supplied through redirect()
+ * 			(for example one mapped into a shared memory segment so that an external reader can drain it). A
+ * 			background drain thread is started on the first record unless one was started explicitly, and by
+ * 			default prints each record to the console, so the models' log_warnings flag keeps printing its
+ * 			warnings without the printing happening under any of the models' locks.
+ */
+class GenericSharedMemoryLog {
+public:
+    /// Type of the ring used by the log.
+    using ring_t = GenericSharedMemoryLogRing<1024>;
+    /// Type of the function called for each drained record.
+    using sink_t = std::function<void(const GenericSharedMemoryLogRecord &)>;
+
+    /// Function instance() returns the process wide log.
+    static GenericSharedMemoryLog &instance() {
+        static GenericSharedMemoryLog log;
+        return log;
+    }
+
+    /**
+     * @brief Function record() is used to push an event into the log without blocking.
+     * @param severity severity of the event.
+     * @param event kind of the event.
+     * @param name name of the segment the event relates to.
+     * @param error_number errno or GetLastError() value associated with the event.
+     * @returns Boolean true when the record was stored, false if it was dropped.
+     */
+    static bool record(GenericSharedMemoryLogSeverity severity, GenericSharedMemoryLogEvent event,
+                       const std::string &name, int error_number) {
+        GenericSharedMemoryLogRecord entry;
+        entry.timestamp_ns = (uint64_t)std::chrono::duration_cast<std::chrono::nanoseconds>(
+            std::chrono::system_clock::now().time_since_epoch()).count();
+        entry.name_hash = hash_name(name);
+        entry.error_number = error_number;
+#ifdef _WIN32
+        entry.process_id = (uint32_t)GetCurrentProcessId();
+#else
+        entry.process_id = (uint32_t)getpid();
+#endif
+        entry.severity = severity;
+        entry.event = event;
+        std::size_t length = name.size() < sizeof(entry.name) - 1 ? name.size() : sizeof(entry.name) - 1;
+        memcpy(entry.name, name.data(), length);
+        entry.name[length] = '\0';
+
+        GenericSharedMemoryLog &log = instance();
+        log.ensure_drain_thread();
+        return log.m_ring.load(std::memory_order_acquire)->push(entry);
+    }
+
+    /**
+     * @brief Function redirect() is used to send future records to a different ring, such as one in shared memory.
+     * @param ring ring to push records to, or nullptr to return to the process local ring.
+     * @note The ring must outlive its use by the log; call redirect(nullptr) before releasing it.
+     */
+    void redirect(ring_t *ring) {
+        m_ring.store(ring != nullptr ? ring : &m_local_ring, std::memory_order_release);
+    }
+
+    /**
+     * @brief Function drain() is used to pass every record currently in the ring to a sink.
+     * @param sink function called once for each record, oldest first.
+     * @returns Number of records drained.
+     */
+    std::size_t drain(const sink_t &sink) {
+        GenericSharedMemoryLogRecord entry;
+        std::size_t count = 0;
+        ring_t *ring = m_ring.load(std::memory_order_acquire);
+        while (ring->pop(entry)) {
+            sink(entry);
+            count++;
+        }
+        return count;
+    }
+
+    /**
+     * @brief Function start_drain_thread() is used to start a background thread that drains the ring into a sink.
+     * @param sink function called for each record, or an empty function to discard records.
+     * @param interval time the thread sleeps when the ring is empty.
+     * @note Any drain thread already running is stopped first.
+     */
+    void start_drain_thread(sink_t sink = print_record, std::chrono::milliseconds interval = std::chrono::milliseconds(10)) {
+        std::scoped_lock<std::mutex> thread_guard(m_thread_lock);
+        start_drain_thread_locked(sink, interval);
+    }
+
+    /// Function stop_drain_thread() stops the background drain thread after draining the records that remain.
+    void stop_drain_thread() {
+        std::scoped_lock<std::mutex> thread_guard(m_thread_lock);
+        stop_drain_thread_locked();
+    }
+
+    /**
+     * @brief Function set_auto_drain() controls whether the first record starts the default console drain thread.
+     * @param enabled true to start the default drain thread automatically (the default), false to leave draining to the user.
+     */
+    void set_auto_drain(bool enabled) {
+        m_auto_drain.store(enabled, std::memory_order_release);
+    }
+
+    /// Function dropped() returns the number of records dropped by the current ring.
+    uint64_t dropped() const {
+        return m_ring.load(std::memory_order_acquire)->dropped();
+    }
+
+    /// Function hash_name() returns the 64-bit FNV-1a hash of a segment name.
+    static uint64_t hash_name(const std::string &name) {
+        return generic_shared_memory_fnv1a(name.data(), name.size());
+    }
+
+    /// Function event_name() returns a human readable name for an event.
+    static const char *event_name(GenericSharedMemoryLogEvent event) {
+        switch (event) {
+            case GenericSharedMemoryLogEvent::OpenFailed:       return "Couldn't connect to shared memory";
+            case GenericSharedMemoryLogEvent::TruncateFailed:   return "Couldn't truncate shared memory";
+            case GenericSharedMemoryLogEvent::MapFailed:        return "Couldn't map view of file to shared memory";
+            case GenericSharedMemoryLogEvent::FixedAddressUnavailable: return "Couldn't map shared memory at its fixed address";
+            case GenericSharedMemoryLogEvent::SchemaIncompatible: return "Shared memory schema is incompatible";
+        }
+        return "Unknown event";
+    }
+
+    /// Function print_record() is the default sink, printing one line per record to the console.
+    static void print_record(const GenericSharedMemoryLogRecord &record) {
+        printf("%s with name: %s (error: %d, pid: %u)\n",
+            event_name(record.event), record.name, (int)record.error_number, (unsigned)record.process_id);
+    }
+
+    /// Function prepare_fork() is called before fork() so that no lock of the log is held by another thread in the child.
+    void prepare_fork() {
+        m_thread_lock.lock();
+        m_stop_lock.lock();
+    }
+
+    /// Function parent_after_fork() is called in the parent after fork() to release the locks taken by prepare_fork().
+    void parent_after_fork() {
+        m_stop_lock.unlock();
+        m_thread_lock.unlock();
+    }
+
+    /**
+     * @brief Function child_after_fork() is called in the child after fork() to release the locks taken by prepare_fork().
+     * @details The drain thread is not duplicated by fork(), so its handle is abandoned and the default drain thread is 
+     * 			started again by the child's first record (if auto draining is enabled).
+     */
+    void child_after_fork() {
+        new (&m_thread) std::thread();
+        m_drain_started.store(false, std::memory_order_release);
+        m_stop_lock.unlock();
+        m_thread_lock.unlock();
+    }
+
+    /// Destructor for the GenericSharedMemoryLog class that stops the drain thread.
+    ~GenericSharedMemoryLog() {
+        stop_drain_thread();
+    }
+
+private:
+    /// Constructor for the GenericSharedMemoryLog class, private as the log is only accessed through instance().
+    GenericSharedMemoryLog() : m_local_ring(), m_ring(&m_local_ring) {}
+
+    /// Function ensure_drain_thread() starts the default drain thread the first time a record is pushed.
+    void ensure_drain_thread() {
+        if (!m_drain_started.load(std::memory_order_acquire) && m_auto_drain.load(std::memory_order_acquire)) {
+            std::scoped_lock<std::mutex> thread_guard(m_thread_lock);
+            if (!m_drain_started.load(std::memory_order_acquire)) {
+                start_drain_thread_locked(print_record, std::chrono::milliseconds(10));
+            }
+        }
+    }
+
+    /// Function start_drain_thread_locked() (re)starts the drain thread, the thread lock must already be held.
+    void start_drain_thread_locked(sink_t sink, std::chrono::milliseconds interval) {
+        stop_drain_thread_locked();
+        m_drain_started.store(true, std::memory_order_release);
+        m_stop = false;
+        m_thread = std::thread([this, sink, interval]() {
+            std::unique_lock<std::mutex> stop_guard(m_stop_lock);
+            for (;;) {
+                stop_guard.unlock();
+                drain(sink ? sink : [](const GenericSharedMemoryLogRecord &) {});
+                stop_guard.lock();
+                if (m_stop) {
+                    break;
+                }
+                m_stop_condition.wait_for(stop_guard, interval);
+            }
+            stop_guard.unlock();
+            // Drain once more so records pushed while stopping are not lost.
+            drain(sink ? sink : [](const GenericSharedMemoryLogRecord &) {});
+        });
+    }
+
+    /// Function stop_drain_thread_locked() stops the drain thread, the thread lock must already be held.
+    void stop_drain_thread_locked() {
+        if (m_thread.joinable()) {
+            {
+                std::scoped_lock<std::mutex> stop_guard(m_stop_lock);
+                m_stop = true;
+            }
+            m_stop_condition.notify_all();
+            m_thread.join();
+        }
+    }
+
+    /// Ring used when the log has not been redirected.
+    ring_t m_local_ring;
+    /// Ring records are currently pushed to.
+    std::atomic<ring_t *> m_ring;
+    /// Flag for if a drain thread has been started, so the default one is not started.
+    std::atomic<bool> m_drain_started{false};
+    /// Flag for if the default drain thread should be started by the first record.
+    std::atomic<bool> m_auto_drain{true};
+    /// Mutex lock protecting the drain thread.
+    std::mutex m_thread_lock;
+    /// Mutex lock and condition used to wake the drain thread when it is stopped.
+    std::mutex m_stop_lock;
+    std::condition_variable m_stop_condition;
+    /// Flag for if the drain thread should exit.
+    bool m_stop = false;
+    /// Background drain thread.
+    std::thread m_thread;
+};
+
+#endif /* GENERIC_SHARED_MEMORY_LOG_H */
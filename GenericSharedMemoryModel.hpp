@@ -14,21 +14,64 @@
 #define GENERIC_SHARED_MEMORY_MODEL_H
 
 // C++ Standard Library Headers
+#include <algorithm>
+#include <atomic>
+#include <concepts>
+#include <cstdint>
 #include <cstring>
 #include <mutex>
 #include <string>
+#include <thread>
+#include <type_traits>
+#include <vector>
 
-// Platform Dependant System Libraries
-#ifdef _WIN32
-#define WIN32_LEAN_AND_MEAN
-#include <Windows.h>
-#include <tchar.h>
-#else
-#include <fcntl.h>      // Needed for read/write definitions
-#include <unistd.h>     // Needed for close()
-#include <sys/mman.h>   // For POSIX shared memory via shm_open
-#include <sys/stat.h>
-#endif
+// Library Headers
+#include "GenericSharedMemorySegment.hpp"
+
+/**
+ * @brief 	Struct GenericSharedMemoryLiveBytes is the trait used to find how many leading bytes of a segment's value are in use.
+ * @details get_data() and write_data() copy only the live bytes of a value, so fixed capacity containers such as 
+ * 			GenericSharedMemoryVector copy only their used elements rather than their whole capacity. Types with a 
+ * 			live_bytes() member function report it, and other types are copied whole. The trait can be specialised for 
+ * 			other types whose trailing bytes are not always in use.
+ * @param 	T datatype of the value.
+ */
+template<typename T>
+struct GenericSharedMemoryLiveBytes {
+    /// Flag for if values of the type may have fewer live bytes than their size.
+    static constexpr bool is_partial = requires (const T &value) { { value.live_bytes() } -> std::convertible_to<std::size_t>; };
+
+    /// Function size() returns the number of leading bytes of a value that are in use, at most sizeof(T).
+    static std::size_t size(const T &value) {
+        if constexpr (is_partial) {
+            return std::min<std::size_t>(value.live_bytes(), sizeof(T));
+        }
+        else {
+            return sizeof(T);
+        }
+    }
+};
+
+/**
+ * @brief 	Struct GenericSharedMemoryFixedAddress is a segment layout recording the address its segment is mapped at.
+ * @details Use it as the datatype of a GenericSharedMemoryModel to share plain pointers into the segment between processes. 
+ * 			The first model to connect records the address it mapped the segment at, and every other model maps the segment 
+ * 			at the recorded address or fails to connect, so pointers into the payload are valid in every connected process.
+ * @param 	T datatype of the payload.
+ */
+template<typename T>
+struct GenericSharedMemoryFixedAddress {
+    /// Address the segment is mapped at in every process, or 0 until the first model connects.
+    std::atomic<uint64_t> fixed_address;
+    /// Payload of the segment.
+    T payload;
+};
+
+/// Trait for if a segment layout is a GenericSharedMemoryFixedAddress, so records the address it is mapped at.
+template<typename T>
+struct is_generic_shared_memory_fixed_address : std::false_type {};
+template<typename T>
+struct is_generic_shared_memory_fixed_address<GenericSharedMemoryFixedAddress<T>> : std::true_type {};
 
 /**
  * @brief 	Class GenericSharedMemoryModel is used for management of a connection to a shared memory segment of any type.
@@ -36,18 +79,18 @@
  * 			in any C++ application. The class has functions for connecting to and disconnecting from shared memory along with a function for 
  * 			taking a snapshot of the shared memory segment at any given time. Because the structure that is mapped to shared memory is 
  * 			also public, it can be interacted with directly by the user and therefore can be used to set values in shared memory, unlike 
- * 			the struct returned be get_data().
+ * 			the struct returned be get_data(). The model is a thin typed wrapper around GenericSharedMemoryConnection, which 
+ * 			implements connecting and the rest of the platform code once for every type.
  * @param 	T datatype of the shared memory segment to connect to.
  */
 template<typename T>
-class GenericSharedMemoryModel {
+class GenericSharedMemoryModel : public GenericSharedMemoryConnection {
 public:
     /// Constructor for the GenericSharedMemoryModel class that initialises members, but does not connect shared memory.
     GenericSharedMemoryModel(const std::string name, const bool log_warnings = false) : 
-        m_name(name),
-        m_log_warnings(log_warnings)
+        GenericSharedMemoryConnection(name, log_warnings, child_after_fork)
     {
-        m_is_connected = false;
+        data = nullptr;
     }
 	
     /// Destructor for the GenericSharedMemoryModel class that disconnects from shared memory if the object is deleted.
@@ -60,192 +103,196 @@ public:
      * @brief Function connect() is used to connect the GenericSharedMemoryModel object to the shared memory segment.
      * @returns Boolean true when the shared memory segment was successfully connected, false otherwise.
      */
-    bool connect();
+    bool connect() {
+		// Gain access to the member mutex.
+		std::scoped_lock<GenericSharedMemoryLock> member_guard(m_member_lock);
+        return connect_data_locked();
+    }
 
     /**
      * @brief Function disconnect() is used to disconnect the GenericSharedMemoryModel object from the shared memory segment.
      * @returns Boolean true when the shared memory segment was successfully disconnected, false otherwise.
      */
-    bool disconnect();
+    bool disconnect() {
+		// Gain access to the member mutex.
+		std::scoped_lock<GenericSharedMemoryLock> member_guard(m_member_lock);
+        disconnect_locked(data, sizeof(T));
+        data = nullptr;
+        return true;
+    }
 
     /**
-     * @brief Function is_connected() is used to check if the shared memory is connected.
-     * @returns Boolean true when the shared memory is connected, false otherwise.
+     * @brief Function connect_all() is used to connect many models at once using several threads.
+     * @details Opening and mapping a segment is dominated by system calls, so connecting thousands of small segments 
+     * 			one at a time is slow; this spreads the calls to connect() over a pool of threads.
+     * @param models range of pointers to the models to be connected.
+     * @param thread_count number of threads to use, or 0 to use the number of hardware threads.
+     * @returns Number of models that are connected once the function returns.
      */
-    bool is_connected() {
+    template<typename Range>
+    static std::size_t connect_all(Range &models, unsigned thread_count = 0);
+
+    /**
+     * @brief Function set_idle_unmap() is used to allow the segment to be unmapped by the GenericSharedMemoryMappingRegistry policy.
+     * @details Enabling idle unmapping also enables lazy connection, so that an unmapped model is transparently mapped 
+     * 			again on its next access through get_data() or write_data(). The data pointer is set to nullptr while the 
+     * 			model is unmapped and must not be held across accesses.
+     * @param enabled true to allow the model to be unmapped while idle, false to keep it mapped (the default).
+     */
+    void set_idle_unmap(bool enabled) {
 		// Gain access to the member mutex.
-		std::scoped_lock<std::mutex> member_guard(m_member_lock);
-		return m_is_connected;
-	};
+		std::scoped_lock<GenericSharedMemoryLock> member_guard(m_member_lock);
+        set_idle_unmap_locked(enabled, sizeof(T), idle_action);
+    }
+
+    /**
+     * @brief Function residency() is used to find how much of the segment is resident in memory.
+     * @returns Residency of the segment, with no resident pages if it is not connected.
+     */
+    GenericSharedMemoryResidency residency() {
+		// Gain access to the member mutex.
+		std::scoped_lock<GenericSharedMemoryLock> member_guard(m_member_lock);
+        return generic_shared_memory_residency(m_is_connected ? data : nullptr, sizeof(T));
+    }
+
+    /**
+     * @brief Function advise() is used to advise the kernel about the future use of the segment.
+     * @details Cold segments can be advised out of memory with GenericSharedMemoryAdvice::Cold or PageOut and prefetched 
+     * 			with WillNeed before they are next used. Remove discards the contents of the segment for every process, 
+     * 			so is only suitable for scratch segments that can be rebuilt.
+     * @param advice advice to be given.
+     * @returns Boolean true when the advice was accepted, false if the segment is not connected or the advice failed.
+     */
+    bool advise(GenericSharedMemoryAdvice advice) {
+		// Gain access to the member mutex.
+		std::scoped_lock<GenericSharedMemoryLock> member_guard(m_member_lock);
+        return m_is_connected && generic_shared_memory_advise(data, sizeof(T), advice);
+    }
 
     /**
      * @brief Function get_data() is used to get a read only snapshot of the shared memory segment.
      * @returns T structure that is a snapshot of the shared memory segment at the time of the function call.
      * @note While data is public, it would be best to use get_data() if read only access is needed to shared memory.
+     * 		Only the live bytes of the segment (see GenericSharedMemoryLiveBytes) are copied, the rest of the snapshot is 
+     * 		left uninitialised.
      */
     T get_data() {
 		// Gain access to the member mutex.
-		std::scoped_lock<std::mutex> member_guard(m_member_lock);
-		return *data;
+		std::scoped_lock<GenericSharedMemoryLock> member_guard(m_member_lock);
+        if (!access_locked()) {
+            return T();
+        }
+        if constexpr (GenericSharedMemoryLiveBytes<T>::is_partial) {
+            T snapshot;
+            memcpy((void*)&snapshot, data, GenericSharedMemoryLiveBytes<T>::size(*data));
+            return snapshot;
+        }
+        else {
+            return *data;
+        }
 	};
 
     /**
      * @brief Function write_data() is used to write a new value of the T into the shared memory segment.
-     * @param  new_data T structure to be written into the shared memory segment.
+     * @param  new_data T structure to be written into the shared memory segment, of which only the live bytes are copied.
      */
-	void write_data(const T new_data) {
+	void write_data(const T &new_data) {
 		// Gain access to the member mutex.
-		std::scoped_lock<std::mutex> member_guard(m_member_lock);
-		memcpy(data, &new_data, sizeof(T));
+		std::scoped_lock<GenericSharedMemoryLock> member_guard(m_member_lock);
+        if (!access_locked()) {
+            return;
+        }
+		memcpy((void*)data, &new_data, GenericSharedMemoryLiveBytes<T>::size(new_data));
 	}
 
     /// Public member for the structure that is mapped to the shared memory segment upon the calling of connect().
     T* data;
 
 private:
-    /// Private member for the status of the connection to shared memory.
-    bool m_is_connected;
-    /// Flag for if warnings should be logged to the console (instead of just flagged in return values).
-    bool m_log_warnings;
-    /// Name of the shared memory segment.
-    std::string m_name;
-	/// Mutex lock to protect the members of the class when accessing concurrently.
-	std::mutex m_member_lock;
-
-#ifdef WIN32
-    /// Handle to file mapping object for the connection to shared memory in Windows.
-    HANDLE m_file_mapping_handle;
-#else
-    // ID of the shared memory segment in a UNIX environment.
-    int m_file_mapping_handle;
-#endif
-
-};
-
-template<typename T>
-bool GenericSharedMemoryModel<T>::connect()
-{
-	// Gain access to the member mutex.
-	std::scoped_lock<std::mutex> member_guard(m_member_lock);
-
-    // If shared memory is not connected already,
-    if(!m_is_connected) {
-#ifdef _WIN32
-        // Store the value of the handle returned by CreateFileMappingA so it can be error-checked.
-		// 2023-02-14 JH:	Force use of CreateFileMappingA as on some platforms CreateFileMapping 
-		//					expands to CreateFileMappingW requiring a wide string which a std::string
-		// 					is not always compatible with without conversion.
-        m_file_mapping_handle = CreateFileMappingA(                               
-			INVALID_HANDLE_VALUE,		// Create new file mapping object.
-			NULL,	                    // default security
-			PAGE_READWRITE,		        // read/write access
-			0,						    // maximum object size (high-order DWORD)
-			sizeof(T),		// maximum object size (low-order DWORD)
-			m_name.c_str());				// name of mapping object 
-        
-        // If the handle is invalid,
-        if (m_file_mapping_handle == NULL){
-            // Return failure.
-            if (m_log_warnings) {
-                printf("Couldn't connect to shared memory with name: %s\n", m_name.c_str());
-            }
-            m_is_connected = false;
-            return false;
+    /// Function connect_data_locked() maps the segment as a T, the member mutex must already be held.
+    bool connect_data_locked() {
+        if (!m_is_connected) {
+            std::size_t bytes = sizeof(T);
+            data = (T*)connect_locked(bytes, is_generic_shared_memory_fixed_address<T>::value, idle_action);
         }
+        return m_is_connected;
+    }
 
-        // If the handle is valid, try to map the handle to the T structure.
-		// Cast the new file to the struct from FRL types so we can read/write easily.
-        data = (T*)MapViewOfFile(
-			m_file_mapping_handle,            // assign the map object to the shared data struct.
-			FILE_MAP_ALL_ACCESS, // read/write permission
-			0,
-			0,
-			sizeof(T));
-
-        // If the mapping returned an invalid memory location,
-        if (data == NULL){
-            // Close the file handle, and return failure.
-            if (m_log_warnings) {
-                printf("Couldn't map view of file to shared memory with name: %s\n", m_name.c_str());
-            }
-            CloseHandle(m_file_mapping_handle);
-            m_is_connected = false;
-            return false;
-        }        
-
-        // Set the connection state to true.
-        m_is_connected = true;
-#else
-        // Get an ID for the shared memory segment with the name.
-        m_file_mapping_handle = shm_open(m_name.c_str(), O_CREAT | O_RDWR, 0666); // Create file descriptor for shared mem. Create the mem if it doesn't already exist. Set permissions to 666
-
-        // If the ID is invalid,
-        if (m_file_mapping_handle < 0) {
-            // Could not create the shared memory file descriptor via shm_open()
-            if (m_log_warnings) {
-                // Print an error message and return failure.
-                printf("Couldn't connect to shared memory with name: %s\n", m_name.c_str());
-            }
-			m_is_connected = false;
+    /**
+     * @brief Function access_locked() prepares the segment for an access, the member mutex must already be held.
+     * @returns Boolean true when the segment is mapped (connecting it first if lazy connection is enabled), false otherwise.
+     */
+    bool access_locked() {
+        if (!m_is_connected && !(m_lazy_connect && connect_data_locked())) {
             return false;
         }
+        touch_locked(data, sizeof(T));
+        return true;
+    }
 
-        // Check if this is the first time the segment is being opened, and if so try to truncate it.
-        struct stat mapping_stat;
-        if (fstat(m_file_mapping_handle, &mapping_stat) != -1 && mapping_stat.st_size == 0) {
-            // Try to truncate the file mapping handle to the correct size.
-            if (ftruncate(m_file_mapping_handle, sizeof (T)) != 0) {
-                // Could not truncate shared memory to the correct size.
-                if (m_log_warnings) {
-                    // Print an error message and return failure.
-                    printf("Couldn't truncate shared memory because of error: %d\n", errno);
-                }
-                m_is_connected = false;
-                return false;
-            }
-        }
-
-        // Try to map the shared memory segment to a T structure.
-        data = (T *) mmap(NULL, sizeof(T), PROT_READ | PROT_WRITE, MAP_SHARED, m_file_mapping_handle, 0);
+    /// Function idle_action() is called by the GenericSharedMemoryMappingRegistry to act on the model if it is not in use.
+    static bool idle_action(void *connection, GenericSharedMemoryIdleAction action) {
+        GenericSharedMemoryModel<T> *idle_model = static_cast<GenericSharedMemoryModel<T>*>((GenericSharedMemoryConnection*)connection);
 
-        // If the mapping is unsuccessful,
-        if (data == MAP_FAILED) {
-            // Close the file handle, and return failure.
-            if (m_log_warnings) {
-                printf("Couldn't map view of file to shared memory with name: %s\n", m_name.c_str());
-            }
-            m_is_connected = false;
+        // Only try to gain access to the member mutex, as the registry lock is held and the model may be in use.
+        if (!idle_model->m_member_lock.try_lock()) {
             return false;
         }
+        const bool applied = idle_model->idle_locked(idle_model->data, sizeof(T), action);
+        if (!idle_model->m_is_connected) {
+            idle_model->data = nullptr;
+        }
+        idle_model->m_member_lock.unlock();
+        return applied;
+    }
 
-        // Set the connection state to true.
-        m_is_connected = true;
-#endif
+    /// Function child_after_fork() drops the mapping in a child created by fork() if it was not inherited.
+    static bool child_after_fork(void *connection) {
+        GenericSharedMemoryModel<T> *child_model = static_cast<GenericSharedMemoryModel<T>*>((GenericSharedMemoryConnection*)connection);
+        const bool dropped = child_model->child_after_fork_locked(child_model->data, sizeof(T));
+        if (dropped) {
+            child_model->data = nullptr;
+        }
+        child_model->m_member_lock.unlock();
+        return dropped;
     }
-    // If already connected or the connection process completed without returning false,
-    // Return successfully.
-    return m_is_connected;
-}
+};
 
 template<typename T>
-bool GenericSharedMemoryModel<T>::disconnect()
+template<typename Range>
+std::size_t GenericSharedMemoryModel<T>::connect_all(Range &models, unsigned thread_count)
 {
-	// Gain access to the member mutex.
-	std::scoped_lock<std::mutex> member_guard(m_member_lock);
-
-    // If shared memory is connected currently,
-    if(m_is_connected){
-#ifdef _WIN32
-        UnmapViewOfFile(data);
-        CloseHandle(m_file_mapping_handle);
-        m_is_connected = false;
-#else
-        munmap(data, sizeof (T));
-        close(m_file_mapping_handle);
-        m_is_connected = false;
-#endif
-    }
-    return true;
+    // Collect the models so they can be shared out by index.
+    std::vector<GenericSharedMemoryModel<T>*> pending;
+    for (GenericSharedMemoryModel<T>* model : models) {
+        pending.push_back(model);
+    }
+
+    // Use one thread per hardware thread by default, but never more threads than models.
+    if (thread_count == 0) {
+        thread_count = std::max(1u, std::thread::hardware_concurrency());
+    }
+    thread_count = (unsigned)std::min<std::size_t>(thread_count, pending.size());
+
+    // Each thread takes the next unconnected model until all have been attempted.
+    std::atomic<std::size_t> next_model = 0;
+    std::atomic<std::size_t> connected_count = 0;
+    auto connect_worker = [&]() {
+        for (std::size_t i = next_model++; i < pending.size(); i = next_model++) {
+            if (pending[i]->connect()) {
+                connected_count++;
+            }
+        }
+    };
+    std::vector<std::thread> workers;
+    for (unsigned i = 1; i < thread_count; i++) {
+        workers.emplace_back(connect_worker);
+    }
+    connect_worker();
+    for (std::thread &worker : workers) {
+        worker.join();
+    }
+    return connected_count;
 }
 
 #endif /* GENERIC_SHARED_MEMORY_MODEL_H */
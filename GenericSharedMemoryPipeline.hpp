@@ -0,0 +1,329 @@
+/**
+ * 	@file		GenericSharedMemoryPipeline.hpp
+ *	@brief		Definition of the GenericSharedMemoryPipeline class.
+ *	@details	This header file defines a runner for pipelines of processes connected by channels. The
+				pipeline is read from a description naming its edges, each a queue or latest value channel
+				with its message size and depth, and its stages, each a command optionally pinned to a
+				processor. The runner creates the channels, launches the stages, and samples the counters
+				of every edge, so pipelines can be rewired, rebalanced and profiled by editing the
+				description rather than the stages.
+ *	@author		James Horner
+ */
+
+#ifndef GENERIC_SHARED_MEMORY_PIPELINE_H
+#define GENERIC_SHARED_MEMORY_PIPELINE_H
+
+// C++ Standard Library Headers
+#include <cstddef>
+#include <cstdlib>
+#include <fstream>
+#include <memory>
+#include <sstream>
+#include <string>
+#include <vector>
+
+// Platform Dependant System Libraries
+#include <csignal>
+#include <sched.h>      // Needed for sched_setaffinity()
+#include <unistd.h>     // Needed for fork() and execl()
+#include <sys/wait.h>   // Needed for waitpid()
+
+// Library Headers
+#include "GenericSharedMemoryChannel.hpp"
+
+/// Struct GenericSharedMemoryPipelineEdge describes a channel of a pipeline.
+struct GenericSharedMemoryPipelineEdge {
+    /// Name of the channel's segment.
+    std::string name;
+    /// Kind of the channel.
+    GenericSharedMemoryChannelKind kind;
+    /// Size of a message in bytes.
+    std::size_t message_bytes;
+    /// Maximum number of messages waiting in a queue, 1 for a latest value.
+    std::size_t depth;
+};
+
+/// Struct GenericSharedMemoryPipelineStage describes a process of a pipeline.
+struct GenericSharedMemoryPipelineStage {
+    /// Name of the stage, given to its process in the GENERIC_SHARED_MEMORY_STAGE environment variable.
+    std::string name;
+    /// Processor the stage is pinned to, or -1 to leave it unpinned.
+    int cpu;
+    /// Command run by /bin/sh for the stage.
+    std::string command;
+    /// Process ID of the running stage, or 0 if it is not running.
+    pid_t pid;
+    /// Status returned by waitpid() once the stage exited.
+    int status;
+};
+
+/**
+ * @brief 	Class GenericSharedMemoryPipeline is used to run a pipeline of processes connected by channels.
+ * @details A description has one declaration per line, with blank lines and lines starting with # ignored:
+ * 			    edge <name> queue <message bytes> <depth>
+ * 			    edge <name> latest <message bytes>
+ * 			    stage <name> [cpu=<processor>] <command>
+ * 			Stages find their channels by the edge names written in their commands, and each queue edge should have one
+ * 			writing and one reading stage.
+ */
+class GenericSharedMemoryPipeline {
+public:
+    /**
+     * @brief Function parse() is used to read a pipeline description, replacing any pipeline already read.
+     * @param description text of the description.
+     * @param error set to a message naming the line of the first error, if there is one.
+     * @returns Boolean true when the description was read, false if it has an error.
+     */
+    bool parse(const std::string &description, std::string *error = nullptr);
+
+    /**
+     * @brief Function load() is used to read a pipeline description from a file.
+     * @param path path of the description file.
+     * @param error set to a message describing the first error, if there is one.
+     * @returns Boolean true when the description was read, false if the file could not be read or has an error.
+     */
+    bool load(const std::string &path, std::string *error = nullptr) {
+        std::ifstream file(path);
+        if (!file) {
+            if (error != nullptr) {
+                *error = "Couldn't read pipeline description: " + path;
+            }
+            return false;
+        }
+        std::stringstream text;
+        text << file.rdbuf();
+        return parse(text.str(), error);
+    }
+
+    /// Function edges() returns the edges of the pipeline.
+    const std::vector<GenericSharedMemoryPipelineEdge> &edges() const {
+        return m_edges;
+    }
+
+    /// Function stages() returns the stages of the pipeline.
+    const std::vector<GenericSharedMemoryPipelineStage> &stages() const {
+        return m_stages;
+    }
+
+    /**
+     * @brief Function create_edges() is used to create the channel of every edge, replacing segments of the same names.
+     * @returns Boolean true when every channel was created, false otherwise.
+     */
+    bool create_edges() {
+        m_channels.clear();
+        for (const GenericSharedMemoryPipelineEdge &edge : m_edges) {
+            m_channels.push_back(std::make_unique<GenericSharedMemoryChannel>(edge.name));
+            if (!m_channels.back()->create(edge.kind, edge.message_bytes, edge.depth)) {
+                return false;
+            }
+        }
+        return true;
+    }
+
+    /// Function remove_edges() removes the channel segments of the edges.
+    void remove_edges() {
+        m_channels.clear();
+        for (const GenericSharedMemoryPipelineEdge &edge : m_edges) {
+            GenericSharedMemoryChannel::remove(edge.name);
+        }
+    }
+
+    /// Function edge_stats() returns the counters of every edge, in the order of edges().
+    std::vector<GenericSharedMemoryChannelStats> edge_stats() const {
+        std::vector<GenericSharedMemoryChannelStats> stats;
+        for (const std::unique_ptr<GenericSharedMemoryChannel> &channel : m_channels) {
+            stats.push_back(channel->stats());
+        }
+        stats.resize(m_edges.size());
+        return stats;
+    }
+
+    /**
+     * @brief Function launch() is used to start the process of every stage that is not running.
+     * @details Each stage runs its command with /bin/sh in a process group of its own, pinned to its processor on Linux,
+     * 			and with its name in the GENERIC_SHARED_MEMORY_STAGE environment variable.
+     * @returns Boolean true when every stage was started, false if a process could not be created.
+     */
+    bool launch();
+
+    /**
+     * @brief Function poll() is used to collect the stages that exited, without blocking.
+     * @returns Number of stages still running.
+     */
+    std::size_t poll() {
+        std::size_t running = 0;
+        for (GenericSharedMemoryPipelineStage &stage : m_stages) {
+            if (stage.pid != 0 && waitpid(stage.pid, &stage.status, WNOHANG) == stage.pid) {
+                stage.pid = 0;
+            }
+            running += stage.pid != 0;
+        }
+        return running;
+    }
+
+    /// Function stop() sends a signal to the process group of every running stage, reaching every process of its command.
+    void stop(int signal_number = SIGTERM) {
+        for (const GenericSharedMemoryPipelineStage &stage : m_stages) {
+            if (stage.pid != 0) {
+                kill(-stage.pid, signal_number);
+            }
+        }
+    }
+
+    /// Function wait() blocks until every stage exited.
+    void wait() {
+        for (GenericSharedMemoryPipelineStage &stage : m_stages) {
+            if (stage.pid != 0 && waitpid(stage.pid, &stage.status, 0) == stage.pid) {
+                stage.pid = 0;
+            }
+        }
+    }
+
+    /// Function kind_name() returns the name of a kind of channel in descriptions.
+    static const char *kind_name(GenericSharedMemoryChannelKind kind) {
+        return kind == GenericSharedMemoryChannelKind::Latest ? "latest" : "queue";
+    }
+
+private:
+    /// Function parse_size() reads a positive size, returning 0 if the text is not one.
+    static std::size_t parse_size(const std::string &text) {
+        char *end = nullptr;
+        const unsigned long long value = strtoull(text.c_str(), &end, 10);
+        return !text.empty() && text[0] != '-' && *end == '\0' ? (std::size_t)value : 0;
+    }
+
+    /// Edges of the pipeline.
+    std::vector<GenericSharedMemoryPipelineEdge> m_edges;
+    /// Stages of the pipeline.
+    std::vector<GenericSharedMemoryPipelineStage> m_stages;
+    /// Channels of the edges, once created.
+    std::vector<std::unique_ptr<GenericSharedMemoryChannel>> m_channels;
+};
+
+inline bool GenericSharedMemoryPipeline::parse(const std::string &description, std::string *error)
+{
+    std::vector<GenericSharedMemoryPipelineEdge> edges;
+    std::vector<GenericSharedMemoryPipelineStage> stages;
+    std::istringstream lines(description);
+    std::string line;
+    std::size_t line_number = 0;
+    auto fail = [&](const std::string &message) {
+        if (error != nullptr) {
+            *error = "Line " + std::to_string(line_number) + ": " + message;
+        }
+        return false;
+    };
+    auto is_name_used = [&](const std::string &name) {
+        for (const GenericSharedMemoryPipelineEdge &edge : edges) {
+            if (edge.name == name) {
+                return true;
+            }
+        }
+        for (const GenericSharedMemoryPipelineStage &stage : stages) {
+            if (stage.name == name) {
+                return true;
+            }
+        }
+        return false;
+    };
+
+    while (std::getline(lines, line)) {
+        line_number++;
+        std::istringstream words(line);
+        std::string keyword;
+        std::string name;
+        if (!(words >> keyword) || keyword[0] == '#') {
+            continue;
+        }
+        if (!(words >> name)) {
+            return fail("Missing name.");
+        }
+        if (is_name_used(name)) {
+            return fail("Name used twice: " + name);
+        }
+
+        if (keyword == "edge") {
+            std::string kind;
+            std::string message_bytes;
+            std::string depth = "1";
+            words >> kind >> message_bytes;
+            if (kind == "queue") {
+                depth.clear();
+                words >> depth;
+            }
+            else if (kind != "latest") {
+                return fail("Edge kind must be queue or latest: " + name);
+            }
+            std::string extra;
+            if (parse_size(message_bytes) == 0 || parse_size(depth) == 0 || (words >> extra)) {
+                return fail("Edge needs a message size, and a depth for a queue: " + name);
+            }
+            edges.push_back({name, kind == "queue" ? GenericSharedMemoryChannelKind::Queue : GenericSharedMemoryChannelKind::Latest,
+                             parse_size(message_bytes), parse_size(depth)});
+        }
+        else if (keyword == "stage") {
+            GenericSharedMemoryPipelineStage stage{name, -1, "", 0, 0};
+            std::string command;
+            std::getline(words >> std::ws, command);
+            if (command.rfind("cpu=", 0) == 0) {
+                const std::size_t end = command.find_first_of(" \t");
+                const std::string cpu = command.substr(4, end == std::string::npos ? std::string::npos : end - 4);
+                if (cpu.empty() || cpu.find_first_not_of("0123456789") != std::string::npos) {
+                    return fail("Stage processor must be a number: " + name);
+                }
+                stage.cpu = atoi(cpu.c_str());
+                const std::size_t start = end == std::string::npos ? std::string::npos : command.find_first_not_of(" \t", end);
+                command = start == std::string::npos ? "" : command.substr(start);
+            }
+            if (command.empty()) {
+                return fail("Stage needs a command: " + name);
+            }
+            stage.command = command;
+            stages.push_back(stage);
+        }
+        else {
+            return fail("Unknown declaration: " + keyword);
+        }
+    }
+    m_edges = std::move(edges);
+    m_stages = std::move(stages);
+    m_channels.clear();
+    return true;
+}
+
+inline bool GenericSharedMemoryPipeline::launch()
+{
+    for (GenericSharedMemoryPipelineStage &stage : m_stages) {
+        if (stage.pid != 0) {
+            continue;
+        }
+        const pid_t pid = fork();
+        if (pid < 0) {
+            return false;
+        }
+        // The stage leads a process group, so commands the shell does not exec directly (such as pipes) are stopped
+        // as a whole. Both processes set the group, so it exists whichever runs first.
+        if (pid == 0) {
+            setpgid(0, 0);
+#ifdef __linux__
+            if (stage.cpu >= 0) {
+                cpu_set_t cpus;
+                CPU_ZERO(&cpus);
+                CPU_SET(stage.cpu, &cpus);
+                if (sched_setaffinity(0, sizeof(cpus), &cpus) != 0) {
+                    _exit(127);
+                }
+            }
+#endif
+            setenv("GENERIC_SHARED_MEMORY_STAGE", stage.name.c_str(), 1);
+            execl("/bin/sh", "sh", "-c", stage.command.c_str(), (char *)nullptr);
+            _exit(127);
+        }
+        setpgid(pid, pid);
+        stage.pid = pid;
+        stage.status = 0;
+    }
+    return true;
+}
+
+#endif /* GENERIC_SHARED_MEMORY_PIPELINE_H */
@@ -0,0 +1,165 @@
+/**
+ * 	@file		GenericSharedMemoryProcess.hpp
+ *	@brief		Definition of the process token functions used to record the owners of shared state.
+ *	@details	This header file defines functions for naming the process that owns a lock or an entry
+				in shared memory, and for checking later whether that process has gone. A process ID
+				alone is not enough for this: IDs are reused once a process exits, and processes in
+				different PID namespaces (such as containers sharing /dev/shm) see different IDs for the
+				same process. A token therefore holds the process ID together with tags of the process's
+				start time and PID namespace, and an owner is only judged dead when it was in the same
+				namespace as the caller and its ID is now unused or held by a process started later.
+ *	@author		James Horner
+ */
+
+#ifndef GENERIC_SHARED_MEMORY_PROCESS_H
+#define GENERIC_SHARED_MEMORY_PROCESS_H
+
+// C++ Standard Library Headers
+#include <atomic>
+#include <cerrno>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+
+// Platform Dependant System Libraries
+#ifdef _WIN32
+#include <Windows.h>
+#else
+#include <signal.h>         // Needed for kill()
+#include <unistd.h>         // Needed for getpid()
+#include <sys/stat.h>       // Needed for stat()
+#endif
+
+/// Bit position of the PID namespace tag in a process token.
+#define GENERIC_SHARED_MEMORY_PROCESS_NAMESPACE_SHIFT 32
+/// Bit position of the start time tag in a process token.
+#define GENERIC_SHARED_MEMORY_PROCESS_START_SHIFT 48
+
+/**
+ * @brief Function generic_shared_memory_process_start_tag() returns the low 16 bits of a process's start time.
+ * @param process_id ID of the process.
+ * @param tag set to the tag when it is found.
+ * @returns Boolean true when the start time was found, false if no process has the ID or the start time cannot be read.
+ */
+inline bool generic_shared_memory_process_start_tag(uint32_t process_id, uint16_t &tag)
+{
+#ifdef _WIN32
+    HANDLE process = OpenProcess(PROCESS_QUERY_LIMITED_INFORMATION, FALSE, (DWORD)process_id);
+    if (process == NULL) {
+        return false;
+    }
+    FILETIME creation, exit, kernel, user;
+    const bool found = GetProcessTimes(process, &creation, &exit, &kernel, &user) != 0;
+    CloseHandle(process);
+    // Creation times count 100 ns intervals, so take bits that change between processes started apart.
+    tag = (uint16_t)(creation.dwLowDateTime >> 16);
+    return found;
+#elif defined(__linux__)
+    const std::string path = "/proc/" + std::to_string(process_id) + "/stat";
+    FILE *file = fopen(path.c_str(), "r");
+    if (file == nullptr) {
+        return false;
+    }
+    char buffer[1024];
+    const std::size_t length = fread(buffer, 1, sizeof(buffer) - 1, file);
+    fclose(file);
+    buffer[length] = '\0';
+
+    // The command name may hold spaces, so count the fields from its closing bracket; the start time is field 22.
+    const char *field = strrchr(buffer, ')');
+    for (int index = 2; field != nullptr && index < 22; index++) {
+        field = strchr(field + 1, ' ');
+    }
+    if (field == nullptr) {
+        return false;
+    }
+    tag = (uint16_t)strtoull(field + 1, nullptr, 10);
+    return true;
+#else
+    (void)process_id;
+    (void)tag;
+    return false;
+#endif
+}
+
+/// Function generic_shared_memory_process_namespace_tag() returns the low 16 bits of the caller's PID namespace, or 0 if it is unknown.
+inline uint16_t generic_shared_memory_process_namespace_tag()
+{
+#ifdef __linux__
+    struct stat namespace_stat;
+    if (stat("/proc/self/ns/pid", &namespace_stat) == 0) {
+        return (uint16_t)namespace_stat.st_ino;
+    }
+#endif
+    return 0;
+}
+
+/// Function generic_shared_memory_process_id() returns the ID of the calling process.
+inline uint32_t generic_shared_memory_process_id()
+{
+#ifdef _WIN32
+    return (uint32_t)GetCurrentProcessId();
+#else
+    return (uint32_t)getpid();
+#endif
+}
+
+/**
+ * @brief Function generic_shared_memory_process_token() returns a token naming the calling process.
+ * @details The process ID is in the low 32 bits, followed by 16 bit tags of the PID namespace and the start time. A
+ * 			token is never 0, so 0 can mark state without an owner. The tags are read from /proc, so the token is computed
+ * 			once per process and again in a child once fork() has given it a new ID.
+ */
+inline uint64_t generic_shared_memory_process_token()
+{
+    static std::atomic<uint64_t> s_token(0);
+    const uint32_t process_id = generic_shared_memory_process_id();
+    uint64_t token = s_token.load(std::memory_order_relaxed);
+    if ((uint32_t)token != process_id) {
+        uint16_t start = 0;
+        generic_shared_memory_process_start_tag(process_id, start);
+        token = (uint64_t)process_id |
+            ((uint64_t)generic_shared_memory_process_namespace_tag() << GENERIC_SHARED_MEMORY_PROCESS_NAMESPACE_SHIFT) |
+            ((uint64_t)start << GENERIC_SHARED_MEMORY_PROCESS_START_SHIFT);
+        s_token.store(token, std::memory_order_relaxed);
+    }
+    return token;
+}
+
+/**
+ * @brief Function generic_shared_memory_process_alive() is used to check whether the process named by a token may still exist.
+ * @details Owners in another PID namespace cannot be seen, so they are always taken to be alive. The tags are 16 bits,
+ * 			so a process started a multiple of 65536 clock ticks after a dead owner and given its ID is taken for it.
+ * @param token token of the process, from generic_shared_memory_process_token().
+ * @returns Boolean false only when the process has certainly exited, true otherwise.
+ */
+inline bool generic_shared_memory_process_alive(uint64_t token)
+{
+    const uint32_t process_id = (uint32_t)token;
+    const uint16_t namespace_tag = (uint16_t)(token >> GENERIC_SHARED_MEMORY_PROCESS_NAMESPACE_SHIFT);
+    const uint16_t start_tag = (uint16_t)(token >> GENERIC_SHARED_MEMORY_PROCESS_START_SHIFT);
+    if (namespace_tag != (uint16_t)(generic_shared_memory_process_token() >> GENERIC_SHARED_MEMORY_PROCESS_NAMESPACE_SHIFT)) {
+        return true;
+    }
+
+    // A process with the ID that started at a different time has reused the ID of the owner.
+    uint16_t start = 0;
+    if (generic_shared_memory_process_start_tag(process_id, start)) {
+        return start == start_tag;
+    }
+#ifdef _WIN32
+    HANDLE process = OpenProcess(SYNCHRONIZE, FALSE, (DWORD)process_id);
+    if (process == NULL) {
+        return GetLastError() != ERROR_INVALID_PARAMETER;
+    }
+    const bool alive = WaitForSingleObject(process, 0) == WAIT_TIMEOUT;
+    CloseHandle(process);
+    return alive;
+#else
+    return kill((pid_t)process_id, 0) == 0 || errno != ESRCH;
+#endif
+}
+
+#endif /* GENERIC_SHARED_MEMORY_PROCESS_H */
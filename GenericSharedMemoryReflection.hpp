@@ -0,0 +1,404 @@
+/**
+ * 	@file		GenericSharedMemoryReflection.hpp
+ *	@brief		Definition of the compile time field reflection of segment types.
+ *	@details	This header file defines GenericSharedMemoryReflection, which describes the fields of
+				an aggregate segment type at compile time: how many there are, their types, offsets,
+				sizes and kinds, and (when registered with GENERIC_SHARED_MEMORY_REFLECT) their names.
+				Fields are found by aggregate initialisation and structured bindings, so no hand
+				maintained offsets are needed, and the descriptor table is a constexpr array so it
+				costs nothing at runtime. It is the basis of the library's per-field operations.
+ *	@author		James Horner
+ */
+
+#ifndef GENERIC_SHARED_MEMORY_REFLECTION_H
+#define GENERIC_SHARED_MEMORY_REFLECTION_H
+
+// C++ Standard Library Headers
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <string_view>
+#include <tuple>
+#include <type_traits>
+#include <utility>
+
+/// Maximum number of fields in a reflected type.
+#define GENERIC_SHARED_MEMORY_REFLECTION_MAX_FIELDS 32
+
+/// Kind of value held by a field, for tools that format or export fields without knowing their types.
+enum class GenericSharedMemoryFieldKind : uint8_t {
+    /// Any type not listed below, such as a nested struct or an array.
+    Other,
+    /// bool.
+    Bool,
+    /// Signed integer, including signed char types.
+    Signed,
+    /// Unsigned integer, including unsigned char types.
+    Unsigned,
+    /// Floating point.
+    Float
+};
+
+/// Struct GenericSharedMemoryField describes one field of a reflected type.
+struct GenericSharedMemoryField {
+    /// Name of the field, or empty if the type was not registered with GENERIC_SHARED_MEMORY_REFLECT.
+    std::string_view name;
+    /// Position of the field in the type.
+    std::size_t index;
+    /// Offset of the field from the start of the type in bytes.
+    std::size_t offset;
+    /// Size of the field in bytes.
+    std::size_t size;
+    /// Alignment of the field in bytes.
+    std::size_t alignment;
+    /// Kind of value held by the field.
+    GenericSharedMemoryFieldKind kind;
+};
+
+/**
+ * @brief 	Struct GenericSharedMemoryFieldNames holds the field names registered for a type.
+ * @details Specialised by GENERIC_SHARED_MEMORY_REFLECT with the comma separated list of names; the primary template
+ * 			has no names.
+ */
+template<typename T>
+struct GenericSharedMemoryFieldNames {
+    /// Comma separated names of the fields, or empty if none were registered.
+    static constexpr std::string_view list = "";
+};
+
+/**
+ * @brief Macro GENERIC_SHARED_MEMORY_REFLECT registers the names of the fields of a type, in declaration order.
+ * @details Must be used at global scope, for example GENERIC_SHARED_MEMORY_REFLECT(pose_t, x, y, z). The number of names
+ * 			is checked against the number of fields when the type is reflected.
+ */
+#define GENERIC_SHARED_MEMORY_REFLECT(Type, ...) \
+    template<> \
+    struct GenericSharedMemoryFieldNames<Type> { \
+        static constexpr std::string_view list = #__VA_ARGS__; \
+    }
+
+/// Namespace generic_shared_memory_reflection_detail holds the implementation of GenericSharedMemoryReflection.
+namespace generic_shared_memory_reflection_detail {
+    /// Struct any_t converts to any type, so is used to probe how many initialisers a type accepts.
+    template<std::size_t Index>
+    struct any_t {
+        template<typename U>
+        constexpr operator U() const noexcept;
+    };
+
+    /// Function accepts() returns true if T can be aggregate initialised with one braced initialiser per index.
+    template<typename T, std::size_t... Indices>
+    constexpr bool accepts(std::index_sequence<Indices...>) {
+        // Each initialiser is braced so that arrays and nested aggregates take exactly one initialiser.
+        return requires { T{ {any_t<Indices>{}}... }; };
+    }
+
+    /// Function field_count() returns the number of fields of T, the largest number of initialisers it accepts.
+    template<typename T, std::size_t Count = 0>
+    constexpr std::size_t field_count() {
+        if constexpr (Count < GENERIC_SHARED_MEMORY_REFLECTION_MAX_FIELDS && accepts<T>(std::make_index_sequence<Count + 1>())) {
+            return field_count<T, Count + 1>();
+        }
+        else {
+            return Count;
+        }
+    }
+
+    /// Function tie() returns a tuple of references to the fields of a value with Count fields.
+    template<std::size_t Count, typename T>
+    constexpr auto tie(T &value) {
+        if constexpr (Count == 0) {
+            return std::tuple<>();
+        }
+        else if constexpr (Count == 1) {
+            auto &[f0] = value;
+            return std::tie(f0);
+        }
+        else if constexpr (Count == 2) {
+            auto &[f0, f1] = value;
+            return std::tie(f0, f1);
+        }
+        else if constexpr (Count == 3) {
+            auto &[f0, f1, f2] = value;
+            return std::tie(f0, f1, f2);
+        }
+        else if constexpr (Count == 4) {
+            auto &[f0, f1, f2, f3] = value;
+            return std::tie(f0, f1, f2, f3);
+        }
+        else if constexpr (Count == 5) {
+            auto &[f0, f1, f2, f3, f4] = value;
+            return std::tie(f0, f1, f2, f3, f4);
+        }
+        else if constexpr (Count == 6) {
+            auto &[f0, f1, f2, f3, f4, f5] = value;
+            return std::tie(f0, f1, f2, f3, f4, f5);
+        }
+        else if constexpr (Count == 7) {
+            auto &[f0, f1, f2, f3, f4, f5, f6] = value;
+            return std::tie(f0, f1, f2, f3, f4, f5, f6);
+        }
+        else if constexpr (Count == 8) {
+            auto &[f0, f1, f2, f3, f4, f5, f6, f7] = value;
+            return std::tie(f0, f1, f2, f3, f4, f5, f6, f7);
+        }
+        else if constexpr (Count == 9) {
+            auto &[f0, f1, f2, f3, f4, f5, f6, f7, f8] = value;
+            return std::tie(f0, f1, f2, f3, f4, f5, f6, f7, f8);
+        }
+        else if constexpr (Count == 10) {
+            auto &[f0, f1, f2, f3, f4, f5, f6, f7, f8, f9] = value;
+            return std::tie(f0, f1, f2, f3, f4, f5, f6, f7, f8, f9);
+        }
+        else if constexpr (Count == 11) {
+            auto &[f0, f1, f2, f3, f4, f5, f6, f7, f8, f9, f10] = value;
+            return std::tie(f0, f1, f2, f3, f4, f5, f6, f7, f8, f9, f10);
+        }
+        else if constexpr (Count == 12) {
+            auto &[f0, f1, f2, f3, f4, f5, f6, f7, f8, f9, f10, f11] = value;
+            return std::tie(f0, f1, f2, f3, f4, f5, f6, f7, f8, f9, f10, f11);
+        }
+        else if constexpr (Count == 13) {
+            auto &[f0, f1, f2, f3, f4, f5, f6, f7, f8, f9, f10, f11, f12] = value;
+            return std::tie(f0, f1, f2, f3, f4, f5, f6, f7, f8, f9, f10, f11, f12);
+        }
+        else if constexpr (Count == 14) {
+            auto &[f0, f1, f2, f3, f4, f5, f6, f7, f8, f9, f10, f11, f12, f13] = value;
+            return std::tie(f0, f1, f2, f3, f4, f5, f6, f7, f8, f9, f10, f11, f12, f13);
+        }
+        else if constexpr (Count == 15) {
+            auto &[f0, f1, f2, f3, f4, f5, f6, f7, f8, f9, f10, f11, f12, f13, f14] = value;
+            return std::tie(f0, f1, f2, f3, f4, f5, f6, f7, f8, f9, f10, f11, f12, f13, f14);
+        }
+        else if constexpr (Count == 16) {
+            auto &[f0, f1, f2, f3, f4, f5, f6, f7, f8, f9, f10, f11, f12, f13, f14, f15] = value;
+            return std::tie(f0, f1, f2, f3, f4, f5, f6, f7, f8, f9, f10, f11, f12, f13, f14, f15);
+        }
+        else if constexpr (Count == 17) {
+            auto &[f0, f1, f2, f3, f4, f5, f6, f7, f8, f9, f10, f11, f12, f13, f14, f15, f16] = value;
+            return std::tie(f0, f1, f2, f3, f4, f5, f6, f7, f8, f9, f10, f11, f12, f13, f14, f15, f16);
+        }
+        else if constexpr (Count == 18) {
+            auto &[f0, f1, f2, f3, f4, f5, f6, f7, f8, f9, f10, f11, f12, f13, f14, f15, f16, f17] = value;
+            return std::tie(f0, f1, f2, f3, f4, f5, f6, f7, f8, f9, f10, f11, f12, f13, f14, f15, f16, f17);
+        }
+        else if constexpr (Count == 19) {
+            auto &[f0, f1, f2, f3, f4, f5, f6, f7, f8, f9, f10, f11, f12, f13, f14, f15, f16, f17, f18] = value;
+            return std::tie(f0, f1, f2, f3, f4, f5, f6, f7, f8, f9, f10, f11, f12, f13, f14, f15, f16, f17, f18);
+        }
+        else if constexpr (Count == 20) {
+            auto &[f0, f1, f2, f3, f4, f5, f6, f7, f8, f9, f10, f11, f12, f13, f14, f15, f16, f17, f18, f19] = value;
+            return std::tie(f0, f1, f2, f3, f4, f5, f6, f7, f8, f9, f10, f11, f12, f13, f14, f15, f16, f17, f18, f19);
+        }
+        else if constexpr (Count == 21) {
+            auto &[f0, f1, f2, f3, f4, f5, f6, f7, f8, f9, f10, f11, f12, f13, f14, f15, f16, f17, f18, f19, f20] = value;
+            return std::tie(f0, f1, f2, f3, f4, f5, f6, f7, f8, f9, f10, f11, f12, f13, f14, f15, f16, f17, f18, f19, f20);
+        }
+        else if constexpr (Count == 22) {
+            auto &[f0, f1, f2, f3, f4, f5, f6, f7, f8, f9, f10, f11, f12, f13, f14, f15, f16, f17, f18, f19, f20, f21] = value;
+            return std::tie(f0, f1, f2, f3, f4, f5, f6, f7, f8, f9, f10, f11, f12, f13, f14, f15, f16, f17, f18, f19, f20, f21);
+        }
+        else if constexpr (Count == 23) {
+            auto &[f0, f1, f2, f3, f4, f5, f6, f7, f8, f9, f10, f11, f12, f13, f14, f15, f16, f17, f18, f19, f20, f21, f22] = value;
+            return std::tie(f0, f1, f2, f3, f4, f5, f6, f7, f8, f9, f10, f11, f12, f13, f14, f15, f16, f17, f18, f19, f20, f21, f22);
+        }
+        else if constexpr (Count == 24) {
+            auto &[f0, f1, f2, f3, f4, f5, f6, f7, f8, f9, f10, f11, f12, f13, f14, f15, f16, f17, f18, f19, f20, f21, f22, f23] = value;
+            return std::tie(f0, f1, f2, f3, f4, f5, f6, f7, f8, f9, f10, f11, f12, f13, f14, f15, f16, f17, f18, f19, f20, f21, f22, f23);
+        }
+        else if constexpr (Count == 25) {
+            auto &[f0, f1, f2, f3, f4, f5, f6, f7, f8, f9, f10, f11, f12, f13, f14, f15, f16, f17, f18, f19, f20, f21, f22, f23, f24] = value;
+            return std::tie(f0, f1, f2, f3, f4, f5, f6, f7, f8, f9, f10, f11, f12, f13, f14, f15, f16, f17, f18, f19, f20, f21, f22, f23, f24);
+        }
+        else if constexpr (Count == 26) {
+            auto &[f0, f1, f2, f3, f4, f5, f6, f7, f8, f9, f10, f11, f12, f13, f14, f15, f16, f17, f18, f19, f20, f21, f22, f23, f24, f25] = value;
+            return std::tie(f0, f1, f2, f3, f4, f5, f6, f7, f8, f9, f10, f11, f12, f13, f14, f15, f16, f17, f18, f19, f20, f21, f22, f23, f24, f25);
+        }
+        else if constexpr (Count == 27) {
+            auto &[f0, f1, f2, f3, f4, f5, f6, f7, f8, f9, f10, f11, f12, f13, f14, f15, f16, f17, f18, f19, f20, f21, f22, f23, f24, f25, f26] = value;
+            return std::tie(f0, f1, f2, f3, f4, f5, f6, f7, f8, f9, f10, f11, f12, f13, f14, f15, f16, f17, f18, f19, f20, f21, f22, f23, f24, f25, f26);
+        }
+        else if constexpr (Count == 28) {
+            auto &[f0, f1, f2, f3, f4, f5, f6, f7, f8, f9, f10, f11, f12, f13, f14, f15, f16, f17, f18, f19, f20, f21, f22, f23, f24, f25, f26, f27] = value;
+            return std::tie(f0, f1, f2, f3, f4, f5, f6, f7, f8, f9, f10, f11, f12, f13, f14, f15, f16, f17, f18, f19, f20, f21, f22, f23, f24, f25, f26, f27);
+        }
+        else if constexpr (Count == 29) {
+            auto &[f0, f1, f2, f3, f4, f5, f6, f7, f8, f9, f10, f11, f12, f13, f14, f15, f16, f17, f18, f19, f20, f21, f22, f23, f24, f25, f26, f27, f28] = value;
+            return std::tie(f0, f1, f2, f3, f4, f5, f6, f7, f8, f9, f10, f11, f12, f13, f14, f15, f16, f17, f18, f19, f20, f21, f22, f23, f24, f25, f26, f27, f28);
+        }
+        else if constexpr (Count == 30) {
+            auto &[f0, f1, f2, f3, f4, f5, f6, f7, f8, f9, f10, f11, f12, f13, f14, f15, f16, f17, f18, f19, f20, f21, f22, f23, f24, f25, f26, f27, f28, f29] = value;
+            return std::tie(f0, f1, f2, f3, f4, f5, f6, f7, f8, f9, f10, f11, f12, f13, f14, f15, f16, f17, f18, f19, f20, f21, f22, f23, f24, f25, f26, f27, f28, f29);
+        }
+        else if constexpr (Count == 31) {
+            auto &[f0, f1, f2, f3, f4, f5, f6, f7, f8, f9, f10, f11, f12, f13, f14, f15, f16, f17, f18, f19, f20, f21, f22, f23, f24, f25, f26, f27, f28, f29, f30] = value;
+            return std::tie(f0, f1, f2, f3, f4, f5, f6, f7, f8, f9, f10, f11, f12, f13, f14, f15, f16, f17, f18, f19, f20, f21, f22, f23, f24, f25, f26, f27, f28, f29, f30);
+        }
+        else if constexpr (Count == 32) {
+            auto &[f0, f1, f2, f3, f4, f5, f6, f7, f8, f9, f10, f11, f12, f13, f14, f15, f16, f17, f18, f19, f20, f21, f22, f23, f24, f25, f26, f27, f28, f29, f30, f31] = value;
+            return std::tie(f0, f1, f2, f3, f4, f5, f6, f7, f8, f9, f10, f11, f12, f13, f14, f15, f16, f17, f18, f19, f20, f21, f22, f23, f24, f25, f26, f27, f28, f29, f30, f31);
+        }
+    }
+
+    /// Union probe_t overlays a value with its bytes, so the offsets of its fields can be found in constant expressions.
+    template<typename T>
+    union probe_t {
+        unsigned char bytes[sizeof(T)];
+        T value;
+
+        constexpr probe_t() : bytes{} {}
+        constexpr ~probe_t() {}
+    };
+
+    /// Function kind() returns the kind of value held by a field type.
+    template<typename F>
+    constexpr GenericSharedMemoryFieldKind kind() {
+        if constexpr (std::is_same_v<F, bool>) {
+            return GenericSharedMemoryFieldKind::Bool;
+        }
+        else if constexpr (std::is_integral_v<F> || std::is_enum_v<F>) {
+            using integer_t = typename std::conditional_t<std::is_enum_v<F>, std::underlying_type<F>, std::type_identity<F>>::type;
+            return std::is_signed_v<integer_t> ? GenericSharedMemoryFieldKind::Signed : GenericSharedMemoryFieldKind::Unsigned;
+        }
+        else if constexpr (std::is_floating_point_v<F>) {
+            return GenericSharedMemoryFieldKind::Float;
+        }
+        else {
+            return GenericSharedMemoryFieldKind::Other;
+        }
+    }
+
+    /// Function name_count() returns the number of names in a comma separated list.
+    constexpr std::size_t name_count(std::string_view list) {
+        if (list.empty()) {
+            return 0;
+        }
+        std::size_t count = 1;
+        for (char character : list) {
+            count += character == ',';
+        }
+        return count;
+    }
+
+    /// Function name_at() returns a name from a comma separated list, without surrounding spaces.
+    constexpr std::string_view name_at(std::string_view list, std::size_t index) {
+        for (; index > 0; index--) {
+            list.remove_prefix(list.find(',') + 1);
+        }
+        list = list.substr(0, list.find(','));
+        while (!list.empty() && (list.front() == ' ' || list.front() == '\t' || list.front() == '\n')) {
+            list.remove_prefix(1);
+        }
+        while (!list.empty() && (list.back() == ' ' || list.back() == '\t' || list.back() == '\n')) {
+            list.remove_suffix(1);
+        }
+        return list;
+    }
+}
+
+/**
+ * @brief 	Struct GenericSharedMemoryReflection describes the fields of a segment type at compile time.
+ * @details T must be an aggregate without base classes, reference members or bit-fields, with at most
+ * 			GENERIC_SHARED_MEMORY_REFLECTION_MAX_FIELDS fields, which is what segment types already are. Array and nested
+ * 			struct members are single fields of kind Other. Offsets are found from the addresses of the fields, so they hold for
+ * 			members declared with alignas and for packed types.
+ * @param 	T datatype to reflect.
+ */
+template<typename T>
+struct GenericSharedMemoryReflection {
+    static_assert(std::is_aggregate_v<T>, "Only aggregate types can be reflected.");
+
+    /// Number of fields of the type.
+    static constexpr std::size_t field_count = generic_shared_memory_reflection_detail::field_count<T>();
+
+    /// Function tie() returns a tuple of references to the fields of a value.
+    static constexpr auto tie(T &value) {
+        return generic_shared_memory_reflection_detail::tie<field_count>(value);
+    }
+    static constexpr auto tie(const T &value) {
+        return generic_shared_memory_reflection_detail::tie<field_count>(value);
+    }
+
+    /// Type of a field of the type.
+    template<std::size_t Index>
+    using field_type = std::remove_reference_t<std::tuple_element_t<Index, decltype(tie(std::declval<T&>()))>>;
+
+    /// Function get() returns a reference to a field of a value.
+    template<std::size_t Index>
+    static constexpr field_type<Index> &get(T &value) {
+        return std::get<Index>(tie(value));
+    }
+    template<std::size_t Index>
+    static constexpr const field_type<Index> &get(const T &value) {
+        return std::get<Index>(tie(value));
+    }
+
+    /// Function offset_of() returns the offset of a field from the start of the type in bytes.
+    template<std::size_t Index>
+    static constexpr std::size_t offset_of() {
+        // The field is found among the bytes of a probe rather than placed by its alignment, so members declared with
+        // alignas or inside #pragma pack get their real offsets. The search starts where the previous field ends.
+        std::size_t start = 0;
+        if constexpr (Index > 0) {
+            constexpr std::size_t end = offset_of<Index - 1>() + sizeof(field_type<Index - 1>);
+            start = end;
+        }
+        generic_shared_memory_reflection_detail::probe_t<T> probe;
+        const void *field = std::addressof(std::get<Index>(tie(probe.value)));
+        for (std::size_t offset = start; offset < sizeof(T); offset++) {
+            if (field == static_cast<const void *>(&probe.bytes[offset])) {
+                return offset;
+            }
+        }
+        return sizeof(T);
+    }
+
+    /// Function index_of() returns the position of the field with a name, or field_count if there is none.
+    static constexpr std::size_t index_of(std::string_view name) {
+        for (std::size_t index = 0; index < field_count; index++) {
+            if (fields[index].name == name && !name.empty()) {
+                return index;
+            }
+        }
+        return field_count;
+    }
+
+    /**
+     * @brief Function for_each() calls a function with the descriptor of and a reference to every field of a value.
+     * @param value value whose fields are visited.
+     * @param function function called as function(const GenericSharedMemoryField &, field &).
+     */
+    template<typename Value, typename Function>
+    static constexpr void for_each(Value &value, Function &&function) {
+        static_assert(std::is_same_v<std::remove_const_t<Value>, T>, "The value must be a T.");
+        auto fields_of_value = tie(value);
+        [&]<std::size_t... Indices>(std::index_sequence<Indices...>) {
+            (function(fields[Indices], std::get<Indices>(fields_of_value)), ...);
+        }(std::make_index_sequence<field_count>());
+    }
+
+private:
+    /// Function make_fields() builds the descriptor table of the fields.
+    template<std::size_t... Indices>
+    static constexpr std::array<GenericSharedMemoryField, field_count> make_fields(std::index_sequence<Indices...>) {
+        constexpr std::string_view names = GenericSharedMemoryFieldNames<T>::list;
+        return {{{names.empty() ? std::string_view() : generic_shared_memory_reflection_detail::name_at(names, Indices),
+                  Indices, offset_of<Indices>(), sizeof(field_type<Indices>), alignof(field_type<Indices>),
+                  generic_shared_memory_reflection_detail::kind<std::remove_cv_t<field_type<Indices>>>()}...}};
+    }
+
+    static_assert(GenericSharedMemoryFieldNames<T>::list.empty() ||
+                  generic_shared_memory_reflection_detail::name_count(GenericSharedMemoryFieldNames<T>::list) == field_count,
+                  "GENERIC_SHARED_MEMORY_REFLECT must name every field of the type.");
+
+public:
+    /// Descriptor table of the fields, in declaration order.
+    static constexpr std::array<GenericSharedMemoryField, field_count> fields = make_fields(std::make_index_sequence<field_count>());
+
+    static_assert([]<std::size_t... Indices>(std::index_sequence<Indices...>) {
+                      return ((offset_of<Indices>() + sizeof(field_type<Indices>) <= sizeof(T)) && ...);
+                  }(std::make_index_sequence<field_count>()), "The offsets of the fields of the type could not be found.");
+};
+
+#endif /* GENERIC_SHARED_MEMORY_REFLECTION_H */
@@ -0,0 +1,142 @@
+/**
+ * 	@file		GenericSharedMemoryResidency.hpp
+ *	@brief		Definition of the residency accounting and memory advice functions for shared memory mappings.
+ *	@details	This header file defines functions for measuring how much of a mapped shared memory
+				segment is resident in memory (using mincore()) and for advising the kernel about
+				the future use of a mapping, so that cold segments can be reclaimed and prefetched
+				again before they are used. The functions work on any mapping, so they are used both
+				by GenericSharedMemoryModel and by the residency report tool.
+ *	@author		James Horner
+ */
+
+#ifndef GENERIC_SHARED_MEMORY_RESIDENCY_H
+#define GENERIC_SHARED_MEMORY_RESIDENCY_H
+
+// C++ Standard Library Headers
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+// Platform Dependant System Libraries
+#ifdef _WIN32
+#define WIN32_LEAN_AND_MEAN
+#include <Windows.h>
+#else
+#include <unistd.h>     // Needed for sysconf()
+#include <sys/mman.h>   // Needed for mincore() and madvise()
+#endif
+
+/// Advice that can be given to the kernel about the future use of a mapping.
+enum class GenericSharedMemoryAdvice : uint8_t {
+    /// The mapping will be used soon, so its pages should be read in ahead of time (MADV_WILLNEED).
+    WillNeed,
+    /// The mapping is cold, so its pages should be reclaimed first under memory pressure (MADV_COLD).
+    Cold,
+    /// The mapping is cold, so its pages should be reclaimed now (MADV_PAGEOUT).
+    PageOut,
+    /// The contents of the mapping are scratch and can be discarded, freeing its pages (MADV_REMOVE).
+    Remove
+};
+
+/// Struct GenericSharedMemoryResidency describes how much of a mapping is resident in memory.
+struct GenericSharedMemoryResidency {
+    /// Number of pages of the mapping resident in memory.
+    std::size_t resident_pages;
+    /// Total number of pages in the mapping.
+    std::size_t total_pages;
+    /// Size of a page in bytes.
+    std::size_t page_size;
+};
+
+/// Function generic_shared_memory_page_size() returns the size of a page in bytes.
+inline std::size_t generic_shared_memory_page_size()
+{
+#ifdef _WIN32
+    SYSTEM_INFO system_info;
+    GetSystemInfo(&system_info);
+    return (std::size_t)system_info.dwPageSize;
+#else
+    return (std::size_t)sysconf(_SC_PAGESIZE);
+#endif
+}
+
+/**
+ * @brief Function generic_shared_memory_residency() is used to find how many pages of a mapping are resident in memory.
+ * @param address start of the mapping, which must be page aligned.
+ * @param bytes size of the mapping in bytes.
+ * @returns Residency of the mapping, with resident_pages set to 0 if it could not be determined.
+ * @note On Windows residency cannot be queried for a single mapping, so no pages are reported as resident.
+ */
+inline GenericSharedMemoryResidency generic_shared_memory_residency(const void *address, std::size_t bytes)
+{
+    GenericSharedMemoryResidency residency;
+    residency.page_size = generic_shared_memory_page_size();
+    residency.total_pages = (bytes + residency.page_size - 1) / residency.page_size;
+    residency.resident_pages = 0;
+
+#ifndef _WIN32
+    // mincore() reports the residency of each page in the least significant bit of a byte.
+    std::vector<unsigned char> page_states(residency.total_pages);
+    if (address != nullptr && mincore((void*)address, bytes, page_states.data()) == 0) {
+        for (unsigned char page_state : page_states) {
+            residency.resident_pages += page_state & 1;
+        }
+    }
+#endif
+    return residency;
+}
+
+/**
+ * @brief Function generic_shared_memory_advise() is used to advise the kernel about the future use of a mapping.
+ * @param address start of the mapping, which must be page aligned.
+ * @param bytes size of the mapping in bytes.
+ * @param advice advice to be given.
+ * @returns Boolean true when the advice was accepted, false if it failed or is not supported on the platform.
+ * @note GenericSharedMemoryAdvice::Remove discards the contents of the segment for every process using it.
+ */
+inline bool generic_shared_memory_advise(void *address, std::size_t bytes, GenericSharedMemoryAdvice advice)
+{
+    if (address == nullptr) {
+        return false;
+    }
+#ifdef _WIN32
+    switch (advice) {
+        case GenericSharedMemoryAdvice::WillNeed: {
+            WIN32_MEMORY_RANGE_ENTRY range = {address, bytes};
+            return PrefetchVirtualMemory(GetCurrentProcess(), 1, &range, 0) != 0;
+        }
+        case GenericSharedMemoryAdvice::Cold:
+        case GenericSharedMemoryAdvice::PageOut:
+            return VirtualUnlock(address, bytes) != 0 || GetLastError() == ERROR_NOT_LOCKED;
+        default:
+            return false;
+    }
+#else
+    int native_advice = -1;
+    switch (advice) {
+        case GenericSharedMemoryAdvice::WillNeed:
+            native_advice = MADV_WILLNEED;
+            break;
+#ifdef MADV_COLD
+        case GenericSharedMemoryAdvice::Cold:
+            native_advice = MADV_COLD;
+            break;
+#endif
+#ifdef MADV_PAGEOUT
+        case GenericSharedMemoryAdvice::PageOut:
+            native_advice = MADV_PAGEOUT;
+            break;
+#endif
+#ifdef MADV_REMOVE
+        case GenericSharedMemoryAdvice::Remove:
+            native_advice = MADV_REMOVE;
+            break;
+#endif
+        default:
+            break;
+    }
+    return native_advice != -1 && madvise(address, bytes, native_advice) == 0;
+#endif
+}
+
+#endif /* GENERIC_SHARED_MEMORY_RESIDENCY_H */
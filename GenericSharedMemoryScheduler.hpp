@@ -0,0 +1,343 @@
+/**
+ * 	@file		GenericSharedMemoryScheduler.hpp
+ *	@brief		Definition of the GenericSharedMemoryScheduler class.
+ *	@details	This header file defines a work stealing scheduler for worker processes sharing a segment.
+				Each worker owns a Chase-Lev deque in the segment: it pushes and pops tasks at the bottom
+				without contention, and idle workers steal from the top of other workers' deques, so
+				uneven tasks balance themselves without a central queue. Workers that find every deque
+				empty park on a futex in the segment until a task is pushed.
+ *	@author		James Horner
+ */
+
+#ifndef GENERIC_SHARED_MEMORY_SCHEDULER_H
+#define GENERIC_SHARED_MEMORY_SCHEDULER_H
+
+// C++ Standard Library Headers
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <string>
+#include <type_traits>
+
+// Library Headers
+#include "GenericSharedMemoryFutex.hpp"
+#include "GenericSharedMemoryModel.hpp"
+
+/**
+ * @brief 	Struct GenericSharedMemoryDeque is a Chase-Lev deque of fixed capacity in a segment.
+ * @details The owner pushes and pops at the bottom and thieves take from the top, each on its own cache line.
+ * @param 	Task datatype of the tasks.
+ * @param 	Capacity maximum number of tasks in the deque.
+ */
+template<typename Task, std::size_t Capacity>
+struct GenericSharedMemoryDeque {
+    /// Position of the oldest task, advanced by steals and by the owner taking the last task.
+    alignas(64) std::atomic<int64_t> top;
+    /// Position after the newest task, written only by the owner.
+    alignas(64) std::atomic<int64_t> bottom;
+    /// Ring of tasks indexed by position modulo the capacity.
+    alignas(64) Task tasks[Capacity];
+};
+
+/// Struct GenericSharedMemorySchedulerLayout is the structure mapped to a scheduler segment.
+template<typename Task, std::size_t Workers, std::size_t Capacity>
+struct GenericSharedMemorySchedulerLayout {
+    /// Futex word incremented to wake parked workers.
+    alignas(64) std::atomic<uint32_t> epoch;
+    /// Number of workers parked, or about to park.
+    std::atomic<uint32_t> sleepers;
+    /// Non-zero once the scheduler is stopped.
+    std::atomic<uint32_t> stopped;
+    /// Deque of each worker.
+    GenericSharedMemoryDeque<Task, Capacity> deques[Workers];
+};
+
+/**
+ * @brief 	Class GenericSharedMemoryScheduler is used for management of a connection to a work stealing scheduler segment.
+ * @details Workers are numbered from 0, and each worker number must be used by only one thread at a time, as push() and
+ * 			pop() are only safe for the owner of a deque. Any thread may steal. A producer that is not a worker should
+ * 			push through a worker number of its own that no worker process uses.
+ * @param 	Task datatype of the tasks, which must be trivially copyable.
+ * @param 	Workers number of worker deques.
+ * @param 	Capacity maximum number of tasks in each deque.
+ */
+template<typename Task, std::size_t Workers, std::size_t Capacity = 1024>
+class GenericSharedMemoryScheduler {
+    static_assert(std::is_trivially_copyable_v<Task>, "Tasks must be trivially copyable.");
+    static_assert(Workers > 0 && Capacity > 0, "A scheduler needs at least one worker and a capacity of at least one task.");
+
+public:
+    /// Type of the structure mapped to the segment.
+    using layout_t = GenericSharedMemorySchedulerLayout<Task, Workers, Capacity>;
+
+    /// Constructor for the GenericSharedMemoryScheduler class that initialises members, but does not connect shared memory.
+    GenericSharedMemoryScheduler(const std::string name, const bool log_warnings = false) :
+        m_model(name, log_warnings)
+    {
+    }
+
+    /**
+     * @brief Function connect() is used to connect to the shared memory segment.
+     * @returns Boolean true when the shared memory segment was successfully connected, false otherwise.
+     */
+    bool connect() {
+        return m_model.connect();
+    }
+
+    /**
+     * @brief Function disconnect() is used to disconnect from the shared memory segment.
+     * @returns Boolean true when the shared memory segment was successfully disconnected, false otherwise.
+     */
+    bool disconnect() {
+        return m_model.disconnect();
+    }
+
+    /**
+     * @brief Function is_connected() is used to check if the segment is connected.
+     * @returns Boolean true when the shared memory is connected, false otherwise.
+     */
+    bool is_connected() {
+        return m_model.is_connected();
+    }
+
+    /// Function workers() returns the number of worker deques.
+    static constexpr std::size_t workers() {
+        return Workers;
+    }
+
+    /// Function capacity() returns the maximum number of tasks in each deque.
+    static constexpr std::size_t capacity() {
+        return Capacity;
+    }
+
+    /// Function size() returns the number of tasks in a worker's deque, which may be stale by the time it returns.
+    std::size_t size(std::size_t worker) {
+        layout_t *layout = m_model.data;
+        if (layout == nullptr || worker >= Workers) {
+            return 0;
+        }
+        const int64_t bottom = layout->deques[worker].bottom.load(std::memory_order_acquire);
+        const int64_t top = layout->deques[worker].top.load(std::memory_order_acquire);
+        return bottom > top ? (std::size_t)(bottom - top) : 0;
+    }
+
+    /**
+     * @brief Function push() is used by a worker to push a task onto the bottom of its deque, waking a parked worker.
+     * @param worker worker number of the caller.
+     * @param task task to push.
+     * @returns Boolean true when the task was pushed, false if the deque is full or the segment is not connected.
+     */
+    bool push(std::size_t worker, const Task &task);
+
+    /**
+     * @brief Function pop() is used by a worker to take the newest task from the bottom of its deque.
+     * @param worker worker number of the caller.
+     * @param task set to the task taken.
+     * @returns Boolean true when a task was taken, false if the deque is empty or the segment is not connected.
+     */
+    bool pop(std::size_t worker, Task &task);
+
+    /**
+     * @brief Function steal() is used to take the oldest task from the top of a worker's deque.
+     * @param victim worker number of the deque to steal from.
+     * @param task set to the task taken.
+     * @returns Boolean true when a task was taken, false if the deque is empty or the segment is not connected.
+     */
+    bool steal(std::size_t victim, Task &task);
+
+    /**
+     * @brief Function next() is used by a worker to get its next task, from its own deque or by stealing, parking while
+     * 		  every deque is empty.
+     * @param worker worker number of the caller.
+     * @param task set to the task taken.
+     * @param timeout_ms time to park in milliseconds, or -1 to park until a task is pushed or the scheduler is stopped.
+     * @returns Boolean true when a task was taken, false on a timeout, when the scheduler is stopped or not connected.
+     */
+    bool next(std::size_t worker, Task &task, int timeout_ms = -1);
+
+    /// Function stop() stops the scheduler until reset(), waking every parked worker so next() returns false.
+    void stop() {
+        layout_t *layout = m_model.data;
+        if (layout != nullptr) {
+            layout->stopped.store(1, std::memory_order_seq_cst);
+            layout->epoch.fetch_add(1, std::memory_order_seq_cst);
+            generic_shared_memory_futex_wake(&layout->epoch);
+        }
+    }
+
+    /**
+     * @brief Function reset() is used to restart a scheduler left stopped by an earlier run, discarding leftover tasks.
+     * @details The segment outlives its workers, so the stopped flag, any tasks left in the deques and the count of
+     * 			parked workers (which a worker killed while parked never lowers) carry over to the next worker pool on the
+     * 			same name until it is reset. It must be called while no workers are attached.
+     * @returns Boolean true when the scheduler was reset, false if the segment is not connected.
+     */
+    bool reset() {
+        layout_t *layout = m_model.data;
+        if (layout == nullptr) {
+            return false;
+        }
+        for (std::size_t index = 0; index < Workers; index++) {
+            layout->deques[index].top.store(0, std::memory_order_relaxed);
+            layout->deques[index].bottom.store(0, std::memory_order_relaxed);
+        }
+        layout->sleepers.store(0, std::memory_order_relaxed);
+        layout->stopped.store(0, std::memory_order_seq_cst);
+        layout->epoch.fetch_add(1, std::memory_order_seq_cst);
+        generic_shared_memory_futex_wake(&layout->epoch);
+        return true;
+    }
+
+    /// Function is_stopped() returns true if the scheduler is stopped or not connected.
+    bool is_stopped() {
+        layout_t *layout = m_model.data;
+        return layout == nullptr || layout->stopped.load(std::memory_order_acquire) != 0;
+    }
+
+private:
+    /// Function steal_any() tries to steal from every other worker once, starting after the caller.
+    bool steal_any(std::size_t worker, Task &task) {
+        for (std::size_t offset = 1; offset <= Workers; offset++) {
+            if (steal((worker + offset) % Workers, task)) {
+                return true;
+            }
+        }
+        return false;
+    }
+
+    /// Function any_work() returns true if any deque holds a task.
+    bool any_work(layout_t *layout) {
+        for (std::size_t index = 0; index < Workers; index++) {
+            if (layout->deques[index].bottom.load(std::memory_order_seq_cst) > layout->deques[index].top.load(std::memory_order_seq_cst)) {
+                return true;
+            }
+        }
+        return false;
+    }
+
+    /// Model for the shared memory segment.
+    GenericSharedMemoryModel<layout_t> m_model;
+};
+
+template<typename Task, std::size_t Workers, std::size_t Capacity>
+bool GenericSharedMemoryScheduler<Task, Workers, Capacity>::push(std::size_t worker, const Task &task)
+{
+    layout_t *layout = m_model.data;
+    if (layout == nullptr || worker >= Workers) {
+        return false;
+    }
+    GenericSharedMemoryDeque<Task, Capacity> &deque = layout->deques[worker];
+    const int64_t bottom = deque.bottom.load(std::memory_order_relaxed);
+    const int64_t top = deque.top.load(std::memory_order_acquire);
+    if (bottom - top >= (int64_t)Capacity) {
+        return false;
+    }
+    memcpy((void *)&deque.tasks[bottom % Capacity], &task, sizeof(Task));
+    std::atomic_thread_fence(std::memory_order_release);
+    deque.bottom.store(bottom + 1, std::memory_order_relaxed);
+
+    // Workers count themselves as sleepers before checking the deques a last time, so either they see the task or
+    // this sees them and wakes one.
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+    if (layout->sleepers.load(std::memory_order_relaxed) > 0) {
+        layout->epoch.fetch_add(1, std::memory_order_seq_cst);
+        generic_shared_memory_futex_wake(&layout->epoch, 1);
+    }
+    return true;
+}
+
+template<typename Task, std::size_t Workers, std::size_t Capacity>
+bool GenericSharedMemoryScheduler<Task, Workers, Capacity>::pop(std::size_t worker, Task &task)
+{
+    layout_t *layout = m_model.data;
+    if (layout == nullptr || worker >= Workers) {
+        return false;
+    }
+    GenericSharedMemoryDeque<Task, Capacity> &deque = layout->deques[worker];
+    // Claim the bottom task before looking at the top, so a thief racing for the same task sees the claim.
+    const int64_t bottom = deque.bottom.load(std::memory_order_relaxed) - 1;
+    deque.bottom.store(bottom, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+    int64_t top = deque.top.load(std::memory_order_relaxed);
+    if (top > bottom) {
+        deque.bottom.store(bottom + 1, std::memory_order_relaxed);
+        return false;
+    }
+    Task popped;
+    memcpy((void *)&popped, &deque.tasks[bottom % Capacity], sizeof(Task));
+    if (top == bottom) {
+        // The last task can also be stolen, so whoever advances the top takes it.
+        const bool taken = deque.top.compare_exchange_strong(top, top + 1, std::memory_order_seq_cst, std::memory_order_relaxed);
+        deque.bottom.store(bottom + 1, std::memory_order_relaxed);
+        if (!taken) {
+            return false;
+        }
+    }
+    task = popped;
+    return true;
+}
+
+template<typename Task, std::size_t Workers, std::size_t Capacity>
+bool GenericSharedMemoryScheduler<Task, Workers, Capacity>::steal(std::size_t victim, Task &task)
+{
+    layout_t *layout = m_model.data;
+    if (layout == nullptr || victim >= Workers) {
+        return false;
+    }
+    GenericSharedMemoryDeque<Task, Capacity> &deque = layout->deques[victim];
+    for (;;) {
+        int64_t top = deque.top.load(std::memory_order_acquire);
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        const int64_t bottom = deque.bottom.load(std::memory_order_acquire);
+        if (top >= bottom) {
+            return false;
+        }
+        // The slot is not reused until the top moves past it, so a copy taken before winning the top is the task.
+        Task stolen;
+        memcpy((void *)&stolen, &deque.tasks[top % Capacity], sizeof(Task));
+        if (deque.top.compare_exchange_strong(top, top + 1, std::memory_order_seq_cst, std::memory_order_relaxed)) {
+            task = stolen;
+            return true;
+        }
+    }
+}
+
+template<typename Task, std::size_t Workers, std::size_t Capacity>
+bool GenericSharedMemoryScheduler<Task, Workers, Capacity>::next(std::size_t worker, Task &task, int timeout_ms)
+{
+    layout_t *layout = m_model.data;
+    if (layout == nullptr || worker >= Workers) {
+        return false;
+    }
+    const auto deadline = std::chrono::steady_clock::now() + std::chrono::milliseconds(timeout_ms);
+    for (;;) {
+        if (layout->stopped.load(std::memory_order_acquire) != 0) {
+            return false;
+        }
+        if (pop(worker, task) || steal_any(worker, task)) {
+            return true;
+        }
+
+        // Announce the intent to park, then look once more so a push that missed the announcement is not lost.
+        const uint32_t epoch = layout->epoch.load(std::memory_order_seq_cst);
+        layout->sleepers.fetch_add(1, std::memory_order_seq_cst);
+        if (any_work(layout) || layout->stopped.load(std::memory_order_seq_cst) != 0) {
+            layout->sleepers.fetch_sub(1, std::memory_order_seq_cst);
+            continue;
+        }
+        int remaining_ms = -1;
+        if (timeout_ms >= 0) {
+            remaining_ms = (int)std::chrono::duration_cast<std::chrono::milliseconds>(deadline - std::chrono::steady_clock::now()).count();
+            if (remaining_ms <= 0) {
+                layout->sleepers.fetch_sub(1, std::memory_order_seq_cst);
+                return false;
+            }
+        }
+        generic_shared_memory_futex_wait(&layout->epoch, epoch, remaining_ms);
+        layout->sleepers.fetch_sub(1, std::memory_order_seq_cst);
+    }
+}
+
+#endif /* GENERIC_SHARED_MEMORY_SCHEDULER_H */
@@ -0,0 +1,369 @@
+/**
+ * 	@file		GenericSharedMemorySchema.hpp
+ *	@brief		Definition of the GenericSharedMemoryVersionedModel class.
+ *	@details	This header file defines a model for segments whose type changes between releases. The
+				segment header records a schema id and the table of fields of the value, and the value is
+				stored in a fixed capacity so every version of the type maps the same segment. Newer
+				versions of the type append fields while keeping the offsets of the old ones, and
+				processes built against any version read and write the fields they share with the
+				segment through a shim computed once at connect(), so processes can be upgraded one at
+				a time rather than all restarted together.
+ *	@author		James Horner
+ */
+
+#ifndef GENERIC_SHARED_MEMORY_SCHEMA_H
+#define GENERIC_SHARED_MEMORY_SCHEMA_H
+
+// C++ Standard Library Headers
+#include <algorithm>
+#include <atomic>
+#include <cstdint>
+#include <cstring>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <type_traits>
+#include <vector>
+
+// Library Headers
+#include "GenericSharedMemoryHash.hpp"
+#include "GenericSharedMemoryLog.hpp"
+#include "GenericSharedMemoryModel.hpp"
+#include "GenericSharedMemoryReflection.hpp"
+
+/// Maximum length of a field name recorded in a schema, including the terminator.
+#define GENERIC_SHARED_MEMORY_SCHEMA_NAME_LENGTH 32
+
+/// Struct GenericSharedMemorySchemaField describes one field of the value in a schema header.
+struct GenericSharedMemorySchemaField {
+    /// Null terminated, possibly truncated, name of the field, or empty if the type has no registered names.
+    char name[GENERIC_SHARED_MEMORY_SCHEMA_NAME_LENGTH];
+    /// Offset of the field from the start of the value in bytes.
+    uint32_t offset;
+    /// Size of the field in bytes.
+    uint32_t size;
+    /// Kind of value held by the field.
+    GenericSharedMemoryFieldKind kind;
+};
+
+/**
+ * @brief 	Struct GenericSharedMemorySchemaHeader is the header of a versioned segment.
+ * @details A header with no fields belongs to a newly created segment and is filled in by the first process to connect.
+ * 			The sequence is a sequence lock over the header and the value, odd while either is written.
+ */
+struct GenericSharedMemorySchemaHeader {
+    /// Sequence lock of the header and the value.
+    std::atomic<uint32_t> sequence;
+    /// Number of fields in the table.
+    uint32_t field_count;
+    /// Hash of the field table, equal for processes using the same version of the type.
+    uint64_t schema_id;
+    /// Size of the value of the version that wrote the table.
+    uint64_t value_bytes;
+    /// Field table.
+    GenericSharedMemorySchemaField fields[GENERIC_SHARED_MEMORY_REFLECTION_MAX_FIELDS];
+};
+
+/// Struct GenericSharedMemorySchemaLayout is the structure mapped to a versioned segment.
+template<std::size_t Capacity>
+struct GenericSharedMemorySchemaLayout {
+    /// Header of the segment.
+    GenericSharedMemorySchemaHeader header;
+    /// Storage of the value, large enough for every version of the type.
+    alignas(64) unsigned char value[Capacity];
+};
+
+/**
+ * @brief 	Class GenericSharedMemoryVersionedModel is used for management of a connection to a segment shared by versions of a type.
+ * @details Fields are matched between T and the segment by name when both register names with
+ * 			GENERIC_SHARED_MEMORY_REFLECT, otherwise by position. A process whose T extends the segment's schema (keeps all
+ * 			of its fields at the same offsets and appends more) upgrades the header at connect(). Fields of T missing from
+ * 			the segment read as value initialised and are not written, and fields of the segment missing from T are left
+ * 			untouched by writes. connect() fails if a field is shared with a different size or kind, or if no field is 
+ * 			shared. Every version must use the same Capacity.
+ * @param 	T datatype of the value, which must be a reflectable trivially copyable aggregate.
+ * @param 	Capacity bytes reserved for the value, which bounds the size of every version of T.
+ */
+template<typename T, std::size_t Capacity = 4096>
+class GenericSharedMemoryVersionedModel {
+    static_assert(std::is_trivially_copyable_v<T>, "T must be trivially copyable.");
+    static_assert(sizeof(T) <= Capacity, "T must fit in the capacity of the segment.");
+
+public:
+    /// Type of the structure mapped to the versioned segment.
+    using layout_t = GenericSharedMemorySchemaLayout<Capacity>;
+
+    /// Constructor for the GenericSharedMemoryVersionedModel class that builds the schema of T, but does not connect shared memory.
+    GenericSharedMemoryVersionedModel(const std::string name, const bool log_warnings = false) :
+        m_model(name, log_warnings),
+        m_name(name),
+        m_log_warnings(log_warnings)
+    {
+        for (std::size_t index = 0; index < GenericSharedMemoryReflection<T>::field_count; index++) {
+            const GenericSharedMemoryField &field = GenericSharedMemoryReflection<T>::fields[index];
+            GenericSharedMemorySchemaField &entry = m_schema.fields[index];
+            std::size_t length = std::min(field.name.size(), sizeof(entry.name) - 1);
+            memcpy(entry.name, field.name.data(), length);
+            entry.offset = (uint32_t)field.offset;
+            entry.size = (uint32_t)field.size;
+            entry.kind = field.kind;
+        }
+        m_schema.field_count = (uint32_t)GenericSharedMemoryReflection<T>::field_count;
+        m_schema.value_bytes = sizeof(T);
+        m_schema.schema_id = hash_schema(m_schema);
+    }
+
+    /**
+     * @brief Function connect() is used to connect the model to its segment and compute the shim to its schema.
+     * @returns Boolean true when the segment was connected and its schema is compatible with T, false otherwise.
+     */
+    bool connect();
+
+    /**
+     * @brief Function disconnect() is used to disconnect the model from its shared memory segment.
+     * @returns Boolean true when the shared memory segment was successfully disconnected, false otherwise.
+     */
+    bool disconnect() {
+        m_runs.clear();
+        return m_model.disconnect();
+    }
+
+    /**
+     * @brief Function is_connected() is used to check if the model is connected.
+     * @returns Boolean true when the shared memory is connected, false otherwise.
+     */
+    bool is_connected() {
+        return m_model.is_connected();
+    }
+
+    /**
+     * @brief Function get_data() is used to get a consistent snapshot of the fields T shares with the segment.
+     * @returns Value of the segment at the time of the call, or a value initialised T if the model is not connected.
+     */
+    T get_data();
+
+    /**
+     * @brief Function write_data() is used to write the fields T shares with the segment.
+     * @param new_value value to be written.
+     */
+    void write_data(const T &new_value);
+
+    /// Function schema_id() returns the schema id of T.
+    uint64_t schema_id() const {
+        return m_schema.schema_id;
+    }
+
+    /// Function segment_schema_id() returns the schema id recorded in the segment, or 0 if the model is not connected.
+    uint64_t segment_schema_id() {
+        layout_t *layout = m_model.data;
+        if (layout == nullptr) {
+            return 0;
+        }
+        GenericSharedMemorySchemaHeader header;
+        read_header(layout, header);
+        return header.schema_id;
+    }
+
+    /// Function uses_prefix() returns true if the segment starts with the layout of T, so values are copied as one prefix.
+    bool uses_prefix() const {
+        return m_runs.size() == 1 && m_runs[0].local_offset == 0 && m_runs[0].segment_offset == 0 && m_missing_fields == 0;
+    }
+
+    /// Function missing_fields() returns the number of fields of T that the connected segment does not have.
+    std::size_t missing_fields() const {
+        return m_missing_fields;
+    }
+
+private:
+    /// Struct run_t is a range of bytes copied between T and the segment.
+    struct run_t {
+        std::size_t local_offset;
+        std::size_t segment_offset;
+        std::size_t size;
+    };
+
+    /// Function hash_schema() returns the 64-bit FNV-1a hash of a field table.
+    static uint64_t hash_schema(const GenericSharedMemorySchemaHeader &schema) {
+        return generic_shared_memory_fnv1a(schema.fields, sizeof(GenericSharedMemorySchemaField) * schema.field_count);
+    }
+
+    /// Function same_field() returns true if two entries describe the same field at the same place.
+    static bool same_field(const GenericSharedMemorySchemaField &a, const GenericSharedMemorySchemaField &b) {
+        return strncmp(a.name, b.name, sizeof(a.name)) == 0 && a.offset == b.offset && a.size == b.size && a.kind == b.kind;
+    }
+
+    /// Function lock() takes the sequence lock of the segment for writing, returning the sequence to release it with.
+    static uint32_t lock(layout_t *layout) {
+        uint32_t sequence = layout->header.sequence.load(std::memory_order_relaxed);
+        while ((sequence & 1) || !layout->header.sequence.compare_exchange_weak(sequence, sequence + 1, std::memory_order_acquire)) {
+            if (sequence & 1) {
+                std::this_thread::yield();
+                sequence = layout->header.sequence.load(std::memory_order_relaxed);
+            }
+        }
+        std::atomic_thread_fence(std::memory_order_release);
+        return sequence + 2;
+    }
+
+    /// Function read_header() copies the header of the segment under the sequence lock.
+    static void read_header(layout_t *layout, GenericSharedMemorySchemaHeader &header) {
+        for (;;) {
+            const uint32_t sequence = layout->header.sequence.load(std::memory_order_acquire);
+            if (sequence & 1) {
+                std::this_thread::yield();
+                continue;
+            }
+            memcpy((void *)&header, (const void *)&layout->header, sizeof(header));
+            std::atomic_thread_fence(std::memory_order_acquire);
+            if (layout->header.sequence.load(std::memory_order_relaxed) == sequence) {
+                return;
+            }
+        }
+    }
+
+    /// Function build_shim() computes the runs copied between T and a segment schema, returning false if they are incompatible.
+    bool build_shim(const GenericSharedMemorySchemaHeader &segment);
+
+    /// Model for the shared memory segment.
+    GenericSharedMemoryModel<layout_t> m_model;
+    /// Name of the segment, for logging.
+    std::string m_name;
+    /// Whether warnings are logged.
+    bool m_log_warnings;
+    /// Schema of T.
+    GenericSharedMemorySchemaHeader m_schema = {};
+    /// Runs copied between T and the segment, computed at connect().
+    std::vector<run_t> m_runs;
+    /// Number of fields of T the segment does not have.
+    std::size_t m_missing_fields = 0;
+};
+
+template<typename T, std::size_t Capacity>
+bool GenericSharedMemoryVersionedModel<T, Capacity>::connect()
+{
+    if (!m_model.connect()) {
+        return false;
+    }
+    layout_t *layout = m_model.data;
+
+    // Fill in the header of a new segment, or upgrade it if T extends its schema.
+    const uint32_t release_sequence = lock(layout);
+    GenericSharedMemorySchemaHeader &header = layout->header;
+    bool extends = header.field_count < m_schema.field_count;
+    for (uint32_t index = 0; extends && index < header.field_count; index++) {
+        extends = same_field(header.fields[index], m_schema.fields[index]);
+    }
+    if (extends) {
+        header.field_count = m_schema.field_count;
+        header.schema_id = m_schema.schema_id;
+        header.value_bytes = m_schema.value_bytes;
+        memcpy(header.fields, m_schema.fields, sizeof(header.fields));
+    }
+    GenericSharedMemorySchemaHeader segment;
+    memcpy((void *)&segment, (const void *)&header, sizeof(segment));
+    header.sequence.store(release_sequence, std::memory_order_release);
+
+    if (!build_shim(segment)) {
+        if (m_log_warnings) {
+            GenericSharedMemoryLog::record(GenericSharedMemoryLogSeverity::Warning,
+                GenericSharedMemoryLogEvent::SchemaIncompatible, m_name, 0);
+        }
+        disconnect();
+        return false;
+    }
+    return true;
+}
+
+template<typename T, std::size_t Capacity>
+bool GenericSharedMemoryVersionedModel<T, Capacity>::build_shim(const GenericSharedMemorySchemaHeader &segment)
+{
+    m_runs.clear();
+    m_missing_fields = 0;
+    // Match by name only when both T and the segment registered names, as a segment written by a type without names
+    // records empty names.
+    const bool named = m_schema.field_count > 0 && m_schema.fields[0].name[0] != '\0' &&
+                       segment.field_count > 0 && segment.fields[0].name[0] != '\0';
+    for (uint32_t index = 0; index < m_schema.field_count; index++) {
+        const GenericSharedMemorySchemaField &local = m_schema.fields[index];
+
+        // Find the field in the segment by name, or by position without names.
+        const GenericSharedMemorySchemaField *match = nullptr;
+        for (uint32_t other = 0; other < segment.field_count && match == nullptr; other++) {
+            if (named ? strncmp(local.name, segment.fields[other].name, sizeof(local.name)) == 0 : other == index) {
+                match = &segment.fields[other];
+            }
+        }
+        if (match == nullptr) {
+            m_missing_fields++;
+            continue;
+        }
+        if (match->size != local.size || match->kind != local.kind || (std::size_t)match->offset + match->size > Capacity) {
+            m_runs.clear();
+            return false;
+        }
+
+        // Extend the previous run when the field follows it by the same gap on both sides, such as shared padding,
+        // unless the gap holds a field of the segment that T does not know about.
+        if (!m_runs.empty()) {
+            run_t &last = m_runs.back();
+            const std::size_t local_end = last.local_offset + last.size;
+            const std::size_t segment_end = last.segment_offset + last.size;
+            bool shared_gap = local.offset >= local_end && match->offset >= segment_end && local.offset - local_end == match->offset - segment_end;
+            for (uint32_t other = 0; shared_gap && other < segment.field_count; other++) {
+                shared_gap = segment.fields[other].offset + segment.fields[other].size <= segment_end ||
+                             segment.fields[other].offset >= match->offset;
+            }
+            if (shared_gap) {
+                last.size = local.offset + local.size - last.local_offset;
+                continue;
+            }
+        }
+        m_runs.push_back({local.offset, match->offset, local.size});
+    }
+
+    // Runs end at the last field rather than covering the trailing padding of T, as a newer version of the type may
+    // have appended fields there. A T sharing no fields with the segment would read zeros and drop its writes.
+    return !m_runs.empty();
+}
+
+template<typename T, std::size_t Capacity>
+T GenericSharedMemoryVersionedModel<T, Capacity>::get_data()
+{
+    T value{};
+    layout_t *layout = m_model.data;
+    if (layout == nullptr) {
+        return value;
+    }
+
+    // Copy the shared fields until a copy is made without a write starting or finishing during it.
+    for (;;) {
+        const uint32_t sequence = layout->header.sequence.load(std::memory_order_acquire);
+        if (sequence & 1) {
+            std::this_thread::yield();
+            continue;
+        }
+        for (const run_t &run : m_runs) {
+            memcpy((unsigned char *)&value + run.local_offset, layout->value + run.segment_offset, run.size);
+        }
+        std::atomic_thread_fence(std::memory_order_acquire);
+        if (layout->header.sequence.load(std::memory_order_relaxed) == sequence) {
+            return value;
+        }
+    }
+}
+
+template<typename T, std::size_t Capacity>
+void GenericSharedMemoryVersionedModel<T, Capacity>::write_data(const T &new_value)
+{
+    layout_t *layout = m_model.data;
+    if (layout == nullptr) {
+        return;
+    }
+    const uint32_t release_sequence = lock(layout);
+    for (const run_t &run : m_runs) {
+        memcpy(layout->value + run.segment_offset, (const unsigned char *)&new_value + run.local_offset, run.size);
+    }
+    layout->header.sequence.store(release_sequence, std::memory_order_release);
+}
+
+#endif /* GENERIC_SHARED_MEMORY_SCHEMA_H */
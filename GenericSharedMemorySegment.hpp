@@ -0,0 +1,1103 @@
+/**
+ * 	@file		GenericSharedMemorySegment.hpp
+ *	@brief		Definition of the GenericSharedMemoryConnection and GenericSharedMemorySegment classes.
+ *	@details	This header file defines the type independent core of the models: opening, sizing,
+				mapping and unmapping segments on each platform, lazy connection, idle unmapping and
+				fork safety. The core is compiled once rather than once per segment type, and
+				GenericSharedMemoryModel is a thin typed wrapper around it. GenericSharedMemorySegment
+				uses the same core for segments whose size is only known at runtime, such as segments
+				attached by plugins or generic tools, exposing them as spans of bytes.
+ *	@author		James Horner
+ */
+
+#ifndef GENERIC_SHARED_MEMORY_SEGMENT_H
+#define GENERIC_SHARED_MEMORY_SEGMENT_H
+
+// C++ Standard Library Headers
+#include <algorithm>
+#include <atomic>
+#include <cerrno>
+#include <chrono>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <new>
+#include <span>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+// Platform Dependant System Libraries
+#ifdef _WIN32
+#define WIN32_LEAN_AND_MEAN
+#include <Windows.h>
+#include <tchar.h>
+#else
+#include <fcntl.h>      // Needed for read/write definitions
+#include <pthread.h>    // Needed for pthread_atfork()
+#include <unistd.h>     // Needed for close()
+#include <sys/mman.h>   // For POSIX shared memory via shm_open
+#include <sys/stat.h>
+#endif
+
+// Library Headers
+#include "GenericSharedMemoryLog.hpp"
+#include "GenericSharedMemoryResidency.hpp"
+
+/**
+ * @brief 	Class GenericSharedMemoryLock is a one byte mutex used to protect the members of the models.
+ * @details A std::mutex is 40 bytes on most platforms, which adds up for processes holding tens of thousands of models. 
+ * 			This lock satisfies the Lockable requirements so it can be used with std::scoped_lock, and parks contended 
+ * 			threads with std::atomic::wait() rather than spinning.
+ */
+class GenericSharedMemoryLock {
+public:
+    /// Function lock() blocks until the lock is acquired.
+    void lock() {
+        while (m_state.exchange(1, std::memory_order_acquire) != 0) {
+            m_state.wait(1, std::memory_order_relaxed);
+        }
+    }
+
+    /// Function try_lock() acquires the lock if it is free, returning true if it was acquired.
+    bool try_lock() {
+        return m_state.exchange(1, std::memory_order_acquire) == 0;
+    }
+
+    /// Function unlock() releases the lock and wakes one waiting thread.
+    void unlock() {
+        m_state.store(0, std::memory_order_release);
+        m_state.notify_one();
+    }
+
+private:
+    /// State of the lock, 0 when free and 1 when held.
+    std::atomic<uint8_t> m_state{0};
+};
+
+/// Action taken by the GenericSharedMemoryMappingRegistry on models that have been idle for longer than the timeout.
+enum class GenericSharedMemoryIdleAction : uint8_t {
+    /// Unmap the model, which is mapped again on its next access.
+    Unmap,
+    /// Keep the model mapped but advise its pages as cold (MADV_COLD), prefetching them on its next access.
+    Cold,
+    /// Keep the model mapped but page it out (MADV_PAGEOUT), prefetching it on its next access.
+    PageOut,
+    /// Keep the model mapped but discard its contents (MADV_REMOVE), for reclaimable scratch segments.
+    Remove
+};
+
+class GenericSharedMemoryConnection;
+
+/**
+ * @brief 	Class GenericSharedMemoryMappingRegistry tracks the models of the process and the mappings that may be unmapped while idle.
+ * @details Models with idle unmapping enabled register their mapping here when they connect. The registry applies a 
+ * 			process wide policy, unmapping models that have not been accessed for a time and evicting the least recently 
+ * 			used models while the total mapped size is over a cap. Unmapped models are mapped again on their next access. 
+ * 			Instead of unmapping idle models, the registry can advise their pages out of memory while keeping them mapped, 
+ * 			in which case the pages are prefetched with MADV_WILLNEED on the model's next access. 
+ * 			The policy is applied when a model is registered, when unmap_idle() is called, or periodically by a background 
+ * 			thread started with start(). Models that are in use when the policy is applied are skipped.
+ *
+ * 			Models that ask to be handled around fork(), by enabling locking on fork or disabling inheritance, are also 
+ * 			kept in a list threaded through the models themselves. Handlers installed with pthread_atfork() lock those 
+ * 			models before the fork, so that none is mid-operation and no lock is held by a thread that does not exist in 
+ * 			the child, then release them in both processes. Other models cost nothing on a fork. Mappings are inherited 
+ * 			by the child, so its models stay connected without opening the segments again, except for models with 
+ * 			inheritance disabled, which are marked as disconnected in the child.
+ */
+class GenericSharedMemoryMappingRegistry {
+public:
+    /// Function used by the registry to apply an idle action to a model, returning true if it was applied.
+    using idle_function_t = bool (*)(void *model, GenericSharedMemoryIdleAction action);
+
+    /// Function used by the registry to unlock a model in the child after fork(), returning true if its mapping was not inherited.
+    using fork_function_t = bool (*)(void *model);
+
+    /// Function instance() returns the process wide registry.
+    static GenericSharedMemoryMappingRegistry &instance() {
+        static GenericSharedMemoryMappingRegistry registry;
+        return registry;
+    }
+
+    /**
+     * @brief Function now_ms() returns the clock used to timestamp accesses to the models, in milliseconds.
+     * @note The clock wraps every 49 days, so timestamps are only compared through their age relative to now.
+     */
+    static uint32_t now_ms() {
+        return (uint32_t)std::chrono::duration_cast<std::chrono::milliseconds>(
+            std::chrono::steady_clock::now().time_since_epoch()).count();
+    }
+
+    /**
+     * @brief Function set_policy() is used to set the idle unmapping policy.
+     * @param idle_timeout time after its last access that a model is unmapped, or 0 to never unmap because of idleness.
+     * @param max_mapped_bytes cap on the total size of registered mappings, or 0 for no cap.
+     * @param idle_action action taken on idle models, models over the cap are always unmapped.
+     */
+    void set_policy(std::chrono::milliseconds idle_timeout, std::size_t max_mapped_bytes, 
+                    GenericSharedMemoryIdleAction idle_action = GenericSharedMemoryIdleAction::Unmap) {
+        std::scoped_lock<std::mutex> registry_guard(m_registry_lock);
+        m_idle_timeout_ms = (uint64_t)idle_timeout.count();
+        m_max_mapped_bytes = max_mapped_bytes;
+        m_idle_action = idle_action;
+    }
+
+    /**
+     * @brief Function unmap_idle() is used to apply the policy to the registered models once.
+     * @returns Number of models unmapped or advised out.
+     */
+    std::size_t unmap_idle() {
+        std::scoped_lock<std::mutex> registry_guard(m_registry_lock);
+        return apply_policy_locked(nullptr);
+    }
+
+    /**
+     * @brief Function start() is used to start a background thread that applies the policy periodically.
+     * @param interval time between applications of the policy.
+     */
+    void start(std::chrono::milliseconds interval = std::chrono::milliseconds(1000)) {
+        stop();
+        std::scoped_lock<std::mutex> thread_guard(m_thread_lock);
+        m_stop = false;
+        m_thread = std::thread([this, interval]() {
+            std::unique_lock<std::mutex> thread_guard(m_thread_lock);
+            while (!m_stop) {
+                m_stop_condition.wait_for(thread_guard, interval);
+                if (!m_stop) {
+                    unmap_idle();
+                }
+            }
+        });
+    }
+
+    /// Function stop() is used to stop the background thread started by start().
+    void stop() {
+        {
+            std::scoped_lock<std::mutex> thread_guard(m_thread_lock);
+            m_stop = true;
+        }
+        m_stop_condition.notify_all();
+        if (m_thread.joinable()) {
+            m_thread.join();
+        }
+    }
+
+    /// Function mapped_bytes() returns the total size of the registered mappings.
+    std::size_t mapped_bytes() {
+        std::scoped_lock<std::mutex> registry_guard(m_registry_lock);
+        return m_mapped_bytes;
+    }
+
+    /// Function mapped_count() returns the number of registered mappings.
+    std::size_t mapped_count() {
+        std::scoped_lock<std::mutex> registry_guard(m_registry_lock);
+        return m_entries.size();
+    }
+
+    /// Function fork_model_count() returns the number of models handled around fork().
+    std::size_t fork_model_count() {
+        std::scoped_lock<std::mutex> models_guard(m_models_lock);
+        return m_fork_model_count;
+    }
+
+    /**
+     * @brief Function add() is used by a model to register its mapping, applying the policy to the other models.
+     * @param model model being registered, which must be locked by the caller.
+     * @param bytes size of the mapping.
+     * @param last_access timestamp of the model's last access, from now_ms().
+     * @param idle function used to apply an idle action to the model, which must only try to lock it.
+     */
+    void add(void *model, std::size_t bytes, const std::atomic<uint32_t> *last_access, idle_function_t idle) {
+        std::scoped_lock<std::mutex> registry_guard(m_registry_lock);
+        m_entries[model] = {bytes, last_access, idle, false, 0};
+        m_mapped_bytes += bytes;
+        apply_policy_locked(model);
+    }
+
+    /**
+     * @brief Function update_fork_model() is used by a model to join or leave the list of models handled around fork() 
+     * 			after changing its fork options.
+     * @param model model whose options changed, which must not be locked by the caller.
+     */
+    void update_fork_model(GenericSharedMemoryConnection *model);
+
+    /// Function remove_fork_model() is used by a model handled around fork() to leave the list when it is destroyed.
+    void remove_fork_model(GenericSharedMemoryConnection *model) {
+        std::scoped_lock<std::mutex> models_guard(m_models_lock);
+        unlink_fork_model_locked(model);
+    }
+
+    /// Function set_fixed_address() records the address a model must be mapped at, or nullptr to map it anywhere.
+    void set_fixed_address(void *model, void *address) {
+        std::scoped_lock<std::mutex> fixed_guard(m_fixed_lock);
+        if (address != nullptr) {
+            m_fixed_addresses[model] = address;
+        }
+        else {
+            m_fixed_addresses.erase(model);
+        }
+    }
+
+    /// Function fixed_address() returns the address a model must be mapped at, or nullptr if it can be mapped anywhere.
+    void *fixed_address(void *model) {
+        std::scoped_lock<std::mutex> fixed_guard(m_fixed_lock);
+        auto fixed = m_fixed_addresses.find(model);
+        return fixed != m_fixed_addresses.end() ? fixed->second : nullptr;
+    }
+
+    /// Function remove() is used by a model to unregister its mapping when it disconnects.
+    void remove(void *model) {
+        std::scoped_lock<std::mutex> registry_guard(m_registry_lock);
+        auto entry = m_entries.find(model);
+        if (entry != m_entries.end()) {
+            m_mapped_bytes -= entry->second.bytes;
+            m_entries.erase(entry);
+        }
+    }
+
+    /// Destructor for the GenericSharedMemoryMappingRegistry class that stops the background thread.
+    ~GenericSharedMemoryMappingRegistry() {
+        stop();
+    }
+
+private:
+    /// Registered mapping of a model.
+    struct entry_t {
+        std::size_t bytes;
+        const std::atomic<uint32_t> *last_access;
+        idle_function_t idle;
+        /// Flag for if the model has been advised out, and the time of its last access when it was.
+        bool advised;
+        uint32_t advised_access;
+    };
+
+    /// Constructor for the GenericSharedMemoryMappingRegistry class, private as it is only accessed through instance().
+    GenericSharedMemoryMappingRegistry() {
+#ifndef _WIN32
+        pthread_atfork(prepare_fork, parent_after_fork, child_after_fork);
+#endif
+    }
+
+    /// Function prepare_fork() locks the registry, the log and the models handled around fork() before fork().
+    static void prepare_fork();
+
+    /// Function parent_after_fork() releases everything locked by prepare_fork() in the parent.
+    static void parent_after_fork();
+
+    /// Function child_after_fork() releases everything locked by prepare_fork() in the child, dropping mappings that were not inherited.
+    static void child_after_fork();
+
+    /// Function unlink_fork_model_locked() removes a model from the list of models handled around fork(), the models lock must be held.
+    void unlink_fork_model_locked(GenericSharedMemoryConnection *model);
+
+    /// Function apply_policy_locked() applies the policy to every model except one, the registry lock must be held.
+    std::size_t apply_policy_locked(void *skip) {
+        // Order the candidates from least to most recently used.
+        const uint32_t now = now_ms();
+        std::vector<std::pair<uint32_t, void*>> candidates;
+        for (auto &[model, entry] : m_entries) {
+            if (model != skip) {
+                candidates.emplace_back(now - entry.last_access->load(std::memory_order_relaxed), model);
+            }
+        }
+        std::sort(candidates.begin(), candidates.end(), std::greater<>());
+
+        // Act on models that are idle, then unmap the least recently used ones while the total is over the cap.
+        std::size_t action_count = 0;
+        for (auto &[age, model] : candidates) {
+            const bool idle = m_idle_timeout_ms != 0 && age >= m_idle_timeout_ms;
+            const bool over_cap = m_max_mapped_bytes != 0 && m_mapped_bytes > m_max_mapped_bytes;
+            if (!idle && !over_cap) {
+                break;
+            }
+            auto entry = m_entries.find(model);
+            const GenericSharedMemoryIdleAction action = over_cap ? GenericSharedMemoryIdleAction::Unmap : m_idle_action;
+
+            // A model that was advised out is not advised again until it has been accessed.
+            if (action != GenericSharedMemoryIdleAction::Unmap && entry->second.advised && entry->second.advised_access == now - age) {
+                continue;
+            }
+            if (entry->second.idle(model, action)) {
+                if (action == GenericSharedMemoryIdleAction::Unmap) {
+                    m_mapped_bytes -= entry->second.bytes;
+                    m_entries.erase(entry);
+                }
+                else {
+                    entry->second.advised = true;
+                    entry->second.advised_access = now - age;
+                }
+                action_count++;
+            }
+        }
+        return action_count;
+    }
+
+    /// Mutex lock protecting the list of models handled around fork(), always taken before any model's member mutex.
+    std::mutex m_models_lock;
+    /// First model of the list of models handled around fork(), which is linked through the models.
+    GenericSharedMemoryConnection *m_fork_models = nullptr;
+    /// Number of models handled around fork().
+    std::size_t m_fork_model_count = 0;
+    /// Mutex lock protecting the registered mappings and the policy, always taken after any model's member mutex.
+    std::mutex m_registry_lock;
+    /// Registered mappings by model.
+    std::unordered_map<void*, entry_t> m_entries;
+    /// Total size of the registered mappings.
+    std::size_t m_mapped_bytes = 0;
+    /// Mutex lock protecting the fixed addresses, which is never held while taking another lock.
+    std::mutex m_fixed_lock;
+    /// Fixed addresses by model, kept here so that models without one stay compact.
+    std::unordered_map<void*, void*> m_fixed_addresses;
+    /// Time after its last access that a model is unmapped, or 0 for never.
+    uint64_t m_idle_timeout_ms = 0;
+    /// Cap on the total size of the registered mappings, or 0 for no cap.
+    std::size_t m_max_mapped_bytes = 0;
+    /// Action taken on idle models.
+    GenericSharedMemoryIdleAction m_idle_action = GenericSharedMemoryIdleAction::Unmap;
+    /// Mutex lock and condition protecting the background thread, always taken before any other lock.
+    std::mutex m_thread_lock;
+    std::condition_variable m_stop_condition;
+    /// Flag for if the background thread should exit.
+    bool m_stop = false;
+    /// Background thread applying the policy.
+    std::thread m_thread;
+};
+
+
+/**
+ * @brief 	Class GenericSharedMemoryConnection is the type independent core of a connection to a shared memory segment.
+ * @details The connection holds the name, the member mutex and the flags of a model, and implements connecting, 
+ * 			disconnecting and the idle and fork handling for a mapping of any size. It does not hold the address of the 
+ * 			mapping, which its wrappers keep as a pointer of their own type and pass in by value, so a typed model costs 
+ * 			no more than the pointer on top of the connection. The functions ending in _locked must be called with the 
+ * 			member mutex held.
+ */
+class GenericSharedMemoryConnection {
+public:
+    /**
+     * @brief Function lock() is used to hold the member mutex across several accesses to the mapping, excluding the 
+     * 			accesses of other threads through the wrapper. With unlock() this makes connections usable with 
+     * 			std::scoped_lock.
+     * @note The other functions of the wrapper must not be called by the thread holding the lock.
+     */
+    void lock() {
+        m_member_lock.lock();
+    }
+
+    /// Function unlock() is used to release the member mutex held with lock().
+    void unlock() {
+        m_member_lock.unlock();
+    }
+
+    /**
+     * @brief Function is_connected() is used to check if the shared memory is connected.
+     * @returns Boolean true when the shared memory is connected, false otherwise.
+     */
+    bool is_connected() {
+		// Gain access to the member mutex.
+		std::scoped_lock<GenericSharedMemoryLock> member_guard(m_member_lock);
+		return m_is_connected;
+	};
+
+    /**
+     * @brief Function set_lazy_connect() is used to have the segment mapped on its first access rather than by connect().
+     * @details With lazy connection enabled, the accessors of the wrapper (such as get_data() and write_data() of a 
+     * 			model) connect it if it is not connected. Until then the mapping is nullptr, so lazily connected segments 
+     * 			should be accessed through those functions.
+     * @param enabled true to connect on first access, false to require connect() (the default).
+     */
+    void set_lazy_connect(bool enabled) {
+		// Gain access to the member mutex.
+		std::scoped_lock<GenericSharedMemoryLock> member_guard(m_member_lock);
+        m_lazy_connect = enabled || m_idle_unmap;
+    }
+
+    /**
+     * @brief Function set_inherit_on_fork() is used to choose whether a child created by fork() inherits the mapping.
+     * @details By default the mapping is inherited, so the segment in the child is connected to the same memory without 
+     * 			opening the segment again. When inheritance is disabled the mapping is excluded from the child with 
+     * 			MADV_DONTFORK (where available) and the segment is marked as disconnected in the child, which can call 
+     * 			connect() to map the segment itself. Must be called before connect() to take effect on the mapping.
+     * @param enabled true to inherit the mapping (the default), false to exclude it from children.
+     */
+    void set_inherit_on_fork(bool enabled) {
+        {
+            // Gain access to the member mutex.
+            std::scoped_lock<GenericSharedMemoryLock> member_guard(m_member_lock);
+            m_inherit_on_fork = enabled;
+        }
+        GenericSharedMemoryMappingRegistry::instance().update_fork_model(this);
+    }
+
+    /**
+     * @brief Function set_lock_on_fork() is used to have the connection locked around fork(), so that a child never 
+     * 			inherits it mid-operation.
+     * @details Only connections that ask to be handled around fork() are locked by the handlers installed with 
+     * 			pthread_atfork(), so that a process with many segments does not lock them all on every fork. A connection 
+     * 			used by other threads while one thread forks should enable this, otherwise the child may find its member 
+     * 			mutex held by a thread that does not exist in the child. Connections with inheritance disabled are always 
+     * 			handled around fork().
+     * @param enabled true to lock the connection around fork(), false to leave it alone (the default).
+     */
+    void set_lock_on_fork(bool enabled) {
+        {
+            // Gain access to the member mutex.
+            std::scoped_lock<GenericSharedMemoryLock> member_guard(m_member_lock);
+            m_lock_on_fork = enabled;
+        }
+        GenericSharedMemoryMappingRegistry::instance().update_fork_model(this);
+    }
+
+    /**
+     * @brief Function set_fixed_address() is used to map the segment at an agreed virtual address in every process.
+     * @details Mapping a segment at the same address in every process makes plain pointers into it valid everywhere. The 
+     * 			mapping never replaces an existing one (MAP_FIXED_NOREPLACE), so connect() fails, logging 
+     * 			FixedAddressUnavailable, if the address range is in use. Processes should reserve the range at startup, 
+     * 			before other mappings can take it. For a GenericSharedMemoryFixedAddress layout the address only needs to be 
+     * 			set in the first process, as the others map the segment at the address it recorded. Must be called before 
+     * 			connect() to take effect on the mapping.
+     * @param address page aligned address to map the segment at, or nullptr to map it anywhere (the default).
+     */
+    void set_fixed_address(void *address) {
+		// Gain access to the member mutex.
+		std::scoped_lock<GenericSharedMemoryLock> member_guard(m_member_lock);
+        GenericSharedMemoryMappingRegistry::instance().set_fixed_address(this, address);
+        m_has_fixed_address = address != nullptr;
+    }
+
+protected:
+    /**
+     * @brief Constructor for the GenericSharedMemoryConnection class that initialises members, but does not register the 
+     * 			connection anywhere until it is connected or handled around fork().
+     * @param fork_child function unlocking the wrapper in the child after fork(), used once the connection is handled 
+     * 			around fork().
+     */
+    GenericSharedMemoryConnection(const std::string &name, const bool log_warnings, 
+                                  GenericSharedMemoryMappingRegistry::fork_function_t fork_child) :
+        m_name(new char[name.size() + 1]),
+        m_fork_child(fork_child)
+    {
+        memcpy(m_name.get(), name.c_str(), name.size() + 1);
+        m_is_connected = false;
+        m_log_warnings = log_warnings;
+        m_lazy_connect = false;
+        m_idle_unmap = false;
+        m_inherit_on_fork = true;
+        m_advised_out = false;
+        m_lock_on_fork = false;
+        m_fork_registered = false;
+        m_has_fixed_address = false;
+    }
+
+    /// Destructor for the GenericSharedMemoryConnection class, the wrapper must already have disconnected.
+    ~GenericSharedMemoryConnection() {
+        // Only connections that registered with the registry take its locks, so most are destroyed without them.
+        if (m_fork_registered) {
+            GenericSharedMemoryMappingRegistry::instance().remove_fork_model(this);
+        }
+        if (m_has_fixed_address) {
+            GenericSharedMemoryMappingRegistry::instance().set_fixed_address(this, nullptr);
+        }
+    }
+
+    /**
+     * @brief Function connect_locked() opens and maps the segment, which must not be connected.
+     * @param bytes size of the mapping, which sizes a new segment, or 0 to map an existing segment at its own size, in 
+     * 			which case it is set to the size mapped.
+     * @param records_address true if the segment starts with a GenericSharedMemoryFixedAddress record of its address.
+     * @param idle function applying idle actions, registered with the GenericSharedMemoryMappingRegistry while connected.
+     * @returns Address of the mapping, or nullptr if the segment could not be connected.
+     */
+    void *connect_locked(std::size_t &bytes, bool records_address, GenericSharedMemoryMappingRegistry::idle_function_t idle);
+
+    /**
+     * @brief Function disconnect_locked() unmaps the segment, unregistering it from the GenericSharedMemoryMappingRegistry.
+     * @param address address of the mapping.
+     * @param bytes size of the mapping.
+     */
+    void disconnect_locked(void *address, std::size_t bytes) {
+        if (m_is_connected) {
+            if (m_idle_unmap) {
+                GenericSharedMemoryMappingRegistry::instance().remove(this);
+            }
+            unmap_locked(address, bytes);
+        }
+    }
+
+    /// Function unmap_locked() unmaps the segment without unregistering it.
+    void unmap_locked(void *address, std::size_t bytes) {
+        if (m_is_connected) {
+#ifdef _WIN32
+            (void)bytes;
+            UnmapViewOfFile(address);
+#else
+            munmap(address, bytes);
+#endif
+            m_is_connected = false;
+        }
+    }
+
+    /// Function set_idle_unmap_locked() enables or disables idle unmapping, registering a connected mapping if enabled.
+    void set_idle_unmap_locked(bool enabled, std::size_t bytes, GenericSharedMemoryMappingRegistry::idle_function_t idle) {
+        if (m_idle_unmap != enabled && m_is_connected) {
+            if (enabled) {
+                GenericSharedMemoryMappingRegistry::instance().add(this, bytes, &m_last_access, idle);
+            }
+            else {
+                GenericSharedMemoryMappingRegistry::instance().remove(this);
+            }
+        }
+        m_idle_unmap = enabled;
+        m_lazy_connect = m_lazy_connect || enabled;
+    }
+
+    /// Function touch_locked() prefetches a mapping that was advised out and records the access for idle unmapping.
+    void touch_locked(void *address, std::size_t bytes) {
+        if (m_advised_out) {
+            generic_shared_memory_advise(address, bytes, GenericSharedMemoryAdvice::WillNeed);
+            m_advised_out = false;
+        }
+        if (m_idle_unmap) {
+            m_last_access.store(GenericSharedMemoryMappingRegistry::now_ms(), std::memory_order_relaxed);
+        }
+    }
+
+    /**
+     * @brief Function idle_locked() applies an idle action chosen by the GenericSharedMemoryMappingRegistry.
+     * @returns Boolean true when the action was applied, in which case an unmapped wrapper must forget its address.
+     */
+    bool idle_locked(void *address, std::size_t bytes, GenericSharedMemoryIdleAction action) {
+        // Either unmap the segment, or advise its pages out so they are prefetched on its next access.
+        if (action == GenericSharedMemoryIdleAction::Unmap) {
+            unmap_locked(address, bytes);
+            return true;
+        }
+        const GenericSharedMemoryAdvice advice = 
+            action == GenericSharedMemoryIdleAction::Cold ? GenericSharedMemoryAdvice::Cold :
+            action == GenericSharedMemoryIdleAction::PageOut ? GenericSharedMemoryAdvice::PageOut : GenericSharedMemoryAdvice::Remove;
+        const bool applied = generic_shared_memory_advise(address, bytes, advice);
+        m_advised_out = m_advised_out || applied;
+        return applied;
+    }
+
+    /**
+     * @brief Function child_after_fork_locked() drops a mapping that was not inherited by a child created by fork().
+     * @returns Boolean true when the mapping was dropped, in which case the wrapper must forget its address.
+     */
+    bool child_after_fork_locked(void *address, std::size_t bytes) {
+        // The mapping of a segment that is not inherited does not exist in the child, so forget it.
+        const bool dropped = m_is_connected && !m_inherit_on_fork;
+        if (dropped) {
+#if !defined(_WIN32) && !defined(MADV_DONTFORK)
+            munmap(address, bytes);
+#else
+            (void)address;
+            (void)bytes;
+#endif
+            m_is_connected = false;
+        }
+        return dropped;
+    }
+
+    /// Null terminated name of the shared memory segment, kept on the heap as a std::string would triple its size.
+    std::unique_ptr<char[]> m_name;
+	/// Mutex lock to protect the members of the class when accessing concurrently.
+	GenericSharedMemoryLock m_member_lock;
+    // The flags are packed into bit-fields (all protected by the member mutex) to keep the connection compact.
+    /// Private member for the status of the connection to shared memory.
+    bool m_is_connected : 1;
+    /// Flag for if warnings should be logged through the GenericSharedMemoryLog (instead of just flagged in return values).
+    bool m_log_warnings : 1;
+    /// Flag for if the segment should be connected on its first access.
+    bool m_lazy_connect : 1;
+    /// Flag for if the segment may be unmapped by the GenericSharedMemoryMappingRegistry while idle.
+    bool m_idle_unmap : 1;
+    /// Flag for if a child created by fork() inherits the mapping.
+    bool m_inherit_on_fork : 1;
+    /// Flag for if the pages of the segment have been advised out, so should be prefetched before the next access.
+    bool m_advised_out : 1;
+    /// Flag for if the connection should be locked around fork().
+    bool m_lock_on_fork : 1;
+    /// Flag for if the connection is in the registry's list of connections handled around fork().
+    bool m_fork_registered : 1;
+    /// Flag for if a fixed address is recorded in the registry for the connection.
+    bool m_has_fixed_address : 1;
+    /// Time of the last access to the segment, from GenericSharedMemoryMappingRegistry::now_ms().
+    std::atomic<uint32_t> m_last_access = 0;
+
+private:
+    friend class GenericSharedMemoryMappingRegistry;
+
+    /// Function unlocking the wrapper in the child after fork().
+    GenericSharedMemoryMappingRegistry::fork_function_t m_fork_child;
+    /// Neighbours in the registry's list of connections handled around fork(), protected by the registry's models lock.
+    GenericSharedMemoryConnection *m_fork_previous = nullptr;
+    GenericSharedMemoryConnection *m_fork_next = nullptr;
+
+    /// Function warn_locked() records a failure in the log if warnings are enabled.
+    void warn_locked(GenericSharedMemoryLogEvent event, int error_number) {
+        if (m_log_warnings) {
+            GenericSharedMemoryLog::record(GenericSharedMemoryLogSeverity::Warning, event, m_name.get(), error_number);
+        }
+    }
+};
+
+inline void GenericSharedMemoryMappingRegistry::update_fork_model(GenericSharedMemoryConnection *model)
+{
+    std::scoped_lock<std::mutex> models_guard(m_models_lock);
+    std::scoped_lock<GenericSharedMemoryLock> member_guard(model->m_member_lock);
+
+    // The connection is handled around fork() if it should be locked or must drop its mapping in the child.
+    const bool handled = model->m_lock_on_fork || !model->m_inherit_on_fork;
+    if (handled && !model->m_fork_registered) {
+        model->m_fork_previous = nullptr;
+        model->m_fork_next = m_fork_models;
+        if (m_fork_models != nullptr) {
+            m_fork_models->m_fork_previous = model;
+        }
+        m_fork_models = model;
+        m_fork_model_count++;
+    }
+    else if (!handled && model->m_fork_registered) {
+        unlink_fork_model_locked(model);
+    }
+    model->m_fork_registered = handled;
+}
+
+inline void GenericSharedMemoryMappingRegistry::unlink_fork_model_locked(GenericSharedMemoryConnection *model)
+{
+    if (model->m_fork_previous != nullptr) {
+        model->m_fork_previous->m_fork_next = model->m_fork_next;
+    }
+    else {
+        m_fork_models = model->m_fork_next;
+    }
+    if (model->m_fork_next != nullptr) {
+        model->m_fork_next->m_fork_previous = model->m_fork_previous;
+    }
+    model->m_fork_previous = nullptr;
+    model->m_fork_next = nullptr;
+    m_fork_model_count--;
+}
+
+inline void GenericSharedMemoryMappingRegistry::prepare_fork()
+{
+    GenericSharedMemoryMappingRegistry &registry = instance();
+    registry.m_thread_lock.lock();
+    registry.m_models_lock.lock();
+    for (GenericSharedMemoryConnection *model = registry.m_fork_models; model != nullptr; model = model->m_fork_next) {
+        model->m_member_lock.lock();
+    }
+    registry.m_registry_lock.lock();
+    registry.m_fixed_lock.lock();
+    GenericSharedMemoryLog::instance().prepare_fork();
+}
+
+inline void GenericSharedMemoryMappingRegistry::parent_after_fork()
+{
+    GenericSharedMemoryMappingRegistry &registry = instance();
+    GenericSharedMemoryLog::instance().parent_after_fork();
+    registry.m_fixed_lock.unlock();
+    registry.m_registry_lock.unlock();
+    for (GenericSharedMemoryConnection *model = registry.m_fork_models; model != nullptr; model = model->m_fork_next) {
+        model->m_member_lock.unlock();
+    }
+    registry.m_models_lock.unlock();
+    registry.m_thread_lock.unlock();
+}
+
+inline void GenericSharedMemoryMappingRegistry::child_after_fork()
+{
+    GenericSharedMemoryMappingRegistry &registry = instance();
+    GenericSharedMemoryLog::instance().child_after_fork();
+
+    for (GenericSharedMemoryConnection *model = registry.m_fork_models; model != nullptr; model = model->m_fork_next) {
+        if (model->m_fork_child(model)) {
+            auto entry = registry.m_entries.find(model);
+            if (entry != registry.m_entries.end()) {
+                registry.m_mapped_bytes -= entry->second.bytes;
+                registry.m_entries.erase(entry);
+            }
+        }
+    }
+    registry.m_fixed_lock.unlock();
+    registry.m_registry_lock.unlock();
+    registry.m_models_lock.unlock();
+
+    // The background thread is not duplicated by fork(), so its handle is abandoned.
+    new (&registry.m_thread) std::thread();
+    registry.m_stop = true;
+    registry.m_thread_lock.unlock();
+}
+
+inline void *GenericSharedMemoryConnection::connect_locked(std::size_t &bytes, bool records_address, 
+                                                           GenericSharedMemoryMappingRegistry::idle_function_t idle)
+{
+    void *address = nullptr;
+#ifdef _WIN32
+    // Store the value of the handle so it can be error-checked. A segment of unknown size must already exist.
+	// 2023-02-14 JH:	Force use of CreateFileMappingA as on some platforms CreateFileMapping 
+	//					expands to CreateFileMappingW requiring a wide string which a std::string
+	// 					is not always compatible with without conversion.
+    HANDLE file_mapping_handle = bytes != 0 ? 
+        CreateFileMappingA(
+            INVALID_HANDLE_VALUE,		// Create new file mapping object.
+            NULL,	                    // default security
+            PAGE_READWRITE,		        // read/write access
+            (DWORD)((uint64_t)bytes >> 32),	// maximum object size (high-order DWORD)
+            (DWORD)bytes,		        // maximum object size (low-order DWORD)
+            m_name.get()) :			// name of mapping object 
+        OpenFileMappingA(FILE_MAP_ALL_ACCESS, FALSE, m_name.get());
+    
+    // If the handle is invalid,
+    if (file_mapping_handle == NULL){
+        // Return failure.
+        warn_locked(GenericSharedMemoryLogEvent::OpenFailed, (int)GetLastError());
+        return nullptr;
+    }
+
+    // Find the address the segment must be mapped at, which a fixed address layout may have recorded.
+    void *fixed_address = GenericSharedMemoryMappingRegistry::instance().fixed_address(this);
+    if (records_address) {
+        const std::atomic<uint64_t> *recorded = (const std::atomic<uint64_t> *)MapViewOfFile(file_mapping_handle, FILE_MAP_READ, 0, 0, sizeof(uint64_t));
+        if (fixed_address == nullptr && recorded != NULL) {
+            fixed_address = (void*)(uintptr_t)recorded->load();
+        }
+        if (recorded != NULL) {
+            UnmapViewOfFile((LPCVOID)recorded);
+        }
+    }
+
+    // If the handle is valid, try to map the whole segment, or the requested size of it.
+    address = MapViewOfFileEx(
+		file_mapping_handle,            // assign the map object to the shared data struct.
+		FILE_MAP_ALL_ACCESS,            // read/write permission
+		0,
+		0,
+		bytes,                          // size of the view, or 0 for the whole segment
+		fixed_address);                 // fixed address, or NULL to map anywhere
+
+    // If the mapping returned an invalid memory location,
+    if (address == NULL){
+        // Close the file handle, and return failure.
+        warn_locked(fixed_address != nullptr ? GenericSharedMemoryLogEvent::FixedAddressUnavailable : GenericSharedMemoryLogEvent::MapFailed, 
+                    (int)GetLastError());
+        CloseHandle(file_mapping_handle);
+        return nullptr;
+    }        
+
+    // The view keeps the file mapping object alive, so the handle is no longer needed.
+    CloseHandle(file_mapping_handle);
+
+    // A view of the whole segment is rounded up to pages, which is the size known for it.
+    if (bytes == 0) {
+        MEMORY_BASIC_INFORMATION region;
+        VirtualQuery(address, &region, sizeof(region));
+        bytes = region.RegionSize;
+    }
+
+    // Set the connection state to true.
+    m_is_connected = true;
+#else
+    // Get an ID for the shared memory segment with the name, creating it with permissions 666 unless its size is unknown.
+    int file_mapping_handle = shm_open(m_name.get(), bytes != 0 ? O_CREAT | O_RDWR : O_RDWR, 0666);
+
+    // If the ID is invalid,
+    if (file_mapping_handle < 0) {
+        // Could not create the shared memory file descriptor via shm_open()
+        warn_locked(GenericSharedMemoryLogEvent::OpenFailed, errno);
+        return nullptr;
+    }
+
+    // Check if this is the first time the segment is being opened, and if so try to truncate it, or take the size of 
+    // the segment if it is unknown.
+    struct stat mapping_stat;
+    const bool is_stat_valid = fstat(file_mapping_handle, &mapping_stat) != -1;
+    if (bytes == 0) {
+        if (!is_stat_valid || mapping_stat.st_size == 0) {
+            // An attached segment must already exist with a size.
+            warn_locked(GenericSharedMemoryLogEvent::MapFailed, is_stat_valid ? EINVAL : errno);
+            close(file_mapping_handle);
+            return nullptr;
+        }
+        bytes = (std::size_t)mapping_stat.st_size;
+    }
+    else if (is_stat_valid && mapping_stat.st_size == 0) {
+        // Try to truncate the file mapping handle to the correct size.
+        if (ftruncate(file_mapping_handle, bytes) != 0) {
+            // Could not truncate shared memory to the correct size.
+            warn_locked(GenericSharedMemoryLogEvent::TruncateFailed, errno);
+            close(file_mapping_handle);
+            return nullptr;
+        }
+    }
+
+    // Find the address the segment must be mapped at, which a fixed address layout may have recorded.
+    void *fixed_address = GenericSharedMemoryMappingRegistry::instance().fixed_address(this);
+    int mapping_flags = MAP_SHARED;
+    if (records_address) {
+        uint64_t recorded = 0;
+        if (fixed_address == nullptr && pread(file_mapping_handle, &recorded, sizeof(recorded), 0) == (ssize_t)sizeof(recorded)) {
+            fixed_address = (void*)(uintptr_t)recorded;
+        }
+    }
+#ifdef MAP_FIXED_NOREPLACE
+    if (fixed_address != nullptr) {
+        mapping_flags |= MAP_FIXED_NOREPLACE;
+    }
+#endif
+
+    // Try to map the shared memory segment.
+    address = mmap(fixed_address, bytes, PROT_READ | PROT_WRITE, mapping_flags, file_mapping_handle, 0);
+
+    // The mapping keeps the segment alive, so the file descriptor is no longer needed.
+    int mapping_errno = errno;
+    close(file_mapping_handle);
+
+    // Without MAP_FIXED_NOREPLACE the address is only a hint, so a mapping elsewhere is undone.
+    if (address != MAP_FAILED && fixed_address != nullptr && address != fixed_address) {
+        munmap(address, bytes);
+        address = MAP_FAILED;
+        mapping_errno = EEXIST;
+    }
+
+    // If the mapping is unsuccessful,
+    if (address == MAP_FAILED) {
+        // Return failure.
+        warn_locked(fixed_address != nullptr ? GenericSharedMemoryLogEvent::FixedAddressUnavailable : GenericSharedMemoryLogEvent::MapFailed,
+                    mapping_errno);
+        return nullptr;
+    }
+
+#ifdef MADV_DONTFORK
+    // Exclude the mapping from children if it should not be inherited.
+    if (!m_inherit_on_fork) {
+        madvise(address, bytes, MADV_DONTFORK);
+    }
+#endif
+
+    // Set the connection state to true.
+    m_is_connected = true;
+#endif
+
+    // Record the address of a fixed address layout, failing if another process recorded a different one.
+    if (records_address) {
+        uint64_t recorded = 0;
+        const uint64_t mapped = (uint64_t)(uintptr_t)address;
+        if (!((std::atomic<uint64_t>*)address)->compare_exchange_strong(recorded, mapped) && recorded != mapped) {
+            warn_locked(GenericSharedMemoryLogEvent::FixedAddressUnavailable, EADDRINUSE);
+            unmap_locked(address, bytes);
+            return nullptr;
+        }
+    }
+
+    // Register the mapping so that it can be unmapped while idle.
+    if (m_idle_unmap) {
+        m_last_access.store(GenericSharedMemoryMappingRegistry::now_ms(), std::memory_order_relaxed);
+        GenericSharedMemoryMappingRegistry::instance().add(this, bytes, &m_last_access, idle);
+    }
+    return address;
+}
+
+/**
+ * @brief 	Class GenericSharedMemorySegment is used for management of a connection to a shared memory segment of a size 
+ * 			known only at runtime.
+ * @details The segment has the connection features of GenericSharedMemoryModel (lazy connection, idle unmapping, fork 
+ * 			handling and fixed addresses), but exposes the mapping as a span of bytes. A segment constructed with a size 
+ * 			creates and sizes the segment if it does not exist, while a segment constructed without one attaches to an 
+ * 			existing segment at its current size. An attached segment never creates the segment, and takes its size again
+ * 			each time it is connected, as the segment may have been removed or created again with another size since.
+ */
+class GenericSharedMemorySegment : public GenericSharedMemoryConnection {
+public:
+    /**
+     * @brief Constructor for the GenericSharedMemorySegment class that initialises members, but does not connect shared memory.
+     * @param name name of the segment.
+     * @param size size of the segment in bytes, or 0 to attach to an existing segment at its own size.
+     * @param log_warnings true to log failures through the GenericSharedMemoryLog.
+     */
+    GenericSharedMemorySegment(const std::string name, const std::size_t size = 0, const bool log_warnings = false) :
+        GenericSharedMemoryConnection(name, log_warnings, child_after_fork),
+        m_data(nullptr),
+        m_size(size),
+        m_is_attached(size == 0)
+    {
+    }
+
+    /// Destructor for the GenericSharedMemorySegment class that disconnects from shared memory if the object is deleted.
+    ~GenericSharedMemorySegment() {
+        disconnect();
+    }
+
+    /**
+     * @brief Function connect() is used to connect the segment.
+     * @returns Boolean true when the shared memory segment was successfully connected, false otherwise.
+     */
+    bool connect() {
+		// Gain access to the member mutex.
+		std::scoped_lock<GenericSharedMemoryLock> member_guard(m_member_lock);
+        return connect_data_locked();
+    }
+
+    /**
+     * @brief Function disconnect() is used to disconnect the segment.
+     * @returns Boolean true when the shared memory segment was successfully disconnected, false otherwise.
+     */
+    bool disconnect() {
+		// Gain access to the member mutex.
+		std::scoped_lock<GenericSharedMemoryLock> member_guard(m_member_lock);
+        disconnect_locked(m_data, m_size);
+        m_data = nullptr;
+        return true;
+    }
+
+    /**
+     * @brief Function set_idle_unmap() is used to allow the segment to be unmapped by the GenericSharedMemoryMappingRegistry policy.
+     * @details Enabling idle unmapping also enables lazy connection, so that an unmapped segment is transparently mapped 
+     * 			again on its next access through read() or write(). The span returned by bytes() must not be held across 
+     * 			accesses while it is enabled.
+     * @param enabled true to allow the segment to be unmapped while idle, false to keep it mapped (the default).
+     */
+    void set_idle_unmap(bool enabled) {
+		// Gain access to the member mutex.
+		std::scoped_lock<GenericSharedMemoryLock> member_guard(m_member_lock);
+        set_idle_unmap_locked(enabled, m_size, idle_action);
+    }
+
+    /// Function size() returns the size of the segment, which for an attached segment is 0 until it is first connected and
+    /// then the size found when it was last connected.
+    std::size_t size() {
+		// Gain access to the member mutex.
+		std::scoped_lock<GenericSharedMemoryLock> member_guard(m_member_lock);
+        return m_size;
+    }
+
+    /// Function bytes() returns a span over the mapping, which is empty if the segment is not connected.
+    std::span<std::byte> bytes() {
+		// Gain access to the member mutex.
+		std::scoped_lock<GenericSharedMemoryLock> member_guard(m_member_lock);
+        if (!access_locked()) {
+            return {};
+        }
+        return std::span<std::byte>((std::byte*)m_data, m_size);
+    }
+
+    /**
+     * @brief Function read() is used to copy bytes out of the segment.
+     * @param offset offset of the first byte to copy.
+     * @param destination buffer of count bytes to copy into.
+     * @param count number of bytes to copy.
+     * @returns Boolean true when the bytes were copied, false if they are outside the segment or it is not connected.
+     */
+    bool read(std::size_t offset, void *destination, std::size_t count) {
+		// Gain access to the member mutex.
+		std::scoped_lock<GenericSharedMemoryLock> member_guard(m_member_lock);
+        if (!access_locked() || offset > m_size || count > m_size - offset) {
+            return false;
+        }
+        memcpy(destination, (const unsigned char*)m_data + offset, count);
+        return true;
+    }
+
+    /**
+     * @brief Function write() is used to copy bytes into the segment.
+     * @param offset offset of the first byte to write.
+     * @param source buffer of count bytes to copy from.
+     * @param count number of bytes to copy.
+     * @returns Boolean true when the bytes were copied, false if they are outside the segment or it is not connected.
+     */
+    bool write(std::size_t offset, const void *source, std::size_t count) {
+		// Gain access to the member mutex.
+		std::scoped_lock<GenericSharedMemoryLock> member_guard(m_member_lock);
+        if (!access_locked() || offset > m_size || count > m_size - offset) {
+            return false;
+        }
+        memcpy((unsigned char*)m_data + offset, source, count);
+        return true;
+    }
+
+    /**
+     * @brief Function residency() is used to find how much of the segment is resident in memory.
+     * @returns Residency of the segment, with no resident pages if it is not connected.
+     */
+    GenericSharedMemoryResidency residency() {
+		// Gain access to the member mutex.
+		std::scoped_lock<GenericSharedMemoryLock> member_guard(m_member_lock);
+        return generic_shared_memory_residency(m_is_connected ? m_data : nullptr, m_size);
+    }
+
+    /**
+     * @brief Function advise() is used to advise the kernel about the future use of the segment.
+     * @param advice advice to be given.
+     * @returns Boolean true when the advice was accepted, false if the segment is not connected or the advice failed.
+     */
+    bool advise(GenericSharedMemoryAdvice advice) {
+		// Gain access to the member mutex.
+		std::scoped_lock<GenericSharedMemoryLock> member_guard(m_member_lock);
+        return m_is_connected && generic_shared_memory_advise(m_data, m_size, advice);
+    }
+
+private:
+    /// Function connect_data_locked() maps the segment, learning its size again if it was attached without one.
+    bool connect_data_locked() {
+        if (!m_is_connected) {
+            // An attached segment passes no size, so the segment is opened without creating it and sized from the file.
+            std::size_t size = m_is_attached ? 0 : m_size;
+            m_data = connect_locked(size, false, idle_action);
+            if (m_is_connected) {
+                m_size = size;
+            }
+        }
+        return m_is_connected;
+    }
+
+    /// Function access_locked() prepares the segment for an access, connecting it first if lazy connection is enabled.
+    bool access_locked() {
+        if (!m_is_connected && !(m_lazy_connect && connect_data_locked())) {
+            return false;
+        }
+        touch_locked(m_data, m_size);
+        return true;
+    }
+
+    /// Function idle_action() is called by the GenericSharedMemoryMappingRegistry to act on the segment if it is not in use.
+    static bool idle_action(void *connection, GenericSharedMemoryIdleAction action) {
+        GenericSharedMemorySegment *segment = static_cast<GenericSharedMemorySegment*>((GenericSharedMemoryConnection*)connection);
+        // Only try to gain access to the member mutex, as the registry lock is held and the segment may be in use.
+        if (!segment->m_member_lock.try_lock()) {
+            return false;
+        }
+        const bool applied = segment->idle_locked(segment->m_data, segment->m_size, action);
+        if (!segment->m_is_connected) {
+            segment->m_data = nullptr;
+        }
+        segment->m_member_lock.unlock();
+        return applied;
+    }
+
+    /// Function child_after_fork() drops the mapping in a child created by fork() if it was not inherited.
+    static bool child_after_fork(void *connection) {
+        GenericSharedMemorySegment *segment = static_cast<GenericSharedMemorySegment*>((GenericSharedMemoryConnection*)connection);
+        const bool dropped = segment->child_after_fork_locked(segment->m_data, segment->m_size);
+        if (dropped) {
+            segment->m_data = nullptr;
+        }
+        segment->m_member_lock.unlock();
+        return dropped;
+    }
+
+    /// Address of the mapping, or nullptr when not connected.
+    void *m_data;
+    /// Size of the segment in bytes.
+    std::size_t m_size;
+    /// Whether the segment was constructed without a size, so attaches to an existing segment.
+    const bool m_is_attached;
+};
+
+#endif /* GENERIC_SHARED_MEMORY_SEGMENT_H */
@@ -0,0 +1,325 @@
+/**
+ * 	@file		GenericSharedMemorySlab.hpp
+ *	@brief		Definition of the GenericSharedMemorySlab and GenericSharedMemorySlabModel classes.
+ *	@details	This header file defines a slab container segment which packs many small named sub-segments
+				into a single shared memory mapping. The slab holds a hashed directory of its sub-segments
+				followed by the storage for them, allocated at cache line granularity. Sub-segments are
+				accessed with GenericSharedMemorySlabModel handles, which provide the same interface as
+				GenericSharedMemoryModel but attach to a sub-segment by name without creating a new mapping.
+ *	@author		James Horner
+ */
+
+#ifndef GENERIC_SHARED_MEMORY_SLAB_H
+#define GENERIC_SHARED_MEMORY_SLAB_H
+
+// C++ Standard Library Headers
+#include <atomic>
+#include <cstdint>
+#include <cstring>
+#include <mutex>
+#include <string>
+#include <thread>
+
+// Library Headers
+#include "GenericSharedMemoryHash.hpp"
+#include "GenericSharedMemoryModel.hpp"
+#include "GenericSharedMemoryProcess.hpp"
+
+/// Granularity, in bytes, at which sub-segments are allocated within a slab.
+#define GENERIC_SHARED_MEMORY_SLAB_ALIGNMENT 64
+
+/// Directory entry describing one sub-segment of a slab, sized to fill one cache line.
+struct GenericSharedMemorySlabEntry {
+    /// FNV-1a hash of the sub-segment name.
+    uint64_t name_hash;
+    /// Offset of the sub-segment from the start of the slab's storage.
+    uint64_t offset;
+    /// Size of the sub-segment in bytes.
+    uint32_t size;
+    /// Non-zero once the entry is in use.
+    uint32_t in_use;
+    /// Null terminated name of the sub-segment.
+    char name[40];
+};
+
+/**
+ * @brief 	Struct GenericSharedMemorySlabLayout is the structure mapped to the slab's shared memory segment.
+ * @details All of the fields are valid when zero, so a newly created segment is an empty slab. The directory is an
+ * 			open addressing hash table of entries and the lock is a spin lock shared by every process attached to the
+ * 			slab, which is only taken when a sub-segment is attached. The lock holds the process token of its owner, so a
+ * 			lock left by a process that died while attaching is broken by the next process to attach, even if its ID has
+ * 			been reused. A lock held by a process in another PID namespace is never broken, as its owner cannot be seen.
+ * 			An entry is only marked in use once it is complete, so an interrupted allocation at most leaks its storage.
+ * @param 	Bytes number of bytes of storage for sub-segments.
+ * @param 	Entries number of directory entries, must be a power of two.
+ */
+template<std::size_t Bytes, std::size_t Entries>
+struct GenericSharedMemorySlabLayout {
+    /// Spin lock protecting the directory across processes, holding the process token of its owner or 0 when free.
+    alignas(GENERIC_SHARED_MEMORY_SLAB_ALIGNMENT) std::atomic<uint64_t> lock;
+    /// Number of entries in use.
+    std::atomic<uint32_t> entry_count;
+    /// Number of bytes of storage allocated.
+    uint64_t used_bytes;
+    /// Directory of sub-segments.
+    alignas(GENERIC_SHARED_MEMORY_SLAB_ALIGNMENT) GenericSharedMemorySlabEntry entries[Entries];
+    /// Storage for the sub-segments.
+    alignas(GENERIC_SHARED_MEMORY_SLAB_ALIGNMENT) unsigned char storage[Bytes];
+};
+
+/**
+ * @brief 	Class GenericSharedMemorySlabBase is the type independent interface of a slab used by the sub-segment handles.
+ */
+class GenericSharedMemorySlabBase {
+public:
+    /**
+     * @brief Function attach() is used to find a sub-segment by name, allocating it if it does not exist.
+     * @param name name of the sub-segment, at most 39 characters.
+     * @param size size of the sub-segment in bytes.
+     * @returns Pointer to the sub-segment, or nullptr if the slab is not connected, the name is too long, an existing
+     * 			sub-segment with the name is smaller than size, or the slab is full.
+     */
+    virtual void *attach(const std::string &name, std::size_t size) = 0;
+
+protected:
+    /// Destructor for the GenericSharedMemorySlabBase class, protected as slabs are not deleted through it.
+    ~GenericSharedMemorySlabBase() = default;
+};
+
+/**
+ * @brief 	Class GenericSharedMemorySlab is used for management of a slab segment hosting many small named sub-segments.
+ * @details A small segment connected with GenericSharedMemoryModel costs a page, a file, a mapping and (while connecting)
+ * 			a file descriptor. A slab pays those costs once and hands out cache line aligned sub-segments from a single
+ * 			mapping, which GenericSharedMemorySlabModel handles attach to by name.
+ * @param 	Bytes number of bytes of storage for sub-segments.
+ * @param 	Entries number of directory entries, must be a power of two.
+ */
+template<std::size_t Bytes, std::size_t Entries = 1024>
+class GenericSharedMemorySlab : public GenericSharedMemorySlabBase {
+    static_assert(Entries >= 1 && (Entries & (Entries - 1)) == 0, "Entries must be a power of two.");
+
+public:
+    /// Type of the structure mapped to the slab's shared memory segment.
+    using layout_t = GenericSharedMemorySlabLayout<Bytes, Entries>;
+
+    /// Constructor for the GenericSharedMemorySlab class that initialises members, but does not connect shared memory.
+    GenericSharedMemorySlab(const std::string name, const bool log_warnings = false) :
+        m_model(name, log_warnings)
+    {
+    }
+
+    /// Destructor for the GenericSharedMemorySlab class that disconnects from shared memory if the object is deleted.
+    ~GenericSharedMemorySlab() = default;
+
+    /**
+     * @brief Function connect() is used to connect the slab to its shared memory segment.
+     * @returns Boolean true when the shared memory segment was successfully connected, false otherwise.
+     */
+    bool connect() {
+        return m_model.connect();
+    }
+
+    /**
+     * @brief Function disconnect() is used to disconnect the slab from its shared memory segment.
+     * @returns Boolean true when the shared memory segment was successfully disconnected, false otherwise.
+     * @note Pointers returned by attach() are invalid once the slab is disconnected.
+     */
+    bool disconnect() {
+        return m_model.disconnect();
+    }
+
+    /**
+     * @brief Function is_connected() is used to check if the slab is connected.
+     * @returns Boolean true when the shared memory is connected, false otherwise.
+     */
+    bool is_connected() {
+        return m_model.is_connected();
+    }
+
+    void *attach(const std::string &name, std::size_t size) override;
+
+    /// Function entry_count() returns the number of sub-segments in the slab, or 0 if it is not connected.
+    std::size_t entry_count() {
+        std::scoped_lock<GenericSharedMemoryModel<layout_t>> model_guard(m_model);
+        layout_t *layout = m_model.data;
+        return layout != nullptr ? layout->entry_count.load(std::memory_order_acquire) : 0;
+    }
+
+private:
+    /// Function lock_directory() takes the directory's spin lock, breaking it if its owner no longer exists.
+    static void lock_directory(layout_t *layout);
+
+    /// Model for the shared memory segment holding the slab.
+    GenericSharedMemoryModel<layout_t> m_model;
+};
+
+template<std::size_t Bytes, std::size_t Entries>
+void *GenericSharedMemorySlab<Bytes, Entries>::attach(const std::string &name, std::size_t size)
+{
+    // Hold the model's lock so that the slab is not disconnected while its directory is used.
+    std::scoped_lock<GenericSharedMemoryModel<layout_t>> model_guard(m_model);
+    layout_t *layout = m_model.data;
+
+    // If the slab is not connected or the name does not fit in an entry, return failure.
+    if (layout == nullptr || name.size() >= sizeof(GenericSharedMemorySlabEntry::name) || size > UINT32_MAX) {
+        return nullptr;
+    }
+
+    // Gain access to the directory, which may be shared with other processes.
+    lock_directory(layout);
+
+    // Probe the directory from the slot given by the hash of the name.
+    void *sub_segment = nullptr;
+    const uint64_t name_hash = generic_shared_memory_fnv1a(name.data(), name.size());
+    for (std::size_t probe = 0; probe < Entries; probe++) {
+        GenericSharedMemorySlabEntry &entry = layout->entries[(name_hash + probe) & (Entries - 1)];
+
+        // If the slot is free the sub-segment does not exist yet, so allocate it if there is space.
+        if (!entry.in_use) {
+            const uint64_t rounded_size = (size + GENERIC_SHARED_MEMORY_SLAB_ALIGNMENT - 1) & ~(uint64_t)(GENERIC_SHARED_MEMORY_SLAB_ALIGNMENT - 1);
+            if (layout->used_bytes + rounded_size <= Bytes) {
+                // Take the storage before filling in the entry, so an owner dying part way through leaks it at worst.
+                entry.offset = layout->used_bytes;
+                layout->used_bytes += rounded_size;
+                entry.name_hash = name_hash;
+                entry.size = (uint32_t)size;
+                memcpy(entry.name, name.c_str(), name.size() + 1);
+                std::atomic_thread_fence(std::memory_order_release);
+                entry.in_use = 1;
+                layout->entry_count.fetch_add(1, std::memory_order_release);
+                sub_segment = &layout->storage[entry.offset];
+            }
+            break;
+        }
+
+        // If the slot holds the sub-segment, use it as long as it is large enough.
+        if (entry.name_hash == name_hash && strcmp(entry.name, name.c_str()) == 0) {
+            if (entry.size >= size) {
+                sub_segment = &layout->storage[entry.offset];
+            }
+            break;
+        }
+    }
+
+    layout->lock.store(0, std::memory_order_release);
+    return sub_segment;
+}
+
+template<std::size_t Bytes, std::size_t Entries>
+void GenericSharedMemorySlab<Bytes, Entries>::lock_directory(layout_t *layout)
+{
+    const uint64_t token = generic_shared_memory_process_token();
+    uint64_t owner = 0;
+    while (!layout->lock.compare_exchange_weak(owner, token, std::memory_order_acquire)) {
+        // Take over the lock from an owner that died holding it, checking the owner again in case another process did.
+        if (owner != 0 && owner != token && !generic_shared_memory_process_alive(owner) &&
+            layout->lock.compare_exchange_strong(owner, token, std::memory_order_acquire)) {
+            return;
+        }
+        std::this_thread::yield();
+        owner = 0;
+    }
+}
+
+
+/**
+ * @brief 	Class GenericSharedMemorySlabModel is used for management of a connection to a sub-segment of a slab.
+ * @details Class GenericSharedMemorySlabModel has the same interface as GenericSharedMemoryModel, but rather than mapping a
+ * 			segment of its own it attaches to the sub-segment with its name in a connected GenericSharedMemorySlab. The slab
+ * 			must stay connected while the handle is in use.
+ * @param 	T datatype of the sub-segment to connect to.
+ */
+template<typename T>
+class GenericSharedMemorySlabModel {
+    static_assert(alignof(T) <= GENERIC_SHARED_MEMORY_SLAB_ALIGNMENT, "T must not be aligned more strictly than a cache line.");
+
+public:
+    /// Constructor for the GenericSharedMemorySlabModel class that initialises members, but does not attach the sub-segment.
+    GenericSharedMemorySlabModel(GenericSharedMemorySlabBase &slab, const std::string name) :
+        m_slab(slab),
+        m_name(name)
+    {
+        data = nullptr;
+    }
+
+    /**
+     * @brief Function connect() is used to attach the handle to its sub-segment, allocating it if it does not exist.
+     * @returns Boolean true when the sub-segment was successfully attached, false otherwise.
+     */
+    bool connect() {
+        // Gain access to the member mutex.
+        std::scoped_lock<GenericSharedMemoryLock> member_guard(m_member_lock);
+        if (data == nullptr) {
+            data = (T*)m_slab.attach(m_name, sizeof(T));
+        }
+        return data != nullptr;
+    }
+
+    /**
+     * @brief Function disconnect() is used to detach the handle from its sub-segment.
+     * @returns Boolean true when the sub-segment was successfully detached.
+     */
+    bool disconnect() {
+        // Gain access to the member mutex.
+        std::scoped_lock<GenericSharedMemoryLock> member_guard(m_member_lock);
+        data = nullptr;
+        return true;
+    }
+
+    /**
+     * @brief Function is_connected() is used to check if the sub-segment is attached.
+     * @returns Boolean true when the sub-segment is attached, false otherwise.
+     */
+    bool is_connected() {
+        // Gain access to the member mutex.
+        std::scoped_lock<GenericSharedMemoryLock> member_guard(m_member_lock);
+        return data != nullptr;
+    }
+
+    /**
+     * @brief Function get_data() is used to get a read only snapshot of the sub-segment.
+     * @returns T structure that is a snapshot of the sub-segment at the time of the function call, or T() if it is not attached.
+     */
+    T get_data() {
+        // Gain access to the member mutex.
+        std::scoped_lock<GenericSharedMemoryLock> member_guard(m_member_lock);
+        if (data == nullptr) {
+            return T();
+        }
+        if constexpr (GenericSharedMemoryLiveBytes<T>::is_partial) {
+            T snapshot;
+            memcpy((void*)&snapshot, data, GenericSharedMemoryLiveBytes<T>::size(*data));
+            return snapshot;
+        }
+        else {
+            return *data;
+        }
+    }
+
+    /**
+     * @brief Function write_data() is used to write a new value of the T into the sub-segment.
+     * @param  new_data T structure to be written into the sub-segment, of which only the live bytes are copied. Nothing is
+     * 				written if the sub-segment is not attached.
+     */
+    void write_data(const T &new_data) {
+        // Gain access to the member mutex.
+        std::scoped_lock<GenericSharedMemoryLock> member_guard(m_member_lock);
+        if (data == nullptr) {
+            return;
+        }
+        memcpy((void*)data, &new_data, GenericSharedMemoryLiveBytes<T>::size(new_data));
+    }
+
+    /// Public member for the structure in the slab that is attached upon the calling of connect().
+    T* data;
+
+private:
+    /// Slab holding the sub-segment.
+    GenericSharedMemorySlabBase &m_slab;
+    /// Name of the sub-segment.
+    std::string m_name;
+    /// Mutex lock to protect the members of the class when accessing concurrently.
+    GenericSharedMemoryLock m_member_lock;
+};
+
+#endif /* GENERIC_SHARED_MEMORY_SLAB_H */
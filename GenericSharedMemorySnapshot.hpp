@@ -0,0 +1,327 @@
+/**
+ * 	@file		GenericSharedMemorySnapshot.hpp
+ *	@brief		Definition of the GenericSharedMemorySnapshot class.
+ *	@details	This header file defines a class for taking consistent snapshots of large shared memory
+				segments without stopping the writer for the length of the copy. On Linux the segment
+				is write-protected with userfaultfd when the snapshot is taken, and its pages are then
+				copied out in the background; a write to a page that has not been copied yet faults,
+				the page is copied first and the write then continues. Where userfaultfd is not
+				available the snapshot falls back to copying the segment when it is taken.
+ *	@author		James Horner
+ */
+
+#ifndef GENERIC_SHARED_MEMORY_SNAPSHOT_H
+#define GENERIC_SHARED_MEMORY_SNAPSHOT_H
+
+// C++ Standard Library Headers
+#include <algorithm>
+#include <atomic>
+#include <cerrno>
+#include <cstring>
+#include <memory>
+#include <mutex>
+#include <new>
+#include <thread>
+#include <vector>
+
+// Platform Dependant System Libraries
+#if defined(__linux__) && __has_include(<linux/userfaultfd.h>)
+#include <fcntl.h>          // Needed for O_CLOEXEC and O_NONBLOCK
+#include <unistd.h>         // Needed for read() and syscall()
+#include <sys/ioctl.h>      // Needed for ioctl()
+#include <sys/syscall.h>    // Needed for SYS_userfaultfd
+#include <linux/userfaultfd.h>
+#if defined(SYS_userfaultfd) && defined(UFFDIO_WRITEPROTECT)
+#define GENERIC_SHARED_MEMORY_SNAPSHOT_USERFAULTFD
+#endif
+#endif
+
+// Library Headers
+#include "GenericSharedMemoryModel.hpp"
+
+/// Method used by a GenericSharedMemorySnapshot to take a snapshot.
+enum class GenericSharedMemorySnapshotMode : uint8_t {
+    /// Use userfaultfd write protection when it is available, otherwise copy the segment when the snapshot is taken.
+    Auto,
+    /// Always copy the segment when the snapshot is taken.
+    Copy,
+    /// Use userfaultfd write protection only if it also traps writes made by the kernel, otherwise copy the segment.
+    KernelWrites
+};
+
+/**
+ * @brief 	Class GenericSharedMemorySnapshot is used to take consistent snapshots of a shared memory segment.
+ * @details With userfaultfd, take() only write-protects the segment, which does not copy any data, and a background thread
+ * 			then copies the pages into the snapshot and removes the protection page by page. A write to a page that is still
+ * 			protected blocks until that page has been copied (first write wins), so the snapshot holds the contents of the
+ * 			segment at the moment it was taken while the writer keeps running. wait() blocks until every page is copied.
+ *
+ * 			userfaultfd only traps writes made by the process taking the snapshot, so the snapshot is only consistent with
+ * 			respect to writers in other processes if they are quiescent while it is taken; use the Copy mode (and hold the
+ * 			writers off for the copy) in that case. Without userfaultfd, take() copies the whole segment.
+ *
+ * 			Processes without the privilege to handle kernel faults only get a userfaultfd that traps writes from user space
+ * 			(UFFD_USER_MODE_ONLY). With it, writes made by the kernel into the segment, such as read() or recv() into the
+ * 			mapping, fail with EFAULT while a snapshot is being copied. Auto accepts such a userfaultfd, which 
+ * 			allows_kernel_writes() reports, and KernelWrites refuses it and copies instead.
+ *
+ * 			The snapshot is allocated by the first take() and is not initialised, so it only uses memory for the pages copied.
+ */
+class GenericSharedMemorySnapshot {
+public:
+    /**
+     * @brief Constructor for the GenericSharedMemorySnapshot class that prepares to snapshot a range of memory.
+     * @param address start of the segment, which must be page aligned.
+     * @param bytes size of the segment in bytes.
+     * @param mode method used to take snapshots.
+     */
+    GenericSharedMemorySnapshot(void *address, std::size_t bytes, GenericSharedMemorySnapshotMode mode = GenericSharedMemorySnapshotMode::Auto) :
+        m_segment((unsigned char *)address),
+        m_bytes(bytes),
+        m_page_size(generic_shared_memory_page_size())
+    {
+        m_page_count = (bytes + m_page_size - 1) / m_page_size;
+        if (mode != GenericSharedMemorySnapshotMode::Copy && address != nullptr) {
+            register_userfaultfd(mode == GenericSharedMemorySnapshotMode::Auto);
+        }
+    }
+
+    /**
+     * @brief Constructor for the GenericSharedMemorySnapshot class that prepares to snapshot a model's segment.
+     * @param model connected model, which must stay connected while the snapshot is used.
+     * @param mode method used to take snapshots.
+     */
+    template<typename T>
+    GenericSharedMemorySnapshot(GenericSharedMemoryModel<T> &model, GenericSharedMemorySnapshotMode mode = GenericSharedMemorySnapshotMode::Auto) :
+        GenericSharedMemorySnapshot(model.data, sizeof(T), mode)
+    {
+    }
+
+    /// Destructor for the GenericSharedMemorySnapshot class that completes any snapshot in progress.
+    ~GenericSharedMemorySnapshot() {
+        wait();
+#ifdef GENERIC_SHARED_MEMORY_SNAPSHOT_USERFAULTFD
+        if (m_userfaultfd >= 0) {
+            close(m_userfaultfd);
+        }
+#endif
+    }
+
+    /**
+     * @brief Function take() is used to take a snapshot of the segment.
+     * @returns Boolean true when the snapshot was taken, false if the segment is not valid or the snapshot could not be allocated.
+     * @note Any snapshot still in progress is completed first.
+     */
+    bool take();
+
+    /**
+     * @brief Function take() is used to take a snapshot of a model's segment while holding the model's lock, so that it is
+     * 			consistent with writes made through write_data() from any thread of this process.
+     * @param model model given to the constructor.
+     * @returns Boolean true when the snapshot was taken, false if the segment is not valid or the model is no longer mapped where it was.
+     */
+    template<typename T>
+    bool take(GenericSharedMemoryModel<T> &model) {
+        wait();
+        // The model may have been unmapped while idle (or mapped again elsewhere) since the snapshot was prepared.
+        std::scoped_lock<GenericSharedMemoryModel<T>> model_guard(model);
+        return (void *)model.data == (void *)m_segment && take();
+    }
+
+    /// Function wait() blocks until the snapshot in progress (if any) has been completely copied.
+    void wait() {
+        if (m_copier.joinable()) {
+            m_copier.join();
+        }
+    }
+
+    /// Function is_complete() returns true if every page of the snapshot has been copied.
+    bool is_complete() const {
+        return m_complete.load(std::memory_order_acquire);
+    }
+
+    /**
+     * @brief Function data() returns the snapshot, waiting for it to be completely copied.
+     * @returns Pointer to the contents of the segment at the time of the last take(), or nullptr before the first take().
+     */
+    const void *data() {
+        wait();
+        return m_snapshot.get();
+    }
+
+    /// Function uses_userfaultfd() returns true if snapshots are taken with userfaultfd write protection.
+    bool uses_userfaultfd() const {
+        return m_userfaultfd >= 0;
+    }
+
+    /// Function allows_kernel_writes() returns false if writes made by the kernel into the segment fail while a snapshot is copied.
+    bool allows_kernel_writes() const {
+        return m_userfaultfd < 0 || !m_user_mode_only;
+    }
+
+    /// Function faulted_pages() returns the number of pages of the last snapshot copied because a writer faulted on them.
+    std::size_t faulted_pages() const {
+        return m_faulted_pages.load(std::memory_order_acquire);
+    }
+
+private:
+    /**
+     * @brief Function register_userfaultfd() registers the segment for write protection, leaving m_userfaultfd negative on failure.
+     * @param user_mode_only true to accept a userfaultfd that only traps writes from user space.
+     */
+    void register_userfaultfd(bool user_mode_only);
+
+    /// Function copy_pages() is run by the copier thread to copy every page, serving writers' faults first.
+    void copy_pages();
+
+    /// Function copy_page() copies one page into the snapshot and removes its write protection, if not already done.
+    void copy_page(std::size_t page);
+
+    /// Start of the segment.
+    unsigned char *m_segment;
+    /// Size of the segment in bytes.
+    std::size_t m_bytes;
+    /// Size of a page in bytes.
+    std::size_t m_page_size;
+    /// Number of pages in the segment.
+    std::size_t m_page_count;
+    /// Contents of the segment at the time of the last take(), allocated by the first take().
+    std::unique_ptr<unsigned char[]> m_snapshot;
+    /// Flags for which pages of the current snapshot have been copied, only accessed by the copier thread.
+    std::vector<bool> m_copied;
+    /// File descriptor of the userfaultfd object, or -1 when it is not used.
+    int m_userfaultfd = -1;
+    /// Flag for if the userfaultfd object only traps writes from user space.
+    bool m_user_mode_only = false;
+    /// Flag for if the current snapshot has been completely copied.
+    std::atomic<bool> m_complete{true};
+    /// Number of pages of the current snapshot copied because of a fault.
+    std::atomic<std::size_t> m_faulted_pages{0};
+    /// Thread copying the current snapshot.
+    std::thread m_copier;
+};
+
+inline bool GenericSharedMemorySnapshot::take()
+{
+    wait();
+    if (m_segment == nullptr) {
+        return false;
+    }
+    if (m_snapshot == nullptr) {
+        m_snapshot.reset(new (std::nothrow) unsigned char[m_bytes]);
+        if (m_snapshot == nullptr) {
+            return false;
+        }
+    }
+    m_faulted_pages.store(0, std::memory_order_release);
+
+#ifdef GENERIC_SHARED_MEMORY_SNAPSHOT_USERFAULTFD
+    if (m_userfaultfd >= 0) {
+        // Write-protect the whole segment, after which every page still holds its contents as of the snapshot.
+        struct uffdio_writeprotect protect = {};
+        protect.range.start = (uintptr_t)m_segment;
+        protect.range.len = m_page_count * m_page_size;
+        protect.mode = UFFDIO_WRITEPROTECT_MODE_WP;
+        if (ioctl(m_userfaultfd, UFFDIO_WRITEPROTECT, &protect) == 0) {
+            m_copied.assign(m_page_count, false);
+            m_complete.store(false, std::memory_order_release);
+            m_copier = std::thread([this]() { copy_pages(); });
+            return true;
+        }
+        // If the protection failed, stop using userfaultfd and copy instead.
+        close(m_userfaultfd);
+        m_userfaultfd = -1;
+    }
+#endif
+
+    memcpy(m_snapshot.get(), m_segment, m_bytes);
+    m_complete.store(true, std::memory_order_release);
+    return true;
+}
+
+inline void GenericSharedMemorySnapshot::register_userfaultfd(bool user_mode_only)
+{
+#ifdef GENERIC_SHARED_MEMORY_SNAPSHOT_USERFAULTFD
+    // Prefer trapping kernel faults too, so read() into the segment waits for its page rather than failing, falling back
+    // to the faults from user space that unprivileged processes may request.
+    int userfaultfd = (int)syscall(SYS_userfaultfd, O_CLOEXEC | O_NONBLOCK);
+#ifdef UFFD_USER_MODE_ONLY
+    if (userfaultfd < 0 && user_mode_only) {
+        userfaultfd = (int)syscall(SYS_userfaultfd, O_CLOEXEC | O_NONBLOCK | UFFD_USER_MODE_ONLY);
+        m_user_mode_only = userfaultfd >= 0;
+    }
+#endif
+    if (userfaultfd < 0) {
+        return;
+    }
+
+    // Write protection of shared memory needs the shmem feature, which is requested when the kernel has it.
+    struct uffdio_api api = {};
+    api.api = UFFD_API;
+#ifdef UFFD_FEATURE_WP_HUGETLBFS_SHMEM
+    api.features = UFFD_FEATURE_WP_HUGETLBFS_SHMEM;
+#endif
+    struct uffdio_register registration = {};
+    registration.range.start = (uintptr_t)m_segment;
+    registration.range.len = m_page_count * m_page_size;
+    registration.mode = UFFDIO_REGISTER_MODE_WP;
+    if (ioctl(userfaultfd, UFFDIO_API, &api) != 0 || ioctl(userfaultfd, UFFDIO_REGISTER, &registration) != 0 ||
+        (registration.ioctls & ((uint64_t)1 << _UFFDIO_WRITEPROTECT)) == 0) {
+        close(userfaultfd);
+        m_user_mode_only = false;
+        return;
+    }
+    m_userfaultfd = userfaultfd;
+#else
+    (void)user_mode_only;
+#endif
+}
+
+inline void GenericSharedMemorySnapshot::copy_page(std::size_t page)
+{
+    if (m_copied[page]) {
+        return;
+    }
+    const std::size_t offset = page * m_page_size;
+    memcpy(&m_snapshot[offset], m_segment + offset, std::min(m_page_size, m_bytes - offset));
+    m_copied[page] = true;
+
+#ifdef GENERIC_SHARED_MEMORY_SNAPSHOT_USERFAULTFD
+    // Remove the protection, which also wakes any writer blocked on the page.
+    struct uffdio_writeprotect unprotect = {};
+    unprotect.range.start = (uintptr_t)(m_segment + offset);
+    unprotect.range.len = m_page_size;
+    unprotect.mode = 0;
+    while (ioctl(m_userfaultfd, UFFDIO_WRITEPROTECT, &unprotect) != 0 && errno == EAGAIN) {
+    }
+#endif
+}
+
+inline void GenericSharedMemorySnapshot::copy_pages()
+{
+#ifdef GENERIC_SHARED_MEMORY_SNAPSHOT_USERFAULTFD
+    // Copy the pages in order, a few at a time, serving any pending faults between them so writers wait as little as possible.
+    const std::size_t pages_between_faults = 16;
+    for (std::size_t next_page = 0; next_page < m_page_count; ) {
+        struct uffd_msg message;
+        while (read(m_userfaultfd, &message, sizeof(message)) == (ssize_t)sizeof(message)) {
+            if (message.event == UFFD_EVENT_PAGEFAULT && (message.arg.pagefault.flags & UFFD_PAGEFAULT_FLAG_WP)) {
+                const std::size_t page = (std::size_t)((message.arg.pagefault.address - (uintptr_t)m_segment) / m_page_size);
+                if (page < m_page_count && !m_copied[page]) {
+                    m_faulted_pages.fetch_add(1, std::memory_order_relaxed);
+                }
+                if (page < m_page_count) {
+                    copy_page(page);
+                }
+            }
+        }
+        const std::size_t last_page = std::min(m_page_count, next_page + pages_between_faults);
+        for (; next_page < last_page; next_page++) {
+            copy_page(next_page);
+        }
+    }
+#endif
+    m_complete.store(true, std::memory_order_release);
+}
+
+#endif /* GENERIC_SHARED_MEMORY_SNAPSHOT_H */
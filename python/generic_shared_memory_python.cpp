@@ -0,0 +1,592 @@
+/**
+ * 	@file		generic_shared_memory_python.cpp
+ *	@brief		Python bindings exposing shared memory segments as NumPy arrays.
+ *	@details	This module lets Python processes attach to segments written by the library and use them
+				as NumPy structured arrays without copying. A Segment attaches to an existing segment
+				through a GenericSharedMemorySegment and exposes the records of its value through the
+				buffer protocol, so the NumPy array returned by array is a view of the mapping. The
+				records are found from the layout of the C++ class that owns the segment, given by one
+				of the presets below, with a NumPy dtype matching the C++ type (an aligned structured
+				dtype for a struct). Segments with a sequence lock can also be read as consistent
+				snapshots and waited on, with the GIL released while copying or waiting.
+
+				import numpy as np
+				import generic_shared_memory as gsm
+				pose_t = np.dtype([("x", "<f8"), ("y", "<f8")], align=True)
+				pose = gsm.Segment("pose", pose_t)						# GenericSharedMemoryModel<pose_t>
+				pose = gsm.composite("robot", [status_t, pose_t], 1)	# Second member of a composite.
+				pose = gsm.field_model("pose", pose_t)					# GenericSharedMemoryFieldModel<pose_t>
+				pose = gsm.versioned_model("pose", pose_t)				# GenericSharedMemoryVersionedModel<pose_t>
+				pose.array["x"]			# Live view of the segment.
+				pose.snapshot()			# Copy, consistent if the segment has a sequence lock.
+ *	@author		James Horner
+ */
+
+#define PY_SSIZE_T_CLEAN
+#include <Python.h>
+
+// C++ Standard Library Headers
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <thread>
+
+// Library Headers
+#include "GenericSharedMemoryComposite.hpp"
+#include "GenericSharedMemoryFieldModel.hpp"
+#include "GenericSharedMemoryFutex.hpp"
+#include "GenericSharedMemorySchema.hpp"
+#include "GenericSharedMemorySegment.hpp"
+
+/// Struct GenericSharedMemoryPythonLayout locates the records and sequence lock of a segment.
+struct GenericSharedMemoryPythonLayout {
+    /// Offset of the first record from the start of the segment in bytes.
+    std::size_t offset;
+    /// Whether the segment has a sequence lock, and whether its writers wake waiters registered next to it.
+    bool has_sequence;
+    bool has_waiters;
+    /// Offsets of the sequence lock and the count of waiters.
+    std::size_t sequence_offset;
+    std::size_t waiters_offset;
+};
+
+/// Function generic_shared_memory_python_round_up() rounds value up to a multiple of alignment.
+constexpr std::size_t generic_shared_memory_python_round_up(std::size_t value, std::size_t alignment) {
+    return (value + alignment - 1) / alignment * alignment;
+}
+
+/// Function composite_value_offset() returns the offset of the value in a composite slot for a type of the given alignment.
+constexpr std::size_t composite_value_offset(std::size_t alignment) {
+    return generic_shared_memory_python_round_up(2 * sizeof(uint32_t), alignment);
+}
+
+/// Function composite_slot_size() returns the size of a composite slot for a type of the given size and alignment.
+constexpr std::size_t composite_slot_size(std::size_t size, std::size_t alignment) {
+    return generic_shared_memory_python_round_up(composite_value_offset(alignment) + size,
+                                                 std::max<std::size_t>(alignment, GENERIC_SHARED_MEMORY_COMPOSITE_ALIGNMENT));
+}
+
+/// Function field_value_offset() returns the offset of the value in a field segment for a type of the given alignment.
+constexpr std::size_t field_value_offset(std::size_t alignment, std::size_t fields, std::size_t subscribers) {
+    const std::size_t subscriber_size = generic_shared_memory_python_round_up(sizeof(uint64_t) + sizeof(uint64_t) * ((fields + 63) / 64), 64);
+    const std::size_t subscribers_offset = generic_shared_memory_python_round_up(sizeof(uint32_t) * (1 + fields), 64);
+    return generic_shared_memory_python_round_up(subscribers_offset + subscriber_size * subscribers, std::max<std::size_t>(alignment, 64));
+}
+
+// The presets compute the layouts of the C++ classes for a dtype at run time, so check them against the real layouts for
+// types of several alignments, which breaks the build if a layout changes.
+struct generic_shared_memory_python_probe_t { double x, y, z; };
+struct generic_shared_memory_python_byte_t { char c; };
+struct alignas(128) generic_shared_memory_python_wide_t { char c[3]; };
+
+template<typename T>
+constexpr bool generic_shared_memory_python_check_composite() {
+    using slot_t = GenericSharedMemoryCompositeSlot<T>;
+    using layout_t = GenericSharedMemoryCompositeLayout<T, generic_shared_memory_python_byte_t>;
+    return offsetof(slot_t, sequence) == 0 && offsetof(slot_t, waiters) == sizeof(uint32_t) &&
+           offsetof(slot_t, value) == composite_value_offset(alignof(T)) &&
+           sizeof(slot_t) == composite_slot_size(sizeof(T), alignof(T)) && offsetof(layout_t, rest) == sizeof(slot_t);
+}
+
+template<typename T, std::size_t Fields, std::size_t Subscribers>
+constexpr bool generic_shared_memory_python_check_field() {
+    using layout_t = GenericSharedMemoryFieldLayout<T, Fields, Subscribers>;
+    return offsetof(layout_t, sequence) == 0 && offsetof(layout_t, value) == field_value_offset(alignof(T), Fields, Subscribers);
+}
+
+static_assert(generic_shared_memory_python_check_composite<generic_shared_memory_python_probe_t>(), "Composite slot layout changed.");
+static_assert(generic_shared_memory_python_check_composite<generic_shared_memory_python_byte_t>(), "Composite slot layout changed.");
+static_assert(generic_shared_memory_python_check_composite<generic_shared_memory_python_wide_t>(), "Composite slot layout changed.");
+static_assert(generic_shared_memory_python_check_field<generic_shared_memory_python_probe_t, 3, 16>(), "Field layout changed.");
+static_assert(generic_shared_memory_python_check_field<generic_shared_memory_python_byte_t, 70, 5>(), "Field layout changed.");
+static_assert(generic_shared_memory_python_check_field<generic_shared_memory_python_wide_t, 1, 1>(), "Field layout changed.");
+static_assert(offsetof(GenericSharedMemorySchemaLayout<64>, value) == offsetof(GenericSharedMemorySchemaLayout<4096>, value) &&
+              offsetof(GenericSharedMemorySchemaLayout<64>, header) == 0 && offsetof(GenericSharedMemorySchemaHeader, sequence) == 0,
+              "Versioned layout changed.");
+
+/**
+ * @brief 	Struct GenericSharedMemoryPythonSegment is the Python object of a segment viewed through a NumPy dtype.
+ * @details The segment stays connected until the object and every array viewing it have been garbage collected, as the
+ * 			arrays hold a reference to the object through the buffer protocol, so views never dangle. The segment must
+ * 			already exist and be large enough for the records, as Python processes attach to segments owned by the C++
+ * 			processes rather than create them.
+ */
+struct GenericSharedMemoryPythonSegment {
+    PyObject_HEAD
+    /// Connection to the segment, and its name.
+    GenericSharedMemorySegment *segment;
+    PyObject *name;
+    /// NumPy dtype of a record, and its size in bytes.
+    PyObject *dtype;
+    std::size_t itemsize;
+    /// Number of records, or 1 for a segment holding a single value.
+    std::size_t count;
+    /// Whether arrays of the records are read only.
+    bool read_only;
+    /// Start of the records.
+    unsigned char *records;
+    /// Sequence lock and count of waiters in the segment, if it has them.
+    std::atomic<uint32_t> *sequence;
+    std::atomic<uint32_t> *waiters;
+};
+
+/// NumPy's dtype and ndarray types, imported with the module.
+static PyObject *numpy_dtype = nullptr;
+static PyObject *numpy_ndarray = nullptr;
+
+/// Type of the segment objects, created with the module.
+static PyTypeObject *segment_type = nullptr;
+
+/// Function dtype_size() reads a size attribute (itemsize or alignment) of a dtype, returning 0 with an exception set on failure.
+static std::size_t dtype_size(PyObject *dtype, const char *attribute) {
+    PyObject *value = PyObject_GetAttrString(dtype, attribute);
+    if (value == nullptr) {
+        return 0;
+    }
+    const std::size_t size = PyLong_AsSize_t(value);
+    Py_DECREF(value);
+    return PyErr_Occurred() ? 0 : size;
+}
+
+/**
+ * @brief Function open_segment() is used to connect a segment object to a named segment with a layout.
+ * @param self segment object, which must not be connected.
+ * @param name name of the shared memory segment.
+ * @param dtype NumPy dtype, or an object that NumPy converts to one, of a record of the segment.
+ * @param layout layout of the records in the segment.
+ * @param count number of records.
+ * @param read_only true to make arrays of the records read only.
+ * @returns Boolean true if connected, false with a Python exception set otherwise.
+ */
+static bool open_segment(GenericSharedMemoryPythonSegment *self, const char *name, PyObject *dtype,
+                         const GenericSharedMemoryPythonLayout &layout, std::size_t count, bool read_only) {
+    if (self->segment != nullptr) {
+        PyErr_SetString(PyExc_RuntimeError, "Segment is already connected");
+        return false;
+    }
+    if (count == 0) {
+        PyErr_SetString(PyExc_ValueError, "A segment needs at least one record");
+        return false;
+    }
+    PyObject *converted = PyObject_CallOneArg(numpy_dtype, dtype);
+    if (converted == nullptr) {
+        return false;
+    }
+    Py_XSETREF(self->dtype, converted);
+    Py_XSETREF(self->name, PyUnicode_FromString(name));
+    if (self->name == nullptr) {
+        return false;
+    }
+    self->itemsize = dtype_size(converted, "itemsize");
+    if (PyErr_Occurred()) {
+        return false;
+    }
+    self->count = count;
+    self->read_only = read_only;
+
+    GenericSharedMemorySegment *segment = new GenericSharedMemorySegment(name);
+    bool connected = false;
+    std::span<std::byte> bytes;
+    Py_BEGIN_ALLOW_THREADS
+    connected = segment->connect();
+    bytes = segment->bytes();
+    Py_END_ALLOW_THREADS
+    if (!connected) {
+        delete segment;
+        PyErr_Format(PyExc_OSError, "Couldn't connect to shared memory segment %s", name);
+        return false;
+    }
+    const auto word_fits = [&](std::size_t offset) {
+        return offset % alignof(std::atomic<uint32_t>) == 0 && offset + sizeof(uint32_t) <= bytes.size();
+    };
+    if (layout.offset + self->itemsize * count > bytes.size() || (layout.has_sequence && !word_fits(layout.sequence_offset)) ||
+        (layout.has_waiters && !word_fits(layout.waiters_offset))) {
+        delete segment;
+        PyErr_Format(PyExc_ValueError, "Shared memory segment %s is smaller than its layout", name);
+        return false;
+    }
+    self->segment = segment;
+    unsigned char *data = (unsigned char *)bytes.data();
+    self->records = data + layout.offset;
+    self->sequence = layout.has_sequence ? (std::atomic<uint32_t> *)(data + layout.sequence_offset) : nullptr;
+    self->waiters = layout.has_waiters ? (std::atomic<uint32_t> *)(data + layout.waiters_offset) : nullptr;
+    return true;
+}
+
+/// Function new_segment() creates a segment object connected with a layout, returning nullptr with an exception set on failure.
+static PyObject *new_segment(const char *name, PyObject *dtype, const GenericSharedMemoryPythonLayout &layout, bool read_only) {
+    PyObject *self = PyType_GenericAlloc(segment_type, 0);
+    if (self != nullptr && !open_segment((GenericSharedMemoryPythonSegment *)self, name, dtype, layout, 1, read_only)) {
+        Py_CLEAR(self);
+    }
+    return self;
+}
+
+/// Function segment_init() maps a GenericSharedMemoryModel, whose segment holds count records from its start and no sequence lock.
+static int segment_init(PyObject *object, PyObject *args, PyObject *kwargs) {
+    static const char *keywords[] = {"name", "dtype", "count", "read_only", nullptr};
+    const char *name;
+    PyObject *dtype;
+    Py_ssize_t count = 1;
+    int read_only = 0;
+    if (!PyArg_ParseTupleAndKeywords(args, kwargs, "sO|np", (char **)keywords, &name, &dtype, &count, &read_only)) {
+        return -1;
+    }
+    if (count < 0) {
+        PyErr_SetString(PyExc_ValueError, "count must not be negative");
+        return -1;
+    }
+    const GenericSharedMemoryPythonLayout layout = {0, false, false, 0, 0};
+    return open_segment((GenericSharedMemoryPythonSegment *)object, name, dtype, layout, (std::size_t)count, read_only) ? 0 : -1;
+}
+
+/// Function segment_dealloc() disconnects the segment when the object is garbage collected.
+static void segment_dealloc(PyObject *object) {
+    GenericSharedMemoryPythonSegment *self = (GenericSharedMemoryPythonSegment *)object;
+    delete self->segment;
+    Py_XDECREF(self->dtype);
+    Py_XDECREF(self->name);
+    PyTypeObject *type = Py_TYPE(object);
+    type->tp_free(object);
+    Py_DECREF(type);
+}
+
+/// Function segment_getbuffer() exposes the records of the segment through the buffer protocol.
+static int segment_getbuffer(PyObject *object, Py_buffer *view, int flags) {
+    GenericSharedMemoryPythonSegment *self = (GenericSharedMemoryPythonSegment *)object;
+    if (self->segment == nullptr) {
+        PyErr_SetString(PyExc_BufferError, "Segment is not connected");
+        view->obj = nullptr;
+        return -1;
+    }
+    return PyBuffer_FillInfo(view, object, self->records, (Py_ssize_t)(self->itemsize * self->count), self->read_only, flags);
+}
+
+/// Function make_array() returns a NumPy array of the records of the segment over a buffer.
+static PyObject *make_array(GenericSharedMemoryPythonSegment *self, PyObject *buffer) {
+    if (self->segment == nullptr) {
+        PyErr_SetString(PyExc_RuntimeError, "Segment is not connected");
+        return nullptr;
+    }
+    PyObject *shape = self->count == 1 ? PyTuple_New(0) : Py_BuildValue("(n)", (Py_ssize_t)self->count);
+    if (shape == nullptr) {
+        return nullptr;
+    }
+    PyObject *args = Py_BuildValue("(NO)", shape, self->dtype);
+    PyObject *kwargs = Py_BuildValue("{s:O}", "buffer", buffer);
+    PyObject *array = args != nullptr && kwargs != nullptr ? PyObject_Call(numpy_ndarray, args, kwargs) : nullptr;
+    Py_XDECREF(args);
+    Py_XDECREF(kwargs);
+    return array;
+}
+
+/// Function segment_array() returns a NumPy array viewing the records in place, which keeps the segment connected.
+static PyObject *segment_array(PyObject *object, void *) {
+    return make_array((GenericSharedMemoryPythonSegment *)object, object);
+}
+
+/**
+ * @brief Function segment_snapshot() is used to copy the records out of the segment.
+ * @details With a sequence lock the copy is retried until no write overlapped it, otherwise it is a plain copy which
+ * 			may tear if written concurrently. The GIL is released while copying.
+ * @returns NumPy array owning a copy of the records.
+ */
+static PyObject *segment_snapshot(PyObject *object, PyObject *) {
+    GenericSharedMemoryPythonSegment *self = (GenericSharedMemoryPythonSegment *)object;
+    if (self->segment == nullptr) {
+        PyErr_SetString(PyExc_RuntimeError, "Segment is not connected");
+        return nullptr;
+    }
+    const std::size_t bytes = self->itemsize * self->count;
+    PyObject *copy = PyByteArray_FromStringAndSize(nullptr, (Py_ssize_t)bytes);
+    if (copy == nullptr) {
+        return nullptr;
+    }
+    char *destination = PyByteArray_AS_STRING(copy);
+    Py_BEGIN_ALLOW_THREADS
+    for (;;) {
+        const uint32_t sequence = self->sequence != nullptr ? self->sequence->load(std::memory_order_acquire) : 0;
+        if (sequence & 1) {
+            std::this_thread::yield();
+            continue;
+        }
+        memcpy(destination, self->records, bytes);
+        std::atomic_thread_fence(std::memory_order_acquire);
+        if (self->sequence == nullptr || self->sequence->load(std::memory_order_relaxed) == sequence) {
+            break;
+        }
+    }
+    Py_END_ALLOW_THREADS
+    PyObject *array = make_array(self, copy);
+    Py_DECREF(copy);
+    return array;
+}
+
+/// Function segment_version() returns the number of writes made under the sequence lock, or 0 if the segment has none.
+static PyObject *segment_version(PyObject *object, void *) {
+    GenericSharedMemoryPythonSegment *self = (GenericSharedMemoryPythonSegment *)object;
+    return PyLong_FromUnsignedLong(self->sequence != nullptr ? self->sequence->load(std::memory_order_acquire) >> 1 : 0);
+}
+
+/**
+ * @brief Function segment_wait() is used to wait for the records to be written, with the GIL released.
+ * @details Writers that keep a count of waiters (composite slots) only wake waiters that registered in it, so the thread
+ * 			registers and sleeps on the sequence's futex. The other segments wake their subscriptions instead, so their
+ * 			sequence is polled every 100 microseconds.
+ * @returns True when the version differs from the version given, False if the timeout expired.
+ */
+static PyObject *segment_wait(PyObject *object, PyObject *args, PyObject *kwargs) {
+    static const char *keywords[] = {"version", "timeout_ms", nullptr};
+    GenericSharedMemoryPythonSegment *self = (GenericSharedMemoryPythonSegment *)object;
+    unsigned long version;
+    int timeout_ms = -1;
+    if (!PyArg_ParseTupleAndKeywords(args, kwargs, "k|i", (char **)keywords, &version, &timeout_ms)) {
+        return nullptr;
+    }
+    if (self->sequence == nullptr) {
+        PyErr_SetString(PyExc_RuntimeError, "Segment has no sequence lock to wait on");
+        return nullptr;
+    }
+    bool changed = false;
+    Py_BEGIN_ALLOW_THREADS
+    const auto deadline = std::chrono::steady_clock::now() + std::chrono::milliseconds(timeout_ms);
+    if (self->waiters != nullptr) {
+        self->waiters->fetch_add(1, std::memory_order_seq_cst);
+    }
+    for (;;) {
+        const uint32_t sequence = self->sequence->load(std::memory_order_seq_cst);
+        if ((sequence >> 1) != version) {
+            changed = true;
+            break;
+        }
+        int remaining_ms = -1;
+        if (timeout_ms >= 0) {
+            remaining_ms = (int)std::chrono::duration_cast<std::chrono::milliseconds>(deadline - std::chrono::steady_clock::now()).count();
+            if (remaining_ms <= 0) {
+                break;
+            }
+        }
+        if (self->waiters != nullptr) {
+            generic_shared_memory_futex_wait(self->sequence, sequence, remaining_ms);
+        }
+        else {
+            std::this_thread::sleep_for(std::chrono::microseconds(100));
+        }
+    }
+    if (self->waiters != nullptr) {
+        self->waiters->fetch_sub(1, std::memory_order_relaxed);
+    }
+    Py_END_ALLOW_THREADS
+    return PyBool_FromLong(changed);
+}
+
+/// Function segment_name() returns the name of the segment.
+static PyObject *segment_name(PyObject *object, void *) {
+    GenericSharedMemoryPythonSegment *self = (GenericSharedMemoryPythonSegment *)object;
+    return Py_NewRef(self->name != nullptr ? self->name : Py_None);
+}
+
+/// Function segment_size() returns the size of the segment in bytes.
+static PyObject *segment_size(PyObject *object, void *) {
+    GenericSharedMemoryPythonSegment *self = (GenericSharedMemoryPythonSegment *)object;
+    return PyLong_FromSize_t(self->segment != nullptr ? self->segment->size() : 0);
+}
+
+/// Function converted_dtype() converts an object to a NumPy dtype and reads its alignment, returning nullptr with an exception set on failure.
+static PyObject *converted_dtype(PyObject *dtype, std::size_t *alignment) {
+    PyObject *converted = PyObject_CallOneArg(numpy_dtype, dtype);
+    if (converted != nullptr) {
+        *alignment = dtype_size(converted, "alignment");
+        if (PyErr_Occurred()) {
+            Py_CLEAR(converted);
+        }
+    }
+    return converted;
+}
+
+/**
+ * @brief Function composite() maps one member of a GenericSharedMemoryComposite.
+ * @details The slots of a composite depend on the sizes and alignments of every member before the one viewed, so the
+ * 			dtypes of all of the members are given in the order of the C++ template arguments.
+ */
+static PyObject *composite(PyObject *, PyObject *args, PyObject *kwargs) {
+    static const char *keywords[] = {"name", "members", "index", "read_only", nullptr};
+    const char *name;
+    PyObject *members;
+    Py_ssize_t index = 0;
+    int read_only = 0;
+    if (!PyArg_ParseTupleAndKeywords(args, kwargs, "sO|np", (char **)keywords, &name, &members, &index, &read_only)) {
+        return nullptr;
+    }
+    PyObject *sequence = PySequence_Fast(members, "members must be a sequence of dtypes");
+    if (sequence == nullptr) {
+        return nullptr;
+    }
+    PyObject *result = nullptr;
+    if (index < 0 || index >= PySequence_Fast_GET_SIZE(sequence)) {
+        PyErr_SetString(PyExc_IndexError, "index is not a member of the composite");
+    }
+    else {
+        std::size_t slot_offset = 0;
+        PyObject *member = nullptr;
+        for (Py_ssize_t i = 0; i <= index; i++) {
+            std::size_t alignment = 0;
+            Py_XSETREF(member, converted_dtype(PySequence_Fast_GET_ITEM(sequence, i), &alignment));
+            if (member == nullptr) {
+                break;
+            }
+            const std::size_t size = dtype_size(member, "itemsize");
+            if (PyErr_Occurred()) {
+                Py_CLEAR(member);
+                break;
+            }
+            if (i < index) {
+                slot_offset += composite_slot_size(size, alignment);
+            }
+            else {
+                const GenericSharedMemoryPythonLayout layout = {slot_offset + composite_value_offset(alignment), true, true,
+                                                               slot_offset, slot_offset + sizeof(uint32_t)};
+                result = new_segment(name, member, layout, read_only);
+            }
+        }
+        Py_XDECREF(member);
+    }
+    Py_DECREF(sequence);
+    return result;
+}
+
+/**
+ * @brief Function field_model() maps a GenericSharedMemoryFieldModel.
+ * @details The fields default to the fields of the dtype, which match the reflected fields of the C++ struct, and the
+ * 			subscribers to the default of the C++ class.
+ */
+static PyObject *field_model(PyObject *, PyObject *args, PyObject *kwargs) {
+    static const char *keywords[] = {"name", "dtype", "fields", "subscribers", "read_only", nullptr};
+    const char *name;
+    PyObject *dtype;
+    Py_ssize_t fields = 0;
+    Py_ssize_t subscribers = 16;
+    int read_only = 0;
+    if (!PyArg_ParseTupleAndKeywords(args, kwargs, "sO|nnp", (char **)keywords, &name, &dtype, &fields, &subscribers, &read_only)) {
+        return nullptr;
+    }
+    std::size_t alignment = 0;
+    PyObject *converted = converted_dtype(dtype, &alignment);
+    if (converted == nullptr) {
+        return nullptr;
+    }
+    if (fields == 0) {
+        PyObject *names = PyObject_GetAttrString(converted, "names");
+        fields = names != nullptr && names != Py_None ? PyObject_Length(names) : 1;
+        Py_XDECREF(names);
+    }
+    PyObject *result = nullptr;
+    if (!PyErr_Occurred()) {
+        if (fields <= 0 || subscribers < 0) {
+            PyErr_SetString(PyExc_ValueError, "A field segment needs at least one field and no negative subscribers");
+        }
+        else {
+            const GenericSharedMemoryPythonLayout layout = {field_value_offset(alignment, (std::size_t)fields, (std::size_t)subscribers),
+                                                           true, false, 0, 0};
+            result = new_segment(name, converted, layout, read_only);
+        }
+    }
+    Py_DECREF(converted);
+    return result;
+}
+
+/// Function versioned_model() maps a GenericSharedMemoryVersionedModel, whose value follows the schema header.
+static PyObject *versioned_model(PyObject *, PyObject *args, PyObject *kwargs) {
+    static const char *keywords[] = {"name", "dtype", "read_only", nullptr};
+    const char *name;
+    PyObject *dtype;
+    int read_only = 0;
+    if (!PyArg_ParseTupleAndKeywords(args, kwargs, "sO|p", (char **)keywords, &name, &dtype, &read_only)) {
+        return nullptr;
+    }
+    const GenericSharedMemoryPythonLayout layout = {offsetof(GenericSharedMemorySchemaLayout<64>, value), true, false,
+                                                   offsetof(GenericSharedMemorySchemaHeader, sequence), 0};
+    return new_segment(name, dtype, layout, read_only);
+}
+
+static PyMethodDef segment_methods[] = {
+    {"snapshot", segment_snapshot, METH_NOARGS, "Copy the records, consistently if the segment has a sequence lock."},
+    {"wait", (PyCFunction)(void (*)(void))segment_wait, METH_VARARGS | METH_KEYWORDS,
+     "wait(version, timeout_ms=-1)\n--\n\nWait for the version to change, returning False on timeout. Sleeps on the "
+     "sequence of a composite slot, and polls the sequence of other segments."},
+    {nullptr, nullptr, 0, nullptr}
+};
+
+static PyGetSetDef segment_getset[] = {
+    {"array", segment_array, nullptr, "NumPy array viewing the records in place.", nullptr},
+    {"version", segment_version, nullptr, "Number of writes made under the sequence lock.", nullptr},
+    {"name", segment_name, nullptr, "Name of the segment.", nullptr},
+    {"size", segment_size, nullptr, "Size of the segment in bytes.", nullptr},
+    {nullptr, nullptr, nullptr, nullptr, nullptr}
+};
+
+static PyType_Slot segment_slots[] = {
+    {Py_tp_doc, (void *)"Segment(name, dtype, count=1, read_only=False)\n--\n\nMap a GenericSharedMemoryModel holding count "
+                        "records of dtype. Use composite(), field_model() or versioned_model() for the other layouts."},
+    {Py_tp_new, (void *)PyType_GenericNew},
+    {Py_tp_init, (void *)segment_init},
+    {Py_tp_dealloc, (void *)segment_dealloc},
+    {Py_tp_methods, segment_methods},
+    {Py_tp_getset, segment_getset},
+    {Py_bf_getbuffer, (void *)segment_getbuffer},
+    {0, nullptr}
+};
+
+static PyType_Spec segment_spec = {
+    "generic_shared_memory.Segment", sizeof(GenericSharedMemoryPythonSegment), 0, Py_TPFLAGS_DEFAULT, segment_slots
+};
+
+static PyMethodDef module_methods[] = {
+    {"composite", (PyCFunction)(void (*)(void))composite, METH_VARARGS | METH_KEYWORDS,
+     "composite(name, members, index=0, read_only=False)\n--\n\nMap member index of a GenericSharedMemoryComposite "
+     "whose members have the dtypes in members."},
+    {"field_model", (PyCFunction)(void (*)(void))field_model, METH_VARARGS | METH_KEYWORDS,
+     "field_model(name, dtype, fields=0, subscribers=16, read_only=False)\n--\n\nMap a GenericSharedMemoryFieldModel, "
+     "with as many fields as the dtype unless fields is given."},
+    {"versioned_model", (PyCFunction)(void (*)(void))versioned_model, METH_VARARGS | METH_KEYWORDS,
+     "versioned_model(name, dtype, read_only=False)\n--\n\nMap a GenericSharedMemoryVersionedModel, viewing its value "
+     "through dtype."},
+    {nullptr, nullptr, 0, nullptr}
+};
+
+static PyModuleDef generic_shared_memory_module = {
+    PyModuleDef_HEAD_INIT, "generic_shared_memory",
+    "Zero copy access to shared memory segments of the generic shared memory model.", -1, module_methods,
+    nullptr, nullptr, nullptr, nullptr
+};
+
+PyMODINIT_FUNC PyInit_generic_shared_memory(void) {
+    PyObject *numpy = PyImport_ImportModule("numpy");
+    if (numpy == nullptr) {
+        return nullptr;
+    }
+    numpy_dtype = PyObject_GetAttrString(numpy, "dtype");
+    numpy_ndarray = PyObject_GetAttrString(numpy, "ndarray");
+    Py_DECREF(numpy);
+    if (numpy_dtype == nullptr || numpy_ndarray == nullptr) {
+        return nullptr;
+    }
+
+    segment_type = (PyTypeObject *)PyType_FromSpec(&segment_spec);
+    if (segment_type == nullptr) {
+        return nullptr;
+    }
+
+    PyObject *module = PyModule_Create(&generic_shared_memory_module);
+    if (module == nullptr) {
+        return nullptr;
+    }
+    if (PyModule_AddObjectRef(module, "Segment", (PyObject *)segment_type) < 0) {
+        Py_DECREF(module);
+        return nullptr;
+    }
+    return module;
+}
@@ -0,0 +1,69 @@
+/**
+ * 	@file		generic_shared_memory_python_writer.cpp
+ *	@brief		Writer of the segments read by the smoke test of the Python bindings.
+ *	@details	This program writes a pose into a composite segment (as the second member, after a status),
+				a field segment or a versioned segment, creating the segment if it does not exist,
+				optionally after a delay so that the test can wait for the write from Python.
+ *	@author		James Horner
+ */
+
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <chrono>
+#include <thread>
+
+#include "GenericSharedMemoryComposite.hpp"
+#include "GenericSharedMemoryFieldModel.hpp"
+#include "GenericSharedMemorySchema.hpp"
+
+/// Status written before the pose in the composite segment, so that the pose is not the first member.
+typedef struct _python_status_t {
+	uint8_t mode;
+} python_status_t;
+
+/// Pose written to the segments, matching the dtype used by the test.
+typedef struct _python_pose_t {
+	double x;
+	double y;
+	double z;
+} python_pose_t;
+
+/// Function write_pose() connects a model of the pose, waits for the delay, then writes the pose with it.
+template<typename Model, typename Write>
+int write_pose(Model &model, const char *name, int delay_ms, Write write) {
+	if (!model.connect()) {
+		fprintf(stderr, "Couldn't connect to shared memory with name: %s\n", name);
+		return -1;
+	}
+	std::this_thread::sleep_for(std::chrono::milliseconds(delay_ms));
+	write(model);
+	return 0;
+}
+
+int main(int argc, char **argv) {
+	if (argc < 4 || argc > 5) {
+		printf("Usage: %s <composite|field|versioned> <segment name> <x> [delay in milliseconds]\n", argv[0]);
+		return -1;
+	}
+
+	const double x = strtod(argv[3], nullptr);
+	const python_pose_t pose = {x, x + 1.0, x + 2.0};
+	const int delay_ms = argc == 5 ? atoi(argv[4]) : 0;
+	if (strcmp(argv[1], "composite") == 0) {
+		GenericSharedMemoryComposite<python_status_t, python_pose_t> composite(argv[2]);
+		return write_pose(composite, argv[2], delay_ms, [&](auto &model) { model.template write<python_pose_t>(pose); });
+	}
+	if (strcmp(argv[1], "field") == 0) {
+		GenericSharedMemoryFieldModel<python_pose_t> field(argv[2]);
+		return write_pose(field, argv[2], delay_ms, [&](auto &model) { model.write_data(pose); });
+	}
+	if (strcmp(argv[1], "versioned") == 0) {
+		GenericSharedMemoryVersionedModel<python_pose_t> versioned(argv[2]);
+		return write_pose(versioned, argv[2], delay_ms, [&](auto &model) { model.write_data(pose); });
+	}
+	fprintf(stderr, "Unknown kind of segment: %s\n", argv[1]);
+	return -1;
+}
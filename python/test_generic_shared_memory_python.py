@@ -0,0 +1,102 @@
+"""Smoke test of the generic_shared_memory module against segments written by a C++ process.
+
+Usage: test_generic_shared_memory_python.py <path of generic_shared_memory_python_writer>
+"""
+
+import os
+import subprocess
+import sys
+import unittest
+
+import numpy as np
+
+import generic_shared_memory as gsm
+
+WRITER = sys.argv.pop(1) if len(sys.argv) > 1 else "generic_shared_memory_python_writer"
+NAME = "test_python_pose"
+STATUS_T = np.dtype([("mode", "u1")], align=True)
+POSE_T = np.dtype([("x", "<f8"), ("y", "<f8"), ("z", "<f8")], align=True)
+
+
+def write(kind, x, delay_ms=None):
+	"""Start the writer, which writes the pose (x, x + 1, x + 2) into a segment of the given kind."""
+	arguments = [WRITER, kind, NAME, str(x)] + ([str(delay_ms)] if delay_ms is not None else [])
+	return subprocess.Popen(arguments)
+
+
+class GenericSharedMemoryPythonTest(unittest.TestCase):
+	def setUp(self):
+		self.tearDown()
+
+	def tearDown(self):
+		try:
+			os.unlink("/dev/shm/" + NAME)
+		except FileNotFoundError:
+			pass
+
+	# Versions only ever increase, by one per write, and by one per connect of a versioned model, which locks the header.
+	def check_view_and_snapshot(self, kind, pose):
+		self.assertEqual(pose.name, NAME)
+		version = pose.version
+		self.assertGreater(version, 0)
+		self.assertEqual(float(pose.array["x"]), 1.0)
+
+		# The view reads the mapping, while the snapshot keeps the value it copied.
+		snapshot = pose.snapshot()
+		self.assertEqual(float(snapshot["z"]), 3.0)
+		self.assertEqual(write(kind, 5.0).wait(), 0)
+		self.assertEqual(float(pose.array["x"]), 5.0)
+		self.assertEqual(float(snapshot["x"]), 1.0)
+		self.assertGreater(pose.version, version)
+
+	def check_wait(self, kind, pose):
+		version = pose.version
+		self.assertFalse(pose.wait(version, timeout_ms=10))
+		writer = write(kind, 7.0, delay_ms=100)
+		self.assertTrue(pose.wait(version, timeout_ms=5000))
+		self.assertEqual(writer.wait(), 0)
+		self.assertGreater(pose.version, version)
+		self.assertEqual(float(pose.snapshot()["y"]), 8.0)
+
+	def test_composite(self):
+		self.assertEqual(write("composite", 1.0).wait(), 0)
+		pose = gsm.composite(NAME, [STATUS_T, POSE_T], 1)
+		self.check_view_and_snapshot("composite", pose)
+		# A waiter registered in the slot's count of waiters is woken by the writer's futex wake.
+		self.check_wait("composite", pose)
+
+		# The first member is in its own slot, untouched by writes of the pose.
+		status = gsm.composite(NAME, [STATUS_T, POSE_T], 0, read_only=True)
+		self.assertEqual(status.version, 0)
+		self.assertFalse(status.array.flags.writeable)
+		with self.assertRaises(IndexError):
+			gsm.composite(NAME, [STATUS_T, POSE_T], 2)
+
+	def test_field_model(self):
+		self.assertEqual(write("field", 1.0).wait(), 0)
+		pose = gsm.field_model(NAME, POSE_T)
+		self.check_view_and_snapshot("field", pose)
+		self.check_wait("field", pose)
+
+	def test_versioned_model(self):
+		self.assertEqual(write("versioned", 1.0).wait(), 0)
+		pose = gsm.versioned_model(NAME, POSE_T)
+		self.check_view_and_snapshot("versioned", pose)
+		self.check_wait("versioned", pose)
+
+	def test_model(self):
+		# A plain model has no sequence lock, so it is viewed from the start of the segment and can't be waited on.
+		self.assertEqual(write("versioned", 1.0).wait(), 0)
+		raw = gsm.Segment(NAME, np.uint32, count=4)
+		self.assertEqual(raw.array.shape, (4,))
+		self.assertEqual(int(raw.array[0]), 2 * gsm.versioned_model(NAME, POSE_T).version)
+		with self.assertRaises(RuntimeError):
+			raw.wait(0)
+		with self.assertRaises(ValueError):
+			gsm.Segment(NAME, np.uint8, count=raw.size + 1)
+		with self.assertRaises(OSError):
+			gsm.Segment("test_python_missing", POSE_T)
+
+
+if __name__ == "__main__":
+	unittest.main()
@@ -0,0 +1,80 @@
+#include <gtest/gtest.h>
+
+#include "GenericSharedMemoryArrow.hpp"
+
+using namespace std;
+
+typedef struct _test_entity_t {
+	int32_t id;
+	double x;
+	bool active;
+	char tag[4];
+} test_entity_t;
+GENERIC_SHARED_MEMORY_REFLECT(test_entity_t, id, x, active, tag);
+
+typedef array<test_entity_t, 10> test_entities_t;
+
+TEST(GenericSharedMemoryArrowTest, TestExportRecords) {
+	shm_unlink("test_arrow");
+	GenericSharedMemoryModel<test_entities_t> model("test_arrow");
+	ArrowSchema schema;
+	ArrowArray array;
+	ASSERT_FALSE(GenericSharedMemoryArrow::export_model(model, &schema, &array));
+	ASSERT_TRUE(model.connect());
+	for (int i = 0; i < 10; i++) {
+		(*model.data)[i] = {i, i * 0.5, i % 3 == 0, {'a', 'b', 'c', (char)('0' + i)}};
+	}
+	ASSERT_TRUE(GenericSharedMemoryArrow::export_model(model, &schema, &array));
+
+	// The records are a struct array with a child per field.
+	ASSERT_STREQ(schema.format, "+s");
+	ASSERT_EQ(schema.n_children, 4);
+	ASSERT_STREQ(schema.children[0]->format, "i");
+	ASSERT_STREQ(schema.children[0]->name, "id");
+	ASSERT_STREQ(schema.children[1]->format, "g");
+	ASSERT_STREQ(schema.children[2]->format, "b");
+	ASSERT_STREQ(schema.children[3]->format, "w:4");
+	ASSERT_EQ(array.length, 10);
+	ASSERT_EQ(array.n_children, 4);
+
+	// Each column is contiguous, aligned and a snapshot of the segment.
+	(*model.data)[9].x = -1.0;
+	const double *x = (const double *)array.children[1]->buffers[1];
+	ASSERT_EQ((uintptr_t)x % GENERIC_SHARED_MEMORY_ARROW_ALIGNMENT, 0u);
+	ASSERT_EQ(x[9], 4.5);
+	ASSERT_EQ(((const int32_t *)array.children[0]->buffers[1])[7], 7);
+	ASSERT_EQ(((const uint8_t *)array.children[2]->buffers[1])[0], 0x49);
+	ASSERT_EQ(((const char *)array.children[3]->buffers[1])[4 * 5 + 3], '5');
+
+	// A child moved out of the array outlives the parent.
+	ArrowArray child = *array.children[1];
+	array.children[1]->release = nullptr;
+	array.release(&array);
+	ASSERT_EQ(array.release, nullptr);
+	ASSERT_EQ(((const double *)child.buffers[1])[2], 1.0);
+	child.release(&child);
+	schema.release(&schema);
+
+	model.disconnect();
+	shm_unlink("test_arrow");
+}
+
+TEST(GenericSharedMemoryArrowTest, TestExportColumns) {
+	// Contiguous columns are exported in place, keeping their owner alive.
+	auto values = make_shared<vector<float>>(vector<float>{1.0f, 2.0f, 3.0f});
+	const void *columns[] = {values->data()};
+	GenericSharedMemoryField field = {"value", 0, 0, sizeof(float), alignof(float), GenericSharedMemoryFieldKind::Float};
+	ArrowSchema schema;
+	ArrowArray array;
+	ASSERT_TRUE(GenericSharedMemoryArrow::export_columns(columns, 3, &field, 1, values, &schema, &array));
+	ASSERT_EQ(array.children[0]->buffers[1], values->data());
+	ASSERT_EQ(values.use_count(), 2);
+	array.release(&array);
+	schema.release(&schema);
+	ASSERT_EQ(values.use_count(), 1);
+
+	// Fields without an Arrow type are rejected.
+	field.kind = GenericSharedMemoryFieldKind::Signed;
+	field.size = 3;
+	ASSERT_FALSE(GenericSharedMemoryArrow::export_columns(columns, 3, &field, 1, values, &schema, &array));
+}
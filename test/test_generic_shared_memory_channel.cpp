@@ -0,0 +1,159 @@
+#include <gtest/gtest.h>
+
+#include <sys/wait.h>
+#include <thread>
+#include <unistd.h>
+
+#include "GenericSharedMemoryChannel.hpp"
+#include "GenericSharedMemorySegment.hpp"
+
+using namespace std;
+
+typedef struct _test_message_t {
+	uint64_t sequence;
+	double value;
+	uint32_t source;
+} test_message_t;
+
+TEST(GenericSharedMemoryChannelTest, TestQueue) {
+	GenericSharedMemoryChannel::remove("test_channel_queue");
+	GenericSharedMemoryChannel writer("test_channel_queue");
+	GenericSharedMemoryChannel reader("test_channel_queue");
+	test_message_t message{};
+	ASSERT_FALSE(reader.connect());
+	ASSERT_FALSE(writer.write(&message));
+	ASSERT_FALSE(writer.create(GenericSharedMemoryChannelKind::Queue, 0, 4));
+	ASSERT_TRUE(writer.create(GenericSharedMemoryChannelKind::Queue, sizeof(test_message_t), 4));
+	ASSERT_TRUE(reader.connect());
+	ASSERT_EQ(reader.kind(), GenericSharedMemoryChannelKind::Queue);
+	ASSERT_EQ(reader.message_bytes(), sizeof(test_message_t));
+	ASSERT_FALSE(reader.read(&message));
+
+	// Messages are read once and in order, and a full queue refuses writes and counts them.
+	for (uint64_t sequence = 0; sequence < 4; sequence++) {
+		message = {sequence, sequence * 0.5, 1};
+		ASSERT_TRUE(writer.write(&message));
+	}
+	ASSERT_FALSE(writer.write(&message));
+	GenericSharedMemoryChannelStats stats = reader.stats();
+	ASSERT_EQ(stats.written, 4u);
+	ASSERT_EQ(stats.queued, 4u);
+	ASSERT_EQ(stats.depth, 4u);
+	ASSERT_EQ(stats.full, 1u);
+	for (uint64_t sequence = 0; sequence < 4; sequence++) {
+		ASSERT_TRUE(reader.read(&message));
+		ASSERT_EQ(message.sequence, sequence);
+		ASSERT_EQ(message.value, sequence * 0.5);
+	}
+	ASSERT_FALSE(reader.read(&message, 10));
+	stats = writer.stats();
+	ASSERT_EQ(stats.read, 4u);
+	ASSERT_EQ(stats.queued, 0u);
+
+	writer.disconnect();
+	reader.disconnect();
+	GenericSharedMemoryChannel::remove("test_channel_queue");
+}
+
+TEST(GenericSharedMemoryChannelTest, TestQueueAcrossProcesses) {
+	GenericSharedMemoryChannel::remove("test_channel_processes");
+	GenericSharedMemoryChannel reader("test_channel_processes");
+	ASSERT_TRUE(reader.create(GenericSharedMemoryChannelKind::Queue, sizeof(test_message_t), 8));
+
+	// A writer in another process blocks on the full queue rather than dropping messages.
+	pid_t pid = fork();
+	if (pid == 0) {
+		GenericSharedMemoryChannel writer("test_channel_processes");
+		bool written = writer.connect();
+		for (uint64_t sequence = 0; written && sequence < 10000; sequence++) {
+			test_message_t message{sequence, 0.0, 2};
+			written = writer.write(&message, 5000);
+		}
+		_exit(written ? 0 : 1);
+	}
+	test_message_t message;
+	for (uint64_t sequence = 0; sequence < 10000; sequence++) {
+		ASSERT_TRUE(reader.read(&message, 5000));
+		ASSERT_EQ(message.sequence, sequence);
+	}
+	int status = 0;
+	waitpid(pid, &status, 0);
+	ASSERT_TRUE(WIFEXITED(status));
+	ASSERT_EQ(WEXITSTATUS(status), 0);
+	ASSERT_EQ(reader.stats().written, 10000u);
+
+	reader.disconnect();
+	GenericSharedMemoryChannel::remove("test_channel_processes");
+}
+
+TEST(GenericSharedMemoryChannelTest, TestLatest) {
+	GenericSharedMemoryChannel::remove("test_channel_latest");
+	GenericSharedMemoryChannel writer("test_channel_latest");
+	GenericSharedMemoryChannel first("test_channel_latest");
+	GenericSharedMemoryChannel second("test_channel_latest");
+	ASSERT_TRUE(writer.create(GenericSharedMemoryChannelKind::Latest, sizeof(test_message_t), 16));
+	ASSERT_TRUE(first.connect());
+	ASSERT_TRUE(second.connect());
+	test_message_t message{};
+	ASSERT_FALSE(first.read(&message));
+
+	// Writes never block, and each reader gets the newest value it has not read.
+	for (uint64_t sequence = 1; sequence <= 3; sequence++) {
+		message = {sequence, 0.0, 3};
+		ASSERT_TRUE(writer.write(&message));
+	}
+	ASSERT_TRUE(first.read(&message));
+	ASSERT_EQ(message.sequence, 3u);
+	ASSERT_FALSE(first.read(&message));
+	ASSERT_TRUE(second.read(&message));
+	ASSERT_EQ(message.sequence, 3u);
+	GenericSharedMemoryChannelStats stats = writer.stats();
+	ASSERT_EQ(stats.written, 3u);
+	ASSERT_EQ(stats.read, 2u);
+	ASSERT_EQ(stats.depth, 1u);
+
+	// A waiting reader is woken by the next write.
+	thread later([&]() {
+		this_thread::sleep_for(chrono::milliseconds(20));
+		test_message_t next{4, 0.0, 3};
+		writer.write(&next);
+	});
+	ASSERT_TRUE(first.read(&message, 5000));
+	ASSERT_EQ(message.sequence, 4u);
+	later.join();
+
+	GenericSharedMemoryChannel::remove("test_channel_latest");
+}
+
+TEST(GenericSharedMemoryChannelTest, TestRecreateAndValidate) {
+	GenericSharedMemoryChannel::remove("test_channel_recreate");
+	GenericSharedMemoryChannel creator("test_channel_recreate");
+	GenericSharedMemoryChannel stale("test_channel_recreate");
+	test_message_t message{7, 1.5, 2};
+	ASSERT_TRUE(creator.create(GenericSharedMemoryChannelKind::Queue, sizeof(test_message_t), 4));
+	ASSERT_TRUE(stale.connect());
+
+	// Creating the channel again leaves a connection to the old segment working on its own copy.
+	GenericSharedMemoryChannel recreator("test_channel_recreate");
+	ASSERT_TRUE(recreator.create(GenericSharedMemoryChannelKind::Queue, sizeof(test_message_t), 8));
+	ASSERT_TRUE(stale.write(&message));
+	ASSERT_TRUE(stale.read(&message));
+	ASSERT_EQ(message.sequence, 7u);
+	ASSERT_EQ(recreator.stats().written, 0u);
+	ASSERT_EQ(recreator.stats().depth, 8u);
+
+	// A header of an unknown kind is refused, as its slots would not match the segment.
+	GenericSharedMemoryChannel corrupt("test_channel_recreate");
+	GenericSharedMemorySegment segment("test_channel_recreate");
+	uint32_t kind = 7;
+	ASSERT_TRUE(segment.connect());
+	ASSERT_TRUE(segment.write(offsetof(GenericSharedMemoryChannelHeader, kind), &kind, sizeof(kind)));
+	segment.disconnect();
+	ASSERT_FALSE(corrupt.connect());
+	ASSERT_FALSE(corrupt.is_connected());
+
+	creator.disconnect();
+	stale.disconnect();
+	recreator.disconnect();
+	GenericSharedMemoryChannel::remove("test_channel_recreate");
+}
@@ -0,0 +1,149 @@
+#include <stdio.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <gtest/gtest.h>
+
+#include "GenericSharedMemoryCheckpoint.hpp"
+
+using namespace std;
+
+typedef struct _test_pages_t {
+	char bytes[8][4096];
+	char tail[100];
+} test_pages_t;
+
+static void remove_chain(const string &prefix) {
+	for (int i = 0; i < 8; i++) {
+		remove((prefix + "." + to_string(i)).c_str());
+	}
+}
+
+static void test_incremental_checkpoints(GenericSharedMemoryCheckpointTracking tracking) {
+	const string prefix = testing::TempDir() + "test_checkpoint";
+	remove_chain(prefix);
+	shm_unlink("test_checkpoint_pages");
+
+	GenericSharedMemoryModel<test_pages_t> test_pages("test_checkpoint_pages");
+	ASSERT_TRUE(test_pages.connect());
+	for (int i = 0; i < 8; i++) {
+		test_pages.data->bytes[i][0] = (char)i;
+	}
+
+	// The first checkpoint saves every page, the next ones only the pages modified since.
+	GenericSharedMemoryCheckpointer checkpointer(prefix, tracking);
+	ASSERT_TRUE(checkpointer.checkpoint(test_pages));
+	ASSERT_EQ(checkpointer.last_page_count(), 9u);
+
+	test_pages.data->bytes[3][100] = 42;
+	test_pages.data->tail[99] = 42;
+	ASSERT_TRUE(checkpointer.checkpoint(test_pages));
+	ASSERT_EQ(checkpointer.last_page_count(), 2u);
+
+	ASSERT_TRUE(checkpointer.checkpoint(test_pages));
+	ASSERT_EQ(checkpointer.last_page_count(), 0u);
+
+	test_pages.data->bytes[6][4095] = 42;
+	ASSERT_TRUE(checkpointer.checkpoint(test_pages));
+	ASSERT_EQ(checkpointer.last_page_count(), 1u);
+	ASSERT_EQ(checkpointer.sequence(), 4u);
+
+	// Replaying the chain restores the segment as of the last checkpoint.
+	test_pages_t *restored = new test_pages_t();
+	ASSERT_EQ(GenericSharedMemoryCheckpointer::restore(prefix, restored, sizeof(test_pages_t)), 4u);
+	ASSERT_EQ(memcmp(restored, test_pages.data, sizeof(test_pages_t)), 0);
+	ASSERT_EQ(GenericSharedMemoryCheckpointer::restore(prefix, restored, sizeof(test_pages_t) - 1), 0u);
+	delete restored;
+
+	remove_chain(prefix);
+	shm_unlink("test_checkpoint_pages");
+}
+
+TEST(GenericSharedMemoryCheckpointTest, TestPageHashCheckpoints) {
+	test_incremental_checkpoints(GenericSharedMemoryCheckpointTracking::PageHash);
+}
+
+TEST(GenericSharedMemoryCheckpointTest, TestSoftDirtyCheckpoints) {
+	// Falls back to page hashes when the kernel does not track soft-dirty bits.
+	GenericSharedMemoryCheckpointer checkpointer("", GenericSharedMemoryCheckpointTracking::SoftDirty);
+	ASSERT_EQ(checkpointer.is_soft_dirty(), GenericSharedMemoryCheckpointer::soft_dirty_supported());
+	test_incremental_checkpoints(GenericSharedMemoryCheckpointTracking::SoftDirty);
+}
+
+TEST(GenericSharedMemoryCheckpointTest, TestNewChainIgnoresOldFiles) {
+	const string prefix = testing::TempDir() + "test_checkpoint_chain";
+	remove_chain(prefix);
+	int value = 1;
+
+	GenericSharedMemoryCheckpointer old_checkpointer(prefix);
+	ASSERT_TRUE(old_checkpointer.checkpoint(&value, sizeof(value)));
+	value = 2;
+	ASSERT_TRUE(old_checkpointer.checkpoint(&value, sizeof(value)));
+
+	value = 3;
+	GenericSharedMemoryCheckpointer new_checkpointer(prefix);
+	ASSERT_TRUE(new_checkpointer.checkpoint(&value, sizeof(value)));
+
+	// The first checkpoint of the new chain removes the files left by the old one.
+	struct stat file_stat;
+	ASSERT_NE(stat((prefix + ".1").c_str(), &file_stat), 0);
+	int restored = 0;
+	ASSERT_EQ(GenericSharedMemoryCheckpointer::restore(prefix, &restored, sizeof(restored)), 1u);
+	ASSERT_EQ(restored, 3);
+
+	// A leftover file from a chain of a different segment size still only ends the chain.
+	const string other_prefix = testing::TempDir() + "test_checkpoint_chain_other";
+	remove_chain(other_prefix);
+	double other_value = 1.0;
+	GenericSharedMemoryCheckpointer other_checkpointer(other_prefix);
+	ASSERT_TRUE(other_checkpointer.checkpoint(&other_value, sizeof(other_value)));
+	ASSERT_TRUE(other_checkpointer.checkpoint(&other_value, sizeof(other_value)));
+	value = 4;
+	ASSERT_TRUE(new_checkpointer.checkpoint(&value, sizeof(value)));
+	ASSERT_EQ(rename((other_prefix + ".1").c_str(), (prefix + ".2").c_str()), 0);
+	ASSERT_EQ(GenericSharedMemoryCheckpointer::restore(prefix, &restored, sizeof(restored)), 2u);
+	ASSERT_EQ(restored, 4);
+	remove_chain(other_prefix);
+	remove_chain(prefix);
+}
+
+static void test_failed_checkpoint(GenericSharedMemoryCheckpointTracking tracking) {
+	const string prefix = testing::TempDir() + "test_checkpoint_failed";
+	remove_chain(prefix);
+	shm_unlink("test_checkpoint_failed_pages");
+
+	GenericSharedMemoryModel<test_pages_t> test_pages("test_checkpoint_failed_pages");
+	ASSERT_TRUE(test_pages.connect());
+	GenericSharedMemoryCheckpointer checkpointer(prefix, tracking);
+	ASSERT_TRUE(checkpointer.checkpoint(test_pages));
+
+	// A checkpoint that cannot be written leaves its pages to the next one.
+	test_pages.data->bytes[2][10] = 42;
+	ASSERT_EQ(mkdir((prefix + ".1.tmp").c_str(), 0700), 0);
+	ASSERT_FALSE(checkpointer.checkpoint(test_pages));
+	ASSERT_EQ(checkpointer.sequence(), 1u);
+	rmdir((prefix + ".1.tmp").c_str());
+	ASSERT_TRUE(checkpointer.checkpoint(test_pages));
+	ASSERT_GE(checkpointer.last_page_count(), 1u);
+
+	test_pages_t *restored = new test_pages_t();
+	ASSERT_EQ(GenericSharedMemoryCheckpointer::restore(prefix, restored, sizeof(test_pages_t)), 2u);
+	ASSERT_EQ(restored->bytes[2][10], 42);
+
+	// A damaged file in the chain leaves the segment unchanged.
+	test_pages.data->bytes[5][0] = 42;
+	ASSERT_TRUE(checkpointer.checkpoint(test_pages));
+	ASSERT_EQ(truncate((prefix + ".2").c_str(), sizeof(GenericSharedMemoryCheckpointHeader) + 4), 0);
+	memset((void *)restored, 7, sizeof(test_pages_t));
+	ASSERT_EQ(GenericSharedMemoryCheckpointer::restore(prefix, restored, sizeof(test_pages_t)), 0u);
+	ASSERT_EQ(restored->bytes[2][10], 7);
+	delete restored;
+
+	remove_chain(prefix);
+	shm_unlink("test_checkpoint_failed_pages");
+}
+
+TEST(GenericSharedMemoryCheckpointTest, TestFailedCheckpoint) {
+	test_failed_checkpoint(GenericSharedMemoryCheckpointTracking::PageHash);
+	test_failed_checkpoint(GenericSharedMemoryCheckpointTracking::SoftDirty);
+}
@@ -0,0 +1,146 @@
+#include <atomic>
+#include <string>
+#include <thread>
+
+#include <gtest/gtest.h>
+
+#include "GenericSharedMemoryModel.hpp"
+#include "GenericSharedMemoryChecksum.hpp"
+
+using namespace std;
+
+typedef struct _test_struct_t {
+	int a;
+	double b;
+	char c[200];
+} test_struct_t;
+
+typedef struct _test_large_t {
+	char bytes[10][1000];
+	char tail[10];
+} test_large_t;
+
+TEST(GenericSharedMemoryChecksumTest, TestCRC32C) {
+	// Check values from RFC 3720.
+	const string digits = "123456789";
+	ASSERT_EQ(generic_shared_memory_crc32c(digits.data(), digits.size()), 0xE3069283u);
+	unsigned char zeros[32] = {};
+	ASSERT_EQ(generic_shared_memory_crc32c(zeros, sizeof(zeros)), 0x8A9136AAu);
+	unsigned char ones[32];
+	memset(ones, 0xFF, sizeof(ones));
+	ASSERT_EQ(generic_shared_memory_crc32c(ones, sizeof(ones)), 0x62A8AB43u);
+
+	// The software implementation matches, as does continuing a checksum across buffers.
+	string text(1000, 'x');
+	for (size_t i = 0; i < text.size(); i++) {
+		text[i] = (char)(i * 7);
+	}
+	const uint32_t crc = generic_shared_memory_crc32c(text.data(), text.size());
+	ASSERT_EQ(~generic_shared_memory_crc32c_detail::software((const unsigned char *)text.data(), text.size(), ~0u), crc);
+	ASSERT_EQ(generic_shared_memory_crc32c(text.data() + 333, 667, generic_shared_memory_crc32c(text.data(), 333)), crc);
+}
+
+TEST(GenericSharedMemoryChecksumTest, TestChecksummedSegment) {
+	shm_unlink("test_checksummed");
+	GenericSharedMemoryModel<GenericSharedMemoryChecksummed<test_struct_t>> writer("test_checksummed");
+	GenericSharedMemoryModel<GenericSharedMemoryChecksummed<test_struct_t>> reader("test_checksummed");
+	ASSERT_TRUE(writer.connect());
+	ASSERT_TRUE(reader.connect());
+
+	writer.data->payload.a = 42;
+	writer.data->payload.b = 3.5;
+	writer.data->seal();
+	ASSERT_TRUE(reader.data->verify());
+
+	// A write through the raw pointer without sealing is detected.
+	writer.data->payload.c[150] = 'z';
+	ASSERT_FALSE(reader.data->verify());
+	writer.data->seal();
+	ASSERT_TRUE(reader.data->verify());
+
+	writer.disconnect();
+	reader.disconnect();
+	shm_unlink("test_checksummed");
+}
+
+TEST(GenericSharedMemoryChecksumTest, TestChunkChecksummedSegment) {
+	typedef GenericSharedMemoryChunkChecksummed<test_large_t, 4096> chunked_t;
+	ASSERT_EQ(chunked_t::chunk_count, 3u);
+
+	chunked_t *chunked = new chunked_t();
+	chunked->seal();
+	ASSERT_TRUE(chunked->verify());
+
+	// Corruption is located to its chunk, and resealing only the modified range restores it.
+	chunked->payload.bytes[5][0] = 1;
+	ASSERT_EQ(chunked->find_corrupt_chunk(), 1u);
+	ASSERT_TRUE(chunked->verify_chunk(0));
+	ASSERT_FALSE(chunked->verify_chunk(1));
+	chunked->seal_range(offsetof(test_large_t, bytes[5][0]), 1);
+	ASSERT_TRUE(chunked->verify());
+
+	chunked->payload.tail[9] = 1;
+	ASSERT_EQ(chunked->find_corrupt_chunk(), 2u);
+	chunked->seal_range(offsetof(test_large_t, tail), 100000);
+	ASSERT_TRUE(chunked->verify());
+
+	// Publishing a range writes it and reseals its chunks together.
+	const char fill[10] = {2, 2, 2, 2, 2, 2, 2, 2, 2, 2};
+	chunked->publish_range(offsetof(test_large_t, bytes[4][995]), fill, sizeof(fill));
+	ASSERT_EQ(chunked->payload.bytes[5][4], 2);
+	ASSERT_TRUE(chunked->verify());
+	delete chunked;
+}
+
+TEST(GenericSharedMemoryChecksumTest, TestChecksumModel) {
+	shm_unlink("test_checksum_model");
+	GenericSharedMemoryChecksumModel<GenericSharedMemoryChecksummed<test_struct_t>> writer("test_checksum_model");
+	GenericSharedMemoryChecksumModel<GenericSharedMemoryChecksummed<test_struct_t>> reader("test_checksum_model");
+	ASSERT_FALSE(writer.write_data(test_struct_t{}));
+	ASSERT_FALSE(reader.verify());
+	ASSERT_TRUE(writer.connect());
+	ASSERT_TRUE(reader.connect());
+
+	// write_data() seals the payload it publishes.
+	test_struct_t value{};
+	value.a = 42;
+	value.c[150] = 'z';
+	ASSERT_TRUE(writer.write_data(value));
+	ASSERT_TRUE(reader.verify());
+	ASSERT_EQ(reader.get_data().a, 42);
+
+	// A reader verifying while a writer publishes never reports corruption.
+	std::atomic<bool> stop(false);
+	std::thread publisher([&]() {
+		for (int i = 0; !stop.load(); i++) {
+			value.a = i;
+			memset(value.c, i, sizeof(value.c));
+			writer.write_data(value);
+		}
+	});
+	for (int i = 0; i < 20000; i++) {
+		ASSERT_TRUE(reader.verify());
+		const test_struct_t copy = reader.get_data();
+		ASSERT_EQ(copy.c[0], copy.c[199]);
+	}
+	stop.store(true);
+	publisher.join();
+
+	writer.disconnect();
+	reader.disconnect();
+	shm_unlink("test_checksum_model");
+}
+
+TEST(GenericSharedMemoryChecksumTest, TestChunkChecksumModel) {
+	shm_unlink("test_chunk_checksum_model");
+	GenericSharedMemoryChecksumModel<GenericSharedMemoryChunkChecksummed<test_large_t, 4096>> model("test_chunk_checksum_model");
+	ASSERT_TRUE(model.connect());
+	ASSERT_TRUE(model.write_data(test_large_t{}));
+	ASSERT_TRUE(model.verify());
+	const char tail[10] = {1, 2, 3, 4, 5, 6, 7, 8, 9, 10};
+	ASSERT_TRUE(model.write_range(offsetof(test_large_t, tail), tail, sizeof(tail)));
+	ASSERT_TRUE(model.verify());
+	ASSERT_EQ(model.get_data().tail[9], 10);
+	model.disconnect();
+	shm_unlink("test_chunk_checksum_model");
+}
@@ -0,0 +1,95 @@
+#include <gtest/gtest.h>
+
+#include "GenericSharedMemoryColumns.hpp"
+
+using namespace std;
+
+typedef struct _test_position_t {
+	float x;
+	float y;
+	double z;
+	int32_t id;
+} test_position_t;
+GENERIC_SHARED_MEMORY_REFLECT(test_position_t, x, y, z, id);
+
+typedef GenericSharedMemoryColumns<test_position_t, 1000> test_columns_t;
+
+TEST(GenericSharedMemoryColumnsTest, TestLayout) {
+	// Every column is contiguous and starts on its own cache line.
+	ASSERT_EQ(test_columns_t::column_count, 4u);
+	ASSERT_EQ(test_columns_t::column_offsets[0], 0u);
+	ASSERT_EQ(test_columns_t::column_offsets[1], 4032u);
+	ASSERT_EQ(test_columns_t::column_offsets[2], 8064u);
+	ASSERT_EQ(test_columns_t::column_offsets[3], 16064u);
+	ASSERT_EQ(alignof(test_columns_t::layout_t), 64u);
+	ASSERT_EQ(offsetof(test_columns_t::layout_t, columns) % 64, 0u);
+}
+
+TEST(GenericSharedMemoryColumnsTest, TestRowsAndColumns) {
+	shm_unlink("test_columns");
+	test_columns_t writer("test_columns");
+	test_columns_t reader("test_columns");
+	ASSERT_FALSE(writer.push_back({}));
+	ASSERT_TRUE(writer.column<0>().empty());
+	ASSERT_TRUE(writer.connect());
+	ASSERT_TRUE(reader.connect());
+
+	// Rows are scattered into the columns and gathered back.
+	for (int i = 0; i < 100; i++) {
+		ASSERT_TRUE(writer.push_back({(float)i, (float)-i, i * 0.5, i}));
+	}
+	ASSERT_EQ(reader.size(), 100u);
+	test_position_t row = reader.get_row(42);
+	ASSERT_EQ(row.x, 42.0f);
+	ASSERT_EQ(row.y, -42.0f);
+	ASSERT_EQ(row.z, 21.0);
+	ASSERT_EQ(row.id, 42);
+	ASSERT_TRUE(writer.set_row(42, {1.0f, 2.0f, 3.0, 4}));
+	ASSERT_FALSE(writer.set_row(100, {}));
+	ASSERT_EQ(reader.get_row(42).id, 4);
+	ASSERT_EQ(reader.get_row(100).id, 0);
+
+	// Columns are spans over the rows in use.
+	span<float> x = reader.column<0>();
+	ASSERT_EQ(x.size(), 100u);
+	ASSERT_EQ((uintptr_t)x.data() % 64, 0u);
+	ASSERT_EQ(x[99], 99.0f);
+	double total = 0.0;
+	for (double z : reader.column<2>()) {
+		total += z;
+	}
+	ASSERT_EQ(total, 2475.0 - 21.0 + 3.0);
+
+	ASSERT_TRUE(writer.resize(1000));
+	ASSERT_FALSE(writer.push_back({}));
+	ASSERT_FALSE(writer.resize(1001));
+	writer.clear();
+	ASSERT_EQ(reader.size(), 0u);
+
+	writer.disconnect();
+	reader.disconnect();
+	shm_unlink("test_columns");
+}
+
+TEST(GenericSharedMemoryColumnsTest, TestExportArrow) {
+	shm_unlink("test_columns_arrow");
+	test_columns_t columns("test_columns_arrow");
+	ASSERT_TRUE(columns.connect());
+	for (int i = 0; i < 10; i++) {
+		columns.push_back({(float)i, 0.0f, 0.0, i});
+	}
+
+	// The columns are exported in place.
+	ArrowSchema schema;
+	ArrowArray array;
+	ASSERT_TRUE(columns.export_arrow(&schema, &array));
+	ASSERT_EQ(array.length, 10);
+	ASSERT_STREQ(schema.children[2]->name, "z");
+	ASSERT_EQ(array.children[0]->buffers[1], columns.column<0>().data());
+	ASSERT_EQ(array.children[3]->buffers[1], columns.column<3>().data());
+	array.release(&array);
+	schema.release(&schema);
+
+	columns.disconnect();
+	shm_unlink("test_columns_arrow");
+}
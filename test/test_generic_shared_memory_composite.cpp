@@ -0,0 +1,93 @@
+#include <thread>
+
+#include <sys/wait.h>
+
+#include <gtest/gtest.h>
+
+#include "GenericSharedMemoryComposite.hpp"
+
+using namespace std;
+
+typedef struct _test_pose_t {
+	double x;
+	double y;
+	double z;
+} test_pose_t;
+
+typedef struct _test_health_t {
+	int status;
+	int checksum;
+} test_health_t;
+
+typedef GenericSharedMemoryComposite<test_pose_t, test_health_t, int> test_composite_t;
+
+TEST(GenericSharedMemoryCompositeTest, TestMembers) {
+	// Every member has its own cache lines.
+	ASSERT_EQ(alignof(test_composite_t::layout_t), 64u);
+	ASSERT_EQ(offsetof(test_composite_t::layout_t, rest), 64u);
+	ASSERT_GE(sizeof(test_composite_t::layout_t), 3 * 64u);
+
+	shm_unlink("test_composite");
+	test_composite_t writer("test_composite");
+	test_composite_t reader("test_composite");
+	ASSERT_EQ(reader.get<int>(), 0);
+	ASSERT_TRUE(writer.connect());
+	ASSERT_TRUE(reader.connect());
+
+	writer.write<test_pose_t>({1.0, 2.0, 3.0});
+	writer.write<int>(42);
+	writer.write<int>(43);
+	ASSERT_EQ(reader.get<test_pose_t>().y, 2.0);
+	ASSERT_EQ(reader.get<int>(), 43);
+	ASSERT_EQ(reader.version<test_pose_t>(), 1u);
+	ASSERT_EQ(reader.version<test_health_t>(), 0u);
+	ASSERT_EQ(reader.version<int>(), 2u);
+
+	// Waiting on a member is not woken by writes to the others.
+	ASSERT_FALSE(reader.wait<test_health_t>(0, 0));
+	writer.write<int>(44);
+	ASSERT_FALSE(reader.wait<test_health_t>(0, 20));
+	ASSERT_TRUE(reader.wait<int>(2, 0));
+
+	writer.disconnect();
+	reader.disconnect();
+	shm_unlink("test_composite");
+}
+
+TEST(GenericSharedMemoryCompositeTest, TestConcurrentAccess) {
+	shm_unlink("test_composite_concurrent");
+	test_composite_t composite("test_composite_concurrent");
+	ASSERT_TRUE(composite.connect());
+
+	// A reader never sees a partially written member.
+	atomic<bool> stop = false;
+	thread writer([&]() {
+		for (int i = 1; !stop; i++) {
+			composite.write<test_health_t>({i, -i});
+		}
+	});
+	for (int i = 0; i < 100000; i++) {
+		test_health_t health = composite.get<test_health_t>();
+		ASSERT_EQ(health.status, -health.checksum);
+	}
+	stop = true;
+	writer.join();
+
+	// A process waiting on a member is woken by a write from another process.
+	const uint32_t version = composite.version<int>();
+	pid_t child = fork();
+	if (child == 0) {
+		test_composite_t child_composite("test_composite_concurrent");
+		bool woken = child_composite.connect() && child_composite.wait<int>(version, 5000) && child_composite.get<int>() == 7;
+		_exit(woken ? 0 : 1);
+	}
+	this_thread::sleep_for(chrono::milliseconds(50));
+	composite.write<int>(7);
+	int status = 0;
+	ASSERT_EQ(waitpid(child, &status, 0), child);
+	ASSERT_TRUE(WIFEXITED(status));
+	ASSERT_EQ(WEXITSTATUS(status), 0);
+
+	composite.disconnect();
+	shm_unlink("test_composite_concurrent");
+}
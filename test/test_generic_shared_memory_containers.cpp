@@ -0,0 +1,89 @@
+#include <string>
+
+#include <gtest/gtest.h>
+
+#include "GenericSharedMemoryModel.hpp"
+#include "GenericSharedMemoryContainers.hpp"
+
+using namespace std;
+
+typedef struct _test_detection_t {
+	int id;
+	double x;
+	double y;
+} test_detection_t;
+
+typedef GenericSharedMemoryVector<test_detection_t, 1024> test_detections_t;
+
+TEST(GenericSharedMemoryContainersTest, TestVector) {
+	ASSERT_TRUE(GenericSharedMemoryLiveBytes<test_detections_t>::is_partial);
+	ASSERT_FALSE(GenericSharedMemoryLiveBytes<test_detection_t>::is_partial);
+
+	test_detections_t detections;
+	ASSERT_TRUE(detections.empty());
+	for (int i = 0; i < 12; i++) {
+		ASSERT_TRUE(detections.push_back({i, i * 1.0, i * 2.0}));
+	}
+	ASSERT_EQ(detections.size(), 12u);
+	ASSERT_EQ(detections[11].id, 11);
+	ASSERT_EQ(GenericSharedMemoryLiveBytes<test_detections_t>::size(detections), 8 + 12 * sizeof(test_detection_t));
+	int sum = 0;
+	for (const test_detection_t &detection : detections) {
+		sum += detection.id;
+	}
+	ASSERT_EQ(sum, 66);
+	detections.pop_back();
+	ASSERT_EQ(detections.size(), 11u);
+	ASSERT_TRUE(detections.resize(1024));
+	ASSERT_EQ(detections[1000].id, 0);
+	ASSERT_TRUE(detections.full());
+	ASSERT_FALSE(detections.push_back({}));
+	ASSERT_FALSE(detections.resize(1025));
+	detections.clear();
+	ASSERT_EQ(GenericSharedMemoryLiveBytes<test_detections_t>::size(detections), 8u);
+}
+
+TEST(GenericSharedMemoryContainersTest, TestModelCopiesLiveBytes) {
+	shm_unlink("test_detections");
+	GenericSharedMemoryModel<test_detections_t> test_detections("test_detections");
+	ASSERT_TRUE(test_detections.connect());
+	ASSERT_TRUE(test_detections.get_data().empty());
+
+	// Bytes past the live prefix of the written vector are left untouched in the segment.
+	test_detections.data->resize(600);
+	(*test_detections.data)[500].id = 42;
+	test_detections_t detections;
+	detections.push_back({7, 1.0, 2.0});
+	test_detections.write_data(detections);
+	ASSERT_EQ(test_detections.data->size(), 1u);
+	ASSERT_EQ(test_detections.data->data()[500].id, 42);
+
+	test_detections_t snapshot = test_detections.get_data();
+	ASSERT_EQ(snapshot.size(), 1u);
+	ASSERT_EQ(snapshot[0].id, 7);
+	ASSERT_EQ(snapshot[0].y, 2.0);
+
+	test_detections.disconnect();
+	shm_unlink("test_detections");
+}
+
+TEST(GenericSharedMemoryContainersTest, TestString) {
+	typedef GenericSharedMemoryString<15> test_name_t;
+	test_name_t name;
+	ASSERT_TRUE(name.empty());
+	ASSERT_STREQ(name.c_str(), "");
+	ASSERT_TRUE(name.assign("camera"));
+	ASSERT_TRUE(name == "camera");
+	ASSERT_EQ(GenericSharedMemoryLiveBytes<test_name_t>::size(name), 4u + 6u + 1u);
+	ASSERT_FALSE(name.assign("a name that is too long"));
+	ASSERT_EQ(name.view(), "a name that is ");
+
+	shm_unlink("test_name");
+	GenericSharedMemoryModel<test_name_t> test_name("test_name");
+	ASSERT_TRUE(test_name.connect());
+	test_name.write_data(test_name_t("lidar"));
+	ASSERT_STREQ(test_name.get_data().c_str(), "lidar");
+	ASSERT_EQ(string(test_name.data->c_str()), "lidar");
+	test_name.disconnect();
+	shm_unlink("test_name");
+}
@@ -0,0 +1,124 @@
+#include <thread>
+#include <vector>
+
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+#include <gtest/gtest.h>
+
+#include "GenericSharedMemoryEgress.hpp"
+
+using namespace std;
+
+typedef struct _test_frame_t {
+	uint32_t bytes[16384];
+} test_frame_t;
+
+/// Function connect_loopback() connects a pair of TCP sockets over loopback.
+static bool connect_loopback(int &sender, int &receiver) {
+	int listener = socket(AF_INET, SOCK_STREAM, 0);
+	struct sockaddr_in address = {};
+	address.sin_family = AF_INET;
+	address.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+	socklen_t address_length = sizeof(address);
+	if (listener < 0 || bind(listener, (struct sockaddr *)&address, sizeof(address)) != 0 || listen(listener, 1) != 0 ||
+		getsockname(listener, (struct sockaddr *)&address, &address_length) != 0) {
+		return false;
+	}
+	sender = socket(AF_INET, SOCK_STREAM, 0);
+	const bool connected = connect(sender, (struct sockaddr *)&address, sizeof(address)) == 0;
+	receiver = connected ? accept(listener, nullptr, nullptr) : -1;
+	close(listener);
+	return receiver >= 0;
+}
+
+TEST(GenericSharedMemoryEgressTest, TestSendSnapshots) {
+	int sender, receiver;
+	ASSERT_TRUE(connect_loopback(sender, receiver));
+	shm_unlink("test_egress_frame");
+	GenericSharedMemoryModel<test_frame_t> test_frame("test_egress_frame");
+	ASSERT_TRUE(test_frame.connect());
+
+	// Receive the frames on another thread, so the sender is not stalled by a full socket.
+	const int frame_count = 8;
+	vector<unsigned char> received(frame_count * sizeof(test_frame_t));
+	thread reader([&]() {
+		size_t offset = 0;
+		while (offset < received.size()) {
+			ssize_t count = recv(receiver, received.data() + offset, received.size() - offset, 0);
+			if (count <= 0) {
+				break;
+			}
+			offset += (size_t)count;
+		}
+	});
+
+	// Each frame is modified as soon as the previous one is sent, which must not affect what was sent.
+	{
+		GenericSharedMemoryEgress egress(sender, 2);
+		ASSERT_TRUE(egress.uses_zerocopy());
+		for (int frame = 0; frame < frame_count; frame++) {
+			for (uint32_t &word : test_frame.data->bytes) {
+				word = (uint32_t)frame;
+			}
+			ASSERT_TRUE(egress.send_snapshot(test_frame));
+		}
+
+		// A model unmapped while idle is not mapped again by the send, which fails instead.
+		GenericSharedMemoryMappingRegistry &registry = GenericSharedMemoryMappingRegistry::instance();
+		registry.set_policy(chrono::milliseconds(1), 0);
+		test_frame.set_idle_unmap(true);
+		this_thread::sleep_for(chrono::milliseconds(5));
+		ASSERT_EQ(registry.unmap_idle(), 1u);
+		ASSERT_FALSE(egress.send_snapshot(test_frame));
+		registry.set_policy(chrono::milliseconds(0), 0);
+		ASSERT_TRUE(egress.flush(5000));
+	}
+	reader.join();
+
+	const test_frame_t *frames = (const test_frame_t *)received.data();
+	for (int frame = 0; frame < frame_count; frame++) {
+		ASSERT_EQ(frames[frame].bytes[0], (uint32_t)frame);
+		ASSERT_EQ(frames[frame].bytes[16383], (uint32_t)frame);
+	}
+
+	close(sender);
+	close(receiver);
+	test_frame.disconnect();
+	shm_unlink("test_egress_frame");
+}
+
+TEST(GenericSharedMemoryEgressTest, TestSendCompletion) {
+	int sender, receiver;
+	ASSERT_TRUE(connect_loopback(sender, receiver));
+	vector<unsigned char> buffer(1 << 20, 7);
+	vector<unsigned char> received(buffer.size() + 100);
+	thread reader([&]() {
+		size_t offset = 0;
+		while (offset < received.size()) {
+			ssize_t count = recv(receiver, received.data() + offset, received.size() - offset, 0);
+			if (count <= 0) {
+				break;
+			}
+			offset += (size_t)count;
+		}
+	});
+
+	// Large sends complete through the error queue, small sends are copied so complete immediately.
+	GenericSharedMemoryEgress egress(sender);
+	uint64_t large_id, small_id;
+	ASSERT_TRUE(egress.send(buffer.data(), buffer.size(), large_id));
+	ASSERT_GT(large_id, 0u);
+	ASSERT_TRUE(egress.wait(large_id, 5000));
+	ASSERT_TRUE(egress.is_complete(large_id));
+	ASSERT_TRUE(egress.send(buffer.data(), 100, small_id));
+	ASSERT_TRUE(egress.is_complete(small_id));
+	reader.join();
+	ASSERT_EQ(received[buffer.size() - 1], 7);
+	ASSERT_EQ(received[buffer.size() + 99], 7);
+
+	close(sender);
+	close(receiver);
+}
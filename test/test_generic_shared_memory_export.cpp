@@ -0,0 +1,105 @@
+#include <stdio.h>
+
+#include <gtest/gtest.h>
+
+#include "GenericSharedMemoryExport.hpp"
+
+using namespace std;
+
+typedef struct _test_state_t {
+	int header[3];
+	char sparse[3][100000];
+	double values[1000];
+	char tail[5];
+} test_state_t;
+
+TEST(GenericSharedMemoryExportTest, TestEncodeDecode) {
+	vector<unsigned char> data(1003, 0);
+	for (size_t i = 200; i < 300; i++) {
+		data[i] = (unsigned char)i;
+	}
+	data[1001] = 7;
+
+	vector<unsigned char> encoded;
+	GenericSharedMemoryExport::encode(data.data(), data.size(), encoded);
+	ASSERT_LT(encoded.size(), 120u);
+
+	vector<unsigned char> decoded(data.size(), 0xFF);
+	ASSERT_TRUE(GenericSharedMemoryExport::decode(encoded.data(), encoded.size(), decoded.data(), decoded.size(), false));
+	ASSERT_EQ(decoded, data);
+
+	// Truncated or mismatched encodings are rejected.
+	ASSERT_FALSE(GenericSharedMemoryExport::decode(encoded.data(), encoded.size() - 1, decoded.data(), decoded.size(), false));
+	ASSERT_FALSE(GenericSharedMemoryExport::decode(encoded.data(), encoded.size(), decoded.data(), decoded.size() - 8, false));
+}
+
+TEST(GenericSharedMemoryExportTest, TestExportImport) {
+	const string path = testing::TempDir() + "test_export.gsmm";
+	shm_unlink("test_export_source");
+	shm_unlink("test_export_destination");
+
+	GenericSharedMemoryModel<test_state_t> source("test_export_source");
+	GenericSharedMemoryModel<test_state_t> destination("test_export_destination");
+	ASSERT_TRUE(source.connect());
+	ASSERT_TRUE(destination.connect());
+	source.data->header[1] = 42;
+	source.data->sparse[1][5000] = 'x';
+	for (int i = 0; i < 1000; i++) {
+		source.data->values[i] = i * 0.5;
+	}
+	source.data->tail[4] = 'y';
+	memset(destination.data, 0xAA, sizeof(test_state_t));
+
+	// The mostly zero segment compresses well, and importing it restores it exactly, including clearing old contents.
+	ASSERT_TRUE(GenericSharedMemoryExport::export_segment(source.data, sizeof(test_state_t), path, 3, 4096));
+	FILE *file = fopen(path.c_str(), "rb");
+	ASSERT_NE(file, nullptr);
+	fseek(file, 0, SEEK_END);
+	ASSERT_LT(ftell(file), 20000);
+	fclose(file);
+	ASSERT_EQ(GenericSharedMemoryExport::segment_bytes(path), sizeof(test_state_t));
+	ASSERT_TRUE(GenericSharedMemoryExport::import_model(destination, path, 2));
+	ASSERT_EQ(memcmp(source.data, destination.data, sizeof(test_state_t)), 0);
+
+	// The model functions use the default chunk size, and a corrupted file is detected.
+	ASSERT_TRUE(GenericSharedMemoryExport::export_model(source, path));
+	file = fopen(path.c_str(), "r+b");
+	ASSERT_NE(file, nullptr);
+	fseek(file, sizeof(GenericSharedMemoryExportHeader) + sizeof(GenericSharedMemoryExportChunk) + 10, SEEK_SET);
+	fputc(0x55, file);
+	fclose(file);
+	ASSERT_FALSE(GenericSharedMemoryExport::import_model(destination, path));
+	ASSERT_FALSE(GenericSharedMemoryExport::import_segment(path, destination.data, sizeof(test_state_t) - 1));
+
+	// Corrupt headers and chunk sizes are rejected rather than allocated.
+	ASSERT_TRUE(GenericSharedMemoryExport::export_segment(source.data, sizeof(test_state_t), path, 1, 1 << 20));
+	GenericSharedMemoryExportHeader header;
+	GenericSharedMemoryExportChunk chunk;
+	file = fopen(path.c_str(), "r+b");
+	ASSERT_NE(file, nullptr);
+	ASSERT_EQ(fread(&header, sizeof(header), 1, file), 1u);
+	ASSERT_EQ(fread(&chunk, sizeof(chunk), 1, file), 1u);
+	ASSERT_EQ(header.chunk_count, 1u);
+	ASSERT_LE(header.chunk_bytes, sizeof(test_state_t) + 7);
+	ASSERT_TRUE(GenericSharedMemoryExport::import_model(destination, path));
+	const GenericSharedMemoryExportHeader good_header = header;
+	for (uint64_t chunk_bytes : {(uint64_t)1 << 62, header.chunk_bytes + 8, header.chunk_bytes - 4}) {
+		header.chunk_bytes = chunk_bytes;
+		fseek(file, 0, SEEK_SET);
+		fwrite(&header, sizeof(header), 1, file);
+		fflush(file);
+		ASSERT_FALSE(GenericSharedMemoryExport::import_model(destination, path));
+	}
+	fseek(file, 0, SEEK_SET);
+	fwrite(&good_header, sizeof(good_header), 1, file);
+	chunk.encoded_bytes = (uint64_t)1 << 62;
+	fwrite(&chunk, sizeof(chunk), 1, file);
+	fclose(file);
+	ASSERT_FALSE(GenericSharedMemoryExport::import_model(destination, path));
+
+	remove(path.c_str());
+	source.disconnect();
+	destination.disconnect();
+	shm_unlink("test_export_source");
+	shm_unlink("test_export_destination");
+}
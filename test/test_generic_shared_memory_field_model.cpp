@@ -0,0 +1,179 @@
+#include <thread>
+
+#include <signal.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+#include <gtest/gtest.h>
+
+#include "GenericSharedMemoryFieldModel.hpp"
+
+using namespace std;
+
+typedef struct _test_status_t {
+	int mode;
+	double speed;
+	double heading;
+	char label[16];
+} test_status_t;
+
+typedef GenericSharedMemoryFieldModel<test_status_t> test_field_model_t;
+
+TEST(GenericSharedMemoryFieldModelTest, TestGenerations) {
+	shm_unlink("test_field_model");
+	test_field_model_t writer("test_field_model");
+	test_field_model_t reader("test_field_model");
+	ASSERT_EQ(reader.generation(0), 0u);
+	ASSERT_TRUE(writer.connect());
+	ASSERT_TRUE(reader.connect());
+
+	// Only the fields that differ are counted as changed.
+	test_status_t status = {1, 2.0, 3.0, "first"};
+	ASSERT_EQ(writer.write_data(status), 4u);
+	status.speed = 4.0;
+	ASSERT_EQ(writer.write_data(status), 1u);
+	ASSERT_EQ(writer.write_data(status), 0u);
+	ASSERT_EQ(reader.generation(0), 1u);
+	ASSERT_EQ(reader.generation(1), 2u);
+	ASSERT_EQ(reader.generation(3), 1u);
+	ASSERT_EQ(reader.get_data().speed, 4.0);
+
+	// Single fields are written and read without the rest of the value.
+	ASSERT_TRUE(writer.write_field<0>(7));
+	ASSERT_FALSE(writer.write_field<0>(7));
+	ASSERT_EQ(reader.get_field<0>(), 7);
+	double heading = 0.0;
+	ASSERT_EQ(reader.read_field(2, &heading), 1u);
+	ASSERT_EQ(heading, 3.0);
+	ASSERT_STREQ(reader.get_data().label, "first");
+
+	writer.disconnect();
+	reader.disconnect();
+	shm_unlink("test_field_model");
+}
+
+TEST(GenericSharedMemoryFieldModelTest, TestDeclaredRegions) {
+	// Regions can group fields, and bytes outside them are still written.
+	shm_unlink("test_field_model_regions");
+	array<GenericSharedMemoryField, 2> regions = {{
+		{"", 0, offsetof(test_status_t, mode), sizeof(int), alignof(int), GenericSharedMemoryFieldKind::Signed},
+		{"", 1, offsetof(test_status_t, speed), 2 * sizeof(double), alignof(double), GenericSharedMemoryFieldKind::Other}}};
+	GenericSharedMemoryFieldModel<test_status_t, 2> model("test_field_model_regions", regions);
+	ASSERT_TRUE(model.connect());
+	test_status_t status = {0, 0.0, 5.0, "label"};
+	ASSERT_EQ(model.write_data(status), 1u);
+	ASSERT_EQ(model.generation(0), 0u);
+	ASSERT_EQ(model.generation(1), 1u);
+	ASSERT_STREQ(model.get_data().label, "label");
+	model.disconnect();
+	shm_unlink("test_field_model_regions");
+}
+
+TEST(GenericSharedMemoryFieldModelTest, TestSubscriptions) {
+	shm_unlink("test_field_model_subscriptions");
+	test_field_model_t model("test_field_model_subscriptions");
+	ASSERT_FALSE(model.subscribe({0}).is_valid());
+	ASSERT_TRUE(model.connect());
+	ASSERT_FALSE(model.subscribe({4}).is_valid());
+
+	{
+		// A subscription only reports changes to the fields it watches.
+		test_field_model_t::subscription_t subscription = model.subscribe({0, 2});
+		ASSERT_TRUE(subscription.is_valid());
+		ASSERT_FALSE(subscription.poll());
+		test_status_t status = {};
+		status.speed = 1.0;
+		model.write_data(status);
+		ASSERT_FALSE(subscription.poll());
+		ASSERT_FALSE(subscription.wait(20));
+		status.heading = 1.0;
+		model.write_data(status);
+		ASSERT_TRUE(subscription.poll());
+		ASSERT_FALSE(subscription.poll());
+
+		// A process waiting on a subscription is woken by a change from another process.
+		pid_t child = fork();
+		if (child == 0) {
+			test_field_model_t child_model("test_field_model_subscriptions");
+			child_model.connect();
+			this_thread::sleep_for(chrono::milliseconds(50));
+			child_model.write_field<1>(2.0);
+			child_model.write_field<0>(3);
+			child_model.disconnect();
+			_exit(0);
+		}
+		ASSERT_TRUE(subscription.wait(5000));
+		ASSERT_EQ(model.get_field<0>(), 3);
+		int status_code = 0;
+		waitpid(child, &status_code, 0);
+		ASSERT_EQ(status_code, 0);
+
+		// Subscriptions release their entry of the table when destroyed.
+		vector<test_field_model_t::subscription_t> subscriptions;
+		for (int i = 0; i < 20; i++) {
+			subscriptions.push_back(model.subscribe({1}));
+		}
+		ASSERT_FALSE(subscriptions.back().is_valid());
+		subscriptions.clear();
+		ASSERT_TRUE(model.subscribe({1}).is_valid());
+
+		// The entry of a subscriber killed without destroying its subscription is reclaimed once the table is full.
+		int ready[2];
+		ASSERT_EQ(pipe(ready), 0);
+		child = fork();
+		if (child == 0) {
+			test_field_model_t child_model("test_field_model_subscriptions");
+			child_model.connect();
+			test_field_model_t::subscription_t child_subscription = child_model.subscribe({2});
+			char valid = child_subscription.is_valid() ? 1 : 0;
+			(void)!write(ready[1], &valid, 1);
+			pause();
+			_exit(0);
+		}
+		char valid = 0;
+		const bool child_ready = read(ready[0], &valid, 1) == 1;
+		close(ready[0]);
+		close(ready[1]);
+
+		// Fill the rest of the table alongside the outer subscription and the child's, then kill the child.
+		std::size_t claimed = 0;
+		for (int i = 0; i < 14; i++) {
+			subscriptions.push_back(model.subscribe({1}));
+			claimed += subscriptions.back().is_valid() ? 1 : 0;
+		}
+		const bool full = !model.subscribe({1}).is_valid();
+		kill(child, SIGKILL);
+		waitpid(child, nullptr, 0);
+		ASSERT_TRUE(child_ready);
+		ASSERT_EQ(valid, 1);
+		ASSERT_EQ(claimed, 14u);
+		ASSERT_TRUE(full);
+		ASSERT_TRUE(model.subscribe({1}).is_valid());
+	}
+
+	model.disconnect();
+	shm_unlink("test_field_model_subscriptions");
+}
+
+TEST(GenericSharedMemoryFieldModelTest, TestConcurrentAccess) {
+	shm_unlink("test_field_model_concurrent");
+	test_field_model_t model("test_field_model_concurrent");
+	ASSERT_TRUE(model.connect());
+
+	// A reader never sees a partially written value.
+	atomic<bool> stop = false;
+	thread writer([&]() {
+		for (int i = 1; !stop; i++) {
+			model.write_data({i, (double)-i, 0.0, ""});
+		}
+	});
+	for (int i = 0; i < 100000; i++) {
+		test_status_t status = model.get_data();
+		ASSERT_EQ((double)status.mode, -status.speed);
+	}
+	stop = true;
+	writer.join();
+
+	model.disconnect();
+	shm_unlink("test_field_model_concurrent");
+}
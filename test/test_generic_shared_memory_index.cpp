@@ -0,0 +1,268 @@
+#include <gtest/gtest.h>
+
+#include <algorithm>
+#include <atomic>
+#include <map>
+#include <random>
+#include <sys/wait.h>
+#include <thread>
+#include <unistd.h>
+#include <vector>
+
+#include "GenericSharedMemoryIndex.hpp"
+
+using namespace std;
+
+typedef GenericSharedMemoryIndex<uint64_t, uint64_t, 100000> test_index_t;
+
+TEST(GenericSharedMemoryIndexTest, TestLayout) {
+	// Nodes are whole cache lines and hold as many keys as fit.
+	ASSERT_EQ(sizeof(test_index_t::node_t), 256u);
+	ASSERT_EQ(alignof(test_index_t::node_t), 64u);
+	ASSERT_EQ(test_index_t::slots, 14u);
+	ASSERT_EQ(offsetof(test_index_t::layout_t, nodes) % 64, 0u);
+}
+
+TEST(GenericSharedMemoryIndexTest, TestInsertFindErase) {
+	shm_unlink("test_index");
+	test_index_t writer("test_index");
+	test_index_t reader("test_index");
+	uint64_t value = 0;
+	ASSERT_FALSE(writer.insert(1, 1));
+	ASSERT_FALSE(reader.find(1, value));
+	ASSERT_TRUE(writer.connect());
+	ASSERT_TRUE(reader.connect());
+	ASSERT_EQ(reader.size(), 0u);
+	ASSERT_FALSE(reader.find(1, value));
+
+	// Keys inserted in random order are found by another connection and match a std::map.
+	map<uint64_t, uint64_t> expected;
+	mt19937_64 random(7);
+	for (int i = 0; i < 100000; i++) {
+		uint64_t key = random() % 1000000;
+		ASSERT_TRUE(writer.insert(key, key * 3));
+		expected[key] = key * 3;
+	}
+	ASSERT_EQ(reader.size(), expected.size());
+	for (auto &[key, expected_value] : expected) {
+		ASSERT_TRUE(reader.find(key, value));
+		ASSERT_EQ(value, expected_value);
+	}
+
+	// Inserting a key again replaces its value.
+	uint64_t first = expected.begin()->first;
+	ASSERT_TRUE(writer.insert(first, 5));
+	ASSERT_TRUE(reader.find(first, value));
+	ASSERT_EQ(value, 5u);
+	expected[first] = 5;
+	ASSERT_EQ(reader.size(), expected.size());
+
+	// Erased keys are no longer found.
+	for (auto it = expected.begin(); it != expected.end();) {
+		if (it->first % 2 == 0) {
+			ASSERT_TRUE(writer.erase(it->first));
+			ASSERT_FALSE(writer.erase(it->first));
+			it = expected.erase(it);
+		}
+		else {
+			it++;
+		}
+	}
+	ASSERT_EQ(reader.size(), expected.size());
+	for (uint64_t key = 0; key < 1000; key++) {
+		ASSERT_EQ(reader.find(key, value), expected.count(key) == 1);
+	}
+
+	writer.disconnect();
+	reader.disconnect();
+	shm_unlink("test_index");
+}
+
+TEST(GenericSharedMemoryIndexTest, TestScan) {
+	shm_unlink("test_index_scan");
+	test_index_t index("test_index_scan");
+	ASSERT_TRUE(index.connect());
+	for (uint64_t key = 0; key < 10000; key += 2) {
+		ASSERT_TRUE(index.insert(key, key + 1));
+	}
+
+	// A scan visits the keys of the half open range in order.
+	vector<uint64_t> keys;
+	ASSERT_EQ(index.scan(101, 201, [&](uint64_t key, uint64_t value) {
+		EXPECT_EQ(value, key + 1);
+		keys.push_back(key);
+		return true;
+	}), 50u);
+	ASSERT_EQ(keys.front(), 102u);
+	ASSERT_EQ(keys.back(), 200u);
+	ASSERT_TRUE(is_sorted(keys.begin(), keys.end()));
+
+	// The function can stop a scan, and empty ranges visit nothing.
+	ASSERT_EQ(index.scan(0, 10000, [](uint64_t key, uint64_t) { return key < 20; }), 10u);
+	ASSERT_EQ(index.scan(200, 200, [](uint64_t, uint64_t) { return true; }), 0u);
+	ASSERT_EQ(index.scan(20000, 30000, [](uint64_t, uint64_t) { return true; }), 0u);
+	ASSERT_EQ(index.scan(0, 100000, [](uint64_t, uint64_t) { return true; }), 5000u);
+
+	index.disconnect();
+	shm_unlink("test_index_scan");
+}
+
+TEST(GenericSharedMemoryIndexTest, TestConcurrentReaders) {
+	shm_unlink("test_index_concurrent");
+	test_index_t writer("test_index_concurrent");
+	ASSERT_TRUE(writer.connect());
+	// Keys below 10000 are stable, while keys above churn during the reads.
+	for (uint64_t key = 0; key < 10000; key += 2) {
+		ASSERT_TRUE(writer.insert(key, key * 2));
+	}
+
+	// A reader in another process finds every stable key, and scans see sorted keys with consistent values.
+	pid_t pid = fork();
+	if (pid == 0) {
+		test_index_t reader("test_index_concurrent");
+		bool valid = reader.connect();
+		for (int round = 0; valid && round < 50; round++) {
+			uint64_t value = 0;
+			for (uint64_t key = 0; valid && key < 10000; key += 2) {
+				valid = reader.find(key, value) && value == key * 2;
+			}
+			uint64_t previous = 0;
+			std::size_t stable = 0;
+			reader.scan(0, UINT64_MAX, [&](uint64_t key, uint64_t value) {
+				valid = valid && value == key * 2 && (stable == 0 || previous < key);
+				stable += key < 10000;
+				previous = key;
+				return true;
+			});
+			valid = valid && stable == 5000;
+		}
+		reader.disconnect();
+		_exit(valid ? 0 : 1);
+	}
+	mt19937_64 random(11);
+	int status = 0;
+	while (waitpid(pid, &status, WNOHANG) == 0) {
+		for (int i = 0; i < 1000; i++) {
+			uint64_t key = 10000 + random() % 50000;
+			if (random() % 3 == 0) {
+				writer.erase(key);
+			}
+			else {
+				ASSERT_TRUE(writer.insert(key, key * 2));
+			}
+		}
+	}
+	ASSERT_TRUE(WIFEXITED(status));
+	ASSERT_EQ(WEXITSTATUS(status), 0);
+
+	writer.disconnect();
+	shm_unlink("test_index_concurrent");
+}
+
+TEST(GenericSharedMemoryIndexTest, TestChurn) {
+	typedef GenericSharedMemoryIndex<uint64_t, uint64_t, 1000> test_small_index_t;
+	shm_unlink("test_index_churn");
+	test_small_index_t index("test_index_churn");
+	ASSERT_TRUE(index.connect());
+
+	// A window of time ordered keys sliding through the index reuses the nodes of erased keys.
+	for (uint64_t key = 0; key < 200000; key++) {
+		ASSERT_TRUE(index.insert(key, key));
+		if (key >= 100) {
+			ASSERT_TRUE(index.erase(key - 100));
+		}
+	}
+	ASSERT_EQ(index.size(), 100u);
+	uint64_t expected = 199900;
+	ASSERT_EQ(index.scan(0, UINT64_MAX, [&](uint64_t key, uint64_t) { return key == expected++; }), 100u);
+
+	// Emptying and refilling the index in random orders reuses every node.
+	for (uint64_t key = 199900; key < 200000; key++) {
+		ASSERT_TRUE(index.erase(key));
+	}
+	mt19937_64 random(13);
+	vector<uint64_t> keys;
+	for (uint64_t key = 0; key < 1000; key++) {
+		keys.push_back(key * 7919);
+	}
+	for (int round = 0; round < 20; round++) {
+		shuffle(keys.begin(), keys.end(), random);
+		for (uint64_t key : keys) {
+			ASSERT_TRUE(index.insert(key, key));
+		}
+		ASSERT_EQ(index.size(), 1000u);
+		shuffle(keys.begin(), keys.end(), random);
+		for (uint64_t key : keys) {
+			ASSERT_TRUE(index.erase(key));
+		}
+		ASSERT_EQ(index.size(), 0u);
+	}
+
+	index.disconnect();
+	shm_unlink("test_index_churn");
+}
+
+TEST(GenericSharedMemoryIndexTest, TestConcurrentChurn) {
+	typedef GenericSharedMemoryIndex<uint64_t, uint64_t, 2000> test_small_index_t;
+	shm_unlink("test_index_concurrent_churn");
+	test_small_index_t writer("test_index_concurrent_churn");
+	ASSERT_TRUE(writer.connect());
+	for (uint64_t key = 0; key < 500; key++) {
+		ASSERT_TRUE(writer.insert(key, key * 2));
+	}
+
+	// Readers see the window in order with consistent values while its oldest nodes are freed and reused.
+	atomic<bool> stop(false);
+	atomic<bool> valid(true);
+	vector<thread> readers;
+	for (int i = 0; i < 2; i++) {
+		readers.emplace_back([&]() {
+			test_small_index_t reader("test_index_concurrent_churn");
+			reader.connect();
+			while (!stop.load()) {
+				uint64_t previous = 0;
+				std::size_t visited = reader.scan(0, UINT64_MAX, [&](uint64_t key, uint64_t value) {
+					if (value != key * 2 || (previous != 0 && key <= previous)) {
+						valid = false;
+					}
+					previous = key;
+					return true;
+				});
+				if (visited < 400) {
+					valid = false;
+				}
+			}
+			reader.disconnect();
+		});
+	}
+	thread eraser([&]() {
+		test_small_index_t index("test_index_concurrent_churn");
+		index.connect();
+		for (uint64_t key = 0; key < 10000; key++) {
+			// Stay 400 keys behind the inserts.
+			while (writer.size() < 500) {
+				this_thread::yield();
+			}
+			if (!index.erase(key)) {
+				valid = false;
+			}
+		}
+		index.disconnect();
+	});
+	for (uint64_t key = 500; key < 10500; key++) {
+		while (writer.size() > 600) {
+			this_thread::yield();
+		}
+		ASSERT_TRUE(writer.insert(key, key * 2));
+	}
+	eraser.join();
+	stop = true;
+	for (thread &reader : readers) {
+		reader.join();
+	}
+	ASSERT_TRUE(valid.load());
+	ASSERT_EQ(writer.size(), 500u);
+
+	writer.disconnect();
+	shm_unlink("test_index_concurrent_churn");
+}
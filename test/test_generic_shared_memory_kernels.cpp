@@ -0,0 +1,121 @@
+#include <numeric>
+#include <random>
+
+#include <gtest/gtest.h>
+
+#include "GenericSharedMemoryColumns.hpp"
+#include "GenericSharedMemoryKernels.hpp"
+
+using namespace std;
+
+typedef struct _test_sample_t {
+	float x;
+	double y;
+	int32_t id;
+	int64_t count;
+	uint16_t flags;
+} test_sample_t;
+GENERIC_SHARED_MEMORY_REFLECT(test_sample_t, x, y, id, count, flags);
+
+/// Function expect_kernels() checks every kernel against a plain loop over the view, for every instruction set.
+template<typename T>
+void expect_kernels(GenericSharedMemoryColumnView<T> view, T operand) {
+	vector<GenericSharedMemoryKernelIsa> isas = {GenericSharedMemoryKernelIsa::Scalar};
+	for (GenericSharedMemoryKernelIsa isa : {GenericSharedMemoryKernelIsa::Avx2, GenericSharedMemoryKernelIsa::Avx512}) {
+		if (GenericSharedMemoryKernels::set_isa(isa)) {
+			isas.push_back(isa);
+		}
+	}
+
+	vector<uint32_t> expected_selection;
+	double expected_sum = 0.0;
+	T expected_min = view[0];
+	T expected_max = view[0];
+	for (size_t i = 0; i < view.size; i++) {
+		if (view[i] > operand) {
+			expected_selection.push_back((uint32_t)i);
+		}
+		expected_sum += (double)view[i];
+		expected_min = min(expected_min, view[i]);
+		expected_max = max(expected_max, view[i]);
+	}
+	vector<uint32_t> expected_top(view.size);
+	iota(expected_top.begin(), expected_top.end(), 0);
+	stable_sort(expected_top.begin(), expected_top.end(), [&](uint32_t a, uint32_t b) { return view[a] > view[b]; });
+	expected_top.resize(min<size_t>(5, view.size));
+
+	for (GenericSharedMemoryKernelIsa isa : isas) {
+		ASSERT_TRUE(GenericSharedMemoryKernels::set_isa(isa));
+		ASSERT_EQ(GenericSharedMemoryKernels::isa(), isa);
+		ASSERT_EQ(GenericSharedMemoryKernels::count(view, GenericSharedMemoryCompare::Greater, operand), expected_selection.size());
+		ASSERT_EQ(GenericSharedMemoryKernels::count(view, GenericSharedMemoryCompare::LessEqual, operand), view.size - expected_selection.size());
+		vector<uint32_t> selection(view.size);
+		selection.resize(GenericSharedMemoryKernels::filter(view, GenericSharedMemoryCompare::Greater, operand, selection.data()));
+		ASSERT_EQ(selection, expected_selection);
+		ASSERT_NEAR((double)GenericSharedMemoryKernels::sum(view), expected_sum, 1e-6 * abs(expected_sum) + 1e-6);
+		ASSERT_NEAR(GenericSharedMemoryKernels::mean(view), expected_sum / view.size, 1e-6 * abs(expected_sum));
+		T smallest;
+		T largest;
+		ASSERT_TRUE(GenericSharedMemoryKernels::min(view, smallest));
+		ASSERT_TRUE(GenericSharedMemoryKernels::max(view, largest));
+		ASSERT_EQ(smallest, expected_min);
+		ASSERT_EQ(largest, expected_max);
+		vector<uint32_t> top(5);
+		top.resize(GenericSharedMemoryKernels::top_k(view, 5, top.data()));
+		ASSERT_EQ(top, expected_top);
+	}
+	GenericSharedMemoryKernels::set_isa(isas.back());
+}
+
+TEST(GenericSharedMemoryKernelsTest, TestColumns) {
+	shm_unlink("test_kernels");
+	GenericSharedMemoryColumns<test_sample_t, 10000> samples("test_kernels");
+	ASSERT_TRUE(samples.connect());
+	mt19937 generator(7);
+	uniform_int_distribution<int> values(-1000, 1000);
+	for (int i = 0; i < 9999; i++) {
+		const int value = values(generator);
+		samples.push_back({value * 0.25f, value * 0.5, value, (int64_t)value * 1000000000, (uint16_t)(value + 1000)});
+	}
+
+	// Every kernel matches a plain loop, for vectorised, tail and scalar only types.
+	expect_kernels<float>(samples.column<0>(), 100.0f);
+	expect_kernels<double>(samples.column<1>(), -3.5);
+	expect_kernels<int32_t>(samples.column<2>(), 0);
+	expect_kernels<int64_t>(samples.column<3>(), 500000000000);
+	expect_kernels<uint16_t>(samples.column<4>(), 1500);
+
+	samples.disconnect();
+	shm_unlink("test_kernels");
+}
+
+TEST(GenericSharedMemoryKernelsTest, TestRecords) {
+	// Fields of an array of records are scanned in place with their stride.
+	vector<test_sample_t> records(1001);
+	for (size_t i = 0; i < records.size(); i++) {
+		records[i] = {(float)(i % 17), (double)i, (int32_t)(i * 7 % 101), (int64_t)i, 0};
+	}
+	expect_kernels<float>(GenericSharedMemoryKernels::field<0>(records.data(), records.size()), 8.0f);
+	expect_kernels<int32_t>(GenericSharedMemoryKernels::field<2>(records.data(), records.size()), 50);
+
+	// Aggregates can be restricted to a selection, and views can be empty.
+	GenericSharedMemoryColumnView<double> y = GenericSharedMemoryKernels::field<1>(records.data(), records.size());
+	vector<uint32_t> selection(records.size());
+	size_t selected = GenericSharedMemoryKernels::filter(y, GenericSharedMemoryCompare::GreaterEqual, 1000.0, selection.data());
+	ASSERT_EQ(selected, 1u);
+	ASSERT_EQ(GenericSharedMemoryKernels::sum(y, selection.data(), selected), 1000.0);
+	ASSERT_EQ(GenericSharedMemoryKernels::mean(y, selection.data(), 0), 0.0);
+	double value;
+	ASSERT_FALSE(GenericSharedMemoryKernels::min(GenericSharedMemoryColumnView<double>(nullptr, 0), value));
+	ASSERT_EQ(GenericSharedMemoryKernels::top_k(y, 0, selection.data()), 0u);
+	ASSERT_EQ(GenericSharedMemoryKernels::top_k(y, 3, selection.data(), false), 3u);
+	ASSERT_EQ(selection[2], 2u);
+	// A k larger than the view finds every value, without reserving room for k of them.
+	ASSERT_EQ(GenericSharedMemoryKernels::top_k(y, SIZE_MAX / 2, selection.data()), records.size());
+	ASSERT_EQ(selection[0], records.size() - 1);
+	ASSERT_EQ(GenericSharedMemoryKernels::top_k(GenericSharedMemoryColumnView<double>(nullptr, 0), 5, selection.data()), 0u);
+
+	// Unsigned values are summed as unsigned, so totals past INT64_MAX do not overflow.
+	vector<uint64_t> large(17, (uint64_t)1 << 59);
+	ASSERT_EQ(GenericSharedMemoryKernels::sum(GenericSharedMemoryColumnView<uint64_t>(large.data(), large.size())), (uint64_t)17 << 59);
+}
@@ -0,0 +1,78 @@
+#include <stdio.h>
+
+#include <gtest/gtest.h>
+
+#include "GenericSharedMemoryModel.hpp"
+
+using namespace std;
+
+static GenericSharedMemoryLogRecord make_record(int error_number) {
+	GenericSharedMemoryLogRecord record = {};
+	record.error_number = error_number;
+	record.severity = GenericSharedMemoryLogSeverity::Warning;
+	record.event = GenericSharedMemoryLogEvent::OpenFailed;
+	return record;
+}
+
+TEST(GenericSharedMemoryLogTest, TestRingOrderAndOverflow) {
+	GenericSharedMemoryLogRing<4> *ring = new GenericSharedMemoryLogRing<4>();
+	GenericSharedMemoryLogRecord record;
+
+	ASSERT_FALSE(ring->pop(record));
+	for (int i = 0; i < 4; i++) {
+		ASSERT_TRUE(ring->push(make_record(i)));
+	}
+	ASSERT_FALSE(ring->push(make_record(4)));
+	ASSERT_EQ(ring->dropped(), 1u);
+
+	for (int lap = 0; lap < 3; lap++) {
+		for (int i = 0; i < 4; i++) {
+			ASSERT_TRUE(ring->pop(record));
+			ASSERT_EQ(record.error_number, lap * 4 + i);
+			ASSERT_TRUE(ring->push(make_record((lap + 1) * 4 + i)));
+		}
+	}
+	delete ring;
+}
+
+TEST(GenericSharedMemoryLogTest, TestRingInSharedMemory) {
+	shm_unlink("test_log_ring");
+	GenericSharedMemoryModel<GenericSharedMemoryLog::ring_t> log_segment("test_log_ring");
+	ASSERT_TRUE(log_segment.connect());
+
+	GenericSharedMemoryLog::instance().set_auto_drain(false);
+	GenericSharedMemoryLog::instance().redirect(log_segment.data);
+	GenericSharedMemoryLog::instance().drain([](const GenericSharedMemoryLogRecord &) {});
+
+	GenericSharedMemoryModel<int> bad_model("bad/name", true);
+	ASSERT_FALSE(bad_model.connect());
+
+	GenericSharedMemoryModel<GenericSharedMemoryLog::ring_t> reader("test_log_ring");
+	ASSERT_TRUE(reader.connect());
+	GenericSharedMemoryLogRecord record;
+	ASSERT_TRUE(reader.data->pop(record));
+	ASSERT_EQ(record.event, GenericSharedMemoryLogEvent::OpenFailed);
+	ASSERT_EQ(record.severity, GenericSharedMemoryLogSeverity::Warning);
+	ASSERT_EQ(record.name_hash, GenericSharedMemoryLog::hash_name("bad/name"));
+	ASSERT_STREQ(record.name, "bad/name");
+	ASSERT_NE(record.error_number, 0);
+	ASSERT_FALSE(reader.data->pop(record));
+
+	GenericSharedMemoryLog::instance().redirect(nullptr);
+	reader.disconnect();
+	log_segment.disconnect();
+	shm_unlink("test_log_ring");
+}
+
+TEST(GenericSharedMemoryLogTest, TestDrainThread) {
+	std::atomic<int> drained = 0;
+	GenericSharedMemoryLog::instance().start_drain_thread([&drained](const GenericSharedMemoryLogRecord &) { drained++; },
+		std::chrono::milliseconds(1));
+
+	GenericSharedMemoryModel<int> bad_model("bad/name", true);
+	ASSERT_FALSE(bad_model.connect());
+	ASSERT_FALSE(bad_model.connect());
+
+	GenericSharedMemoryLog::instance().stop_drain_thread();
+	ASSERT_EQ(drained.load(), 2);
+}
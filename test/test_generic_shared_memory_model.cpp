@@ -1,5 +1,12 @@
 #include <stdio.h>
 
+#include <filesystem>
+#include <memory>
+
+#ifdef __linux__
+#include <sys/wait.h>
+#endif
+
 #include <gtest/gtest.h>
 
 #include "GenericSharedMemoryModel.hpp"
@@ -223,4 +230,273 @@ TEST(GenericSharedMemoryModelTest, TestReadWrite) {
 	}
 
 	ASSERT_FALSE(error);
-}
\ No newline at end of file
+}
+
+TEST(GenericSharedMemoryModelTest, TestConnectAll) {
+
+	std::vector<std::unique_ptr<GenericSharedMemoryModel<uint64_t>>> owners;
+	std::vector<GenericSharedMemoryModel<uint64_t>*> models;
+	for (int i = 0; i < 256; i++) {
+		owners.push_back(std::make_unique<GenericSharedMemoryModel<uint64_t>>("test_connect_all_" + std::to_string(i)));
+		models.push_back(owners.back().get());
+	}
+
+#ifdef __linux__
+	// No file descriptors are left open once the models are connected.
+	auto count_open_files = []() {
+		size_t count = 0;
+		for (const auto &entry : std::filesystem::directory_iterator("/proc/self/fd")) {
+			(void)entry;
+			count++;
+		}
+		return count;
+	};
+	size_t open_files = count_open_files();
+	ASSERT_EQ(GenericSharedMemoryModel<uint64_t>::connect_all(models, 4), models.size());
+	ASSERT_EQ(count_open_files(), open_files);
+#else
+	ASSERT_EQ(GenericSharedMemoryModel<uint64_t>::connect_all(models, 4), models.size());
+#endif
+
+	for (int i = 0; i < 256; i++) {
+		ASSERT_TRUE(models[i]->is_connected());
+		models[i]->write_data(i);
+	}
+	GenericSharedMemoryModel<uint64_t> reader("test_connect_all_42");
+	ASSERT_TRUE(reader.connect());
+	ASSERT_EQ(reader.get_data(), 42u);
+
+	for (int i = 0; i < 256; i++) {
+		ASSERT_TRUE(models[i]->disconnect());
+		shm_unlink(("test_connect_all_" + std::to_string(i)).c_str());
+	}
+	// A model is its name, data, fork function and fork list pointers, plus 8 bytes for the lock, the flags and the access time.
+	ASSERT_EQ(sizeof(GenericSharedMemoryModel<uint64_t>), 5 * sizeof(void*) + 8);
+}
+
+TEST(GenericSharedMemoryModelTest, TestLazyConnect) {
+	shm_unlink("test_lazy_int");
+	GenericSharedMemoryModel<int> test_lazy_int("test_lazy_int");
+	test_lazy_int.set_lazy_connect(true);
+	ASSERT_FALSE(test_lazy_int.is_connected());
+	ASSERT_EQ(test_lazy_int.data, nullptr);
+
+	test_lazy_int.write_data(42);
+	ASSERT_TRUE(test_lazy_int.is_connected());
+
+	GenericSharedMemoryModel<int> test_read_int("test_lazy_int");
+	test_read_int.set_lazy_connect(true);
+	ASSERT_EQ(test_read_int.get_data(), 42);
+	ASSERT_TRUE(test_read_int.is_connected());
+	shm_unlink("test_lazy_int");
+}
+
+TEST(GenericSharedMemoryModelTest, TestIdleUnmap) {
+	typedef struct _test_page_t {
+		char bytes[4096];
+	} test_page_t;
+
+	GenericSharedMemoryMappingRegistry &registry = GenericSharedMemoryMappingRegistry::instance();
+	registry.set_policy(std::chrono::milliseconds(0), 2 * sizeof(test_page_t));
+
+	GenericSharedMemoryModel<test_page_t> test_page_0("test_idle_page_0");
+	GenericSharedMemoryModel<test_page_t> test_page_1("test_idle_page_1");
+	GenericSharedMemoryModel<test_page_t> test_page_2("test_idle_page_2");
+	test_page_0.set_idle_unmap(true);
+	test_page_1.set_idle_unmap(true);
+	test_page_2.set_idle_unmap(true);
+
+	// Mapping a third page evicts the least recently used one.
+	test_page_t page = {};
+	page.bytes[0] = 42;
+	test_page_0.write_data(page);
+	std::this_thread::sleep_for(std::chrono::milliseconds(2));
+	test_page_1.write_data(page);
+	std::this_thread::sleep_for(std::chrono::milliseconds(2));
+	test_page_0.get_data();
+	std::this_thread::sleep_for(std::chrono::milliseconds(2));
+	test_page_2.write_data(page);
+	ASSERT_TRUE(test_page_0.is_connected());
+	ASSERT_FALSE(test_page_1.is_connected());
+	ASSERT_TRUE(test_page_2.is_connected());
+	ASSERT_EQ(registry.mapped_count(), 2u);
+	ASSERT_EQ(registry.mapped_bytes(), 2 * sizeof(test_page_t));
+
+	// The evicted page is mapped again on its next access.
+	ASSERT_EQ(test_page_1.get_data().bytes[0], 42);
+	ASSERT_TRUE(test_page_1.is_connected());
+
+	// Idle pages are unmapped once the timeout passes.
+	registry.set_policy(std::chrono::milliseconds(1), 0);
+	std::this_thread::sleep_for(std::chrono::milliseconds(5));
+	ASSERT_EQ(registry.unmap_idle(), 2u);
+	ASSERT_EQ(registry.mapped_count(), 0u);
+
+	registry.set_policy(std::chrono::milliseconds(0), 0);
+	ASSERT_TRUE(test_page_0.disconnect());
+	shm_unlink("test_idle_page_0");
+	shm_unlink("test_idle_page_1");
+	shm_unlink("test_idle_page_2");
+}
+
+#ifdef __linux__
+TEST(GenericSharedMemoryModelTest, TestForkInheritance) {
+	// Only models that ask to be handled around fork() are registered for it.
+	GenericSharedMemoryMappingRegistry &registry = GenericSharedMemoryMappingRegistry::instance();
+	const size_t fork_model_count = registry.fork_model_count();
+	GenericSharedMemoryModel<int> test_inherited_int("test_fork_inherited_int");
+	GenericSharedMemoryModel<int> test_private_int("test_fork_private_int");
+	GenericSharedMemoryModel<int> test_locked_int("test_fork_locked_int");
+	ASSERT_EQ(registry.fork_model_count(), fork_model_count);
+	test_private_int.set_inherit_on_fork(false);
+	test_locked_int.set_lock_on_fork(true);
+	ASSERT_EQ(registry.fork_model_count(), fork_model_count + 2);
+	{
+		GenericSharedMemoryModel<int> test_unused_int("test_fork_unused_int");
+		test_unused_int.set_inherit_on_fork(false);
+		ASSERT_EQ(registry.fork_model_count(), fork_model_count + 3);
+		test_unused_int.set_inherit_on_fork(true);
+		ASSERT_EQ(registry.fork_model_count(), fork_model_count + 2);
+		test_unused_int.set_lock_on_fork(true);
+	}
+	ASSERT_EQ(registry.fork_model_count(), fork_model_count + 2);
+
+	ASSERT_TRUE(test_inherited_int.connect());
+	ASSERT_TRUE(test_private_int.connect());
+	ASSERT_TRUE(test_locked_int.connect());
+	test_inherited_int.write_data(0);
+	test_private_int.write_data(42);
+	test_locked_int.write_data(42);
+
+	// Keep the handled models busy from another thread while forking, so the locks are contended.
+	std::atomic<bool> stop = false;
+	std::thread writer([&]() {
+		while (!stop) {
+			test_private_int.write_data(42);
+			test_locked_int.write_data(42);
+		}
+	});
+
+	pid_t child = fork();
+	if (child == 0) {
+		// The inherited mapping is used directly, the other must be connected again.
+		int result = 0;
+		result |= test_inherited_int.is_connected() ? 0 : 1;
+		result |= !test_private_int.is_connected() ? 0 : 2;
+		result |= test_private_int.data == nullptr ? 0 : 4;
+		result |= test_private_int.connect() && test_private_int.get_data() == 42 ? 0 : 8;
+		result |= test_locked_int.is_connected() && test_locked_int.get_data() == 42 ? 0 : 16;
+		test_inherited_int.write_data(42);
+		_exit(result);
+	}
+	stop = true;
+	writer.join();
+
+	int status = 0;
+	ASSERT_EQ(waitpid(child, &status, 0), child);
+	ASSERT_TRUE(WIFEXITED(status));
+	ASSERT_EQ(WEXITSTATUS(status), 0);
+	ASSERT_EQ(test_inherited_int.get_data(), 42);
+	ASSERT_TRUE(test_private_int.is_connected());
+
+	shm_unlink("test_fork_inherited_int");
+	shm_unlink("test_fork_private_int");
+	shm_unlink("test_fork_locked_int");
+}
+#endif
+
+TEST(GenericSharedMemoryModelTest, TestResidency) {
+	typedef struct _test_pages_t {
+		char bytes[16][4096];
+	} test_pages_t;
+
+	shm_unlink("test_residency_pages");
+	GenericSharedMemoryModel<test_pages_t> test_pages("test_residency_pages");
+	ASSERT_EQ(test_pages.residency().resident_pages, 0u);
+	ASSERT_FALSE(test_pages.advise(GenericSharedMemoryAdvice::WillNeed));
+	ASSERT_TRUE(test_pages.connect());
+
+	GenericSharedMemoryResidency residency = test_pages.residency();
+	ASSERT_EQ(residency.total_pages * residency.page_size, sizeof(test_pages_t));
+	for (int i = 0; i < 16; i++) {
+		test_pages.data->bytes[i][0] = 42;
+	}
+	ASSERT_EQ(test_pages.residency().resident_pages, residency.total_pages);
+
+	// Removing the pages of a scratch segment frees them and discards their contents.
+	ASSERT_TRUE(test_pages.advise(GenericSharedMemoryAdvice::Remove));
+	ASSERT_EQ(test_pages.residency().resident_pages, 0u);
+	ASSERT_EQ(test_pages.data->bytes[0][0], 0);
+
+	// Idle segments can be advised out by the registry while staying mapped.
+	GenericSharedMemoryMappingRegistry &registry = GenericSharedMemoryMappingRegistry::instance();
+	registry.set_policy(std::chrono::milliseconds(1), 0, GenericSharedMemoryIdleAction::Remove);
+	test_pages.set_idle_unmap(true);
+	for (int i = 0; i < 16; i++) {
+		test_pages.data->bytes[i][0] = 42;
+	}
+	std::this_thread::sleep_for(std::chrono::milliseconds(5));
+	ASSERT_EQ(registry.unmap_idle(), 1u);
+	ASSERT_EQ(registry.unmap_idle(), 0u);
+	ASSERT_TRUE(test_pages.is_connected());
+	ASSERT_EQ(test_pages.residency().resident_pages, 0u);
+	ASSERT_EQ(test_pages.get_data().bytes[0][0], 0);
+
+	registry.set_policy(std::chrono::milliseconds(0), 0);
+	ASSERT_TRUE(test_pages.disconnect());
+	shm_unlink("test_residency_pages");
+}
+
+#ifdef __linux__
+TEST(GenericSharedMemoryModelTest, TestFixedAddress) {
+	typedef struct _test_node_t {
+		struct _test_node_t *next;
+		int value;
+	} test_node_t;
+	typedef struct _test_graph_t {
+		test_node_t nodes[2];
+	} test_graph_t;
+	shm_unlink("test_fixed_graph");
+
+	// Find a free address range to agree on.
+	void *reserved = mmap(NULL, sizeof(GenericSharedMemoryFixedAddress<test_graph_t>), PROT_NONE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+	ASSERT_NE(reserved, MAP_FAILED);
+	munmap(reserved, sizeof(GenericSharedMemoryFixedAddress<test_graph_t>));
+
+	GenericSharedMemoryModel<GenericSharedMemoryFixedAddress<test_graph_t>> test_graph("test_fixed_graph");
+	test_graph.set_fixed_address(reserved);
+	test_graph.set_inherit_on_fork(false);
+	ASSERT_TRUE(test_graph.connect());
+	ASSERT_EQ((void*)test_graph.data, reserved);
+	ASSERT_EQ(test_graph.data->fixed_address.load(), (uint64_t)(uintptr_t)reserved);
+	test_graph.data->payload.nodes[0] = {&test_graph.data->payload.nodes[1], 1};
+	test_graph.data->payload.nodes[1] = {nullptr, 2};
+
+	// The range is taken in this process, so a second mapping of the segment fails rather than landing elsewhere.
+	GenericSharedMemoryModel<GenericSharedMemoryFixedAddress<test_graph_t>> test_graph_again("test_fixed_graph");
+	ASSERT_FALSE(test_graph_again.connect());
+	ASSERT_EQ(test_graph_again.data, nullptr);
+	GenericSharedMemoryModel<int> test_int("test_fixed_int");
+	test_int.set_fixed_address(reserved);
+	ASSERT_FALSE(test_int.connect());
+
+	// A child without the mapping maps the segment at the recorded address, so the pointers in it are valid.
+	pid_t child = fork();
+	if (child == 0) {
+		GenericSharedMemoryModel<GenericSharedMemoryFixedAddress<test_graph_t>> test_child_graph("test_fixed_graph");
+		int result = 0;
+		result |= test_child_graph.connect() ? 0 : 1;
+		result |= (void*)test_child_graph.data == reserved ? 0 : 2;
+		result |= result == 0 && test_child_graph.data->payload.nodes[0].next->value == 2 ? 0 : 4;
+		_exit(result);
+	}
+	int status = 0;
+	ASSERT_EQ(waitpid(child, &status, 0), child);
+	ASSERT_TRUE(WIFEXITED(status));
+	ASSERT_EQ(WEXITSTATUS(status), 0);
+
+	test_graph.disconnect();
+	shm_unlink("test_fixed_graph");
+	shm_unlink("test_fixed_int");
+}
+#endif
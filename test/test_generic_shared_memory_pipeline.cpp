@@ -0,0 +1,122 @@
+#include <gtest/gtest.h>
+
+#include <cerrno>
+#include <chrono>
+#include <fstream>
+#include <signal.h>
+#include <sys/wait.h>
+#include <thread>
+#include <unistd.h>
+
+#include "GenericSharedMemoryPipeline.hpp"
+
+using namespace std;
+
+TEST(GenericSharedMemoryPipelineTest, TestParse) {
+	GenericSharedMemoryPipeline pipeline;
+	string error;
+	ASSERT_TRUE(pipeline.parse(
+		"# ingest -> filter -> publish\n"
+		"edge test_pipeline_raw queue 256 1024\n"
+		"\n"
+		"edge test_pipeline_pose latest 64\n"
+		"stage ingest cpu=0 ./ingest --out test_pipeline_raw\n"
+		"stage filter ./filter --in test_pipeline_raw --out test_pipeline_pose\n", &error)) << error;
+	ASSERT_EQ(pipeline.edges().size(), 2u);
+	ASSERT_EQ(pipeline.edges()[0].name, "test_pipeline_raw");
+	ASSERT_EQ(pipeline.edges()[0].kind, GenericSharedMemoryChannelKind::Queue);
+	ASSERT_EQ(pipeline.edges()[0].message_bytes, 256u);
+	ASSERT_EQ(pipeline.edges()[0].depth, 1024u);
+	ASSERT_EQ(pipeline.edges()[1].kind, GenericSharedMemoryChannelKind::Latest);
+	ASSERT_EQ(pipeline.edges()[1].depth, 1u);
+	ASSERT_EQ(pipeline.stages().size(), 2u);
+	ASSERT_EQ(pipeline.stages()[0].cpu, 0);
+	ASSERT_EQ(pipeline.stages()[0].command, "./ingest --out test_pipeline_raw");
+	ASSERT_EQ(pipeline.stages()[1].cpu, -1);
+
+	// Errors name their line, and leave the pipeline as it was.
+	ASSERT_FALSE(pipeline.parse("edge a queue 8 4\nedge b stack 8\n", &error));
+	ASSERT_EQ(error, "Line 2: Edge kind must be queue or latest: b");
+	ASSERT_FALSE(pipeline.parse("edge a queue 8\n", &error));
+	ASSERT_FALSE(pipeline.parse("edge a latest 0\n", &error));
+	ASSERT_FALSE(pipeline.parse("stage a cpu=x true\n", &error));
+	ASSERT_FALSE(pipeline.parse("stage a cpu=1   \n", &error));
+	ASSERT_FALSE(pipeline.parse("edge a latest 8\nstage a true\n", &error));
+	ASSERT_EQ(error, "Line 2: Name used twice: a");
+	ASSERT_FALSE(pipeline.parse("node a\n", &error));
+	ASSERT_FALSE(pipeline.load("/nonexistent/pipeline", &error));
+	ASSERT_EQ(pipeline.edges().size(), 2u);
+}
+
+TEST(GenericSharedMemoryPipelineTest, TestRun) {
+	// The stages run with their names and pinned processors, and their exit statuses are collected.
+	string output = "/tmp/test_generic_shared_memory_pipeline.txt";
+	remove(output.c_str());
+	GenericSharedMemoryPipeline pipeline;
+	ASSERT_TRUE(pipeline.parse(
+		"edge test_pipeline_run queue 16 32\n"
+		"stage pinned cpu=0 grep Cpus_allowed_list /proc/self/status > " + output + "\n"
+		"stage named exit $(test \"$GENERIC_SHARED_MEMORY_STAGE\" = named && echo 3)\n"));
+	ASSERT_TRUE(pipeline.create_edges());
+	GenericSharedMemoryChannel channel("test_pipeline_run");
+	ASSERT_TRUE(channel.connect());
+	ASSERT_EQ(pipeline.edge_stats()[0].depth, 32u);
+	ASSERT_TRUE(pipeline.launch());
+	pipeline.wait();
+	ASSERT_EQ(pipeline.poll(), 0u);
+	ASSERT_TRUE(WIFEXITED(pipeline.stages()[0].status));
+	ASSERT_EQ(WEXITSTATUS(pipeline.stages()[0].status), 0);
+	ASSERT_EQ(WEXITSTATUS(pipeline.stages()[1].status), 3);
+	ifstream file(output);
+	string line;
+	getline(file, line);
+	ASSERT_EQ(line, "Cpus_allowed_list:\t0");
+
+	// Edge counters follow the channels.
+	char message[16] = {};
+	ASSERT_TRUE(channel.write(message));
+	ASSERT_EQ(pipeline.edge_stats()[0].written, 1u);
+	ASSERT_EQ(pipeline.edge_stats()[0].queued, 1u);
+
+	pipeline.remove_edges();
+	ASSERT_FALSE(GenericSharedMemoryChannel("test_pipeline_run").connect());
+	remove(output.c_str());
+}
+
+/// Function is_running() returns false once a process has exited, even if it is not yet reaped by its new parent.
+static bool is_running(pid_t pid) {
+	if (kill(pid, 0) != 0 && errno == ESRCH) {
+		return false;
+	}
+	ifstream stat("/proc/" + to_string(pid) + "/stat");
+	string line;
+	getline(stat, line);
+	const size_t state = line.rfind(')');
+	return state != string::npos && state + 2 < line.size() && line[state + 2] != 'Z';
+}
+
+TEST(GenericSharedMemoryPipelineTest, TestStopCompoundCommand) {
+	// Stopping a stage reaches every process of its command, not only the shell running it.
+	string output = "/tmp/test_generic_shared_memory_pipeline_stop.txt";
+	remove(output.c_str());
+	GenericSharedMemoryPipeline pipeline;
+	ASSERT_TRUE(pipeline.parse("stage compound sleep 30 & echo $! > " + output + "; wait\n"));
+	ASSERT_TRUE(pipeline.launch());
+	pid_t sleeper = 0;
+	for (int i = 0; i < 500 && sleeper == 0; i++) {
+		this_thread::sleep_for(chrono::milliseconds(10));
+		ifstream file(output);
+		file >> sleeper;
+	}
+	ASSERT_GT(sleeper, 0);
+	ASSERT_EQ(getpgid(sleeper), pipeline.stages()[0].pid);
+	pipeline.stop();
+	pipeline.wait();
+	bool exited = false;
+	for (int i = 0; i < 500 && !exited; i++) {
+		exited = !is_running(sleeper);
+		this_thread::sleep_for(chrono::milliseconds(10));
+	}
+	ASSERT_TRUE(exited);
+	remove(output.c_str());
+}
@@ -0,0 +1,119 @@
+#include <string>
+
+#include <gtest/gtest.h>
+
+#include "GenericSharedMemoryModel.hpp"
+#include "GenericSharedMemoryReflection.hpp"
+
+using namespace std;
+
+typedef struct _test_base_t {
+	int test_int;
+	double test_double;
+} test_base_t;
+
+typedef struct _test_reflected_t {
+	bool test_bool;
+	int8_t test_int8;
+	uint16_t test_uint16;
+	double test_double;
+	char test_chars[13];
+	test_base_t test_base;
+	float test_float;
+} test_reflected_t;
+
+enum class test_mode_t : uint8_t { Off, On };
+
+typedef struct _test_named_t {
+	uint32_t id;
+	test_mode_t mode;
+	double values[3];
+} test_named_t;
+
+GENERIC_SHARED_MEMORY_REFLECT(test_named_t, id, mode, values);
+
+typedef struct _test_aligned_t {
+	int test_int;
+	alignas(64) int test_aligned;
+	char test_char;
+	alignas(4) char test_chars[3];
+	int test_last;
+} test_aligned_t;
+
+#pragma pack(push, 1)
+typedef struct _test_packed_t {
+	char test_char;
+	int test_int;
+	double test_double;
+} test_packed_t;
+#pragma pack(pop)
+
+typedef GenericSharedMemoryReflection<test_reflected_t> test_reflection_t;
+typedef GenericSharedMemoryReflection<test_named_t> test_named_reflection_t;
+
+TEST(GenericSharedMemoryReflectionTest, TestFields) {
+	// The descriptor table is available at compile time and matches the compiler's layout.
+	static_assert(test_reflection_t::field_count == 7);
+	static_assert(test_reflection_t::fields[3].offset == offsetof(test_reflected_t, test_double));
+	static_assert(test_reflection_t::fields[4].offset == offsetof(test_reflected_t, test_chars));
+	static_assert(test_reflection_t::fields[5].offset == offsetof(test_reflected_t, test_base));
+	static_assert(test_reflection_t::fields[6].offset == offsetof(test_reflected_t, test_float));
+	static_assert(std::is_same_v<test_reflection_t::field_type<4>, char[13]>);
+	static_assert(GenericSharedMemoryReflection<test_base_t>::field_count == 2);
+
+	ASSERT_EQ(test_reflection_t::fields[0].kind, GenericSharedMemoryFieldKind::Bool);
+	ASSERT_EQ(test_reflection_t::fields[1].kind, GenericSharedMemoryFieldKind::Signed);
+	ASSERT_EQ(test_reflection_t::fields[2].kind, GenericSharedMemoryFieldKind::Unsigned);
+	ASSERT_EQ(test_reflection_t::fields[3].kind, GenericSharedMemoryFieldKind::Float);
+	ASSERT_EQ(test_reflection_t::fields[5].kind, GenericSharedMemoryFieldKind::Other);
+	ASSERT_EQ(test_reflection_t::fields[5].size, sizeof(test_base_t));
+	ASSERT_TRUE(test_reflection_t::fields[0].name.empty());
+	for (const GenericSharedMemoryField &field : test_reflection_t::fields) {
+		ASSERT_LE(field.offset + field.size, sizeof(test_reflected_t));
+	}
+}
+
+TEST(GenericSharedMemoryReflectionTest, TestAlignedAndPacked) {
+	// Offsets come from the compiler's layout, not the alignment of the field types.
+	typedef GenericSharedMemoryReflection<test_aligned_t> test_aligned_reflection_t;
+	static_assert(test_aligned_reflection_t::fields[1].offset == offsetof(test_aligned_t, test_aligned));
+	static_assert(test_aligned_reflection_t::fields[2].offset == offsetof(test_aligned_t, test_char));
+	static_assert(test_aligned_reflection_t::fields[3].offset == offsetof(test_aligned_t, test_chars));
+	static_assert(test_aligned_reflection_t::fields[4].offset == offsetof(test_aligned_t, test_last));
+	ASSERT_EQ(test_aligned_reflection_t::fields[1].offset, 64u);
+
+	typedef GenericSharedMemoryReflection<test_packed_t> test_packed_reflection_t;
+	static_assert(test_packed_reflection_t::fields[1].offset == offsetof(test_packed_t, test_int));
+	static_assert(test_packed_reflection_t::fields[2].offset == offsetof(test_packed_t, test_double));
+	ASSERT_EQ(test_packed_reflection_t::fields[1].offset, 1u);
+}
+
+TEST(GenericSharedMemoryReflectionTest, TestNamesAndAccess) {
+	static_assert(test_named_reflection_t::index_of("values") == 2);
+	static_assert(test_named_reflection_t::index_of("missing") == 3);
+	ASSERT_EQ(test_named_reflection_t::fields[1].name, "mode");
+	ASSERT_EQ(test_named_reflection_t::fields[1].kind, GenericSharedMemoryFieldKind::Unsigned);
+	ASSERT_EQ(test_named_reflection_t::fields[2].offset, offsetof(test_named_t, values));
+
+	// Fields of a segment are accessed by position without hand written offsets.
+	shm_unlink("test_named");
+	GenericSharedMemoryModel<test_named_t> test_named("test_named");
+	ASSERT_TRUE(test_named.connect());
+	test_named_reflection_t::get<0>(*test_named.data) = 42;
+	test_named_reflection_t::get<2>(*test_named.data)[1] = 1.5;
+	ASSERT_EQ(test_named.get_data().id, 42u);
+	ASSERT_EQ(test_named.get_data().values[1], 1.5);
+
+	string visited;
+	size_t total_size = 0;
+	test_named_t value = test_named.get_data();
+	test_named_reflection_t::for_each(value, [&](const GenericSharedMemoryField &field, auto &member) {
+		visited += string(field.name) + ";";
+		total_size += sizeof(member);
+	});
+	ASSERT_EQ(visited, "id;mode;values;");
+	ASSERT_EQ(total_size, sizeof(uint32_t) + sizeof(test_mode_t) + 3 * sizeof(double));
+
+	test_named.disconnect();
+	shm_unlink("test_named");
+}
@@ -0,0 +1,171 @@
+#include <gtest/gtest.h>
+
+#include <atomic>
+#include <sys/wait.h>
+#include <thread>
+#include <unistd.h>
+#include <vector>
+
+#include "GenericSharedMemoryScheduler.hpp"
+
+using namespace std;
+
+typedef struct _test_task_t {
+	uint32_t id;
+	uint32_t cost;
+} test_task_t;
+
+typedef GenericSharedMemoryScheduler<test_task_t, 4, 64> test_scheduler_t;
+
+TEST(GenericSharedMemorySchedulerTest, TestDeque) {
+	shm_unlink("test_scheduler");
+	test_scheduler_t owner("test_scheduler");
+	test_scheduler_t thief("test_scheduler");
+	test_task_t task;
+	ASSERT_FALSE(owner.push(0, {1, 0}));
+	ASSERT_TRUE(owner.connect());
+	ASSERT_TRUE(thief.connect());
+	ASSERT_FALSE(owner.pop(0, task));
+	ASSERT_FALSE(thief.steal(0, task));
+	ASSERT_FALSE(owner.push(4, {1, 0}));
+
+	// The owner pops the newest task and thieves steal the oldest.
+	for (uint32_t id = 1; id <= 3; id++) {
+		ASSERT_TRUE(owner.push(0, {id, 0}));
+	}
+	ASSERT_EQ(thief.size(0), 3u);
+	ASSERT_TRUE(owner.pop(0, task));
+	ASSERT_EQ(task.id, 3u);
+	ASSERT_TRUE(thief.steal(0, task));
+	ASSERT_EQ(task.id, 1u);
+	ASSERT_TRUE(owner.pop(0, task));
+	ASSERT_EQ(task.id, 2u);
+	ASSERT_FALSE(owner.pop(0, task));
+
+	// A deque holds its capacity of tasks, wrapping around its ring.
+	for (uint32_t id = 0; id < 64; id++) {
+		ASSERT_TRUE(owner.push(1, {id, 0}));
+	}
+	ASSERT_FALSE(owner.push(1, {64, 0}));
+	for (uint32_t id = 0; id < 64; id++) {
+		ASSERT_TRUE(thief.steal(1, task));
+		ASSERT_EQ(task.id, id);
+	}
+	ASSERT_EQ(owner.size(1), 0u);
+
+	// Workers with nothing to do time out, and stop releases them.
+	ASSERT_FALSE(owner.next(2, task, 10));
+	ASSERT_TRUE(owner.push(3, {7, 0}));
+	ASSERT_TRUE(owner.next(2, task, 10));
+	ASSERT_EQ(task.id, 7u);
+	owner.stop();
+	ASSERT_TRUE(thief.is_stopped());
+	ASSERT_FALSE(thief.next(2, task));
+
+	// A stopped scheduler stays stopped across connections until it is reset, which also drops leftover tasks.
+	ASSERT_TRUE(owner.push(0, {8, 0}));
+	owner.disconnect();
+	ASSERT_TRUE(owner.connect());
+	ASSERT_TRUE(owner.is_stopped());
+	ASSERT_TRUE(owner.reset());
+	ASSERT_FALSE(thief.is_stopped());
+	ASSERT_EQ(thief.size(0), 0u);
+	ASSERT_FALSE(thief.next(2, task, 10));
+	ASSERT_TRUE(owner.push(1, {9, 0}));
+	ASSERT_TRUE(thief.next(2, task, 10));
+	ASSERT_EQ(task.id, 9u);
+
+	// A worker killed while parked leaves the sleeper count raised, which reset() clears.
+	GenericSharedMemoryModel<test_scheduler_t::layout_t> layout("test_scheduler");
+	ASSERT_TRUE(layout.connect());
+	layout.data->sleepers.store(1);
+	layout.data->stopped.store(1);
+	ASSERT_TRUE(owner.reset());
+	ASSERT_EQ(layout.data->sleepers.load(), 0u);
+	ASSERT_FALSE(owner.is_stopped());
+	layout.disconnect();
+
+	owner.disconnect();
+	thief.disconnect();
+	shm_unlink("test_scheduler");
+}
+
+TEST(GenericSharedMemorySchedulerTest, TestParking) {
+	shm_unlink("test_scheduler_parking");
+	test_scheduler_t scheduler("test_scheduler_parking");
+	ASSERT_TRUE(scheduler.connect());
+
+	// A worker parked on an empty scheduler is woken by a push from another process.
+	pid_t pid = fork();
+	if (pid == 0) {
+		test_scheduler_t producer("test_scheduler_parking");
+		producer.connect();
+		this_thread::sleep_for(chrono::milliseconds(50));
+		bool pushed = producer.push(3, {42, 0});
+		producer.disconnect();
+		_exit(pushed ? 0 : 1);
+	}
+	test_task_t task;
+	ASSERT_TRUE(scheduler.next(0, task, 5000));
+	ASSERT_EQ(task.id, 42u);
+	int status = 0;
+	waitpid(pid, &status, 0);
+	ASSERT_TRUE(WIFEXITED(status));
+	ASSERT_EQ(WEXITSTATUS(status), 0);
+
+	scheduler.disconnect();
+	shm_unlink("test_scheduler_parking");
+}
+
+TEST(GenericSharedMemorySchedulerTest, TestWorkStealing) {
+	shm_unlink("test_scheduler_stealing");
+	// Worker 0 is seeded with 32 tasks, each splitting into two smaller tasks until 1024 leaves run, and the other workers
+	// only get work by stealing.
+	const uint32_t depth = 5;
+	const uint32_t leaves = 32 << depth;
+	vector<atomic<uint32_t>> runs(leaves);
+	atomic<uint32_t> completed = 0;
+	atomic<uint32_t> failed_pushes = 0;
+	auto work = [&](size_t worker) {
+		test_scheduler_t scheduler("test_scheduler_stealing");
+		scheduler.connect();
+		test_task_t task;
+		while (scheduler.next(worker, task)) {
+			if (task.cost > 0) {
+				for (uint32_t half = 0; half < 2; half++) {
+					failed_pushes += !scheduler.push(worker, {task.id * 2 + half, task.cost - 1});
+				}
+				continue;
+			}
+			runs[task.id]++;
+			this_thread::sleep_for(chrono::microseconds(10));
+			if (++completed == leaves) {
+				scheduler.stop();
+			}
+		}
+		scheduler.disconnect();
+	};
+	test_scheduler_t seeder("test_scheduler_stealing");
+	ASSERT_TRUE(seeder.connect());
+	for (uint32_t id = 0; id < 32; id++) {
+		ASSERT_TRUE(seeder.push(0, {id, depth}));
+	}
+	vector<thread> threads;
+	for (size_t worker = 1; worker < 4; worker++) {
+		threads.emplace_back(work, worker);
+	}
+	work(0);
+	for (thread &t : threads) {
+		t.join();
+	}
+
+	// Every leaf ran exactly once.
+	ASSERT_EQ(failed_pushes, 0u);
+	ASSERT_EQ(completed, leaves);
+	for (uint32_t id = 0; id < leaves; id++) {
+		ASSERT_EQ(runs[id], 1u);
+	}
+
+	seeder.disconnect();
+	shm_unlink("test_scheduler_stealing");
+}
@@ -0,0 +1,200 @@
+#include <gtest/gtest.h>
+
+#include "GenericSharedMemorySchema.hpp"
+
+using namespace std;
+
+typedef struct _test_telemetry_v1_t {
+	int mode;
+	double speed;
+} test_telemetry_v1_t;
+GENERIC_SHARED_MEMORY_REFLECT(test_telemetry_v1_t, mode, speed);
+
+typedef struct _test_telemetry_v2_t {
+	int mode;
+	double speed;
+	int battery;
+	double heading;
+} test_telemetry_v2_t;
+GENERIC_SHARED_MEMORY_REFLECT(test_telemetry_v2_t, mode, speed, battery, heading);
+
+typedef struct _test_telemetry_reordered_t {
+	double heading;
+	int mode;
+} test_telemetry_reordered_t;
+GENERIC_SHARED_MEMORY_REFLECT(test_telemetry_reordered_t, heading, mode);
+
+typedef struct _test_telemetry_incompatible_t {
+	int mode;
+	float speed;
+} test_telemetry_incompatible_t;
+GENERIC_SHARED_MEMORY_REFLECT(test_telemetry_incompatible_t, mode, speed);
+
+typedef struct _test_telemetry_unnamed_t {
+	int mode;
+	double speed;
+} test_telemetry_unnamed_t;
+
+typedef struct _test_telemetry_disjoint_t {
+	int gear;
+	double altitude;
+} test_telemetry_disjoint_t;
+GENERIC_SHARED_MEMORY_REFLECT(test_telemetry_disjoint_t, gear, altitude);
+
+TEST(GenericSharedMemorySchemaTest, TestRollingUpgrade) {
+	shm_unlink("test_schema");
+	GenericSharedMemoryVersionedModel<test_telemetry_v1_t> old_writer("test_schema");
+	GenericSharedMemoryVersionedModel<test_telemetry_v2_t> new_writer("test_schema");
+	GenericSharedMemoryVersionedModel<test_telemetry_v1_t> old_reader("test_schema");
+	ASSERT_NE(old_writer.schema_id(), new_writer.schema_id());
+
+	// The first process records its schema in the new segment.
+	ASSERT_TRUE(old_writer.connect());
+	ASSERT_EQ(old_writer.segment_schema_id(), old_writer.schema_id());
+	ASSERT_TRUE(old_writer.uses_prefix());
+	old_writer.write_data({1, 2.0});
+
+	// A newer version appends its fields, reading the old ones in place.
+	ASSERT_TRUE(new_writer.connect());
+	ASSERT_EQ(new_writer.segment_schema_id(), new_writer.schema_id());
+	ASSERT_EQ(new_writer.missing_fields(), 0u);
+	ASSERT_TRUE(new_writer.uses_prefix());
+	test_telemetry_v2_t value = new_writer.get_data();
+	ASSERT_EQ(value.mode, 1);
+	ASSERT_EQ(value.speed, 2.0);
+	ASSERT_EQ(value.battery, 0);
+	new_writer.write_data({3, 4.0, 50, 90.0});
+
+	// Older processes keep reading the prefix they understand, and their writes leave the new fields alone.
+	ASSERT_TRUE(old_reader.connect());
+	ASSERT_EQ(old_reader.segment_schema_id(), new_writer.schema_id());
+	ASSERT_TRUE(old_reader.uses_prefix());
+	ASSERT_EQ(old_reader.get_data().speed, 4.0);
+	old_writer.write_data({5, 6.0});
+	value = new_writer.get_data();
+	ASSERT_EQ(value.mode, 5);
+	ASSERT_EQ(value.battery, 50);
+	ASSERT_EQ(value.heading, 90.0);
+
+	old_writer.disconnect();
+	new_writer.disconnect();
+	old_reader.disconnect();
+	shm_unlink("test_schema");
+}
+
+typedef struct _test_padded_v1_t {
+	double a;
+	int b;
+} test_padded_v1_t;
+GENERIC_SHARED_MEMORY_REFLECT(test_padded_v1_t, a, b);
+
+typedef struct _test_padded_v2_t {
+	double a;
+	int b;
+	int c;
+} test_padded_v2_t;
+GENERIC_SHARED_MEMORY_REFLECT(test_padded_v2_t, a, b, c);
+
+TEST(GenericSharedMemorySchemaTest, TestAppendedIntoPadding) {
+	shm_unlink("test_schema_padded");
+	static_assert(offsetof(test_padded_v2_t, c) < sizeof(test_padded_v1_t));
+	GenericSharedMemoryVersionedModel<test_padded_v1_t> old_writer("test_schema_padded");
+	GenericSharedMemoryVersionedModel<test_padded_v2_t> new_reader("test_schema_padded");
+	GenericSharedMemoryVersionedModel<test_padded_v1_t> late_writer("test_schema_padded");
+
+	// An older writer connected before the upgrade does not copy its trailing padding over the appended field.
+	ASSERT_TRUE(old_writer.connect());
+	ASSERT_TRUE(old_writer.uses_prefix());
+	ASSERT_TRUE(new_reader.connect());
+	new_reader.write_data({1.0, 2, 77});
+	test_padded_v1_t padded;
+	memset((void *)&padded, 0xAB, sizeof(padded));
+	padded.a = 3.0;
+	padded.b = 4;
+	old_writer.write_data(padded);
+	test_padded_v2_t value = new_reader.get_data();
+	ASSERT_EQ(value.a, 3.0);
+	ASSERT_EQ(value.b, 4);
+	ASSERT_EQ(value.c, 77);
+
+	// Nor does one connected after it.
+	ASSERT_TRUE(late_writer.connect());
+	padded.b = 5;
+	late_writer.write_data(padded);
+	value = new_reader.get_data();
+	ASSERT_EQ(value.b, 5);
+	ASSERT_EQ(value.c, 77);
+
+	old_writer.disconnect();
+	new_reader.disconnect();
+	late_writer.disconnect();
+	shm_unlink("test_schema_padded");
+}
+
+TEST(GenericSharedMemorySchemaTest, TestShim) {
+	shm_unlink("test_schema_shim");
+	GenericSharedMemoryVersionedModel<test_telemetry_v2_t> writer("test_schema_shim");
+	ASSERT_TRUE(writer.connect());
+	writer.write_data({1, 2.0, 3, 4.0});
+
+	// Fields are matched by name when the layouts differ.
+	GenericSharedMemoryVersionedModel<test_telemetry_reordered_t> reordered("test_schema_shim");
+	ASSERT_TRUE(reordered.connect());
+	ASSERT_FALSE(reordered.uses_prefix());
+	test_telemetry_reordered_t value = reordered.get_data();
+	ASSERT_EQ(value.heading, 4.0);
+	ASSERT_EQ(value.mode, 1);
+
+	// The segment schema is not downgraded by an older version connecting.
+	ASSERT_EQ(reordered.segment_schema_id(), writer.schema_id());
+
+	// Fields shared with a different type fail to connect.
+	GenericSharedMemoryVersionedModel<test_telemetry_incompatible_t> incompatible("test_schema_shim");
+	ASSERT_FALSE(incompatible.connect());
+	ASSERT_FALSE(incompatible.is_connected());
+
+	writer.disconnect();
+	reordered.disconnect();
+	shm_unlink("test_schema_shim");
+}
+
+TEST(GenericSharedMemorySchemaTest, TestUnnamedSegment) {
+	shm_unlink("test_schema_unnamed");
+	GenericSharedMemoryVersionedModel<test_telemetry_unnamed_t> writer("test_schema_unnamed");
+	ASSERT_TRUE(writer.connect());
+	writer.write_data({7, 8.0});
+
+	// A type with names reads a segment written without them by position.
+	GenericSharedMemoryVersionedModel<test_telemetry_v1_t> named("test_schema_unnamed");
+	ASSERT_TRUE(named.connect());
+	ASSERT_EQ(named.missing_fields(), 0u);
+	test_telemetry_v1_t value = named.get_data();
+	ASSERT_EQ(value.mode, 7);
+	ASSERT_EQ(value.speed, 8.0);
+
+	writer.disconnect();
+	named.disconnect();
+	shm_unlink("test_schema_unnamed");
+}
+
+TEST(GenericSharedMemorySchemaTest, TestNoSharedFields) {
+	shm_unlink("test_schema_disjoint");
+	GenericSharedMemoryVersionedModel<test_telemetry_v1_t> writer("test_schema_disjoint");
+	ASSERT_TRUE(writer.connect());
+
+	// A type sharing no field with the segment fails to connect and logs why.
+	GenericSharedMemoryLog::instance().set_auto_drain(false);
+	GenericSharedMemoryLog::instance().drain([](const GenericSharedMemoryLogRecord &) {});
+	GenericSharedMemoryVersionedModel<test_telemetry_disjoint_t> disjoint("test_schema_disjoint", true);
+	ASSERT_FALSE(disjoint.connect());
+	ASSERT_FALSE(disjoint.is_connected());
+	size_t incompatible = 0;
+	GenericSharedMemoryLog::instance().drain([&incompatible](const GenericSharedMemoryLogRecord &record) {
+		incompatible += record.event == GenericSharedMemoryLogEvent::SchemaIncompatible;
+	});
+	ASSERT_EQ(incompatible, 1u);
+	GenericSharedMemoryLog::instance().set_auto_drain(true);
+
+	writer.disconnect();
+	shm_unlink("test_schema_disjoint");
+}
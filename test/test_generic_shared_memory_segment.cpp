@@ -0,0 +1,121 @@
+#include <gtest/gtest.h>
+
+#include "GenericSharedMemoryModel.hpp"
+
+using namespace std;
+
+typedef struct _test_segment_t {
+	uint64_t counter;
+	double values[6];
+} test_segment_t;
+
+TEST(GenericSharedMemorySegmentTest, TestRuntimeSize) {
+	shm_unlink("test_segment");
+	GenericSharedMemorySegment attached("test_segment");
+	ASSERT_FALSE(attached.connect());
+	ASSERT_TRUE(attached.bytes().empty());
+
+	// A segment with a size creates the segment, and one without a size attaches at the size it finds.
+	GenericSharedMemorySegment created("test_segment", 10000);
+	ASSERT_TRUE(created.connect());
+	ASSERT_EQ(created.size(), 10000u);
+	ASSERT_TRUE(attached.connect());
+	ASSERT_TRUE(attached.is_connected());
+	ASSERT_EQ(attached.size(), 10000u);
+	span<byte> bytes = attached.bytes();
+	ASSERT_EQ(bytes.size(), 10000u);
+
+	// Both connections see the same bytes, and accesses outside the segment are refused.
+	uint32_t value = 0x12345678;
+	ASSERT_TRUE(created.write(9996, &value, sizeof(value)));
+	ASSERT_FALSE(created.write(9997, &value, sizeof(value)));
+	ASSERT_FALSE(created.write(SIZE_MAX, &value, sizeof(value)));
+	uint32_t read_value = 0;
+	ASSERT_TRUE(attached.read(9996, &read_value, sizeof(read_value)));
+	ASSERT_EQ(read_value, value);
+	ASSERT_EQ(bytes[9996], (byte)0x78);
+	ASSERT_FALSE(attached.read(10000, &read_value, 1));
+
+	ASSERT_TRUE(attached.disconnect());
+	ASSERT_FALSE(attached.is_connected());
+	ASSERT_FALSE(attached.read(0, &read_value, 1));
+	created.disconnect();
+	shm_unlink("test_segment");
+
+	// Reconnecting an attached segment never creates a removed segment.
+	ASSERT_FALSE(attached.connect());
+	ASSERT_FALSE(GenericSharedMemorySegment("test_segment").connect());
+
+	// A segment created again with a smaller size is attached at its new size.
+	GenericSharedMemorySegment recreated("test_segment", 4096);
+	ASSERT_TRUE(recreated.connect());
+	ASSERT_TRUE(attached.connect());
+	ASSERT_EQ(attached.size(), 4096u);
+	ASSERT_TRUE(attached.write(4092, &value, sizeof(value)));
+	ASSERT_FALSE(attached.write(9996, &value, sizeof(value)));
+	ASSERT_TRUE(recreated.read(4092, &read_value, sizeof(read_value)));
+	ASSERT_EQ(read_value, value);
+	attached.disconnect();
+	recreated.disconnect();
+	shm_unlink("test_segment");
+}
+
+TEST(GenericSharedMemorySegmentTest, TestTypedModel) {
+	shm_unlink("test_segment_typed");
+	// The typed model is a wrapper around the same core, so costs only its pointer on top of it.
+	ASSERT_EQ(sizeof(GenericSharedMemoryModel<test_segment_t>), sizeof(GenericSharedMemoryConnection) + sizeof(void*));
+
+	// A generic tool can attach to a typed segment without knowing its type.
+	GenericSharedMemoryModel<test_segment_t> model("test_segment_typed");
+	ASSERT_TRUE(model.connect());
+	model.data->counter = 42;
+	GenericSharedMemorySegment segment("test_segment_typed");
+	ASSERT_TRUE(segment.connect());
+	ASSERT_GE(segment.size(), sizeof(test_segment_t));
+	uint64_t counter = 0;
+	ASSERT_TRUE(segment.read(offsetof(test_segment_t, counter), &counter, sizeof(counter)));
+	ASSERT_EQ(counter, 42u);
+	double value = 2.5;
+	ASSERT_TRUE(segment.write(offsetof(test_segment_t, values) + 3 * sizeof(double), &value, sizeof(value)));
+	ASSERT_EQ(model.get_data().values[3], 2.5);
+
+	segment.disconnect();
+	model.disconnect();
+	shm_unlink("test_segment_typed");
+}
+
+TEST(GenericSharedMemorySegmentTest, TestLazyAndIdle) {
+	shm_unlink("test_segment_idle");
+	GenericSharedMemorySegment segment("test_segment_idle", 4096);
+	segment.set_idle_unmap(true);
+	uint64_t value = 7;
+	// Lazy connection maps the segment on its first access.
+	ASSERT_FALSE(segment.is_connected());
+	ASSERT_TRUE(segment.write(0, &value, sizeof(value)));
+	ASSERT_TRUE(segment.is_connected());
+
+	// The registry unmaps the idle segment, which is mapped again on its next access.
+	GenericSharedMemoryMappingRegistry::instance().set_policy(chrono::milliseconds(1), 0);
+	this_thread::sleep_for(chrono::milliseconds(5));
+	ASSERT_GE(GenericSharedMemoryMappingRegistry::instance().unmap_idle(), 1u);
+	ASSERT_FALSE(segment.is_connected());
+	value = 0;
+	ASSERT_TRUE(segment.read(0, &value, sizeof(value)));
+	ASSERT_EQ(value, 7u);
+
+	// An attached segment unmapped while idle is not created again on its next access once the segment is removed.
+	GenericSharedMemorySegment attached("test_segment_idle");
+	attached.set_idle_unmap(true);
+	ASSERT_TRUE(attached.read(0, &value, sizeof(value)));
+	this_thread::sleep_for(chrono::milliseconds(5));
+	ASSERT_GE(GenericSharedMemoryMappingRegistry::instance().unmap_idle(), 1u);
+	ASSERT_FALSE(attached.is_connected());
+	segment.disconnect();
+	shm_unlink("test_segment_idle");
+	ASSERT_FALSE(attached.read(0, &value, sizeof(value)));
+	ASSERT_FALSE(GenericSharedMemorySegment("test_segment_idle").connect());
+	GenericSharedMemoryMappingRegistry::instance().set_policy(chrono::milliseconds(0), 0);
+
+	attached.disconnect();
+	shm_unlink("test_segment_idle");
+}
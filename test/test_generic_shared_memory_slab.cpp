@@ -0,0 +1,130 @@
+#include <stdio.h>
+#ifdef __linux__
+#include <sys/wait.h>
+#include <unistd.h>
+#endif
+
+#include <gtest/gtest.h>
+
+#include "GenericSharedMemorySlab.hpp"
+
+using namespace std;
+
+typedef struct _test_struct_t {
+	int test_int;
+	double test_double;
+} test_struct_t;
+
+TEST(GenericSharedMemorySlabTest, TestAttach) {
+	shm_unlink("test_slab");
+	GenericSharedMemorySlab<4096, 64> writer_slab("test_slab");
+	GenericSharedMemorySlab<4096, 64> reader_slab("test_slab");
+	ASSERT_TRUE(writer_slab.connect());
+	ASSERT_TRUE(reader_slab.connect());
+
+	GenericSharedMemorySlabModel<float> writer_float(writer_slab, "test_float");
+	GenericSharedMemorySlabModel<int> writer_int(writer_slab, "test_int");
+	GenericSharedMemorySlabModel<test_struct_t> writer_struct(writer_slab, "test_struct");
+	// Handles that are not attached read default values and ignore writes, like a model that is not connected.
+	writer_int.write_data(7);
+	ASSERT_EQ(writer_int.get_data(), 0);
+	ASSERT_TRUE(writer_float.connect());
+	ASSERT_TRUE(writer_int.connect());
+	ASSERT_TRUE(writer_struct.connect());
+	ASSERT_EQ(writer_slab.entry_count(), 3u);
+
+	ASSERT_EQ((uintptr_t)writer_float.data % GENERIC_SHARED_MEMORY_SLAB_ALIGNMENT, 0u);
+	ASSERT_EQ((uintptr_t)writer_int.data % GENERIC_SHARED_MEMORY_SLAB_ALIGNMENT, 0u);
+	ASSERT_EQ((char*)writer_int.data - (char*)writer_float.data, GENERIC_SHARED_MEMORY_SLAB_ALIGNMENT);
+
+	writer_float.write_data(42.42f);
+	writer_int.write_data(42);
+	writer_struct.write_data({42, 42.42});
+
+	GenericSharedMemorySlabModel<float> reader_float(reader_slab, "test_float");
+	GenericSharedMemorySlabModel<int> reader_int(reader_slab, "test_int");
+	GenericSharedMemorySlabModel<test_struct_t> reader_struct(reader_slab, "test_struct");
+	ASSERT_TRUE(reader_float.connect());
+	ASSERT_TRUE(reader_int.connect());
+	ASSERT_TRUE(reader_struct.connect());
+	ASSERT_EQ(reader_slab.entry_count(), 3u);
+
+	ASSERT_EQ(reader_float.get_data(), 42.42f);
+	ASSERT_EQ(reader_int.get_data(), 42);
+	ASSERT_EQ(reader_struct.get_data().test_int, 42);
+	ASSERT_EQ(reader_struct.data->test_double, 42.42);
+
+	ASSERT_TRUE(reader_int.disconnect());
+	ASSERT_FALSE(reader_int.is_connected());
+	ASSERT_EQ(reader_int.get_data(), 0);
+	reader_int.write_data(7);
+	ASSERT_EQ(writer_int.get_data(), 42);
+	shm_unlink("test_slab");
+}
+
+TEST(GenericSharedMemorySlabTest, TestCapacity) {
+	shm_unlink("test_slab_capacity");
+	GenericSharedMemorySlab<256, 8> slab("test_slab_capacity");
+
+	GenericSharedMemorySlabModel<int> unconnected(slab, "test_unconnected");
+	ASSERT_FALSE(unconnected.connect());
+
+	ASSERT_TRUE(slab.connect());
+	for (int i = 0; i < 4; i++) {
+		GenericSharedMemorySlabModel<int> model(slab, "test_int_" + std::to_string(i));
+		ASSERT_TRUE(model.connect());
+	}
+	GenericSharedMemorySlabModel<int> overflow(slab, "test_int_overflow");
+	ASSERT_FALSE(overflow.connect());
+
+	GenericSharedMemorySlabModel<uint64_t> too_large(slab, "test_int_0");
+	ASSERT_FALSE(too_large.connect());
+
+	GenericSharedMemorySlabModel<int> long_name(slab, std::string(64, 'x'));
+	ASSERT_FALSE(long_name.connect());
+	shm_unlink("test_slab_capacity");
+}
+
+#ifdef __linux__
+TEST(GenericSharedMemorySlabTest, TestDeadLockOwner) {
+	shm_unlink("test_slab_dead_owner");
+	typedef GenericSharedMemorySlab<4096, 64> slab_t;
+	slab_t slab("test_slab_dead_owner");
+	ASSERT_TRUE(slab.connect());
+
+	// Leave the directory locked by a process that has exited, as if it died while attaching.
+	GenericSharedMemoryModel<slab_t::layout_t> layout("test_slab_dead_owner");
+	ASSERT_TRUE(layout.connect());
+
+	// The token is cached per process, and a child computes its own rather than inheriting its parent's.
+	const uint64_t token = generic_shared_memory_process_token();
+	ASSERT_EQ((uint32_t)token, (uint32_t)getpid());
+	ASSERT_EQ(generic_shared_memory_process_token(), token);
+	const pid_t child = fork();
+	if (child == 0) {
+		layout.data->lock.store(generic_shared_memory_process_token());
+		_exit(0);
+	}
+	ASSERT_GT(child, 0);
+	ASSERT_EQ(waitpid(child, nullptr, 0), child);
+	ASSERT_EQ((uint32_t)layout.data->lock.load(), (uint32_t)child);
+
+	// The next attach breaks the lock rather than spinning forever, and releases it.
+	GenericSharedMemorySlabModel<int> model(slab, "test_int");
+	ASSERT_TRUE(model.connect());
+	ASSERT_EQ(layout.data->lock.load(), 0u);
+	ASSERT_EQ(slab.entry_count(), 1u);
+
+	// A lock whose owner's ID now belongs to a process started at another time is broken too.
+	ASSERT_TRUE(generic_shared_memory_process_alive(token));
+	layout.data->lock.store(token ^ ((uint64_t)1 << GENERIC_SHARED_MEMORY_PROCESS_START_SHIFT));
+	GenericSharedMemorySlabModel<int> recycled(slab, "test_recycled");
+	ASSERT_TRUE(recycled.connect());
+	ASSERT_EQ(layout.data->lock.load(), 0u);
+
+	// An owner in another PID namespace cannot be seen, so it is never taken for dead.
+	const uint64_t foreign = (uint64_t)child | ((token >> GENERIC_SHARED_MEMORY_PROCESS_NAMESPACE_SHIFT) ^ 1) << GENERIC_SHARED_MEMORY_PROCESS_NAMESPACE_SHIFT;
+	ASSERT_TRUE(generic_shared_memory_process_alive(foreign));
+	shm_unlink("test_slab_dead_owner");
+}
+#endif
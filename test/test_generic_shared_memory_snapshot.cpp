@@ -0,0 +1,98 @@
+#include <thread>
+
+#include <unistd.h>
+
+#include <gtest/gtest.h>
+
+#include "GenericSharedMemorySnapshot.hpp"
+
+using namespace std;
+
+typedef struct _test_pages_t {
+	char bytes[1024][4096];
+} test_pages_t;
+
+static void test_snapshot(GenericSharedMemorySnapshotMode mode) {
+	shm_unlink("test_snapshot_pages");
+	GenericSharedMemoryModel<test_pages_t> test_pages("test_snapshot_pages");
+	ASSERT_TRUE(test_pages.connect());
+	for (int i = 0; i < 1024; i++) {
+		memset(test_pages.data->bytes[i], 1, sizeof(test_pages.data->bytes[i]));
+	}
+
+	GenericSharedMemorySnapshot snapshot(test_pages, mode);
+	if (mode == GenericSharedMemorySnapshotMode::Auto && !snapshot.uses_userfaultfd()) {
+		test_pages.disconnect();
+		shm_unlink("test_snapshot_pages");
+		GTEST_SKIP() << "userfaultfd write protection of shared memory is not available";
+	}
+
+	// Writes made after the snapshot is taken, even while it is being copied, must not appear in it. The last page is
+	// written straight away, long before the copier reaches it, so with write protection the write must fault.
+	ASSERT_TRUE(snapshot.take(test_pages));
+	memset(test_pages.data->bytes[1023], 2, sizeof(test_pages.data->bytes[1023]));
+	thread writer([&test_pages]() {
+		for (int i = 1022; i >= 0; i--) {
+			memset(test_pages.data->bytes[i], 2, sizeof(test_pages.data->bytes[i]));
+		}
+	});
+	writer.join();
+
+	const test_pages_t *taken = (const test_pages_t *)snapshot.data();
+	ASSERT_TRUE(snapshot.is_complete());
+	if (mode == GenericSharedMemorySnapshotMode::Auto) {
+		ASSERT_TRUE(snapshot.uses_userfaultfd());
+		ASSERT_GT(snapshot.faulted_pages(), 0u);
+	}
+	for (int i = 0; i < 1024; i++) {
+		ASSERT_EQ(taken->bytes[i][0], 1);
+		ASSERT_EQ(taken->bytes[i][4095], 1);
+		ASSERT_EQ(test_pages.data->bytes[i][0], 2);
+	}
+
+	// A second snapshot sees the writes.
+	ASSERT_TRUE(snapshot.take());
+	taken = (const test_pages_t *)snapshot.data();
+	ASSERT_EQ(taken->bytes[10][10], 2);
+
+	test_pages.disconnect();
+	shm_unlink("test_snapshot_pages");
+}
+
+TEST(GenericSharedMemorySnapshotTest, TestWriteProtectSnapshot) {
+	test_snapshot(GenericSharedMemorySnapshotMode::Auto);
+}
+
+TEST(GenericSharedMemorySnapshotTest, TestCopySnapshot) {
+	test_snapshot(GenericSharedMemorySnapshotMode::Copy);
+	GenericSharedMemorySnapshot invalid(nullptr, 4096);
+	ASSERT_FALSE(invalid.take());
+	ASSERT_FALSE(invalid.uses_userfaultfd());
+	ASSERT_EQ(invalid.data(), nullptr);
+}
+
+TEST(GenericSharedMemorySnapshotTest, TestKernelWritesSnapshot) {
+	shm_unlink("test_snapshot_kernel");
+	GenericSharedMemoryModel<test_pages_t> test_pages("test_snapshot_kernel");
+	ASSERT_TRUE(test_pages.connect());
+	memset(test_pages.data->bytes[1023], 1, sizeof(test_pages.data->bytes[1023]));
+
+	// A snapshot refusing a userfaultfd that only traps user space writes lets the kernel write into the segment.
+	GenericSharedMemorySnapshot snapshot(test_pages, GenericSharedMemorySnapshotMode::KernelWrites);
+	ASSERT_TRUE(snapshot.allows_kernel_writes());
+	int pipe_ends[2];
+	ASSERT_EQ(pipe(pipe_ends), 0);
+	char written[4096];
+	memset(written, 2, sizeof(written));
+	ASSERT_EQ(write(pipe_ends[1], written, sizeof(written)), (ssize_t)sizeof(written));
+	ASSERT_TRUE(snapshot.take(test_pages));
+	ASSERT_EQ(read(pipe_ends[0], test_pages.data->bytes[1023], sizeof(written)), (ssize_t)sizeof(written));
+	const test_pages_t *taken = (const test_pages_t *)snapshot.data();
+	ASSERT_EQ(taken->bytes[1023][0], 1);
+	ASSERT_EQ(test_pages.data->bytes[1023][0], 2);
+	close(pipe_ends[0]);
+	close(pipe_ends[1]);
+
+	test_pages.disconnect();
+	shm_unlink("test_snapshot_kernel");
+}
@@ -0,0 +1,155 @@
+/**
+ * 	@file		generic_shared_memory_export.cpp
+ *	@brief		Command line export and import of shared memory segments to compressed files.
+ *	@details	This tool exports a named shared memory segment to a compressed file, or imports a
+				file into a named segment, creating it at the size saved in the file. The file is
+				imported into private memory first, so a corrupt or truncated file leaves any existing
+				segment untouched. Once every chunk has been checked, any segment of the same name is
+				replaced with a new one, into which only the non-zero pages are copied, while processes
+				still mapping the old segment keep their copy. The number of threads can be set with
+				--threads=N.
+ *	@author		James Horner
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <string>
+#include <vector>
+
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+#include "GenericSharedMemoryExport.hpp"
+
+using namespace std;
+
+/// Function export_segment() maps a segment read only and exports it to a file.
+static bool export_segment(const string &name, const string &path, unsigned thread_count) {
+	int file_mapping_handle = shm_open(name.c_str(), O_RDONLY, 0);
+	if (file_mapping_handle < 0) {
+		fprintf(stderr, "Couldn't open shared memory with name: %s (error: %d)\n", name.c_str(), errno);
+		return false;
+	}
+	struct stat mapping_stat;
+	if (fstat(file_mapping_handle, &mapping_stat) != 0) {
+		close(file_mapping_handle);
+		fprintf(stderr, "Couldn't stat shared memory with name: %s (error: %d)\n", name.c_str(), errno);
+		return false;
+	}
+	const size_t bytes = (size_t)mapping_stat.st_size;
+	void *mapping = bytes != 0 ? mmap(NULL, bytes, PROT_READ, MAP_SHARED, file_mapping_handle, 0) : nullptr;
+	close(file_mapping_handle);
+	if (mapping == MAP_FAILED) {
+		fprintf(stderr, "Couldn't map shared memory with name: %s (error: %d)\n", name.c_str(), errno);
+		return false;
+	}
+
+	static unsigned char empty_segment;
+	const bool exported = GenericSharedMemoryExport::export_segment(bytes != 0 ? mapping : &empty_segment, bytes, path, thread_count);
+	if (!exported) {
+		fprintf(stderr, "Couldn't export shared memory with name: %s to: %s\n", name.c_str(), path.c_str());
+	}
+	if (bytes != 0) {
+		munmap(mapping, bytes);
+	}
+	return exported;
+}
+
+/// Function import_segment() recreates a segment at the size saved in a file and imports the file into it.
+static bool import_segment(const string &path, const string &name, unsigned thread_count) {
+	const size_t bytes = GenericSharedMemoryExport::segment_bytes(path);
+	if (bytes == 0) {
+		fprintf(stderr, "Couldn't read export file: %s\n", path.c_str());
+		return false;
+	}
+
+	// Import into zero filled private memory, so that a file which turns out to be corrupt part way through never
+	// touches the segment.
+	unsigned char *imported = (unsigned char *)mmap(NULL, bytes, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+	if (imported == MAP_FAILED) {
+		fprintf(stderr, "Couldn't allocate %zu bytes to import: %s (error: %d)\n", bytes, path.c_str(), errno);
+		return false;
+	}
+	if (!GenericSharedMemoryExport::import_segment(path, imported, bytes, true, thread_count)) {
+		munmap(imported, bytes);
+		fprintf(stderr, "Couldn't import shared memory with name: %s from: %s\n", name.c_str(), path.c_str());
+		return false;
+	}
+
+	// Unlinking any old segment before creating a new one gives a zero filled segment without truncating pages that
+	// other processes may still have mapped.
+	shm_unlink(name.c_str());
+	int file_mapping_handle = shm_open(name.c_str(), O_CREAT | O_EXCL | O_RDWR, 0666);
+	if (file_mapping_handle < 0) {
+		munmap(imported, bytes);
+		fprintf(stderr, "Couldn't create shared memory with name: %s (error: %d)\n", name.c_str(), errno);
+		return false;
+	}
+	if (ftruncate(file_mapping_handle, (off_t)bytes) != 0) {
+		close(file_mapping_handle);
+		munmap(imported, bytes);
+		fprintf(stderr, "Couldn't truncate shared memory with name: %s (error: %d)\n", name.c_str(), errno);
+		return false;
+	}
+	unsigned char *mapping = (unsigned char *)mmap(NULL, bytes, PROT_READ | PROT_WRITE, MAP_SHARED, file_mapping_handle, 0);
+	close(file_mapping_handle);
+	if (mapping == MAP_FAILED) {
+		munmap(imported, bytes);
+		fprintf(stderr, "Couldn't map shared memory with name: %s (error: %d)\n", name.c_str(), errno);
+		return false;
+	}
+
+	// Copy only the pages holding data, so zero runs of the new segment stay untouched.
+	const size_t page_size = (size_t)sysconf(_SC_PAGESIZE);
+	for (size_t offset = 0; offset < bytes; offset += page_size) {
+		const size_t length = bytes - offset < page_size ? bytes - offset : page_size;
+		const unsigned char *page = imported + offset;
+		if (page[0] != 0 || memcmp(page, page + 1, length - 1) != 0) {
+			memcpy(mapping + offset, page, length);
+		}
+	}
+	munmap(mapping, bytes);
+	munmap(imported, bytes);
+	return true;
+}
+
+int main(int argc, char **argv) {
+	unsigned thread_count = 0;
+	vector<string> arguments;
+
+	// Parse the options and the command.
+	for (int i = 1; i < argc; i++) {
+		string argument = argv[i];
+		if (argument.rfind("--threads=", 0) == 0) {
+			const char *text = argument.c_str() + 10;
+			char *end = nullptr;
+			const unsigned long value = strtoul(text, &end, 10);
+			if (*text < '0' || *text > '9' || *end != '\0' || value > 1024) {
+				fprintf(stderr, "Invalid number of threads: %s\n", text);
+				return -1;
+			}
+			thread_count = (unsigned)value;
+		}
+		else if (argument == "--help" || argument == "-h") {
+			arguments.clear();
+			break;
+		}
+		else {
+			arguments.push_back(argument);
+		}
+	}
+
+	if (arguments.size() == 3 && arguments[0] == "export") {
+		return export_segment(arguments[1], arguments[2], thread_count) ? 0 : -1;
+	}
+	if (arguments.size() == 3 && arguments[0] == "import") {
+		return import_segment(arguments[1], arguments[2], thread_count) ? 0 : -1;
+	}
+	printf("Usage: %s [--threads=N] export <segment name> <file>\n", argv[0]);
+	printf("       %s [--threads=N] import <file> <segment name>\n", argv[0]);
+	return arguments.empty() ? 0 : -1;
+}
@@ -0,0 +1,128 @@
+/**
+ * 	@file		generic_shared_memory_pipeline.cpp
+ *	@brief		Command line runner for pipelines of processes connected by shared memory channels.
+ *	@details	This tool reads a pipeline description, creates the channel of every edge, launches the
+				stages pinned to their processors, and prints the throughput, depth and backpressure of
+				every edge each interval (set with --interval=MS, 1000 by default) until every stage
+				exits. An interrupt stops the stages. The channels are removed on exit unless --keep is
+				given.
+ *	@author		James Horner
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+
+#include <chrono>
+#include <csignal>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "GenericSharedMemoryPipeline.hpp"
+
+using namespace std;
+
+/// Flag set by the interrupt handler.
+static volatile sig_atomic_t s_interrupted = 0;
+
+/// Function print_edges() prints the rates of every edge since the previous sample.
+static void print_edges(const GenericSharedMemoryPipeline &pipeline, const vector<GenericSharedMemoryChannelStats> &previous,
+						const vector<GenericSharedMemoryChannelStats> &current, double seconds) {
+	printf("%-24s %-6s %12s %12s %15s %12s\n", "edge", "kind", "written/s", "read/s", "queued/depth", "full/s");
+	for (size_t index = 0; index < pipeline.edges().size(); index++) {
+		const GenericSharedMemoryPipelineEdge &edge = pipeline.edges()[index];
+		const GenericSharedMemoryChannelStats &before = previous[index];
+		const GenericSharedMemoryChannelStats &after = current[index];
+		string depth = to_string(after.queued) + "/" + to_string(after.depth);
+		printf("%-24s %-6s %12.0f %12.0f %15s %12.0f\n", edge.name.c_str(), GenericSharedMemoryPipeline::kind_name(edge.kind),
+			   (after.written - before.written) / seconds, (after.read - before.read) / seconds, depth.c_str(),
+			   (after.full - before.full) / seconds);
+	}
+	fflush(stdout);
+}
+
+int main(int argc, char **argv) {
+	int interval_ms = 1000;
+	bool keep = false;
+	vector<string> arguments;
+
+	// Parse the options and the description.
+	for (int i = 1; i < argc; i++) {
+		string argument = argv[i];
+		if (argument.rfind("--interval=", 0) == 0) {
+			const char *text = argument.c_str() + 11;
+			char *end = nullptr;
+			const long value = strtol(text, &end, 10);
+			if (*text < '0' || *text > '9' || *end != '\0' || value < 1 || value > 3600000) {
+				fprintf(stderr, "Invalid interval: %s\n", text);
+				return -1;
+			}
+			interval_ms = (int)value;
+		}
+		else if (argument == "--keep") {
+			keep = true;
+		}
+		else if (argument == "--help" || argument == "-h") {
+			arguments.clear();
+			break;
+		}
+		else {
+			arguments.push_back(argument);
+		}
+	}
+	if (arguments.size() != 1) {
+		printf("Usage: %s [--interval=MS] [--keep] <pipeline description>\n", argv[0]);
+		return arguments.empty() ? 0 : -1;
+	}
+
+	GenericSharedMemoryPipeline pipeline;
+	string error;
+	if (!pipeline.load(arguments[0], &error)) {
+		fprintf(stderr, "%s\n", error.c_str());
+		return -1;
+	}
+	if (!pipeline.create_edges()) {
+		fprintf(stderr, "Couldn't create the channels of: %s (error: %d)\n", arguments[0].c_str(), errno);
+		pipeline.remove_edges();
+		return -1;
+	}
+	signal(SIGINT, [](int) { s_interrupted = 1; });
+	if (!pipeline.launch()) {
+		fprintf(stderr, "Couldn't launch the stages of: %s (error: %d)\n", arguments[0].c_str(), errno);
+		pipeline.stop();
+	}
+
+	// Sample the edges each interval until every stage exited, stopping the stages on an interrupt.
+	vector<GenericSharedMemoryChannelStats> previous = pipeline.edge_stats();
+	auto previous_time = chrono::steady_clock::now();
+	bool stopping = false;
+	while (pipeline.poll() > 0) {
+		this_thread::sleep_for(chrono::milliseconds(interval_ms));
+		if (s_interrupted && !stopping) {
+			pipeline.stop();
+			stopping = true;
+		}
+		vector<GenericSharedMemoryChannelStats> current = pipeline.edge_stats();
+		auto current_time = chrono::steady_clock::now();
+		print_edges(pipeline, previous, current, chrono::duration<double>(current_time - previous_time).count());
+		previous = current;
+		previous_time = current_time;
+	}
+
+	// Report how each stage exited.
+	int result = 0;
+	for (const GenericSharedMemoryPipelineStage &stage : pipeline.stages()) {
+		if (WIFEXITED(stage.status)) {
+			printf("stage %s exited with status %d\n", stage.name.c_str(), WEXITSTATUS(stage.status));
+			result |= WEXITSTATUS(stage.status) != 0;
+		}
+		else if (WIFSIGNALED(stage.status)) {
+			printf("stage %s was killed by signal %d\n", stage.name.c_str(), WTERMSIG(stage.status));
+			result |= !stopping;
+		}
+	}
+	if (!keep) {
+		pipeline.remove_edges();
+	}
+	return result ? -1 : 0;
+}
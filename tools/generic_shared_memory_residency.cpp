@@ -0,0 +1,114 @@
+/**
+ * 	@file		generic_shared_memory_residency.cpp
+ *	@brief		Command line report of the residency of shared memory segments.
+ *	@details	This tool maps the named shared memory segments (or every segment in /dev/shm when
+				no names are given) read only, and prints how many of the pages of each segment are
+				resident in memory. Optionally the segments can be advised out of memory or
+				prefetched with --advise=cold|pageout|willneed|remove. Removing frees the pages and
+				their contents, so only then are the segments mapped writable, and it is only allowed
+				for segments named explicitly.
+ *	@author		James Horner
+ */
+
+#include <stdio.h>
+
+#include <filesystem>
+#include <string>
+#include <vector>
+
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+#include "GenericSharedMemoryResidency.hpp"
+
+using namespace std;
+
+/// Function report_segment() prints the residency of one segment, advising it first if requested.
+static bool report_segment(const string &name, bool advise, GenericSharedMemoryAdvice advice) {
+	// Open the segment read only, it is never created by the report. Removing pages needs a writable shared mapping.
+	const bool writable = advise && advice == GenericSharedMemoryAdvice::Remove;
+	int file_mapping_handle = shm_open(name.c_str(), writable ? O_RDWR : O_RDONLY, 0);
+	if (file_mapping_handle < 0) {
+		fprintf(stderr, "Couldn't open shared memory with name: %s (error: %d)\n", name.c_str(), errno);
+		return false;
+	}
+
+	// Map the segment at its current size.
+	struct stat mapping_stat;
+	if (fstat(file_mapping_handle, &mapping_stat) != 0 || mapping_stat.st_size == 0) {
+		close(file_mapping_handle);
+		printf("%-40s %12d bytes %10s\n", name.c_str(), 0, "empty");
+		return true;
+	}
+	void *mapping = mmap(NULL, (size_t)mapping_stat.st_size, writable ? PROT_READ | PROT_WRITE : PROT_READ, MAP_SHARED, file_mapping_handle, 0);
+	close(file_mapping_handle);
+	if (mapping == MAP_FAILED) {
+		fprintf(stderr, "Couldn't map shared memory with name: %s (error: %d)\n", name.c_str(), errno);
+		return false;
+	}
+
+	if (advise && !generic_shared_memory_advise(mapping, (size_t)mapping_stat.st_size, advice)) {
+		fprintf(stderr, "Couldn't advise shared memory with name: %s (error: %d)\n", name.c_str(), errno);
+	}
+
+	GenericSharedMemoryResidency residency = generic_shared_memory_residency(mapping, (size_t)mapping_stat.st_size);
+	printf("%-40s %12lld bytes %8zu / %-8zu pages resident (%.1f%%)\n", name.c_str(), (long long)mapping_stat.st_size,
+		residency.resident_pages, residency.total_pages,
+		residency.total_pages != 0 ? 100.0 * (double)residency.resident_pages / (double)residency.total_pages : 0.0);
+
+	munmap(mapping, (size_t)mapping_stat.st_size);
+	return true;
+}
+
+int main(int argc, char **argv) {
+	bool advise = false;
+	GenericSharedMemoryAdvice advice = GenericSharedMemoryAdvice::WillNeed;
+	vector<string> names;
+
+	// Parse the options and the names of the segments.
+	for (int i = 1; i < argc; i++) {
+		string argument = argv[i];
+		if (argument.rfind("--advise=", 0) == 0) {
+			string advice_name = argument.substr(9);
+			advise = true;
+			if (advice_name == "willneed") 		advice = GenericSharedMemoryAdvice::WillNeed;
+			else if (advice_name == "cold") 	advice = GenericSharedMemoryAdvice::Cold;
+			else if (advice_name == "pageout") 	advice = GenericSharedMemoryAdvice::PageOut;
+			else if (advice_name == "remove") 	advice = GenericSharedMemoryAdvice::Remove;
+			else {
+				fprintf(stderr, "Unknown advice: %s\n", advice_name.c_str());
+				return -1;
+			}
+		}
+		else if (argument == "--help" || argument == "-h") {
+			printf("Usage: %s [--advise=willneed|cold|pageout|remove] [segment name ...]\n", argv[0]);
+			return 0;
+		}
+		else {
+			names.push_back(argument);
+		}
+	}
+
+	// Report every segment in /dev/shm if no names were given. Removing would destroy the contents of the segments of
+	// every other process on the host, so it needs the segments to be named.
+	if (names.empty()) {
+		if (advise && advice == GenericSharedMemoryAdvice::Remove) {
+			fprintf(stderr, "--advise=remove needs the names of the segments to remove\n");
+			return -1;
+		}
+		error_code error;
+		for (const auto &entry : filesystem::directory_iterator("/dev/shm", error)) {
+			if (entry.is_regular_file()) {
+				names.push_back(entry.path().filename().string());
+			}
+		}
+	}
+
+	bool success = true;
+	for (const string &name : names) {
+		success = report_segment(name, advise, advice) && success;
+	}
+	return success ? 0 : -1;
+}